@@ -1,5 +1,7 @@
 // Test linking Colvars through a C interface
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,6 +20,13 @@ void call_proxy_member(void *proxy);
 int run_colvarscript_command(int objc, unsigned char *const objv[]);
 const char * get_colvarscript_result();
 
+// Array-valued results (e.g. atomic positions) can be retrieved without
+// conversion to text: data points to a row-major array that is valid until
+// the next call (see COLVARSCRIPT_RESULT_* in colvarscript.h for the types)
+int run_colvarscript_command_binary(int objc, unsigned char *const objv[]);
+int get_colvarscript_result_binary(void const **data, int *type, int *ndim,
+                                   size_t *shape);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,32 @@ def run_cmds(*cmds):
 def cv_result():
   return cv.get_colvarscript_result().decode('utf-8')
 
+# Dtypes matching the COLVARSCRIPT_RESULT_* constants in colvarscript.h
+result_ctypes = { 1: ctypes.c_int, 2: ctypes.c_long, 3: ctypes.c_double }
+
+def run_array(cmd, copy=False):
+  """Run a command and return its result as a NumPy array (a view of the
+  Colvars-owned data, valid until the next call, unless copy=True)"""
+  import numpy
+  words = [b(w) for w in cmd.split()]
+  objc = len(words) + 1
+  objv = (ctypes.c_char_p * objc) (b('cv'), *words)
+  if cv.run_colvarscript_command_binary(objc, objv):
+    return None
+  data = ctypes.c_void_p()
+  dtype = ctypes.c_int()
+  ndim = ctypes.c_int()
+  shape = (ctypes.c_size_t * 2)()
+  if cv.get_colvarscript_result_binary(ctypes.byref(data), ctypes.byref(dtype),
+                                       ctypes.byref(ndim), shape):
+    return None
+  dims = tuple(shape[:ndim.value])
+  ptr = ctypes.cast(data, ctypes.POINTER(result_ctypes[dtype.value]))
+  if numpy.prod(dims) == 0:
+    return numpy.zeros(dims, dtype=ptr._type_)
+  result = numpy.ctypeslib.as_array(ptr, shape=dims)
+  return result.copy() if copy else result
+
 def run_echo(cmd):
   print(f'Calling cv {cmd}')
   run_cmd(cmd)
@@ -35,6 +61,9 @@ cv = ctypes.cdll.LoadLibrary('./libcolvars_C.so')
 cv.allocate_Colvars(b('Allocated from Python through ctypes'))
 
 cv.get_colvarscript_result.restype = ctypes.c_char_p
+cv.get_colvarscript_result_binary.argtypes = [
+  ctypes.POINTER(ctypes.c_void_p), ctypes.POINTER(ctypes.c_int),
+  ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_size_t)]
 
 if run_cmd('version'):
   print('Error running cv version')
@@ -44,5 +73,6 @@ print(f'Detected cv version {cv_result()}')
 run_cmds('config', 'units electron')
 run_echo('help')
 run_echo('getconfig')
+print(f'Atomic positions array: {run_array("getatompositions")}')
 run_echo('delete')
 run_echo('reset')
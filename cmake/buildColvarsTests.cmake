@@ -46,3 +46,8 @@ if(BUILD_UNITTESTS)
   # Build unit tests executables
   add_subdirectory(${COLVARS_SOURCE_DIR}/tests/unittests tests/unittests)
 endif()
+
+if(BUILD_BENCHMARKS)
+  # Build micro-benchmarks executable
+  add_subdirectory(${COLVARS_SOURCE_DIR}/tests/benchmarks tests/benchmarks)
+endif()
@@ -109,7 +109,10 @@ class colvars_grid:
 
 
     def read(self, filename):
-        '''Read data from a Colvars multicolumn file'''
+        '''Read data from a Colvars multicolumn file, or from a binary history file'''
+        if is_grid_history(filename):
+            self.read_history(filename)
+            return
         self.reset()
         self.filenames.append(filename)
         with open(filename) as f:
@@ -202,6 +205,34 @@ class colvars_grid:
             self.data.append(self.histdata[i][-1])
 
 
+    def read_history(self, filename, frames=None):
+        '''Read time frames from a binary history file (historyFormat binary)
+        By default all frames are read; frames may be a list of frame indices
+        (negative indices count from the end).
+        The steps of the frames read are stored in self.steps.
+        '''
+        self.reset()
+        self.filenames.append(filename)
+        h = grid_history(filename)
+        self.dim = h.dim
+        self.xmin = h.xmin
+        self.dx = h.dx
+        self.nx = h.nx
+        self.pbc = h.pbc
+        self.nsets = h.mult
+        self.histdata = [[] for _ in range(self.nsets)]
+        if frames is None:
+            frames = range(h.nframes)
+        self.steps = []
+        for t in frames:
+            d = h.frame(t)
+            self.steps.append(h.steps[t])
+            for i in range(self.nsets):
+                self.histdata[i].append(d[i::self.nsets].copy())
+        self.nframes = len(self.steps)
+        self.data = [self.histdata[i][-1] for i in range(self.nsets)]
+
+
     def write(self, filename):
         '''Write data (final, not history) to a Colvars multicolumn file (2d / 3d only)'''
         if self.dim < 2 or self.dim > 3:
@@ -532,6 +563,87 @@ class colvars_grid:
         return grad
 
 
+GRID_HISTORY_SIGNATURE = b'CVGRIDH2'
+
+
+def is_grid_history(filename):
+    '''Whether the file is a binary grid history file'''
+    with open(filename, 'rb') as f:
+        return f.read(len(GRID_HISTORY_SIGNATURE)) == GRID_HISTORY_SIGNATURE
+
+
+class grid_history:
+    '''
+    Index of a binary grid history file, written with historyFormat binary.
+    Each frame contains only the values that changed since the previous
+    frame, with complete keyframes at regular intervals: frame(t) starts
+    from the closest keyframe before t and applies the following changes.
+    For metadynamics, the values are the sum of the hills (not the PMF).
+
+    # Example: count of the first bin over time
+    h = grid_history('run.hist.count.bin')
+    print([h.frame(t)[0] for t in range(h.nframes)])
+
+    Attributes:
+        dim (int): grid dimension
+        mult (int): number of values per grid point
+        xmin, dx, nx, pbc (lists): grid parameters as in colvars_grid
+        steps (list of int): simulation step of each frame
+        nframes (int): number of frames
+    '''
+
+    def __init__(self, filename):
+        with open(filename, 'rb') as f:
+            assert f.read(len(GRID_HISTORY_SIGNATURE)) == GRID_HISTORY_SIGNATURE, \
+                f'{filename} is not a grid history file'
+            self.buf = f.read()
+        buf = self.buf
+        dim, mult = np.frombuffer(buf, dtype=np.float64, count=2)
+        self.dim = int(dim)
+        self.mult = int(mult)
+        grid = np.frombuffer(buf, dtype=np.float64, count=4*self.dim, offset=16)
+        self.xmin = [float(x) for x in grid[0::4]]
+        self.dx = [float(x) for x in grid[1::4]]
+        self.nx = [int(x) for x in grid[2::4]]
+        self.pbc = [x != 0.0 for x in grid[3::4]]
+        pos = 16 + 32*self.dim
+        # Frames: step, type (0 = keyframe, 1 = changes), size (as doubles),
+        # then the values, or the indices (32-bit integers) and the values
+        self.steps = []
+        self._frames = []
+        while pos + 24 <= len(buf):
+            step, ftype, n = np.frombuffer(buf, dtype=np.float64, count=3, offset=pos)
+            keyframe, n = (ftype == 0.0), int(n)
+            size = 8*n if keyframe else 12*n
+            if pos + 24 + size > len(buf):
+                break # Incomplete last frame
+            self.steps.append(int(step))
+            self._frames.append((keyframe, pos + 24, n))
+            pos += 24 + size
+        self.nframes = len(self.steps)
+
+
+    def _values(self, start, n):
+        return np.frombuffer(self.buf, dtype=np.float64, count=n, offset=start)
+
+
+    def frame(self, t):
+        '''Reconstruct frame t (negative values count from the end) as a flat array'''
+        t = range(self.nframes)[t]
+        k = t
+        while not self._frames[k][0]:
+            k -= 1
+        _, start, n = self._frames[k]
+        data = self._values(start, n).copy()
+        for keyframe, start, n in self._frames[k+1:t+1]:
+            if keyframe:
+                data = self._values(start, n).copy()
+            else:
+                indices = np.frombuffer(self.buf, dtype=np.int32, count=n, offset=start)
+                data[indices] = self._values(start + 4*n, n)
+        return data
+
+
 class ABF_dataset:
     def __init__(self, prefix, label='no label'):
         # Special file names for CZAR data
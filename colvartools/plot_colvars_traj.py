@@ -97,6 +97,8 @@ class Colvars_traj(object):
     variable's trajectory is an instance of colvars_traj"""
 
     _keys = []
+    _binary_signature = b"CVTRAJB2"
+    _binary_frame_tag = b"CVTRAJFR"
     _start = {}
     _end = {}
     _colvars = {}
@@ -180,6 +182,73 @@ class Colvars_traj(object):
             dict_buffer[v]['cv_values'].append(v_v)
             dict_buffer[v]['cv_step'].append(step)
 
+    def _read_binary_record(self, f):
+        """
+        Read the tag and length of the next record of a binary colvars.traj
+        file; return (None, 0) at the end of the file
+        """
+        data = f.read(12)
+        if (len(data) < 12):
+            return (None, 0)
+        return (data[:8], int(np.frombuffer(data[8:12], dtype=np.int32)[0]))
+
+    def _parse_binary_header(self, f, length):
+        """
+        Read the header record of a binary colvars.traj file (after its tag),
+        and return the list of columns as (name, offset, dimension)
+        """
+        columns = []
+        offset = 0
+        for line in f.read(length).decode().splitlines():
+            words = line.split()
+            n_d = int(words[2])
+            columns.append((words[0], offset, n_d))
+            offset += n_d
+        if ((len(columns) == 0) or (columns[0][0] != 'step')):
+            raise KeyError("Error: file format incompatible with colvars.traj")
+        self._keys = [c[0] for c in columns]
+        return columns
+
+    def _read_binary_file(self, f, dict_buffer, first, last, every,
+                          last_step):
+        """
+        Read the records of a colvars.traj file written with
+        colvarsTrajFormat binary; return the last step number read
+        """
+        columns = []
+        while True:
+            (tag, length) = self._read_binary_record(f)
+            if (tag is None):
+                break
+            if (tag == self._binary_signature):
+                columns = self._parse_binary_header(f, length)
+                continue
+            if ((tag != self._binary_frame_tag) or (len(columns) == 0) or
+                (length != columns[-1][1] + columns[-1][2])):
+                raise KeyError("Error: corrupted binary colvars.traj file")
+            data = f.read(8 * length)
+            if (len(data) < 8 * length):
+                break # Incomplete last frame
+            frame = np.frombuffer(data, dtype=np.float64)
+            step = np.int64(frame[0])
+            if (step == last_step): continue
+            if ((self._frame >= first) and (self._frame <= last) and
+                (self._frame % every == 0)):
+                for (v, offset, n_d) in columns[1:]:
+                    if (v not in dict_buffer):
+                        dict_buffer[v] = {'cv_step': list(),
+                                          'cv_values': list()}
+                    dict_buffer[v]['dimension'] = n_d
+                    if (n_d > 1):
+                        v_v = np.array(frame[offset:offset+n_d])
+                    else:
+                        v_v = frame[offset]
+                    dict_buffer[v]['cv_values'].append(v_v)
+                    dict_buffer[v]['cv_step'].append(step)
+            self._frame += 1
+            last_step = step
+        return last_step
+
     def read_files(self, filenames, list_variables=False,
                    first=0, last=-1, every=1):
         """
@@ -200,8 +269,21 @@ class Colvars_traj(object):
         if (last == -1):
             last = np.int64(np.iinfo(np.int64).max)
         last_step = -1
-        for f in [open(filename) for filename in filenames]:
+        for filename in filenames:
             dict_buffer = dict()
+            f = open(filename, 'rb')
+            if (f.peek(len(self._binary_signature))[:len(self._binary_signature)]
+                == self._binary_signature):
+                if list_variables:
+                    (tag, length) = self._read_binary_record(f)
+                    self._parse_binary_header(f, length)
+                    f.close()
+                    return self._keys[1:]
+                last_step = self._read_binary_file(f, dict_buffer, first,
+                                                   last, every, last_step)
+            else:
+                f.close()
+                f = open(filename)
             for line in f:
                 if (len(line) == 0): continue
                 if (line[:1] == "@"): continue # xmgr file metadata
@@ -23,7 +23,12 @@
 
 //************************************************************
 // colvarproxy_gromacs
-colvarproxy_gromacs::colvarproxy_gromacs() : colvarproxy() {}
+colvarproxy_gromacs::colvarproxy_gromacs() : colvarproxy()
+{
+  // The cell is passed to the base class only when pbc_dx() reduces to the
+  // nearest image along each axis (see update_data())
+  batched_cell_distances = true;
+}
 
 // Colvars Initialization
 void colvarproxy_gromacs::init(t_inputrec *ir, int64_t step,gmx_mtop_t *mtop,
@@ -418,6 +423,20 @@ void colvarproxy_gromacs::update_data(const t_commrec *cr, int64_t const step, t
 
   gmx_pbc = pbc;
   gmx_box = box;
+
+  if (pbc.pbcTypeDX == epbcdxRECTANGULAR) {
+    boundaries_type = boundaries_pbc_ortho;
+    unit_cell_x.set(box[XX][XX], 0.0, 0.0);
+    unit_cell_y.set(0.0, box[YY][YY], 0.0);
+    unit_cell_z.set(0.0, 0.0, box[ZZ][ZZ]);
+    colvarproxy_system::update_pbc_lattice();
+  } else if (pbc.pbcTypeDX == epbcdxNOPBC) {
+    boundaries_type = boundaries_non_periodic;
+    reset_pbc_lattice();
+  } else {
+    // Triclinic and partially periodic cells are left to pbc_dx()
+    boundaries_type = boundaries_unsupported;
+  }
   gmx_bNS = bNS;
 
   previous_gmx_step = step;
@@ -455,9 +474,7 @@ void colvarproxy_gromacs::calculateForces(
     // On non-master nodes, jump directly to applying the forces
 
     // Zero the forces on the atoms, so that they can be accumulated by the colvars.
-    for (size_t i = 0; i < atoms_new_colvar_forces.size(); i++) {
-      atoms_new_colvar_forces[i].x = atoms_new_colvar_forces[i].y = atoms_new_colvar_forces[i].z = 0.0;
-    }
+    reset_atoms_applied_forces();
 
     // Get the atom positions from the Gromacs array.
     for (size_t i = 0; i < atoms_ids.size(); i++) {
@@ -46,6 +46,10 @@ colvarproxy_lammps::colvarproxy_lammps(LAMMPS_NS::LAMMPS *lmp,
   t_target=temp;
   do_exit=false;
 
+  // Domain::minimum_image() gives the nearest image in the orthogonal boxes
+  // passed to the base class; other boxes remain unsupported there
+  batched_cell_distances = true;
+
   // set input restart name and strip the extension, if present
   input_prefix_str = std::string(inp_name ? inp_name : "");
   if (input_prefix_str.rfind(".colvars.state") != std::string::npos)
@@ -214,9 +218,7 @@ double colvarproxy_lammps::compute()
   }
 
   // zero the forces on the atoms, so that they can be accumulated by the colvars
-  for (size_t i = 0; i < atoms_new_colvar_forces.size(); i++) {
-    atoms_new_colvar_forces[i].reset();
-  }
+  reset_atoms_applied_forces();
 
   bias_energy = 0.0;
 
@@ -357,6 +359,65 @@ int colvarproxy_lammps::replica_comm_send(char* msg_data,
 }
 
 
+int colvarproxy_lammps::replica_comm_async()
+{
+  return replica_enabled();
+}
+
+
+int colvarproxy_lammps::replica_comm_isend(char* msg_data,
+                                           int msg_len, int dest_rep, int tag)
+{
+  // reuse the slot of a completed request
+  size_t i = 0;
+  while ((i < inter_requests.size()) && (inter_requests[i] != MPI_REQUEST_NULL)) i++;
+  if (i == inter_requests.size()) inter_requests.push_back(MPI_REQUEST_NULL);
+  int const retval = MPI_Isend(msg_data,msg_len,MPI_CHAR,dest_rep,tag,inter_comm,
+                               &(inter_requests[i]));
+  return (retval == MPI_SUCCESS) ? int(i) : -1;
+}
+
+
+bool colvarproxy_lammps::replica_comm_send_done(int request, bool wait)
+{
+  MPI_Request &r = inter_requests[request];
+  if (r == MPI_REQUEST_NULL) return true;
+  int flag = 0;
+  MPI_Status status;
+  if (wait) {
+    MPI_Wait(&r,&status);
+    flag = 1;
+  } else {
+    MPI_Test(&r,&flag,&status);
+  }
+  // completed requests are set to MPI_REQUEST_NULL
+  return (flag != 0);
+}
+
+
+bool colvarproxy_lammps::replica_comm_ready(int src_rep, int tag)
+{
+  int flag = 0;
+  MPI_Status status;
+  MPI_Iprobe(src_rep,tag,inter_comm,&flag,&status);
+  return (flag != 0);
+}
+
+
+int colvarproxy_lammps::replica_comm_recv_tagged(char* msg_data,
+                                                 int buf_len, int src_rep, int tag)
+{
+  MPI_Status status;
+  int retval;
+
+  retval = MPI_Recv(msg_data,buf_len,MPI_CHAR,src_rep,tag,inter_comm,&status);
+  if (retval == MPI_SUCCESS) {
+    MPI_Get_count(&status, MPI_CHAR, &retval);
+  } else retval = 0;
+  return retval;
+}
+
+
 
 int colvarproxy_lammps::check_atom_id(int atom_number)
 {
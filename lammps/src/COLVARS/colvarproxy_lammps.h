@@ -44,6 +44,7 @@ class colvarproxy_lammps : public colvarproxy {
 
   MPI_Comm inter_comm;        // MPI comm with 1 root proc from each world
   int inter_me, inter_num;    // rank for the inter replica comm
+  std::vector<MPI_Request> inter_requests;    // non-blocking sends
 
  public:
   friend class cvm::atom;
@@ -117,6 +118,11 @@ class colvarproxy_lammps : public colvarproxy {
   void replica_comm_barrier() override;
   int replica_comm_recv(char *msg_data, int buf_len, int src_rep) override;
   int replica_comm_send(char *msg_data, int msg_len, int dest_rep) override;
+  int replica_comm_async() override;
+  int replica_comm_isend(char *msg_data, int msg_len, int dest_rep, int tag) override;
+  bool replica_comm_send_done(int request, bool wait) override;
+  bool replica_comm_ready(int src_rep, int tag) override;
+  int replica_comm_recv_tagged(char *msg_data, int buf_len, int src_rep, int tag) override;
 };
 
 #endif
@@ -34,6 +34,7 @@
 #include "error.h"
 #include "memory.h"
 #include "modify.h"
+#include "neighbor.h"
 #include "respa.h"
 #include "universe.h"
 #include "update.h"
@@ -46,206 +47,11 @@
 #include "colvarproxy_lammps.h"
 #include "colvarmodule.h"
 
-
-/* struct for packed data communication of coordinates and forces. */
-struct LAMMPS_NS::commdata {
-  int tag,type;
-  double x,y,z,m,q;
-};
-
-inline std::ostream & operator<< (std::ostream &out, const LAMMPS_NS::commdata &cd)
-{
-  out << " (" << cd.tag << "/" << cd.type << ": "
-      << cd.x << ", " << cd.y << ", " << cd.z << ") ";
-  return out;
-}
-
-/* re-usable integer hash table code with static linkage. */
-
-/** hash table top level data structure */
-typedef struct inthash_t {
-  struct inthash_node_t **bucket;        /* array of hash nodes */
-  int size;                           /* size of the array */
-  int entries;                        /* number of entries in table */
-  int downshift;                      /* shift cound, used in hash function */
-  int mask;                           /* used to select bits for hashing */
-} inthash_t;
-
-/** hash table node data structure */
-typedef struct inthash_node_t {
-  int data;                           /* data in hash node */
-  int key;                            /* key for hash lookup */
-  struct inthash_node_t *next;        /* next node in hash chain */
-} inthash_node_t;
-
-#define HASH_FAIL  -1
-#define HASH_LIMIT  0.5
-
-/* initialize new hash table  */
-static void inthash_init(inthash_t *tptr, int buckets);
-/* lookup entry in hash table */
-static int inthash_lookup(void *tptr, int key);
-/* insert an entry into hash table. */
-static int inthash_insert(inthash_t *tptr, int key, int data);
-/* delete the hash table */
-static void inthash_destroy(inthash_t *tptr);
-
-/************************************************************************
- * integer hash code:
- ************************************************************************/
-
-/* inthash() - Hash function returns a hash number for a given key.
- * tptr: Pointer to a hash table, key: The key to create a hash number for */
-static int inthash(const inthash_t *tptr, int key) {
-  int hashvalue;
-
-  hashvalue = (((key*1103515249)>>tptr->downshift) & tptr->mask);
-  if (hashvalue < 0) {
-    hashvalue = 0;
-  }
-
-  return hashvalue;
-}
-
-/*
- *  rebuild_table_int() - Create new hash table when old one fills up.
- *
- *  tptr: Pointer to a hash table
- */
-static void rebuild_table_int(inthash_t *tptr) {
-  inthash_node_t **old_bucket, *old_hash, *tmp;
-  int old_size, h, i;
-
-  old_bucket=tptr->bucket;
-  old_size=tptr->size;
-
-  /* create a new table and rehash old buckets */
-  inthash_init(tptr, old_size<<1);
-  for (i=0; i<old_size; i++) {
-    old_hash=old_bucket[i];
-    while (old_hash) {
-      tmp=old_hash;
-      old_hash=old_hash->next;
-      h=inthash(tptr, tmp->key);
-      tmp->next=tptr->bucket[h];
-      tptr->bucket[h]=tmp;
-      tptr->entries++;
-    } /* while */
-  } /* for */
-
-  /* free memory used by old table */
-  free(old_bucket);
-}
-
-/*
- *  inthash_init() - Initialize a new hash table.
- *
- *  tptr: Pointer to the hash table to initialize
- *  buckets: The number of initial buckets to create
- */
-void inthash_init(inthash_t *tptr, int buckets) {
-
-  /* make sure we allocate something */
-  if (buckets==0)
-    buckets=16;
-
-  /* initialize the table */
-  tptr->entries=0;
-  tptr->size=2;
-  tptr->mask=1;
-  tptr->downshift=29;
-
-  /* ensure buckets is a power of 2 */
-  while (tptr->size<buckets) {
-    tptr->size<<=1;
-    tptr->mask=(tptr->mask<<1)+1;
-    tptr->downshift--;
-  } /* while */
-
-  /* allocate memory for table */
-  tptr->bucket=(inthash_node_t **) calloc(tptr->size, sizeof(inthash_node_t *));
-}
-
-/*
- *  inthash_lookup() - Lookup an entry in the hash table and return a pointer to
- *    it or HASH_FAIL if it wasn't found.
- *
- *  tptr: Pointer to the hash table
- *  key: The key to lookup
- */
-int inthash_lookup(void *ptr, int key) {
-  const inthash_t *tptr = (const inthash_t *) ptr;
-  int h;
-  inthash_node_t *node;
-
-
-  /* find the entry in the hash table */
-  h=inthash(tptr, key);
-  for (node=tptr->bucket[h]; node!=nullptr; node=node->next) {
-    if (node->key == key)
-      break;
-  }
-
-  /* return the entry if it exists, or HASH_FAIL */
-  return(node ? node->data : HASH_FAIL);
-}
-
-/*
- *  inthash_insert() - Insert an entry into the hash table.  If the entry already
- *  exists return a pointer to it, otherwise return HASH_FAIL.
- *
- *  tptr: A pointer to the hash table
- *  key: The key to insert into the hash table
- *  data: A pointer to the data to insert into the hash table
- */
-int inthash_insert(inthash_t *tptr, int key, int data) {
-  int tmp;
-  inthash_node_t *node;
-  int h;
-
-  /* check to see if the entry exists */
-  if ((tmp=inthash_lookup(tptr, key)) != HASH_FAIL)
-    return(tmp);
-
-  /* expand the table if needed */
-  while (tptr->entries>=HASH_LIMIT*tptr->size)
-    rebuild_table_int(tptr);
-
-  /* insert the new entry */
-  h=inthash(tptr, key);
-  node=(struct inthash_node_t *) malloc(sizeof(inthash_node_t));
-  node->data=data;
-  node->key=key;
-  node->next=tptr->bucket[h];
-  tptr->bucket[h]=node;
-  tptr->entries++;
-
-  return HASH_FAIL;
-}
-
-/*
- * inthash_destroy() - Delete the entire table, and all remaining entries.
- *
- */
-void inthash_destroy(inthash_t *tptr) {
-  inthash_node_t *node, *last;
-  int i;
-
-  for (i=0; i<tptr->size; i++) {
-    node = tptr->bucket[i];
-    while (node != nullptr) {
-      last = node;
-      node = node->next;
-      free(last);
-    }
-  }
-
-  /* free the entire array of buckets */
-  if (tptr->bucket != nullptr) {
-    free(tptr->bucket);
-    memset(tptr, 0, sizeof(inthash_t));
-  }
-}
+/* number of values per atom communicated at setup: x, y, z, mass, charge, type */
+static constexpr int SETUP_STRIDE = 6;
+// values per atom when sending only the atoms that received a force:
+// position among the atoms of the receiving rank, and force
+static constexpr int SPARSE_FORCE_STRIDE = 4;
 
 /***************************************************************/
 
@@ -327,15 +133,21 @@ FixColvars::FixColvars(LAMMPS *lmp, int narg, char **arg) :
   tstat_id = -1;
   energy = 0.0;
   nlevels_respa = 0;
+  store_forces = 0;
   init_flag = 0;
   num_coords = 0;
-  comm_buf = nullptr;
-  force_buf = nullptr;
+  taglist = nullptr;
   proxy = nullptr;
-  idmap = nullptr;
 
-  /* storage required to communicate a single coordinate or force. */
-  size_one = sizeof(struct commdata);
+  nlocal_coords = nmax_local = 0;
+  local_atom_index = local_coord_index = nullptr;
+  local_buf = nullptr;
+  ngathered = 0;
+  gather_counts = gather_displs = gather_index = nullptr;
+  data_counts = data_displs = nullptr;
+  gather_buf = nullptr;
+  gather_rank = gather_position = nullptr;
+  force_counts = force_offsets = nullptr;
 }
 
 /*********************************
@@ -348,13 +160,23 @@ FixColvars::~FixColvars()
   delete[] inp_name;
   delete[] out_name;
   delete[] tmp_name;
-  memory->sfree(comm_buf);
+  memory->destroy(taglist);
+  memory->destroy(local_atom_index);
+  memory->destroy(local_coord_index);
+  memory->destroy(local_buf);
+  memory->destroy(gather_counts);
+  memory->destroy(gather_displs);
+  memory->destroy(gather_index);
+  memory->destroy(data_counts);
+  memory->destroy(data_displs);
+  memory->destroy(gather_buf);
+  memory->destroy(gather_rank);
+  memory->destroy(gather_position);
+  memory->destroy(force_counts);
+  memory->destroy(force_offsets);
 
   if (proxy) {
     delete proxy;
-    inthash_t *hashtable = (inthash_t *)idmap;
-    inthash_destroy(hashtable);
-    delete hashtable;
   }
 
   if (root2root != MPI_COMM_NULL)
@@ -400,7 +222,7 @@ void FixColvars::init()
 
 void FixColvars::one_time_init()
 {
-  int i,tmp;
+  int tmp;
 
   if (init_flag) return;
   init_flag = 1;
@@ -448,28 +270,142 @@ void FixColvars::one_time_init()
   }
 
   // send the list of all colvar atom IDs to all nodes.
-  // also initialize and build hashtable on master.
+  // also allocate the buffers used to gather data on the master.
 
   MPI_Bcast(&num_coords, 1, MPI_INT, 0, world);
   memory->create(taglist,num_coords,"colvars:taglist");
-  memory->create(force_buf,3*num_coords,"colvars:force_buf");
 
   if (me == 0) {
     std::vector<int> const &tl = *(proxy->get_atom_ids());
-    inthash_t *hashtable=new inthash_t;
-    inthash_init(hashtable, num_coords);
-    idmap = (void *)hashtable;
-
-    for (i=0; i < num_coords; ++i) {
+    for (int i=0; i < num_coords; ++i) {
       taglist[i] = tl[i];
-      inthash_insert(hashtable, tl[i], i);
     }
+    memory->create(gather_counts,comm->nprocs,"colvars:gather_counts");
+    memory->create(gather_displs,comm->nprocs,"colvars:gather_displs");
+    memory->create(data_counts,comm->nprocs,"colvars:data_counts");
+    memory->create(data_displs,comm->nprocs,"colvars:data_displs");
+    memory->create(gather_index,num_coords,"colvars:gather_index");
+    memory->create(gather_buf,SETUP_STRIDE*num_coords,"colvars:gather_buf");
+    memory->create(gather_rank,num_coords,"colvars:gather_rank");
+    memory->create(gather_position,num_coords,"colvars:gather_position");
+    memory->create(force_counts,comm->nprocs,"colvars:force_counts");
+    memory->create(force_offsets,comm->nprocs,"colvars:force_offsets");
   }
   MPI_Bcast(taglist, num_coords, MPI_LMP_TAGINT, 0, world);
 }
 
 /* ---------------------------------------------------------------------- */
 
+// find the colvar atoms owned by this rank, and collect on the master the
+// number and Colvars indices of the atoms owned by each rank; atoms only
+// migrate between ranks when reneighboring, so this is not done every step
+
+void FixColvars::update_local_map()
+{
+  const int nlocal = atom->nlocal;
+  int i, n = 0;
+
+  for (i=0; i < num_coords; ++i) {
+    const int k = atom->map(taglist[i]);
+    if ((k >= 0) && (k < nlocal))
+      ++n;
+  }
+
+  if (n > nmax_local) {
+    nmax_local = n;
+    memory->grow(local_atom_index,nmax_local,"colvars:local_atom_index");
+    memory->grow(local_coord_index,nmax_local,"colvars:local_coord_index");
+    memory->grow(local_buf,SETUP_STRIDE*nmax_local,"colvars:local_buf");
+  }
+
+  nlocal_coords = 0;
+  for (i=0; i < num_coords; ++i) {
+    const int k = atom->map(taglist[i]);
+    if ((k >= 0) && (k < nlocal)) {
+      local_atom_index[nlocal_coords] = k;
+      local_coord_index[nlocal_coords] = i;
+      ++nlocal_coords;
+    }
+  }
+
+  MPI_Gather(&nlocal_coords, 1, MPI_INT, gather_counts, 1, MPI_INT, 0, world);
+  if (me == 0) {
+    ngathered = 0;
+    for (int iproc=0; iproc < comm->nprocs; ++iproc) {
+      gather_displs[iproc] = ngathered;
+      ngathered += gather_counts[iproc];
+    }
+  }
+  MPI_Gatherv(local_coord_index, nlocal_coords, MPI_INT,
+              gather_index, gather_counts, gather_displs, MPI_INT, 0, world);
+
+  // reverse map, used to route the forces of individual atoms
+  if (me == 0) {
+    for (i=0; i < num_coords; ++i) gather_position[i] = -1;
+    for (int iproc=0; iproc < comm->nprocs; ++iproc) {
+      for (i=gather_displs[iproc]; i < gather_displs[iproc]+gather_counts[iproc]; ++i) {
+        gather_rank[i] = iproc;
+        gather_position[gather_index[i]] = i;
+      }
+    }
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+// collect "stride" values per atom from local_buf of all ranks into
+// gather_buf on the master, ordered as gather_index
+
+void FixColvars::gather_atom_data(int stride)
+{
+  if (me == 0) {
+    for (int iproc=0; iproc < comm->nprocs; ++iproc) {
+      data_counts[iproc] = stride*gather_counts[iproc];
+      data_displs[iproc] = stride*gather_displs[iproc];
+    }
+  }
+  MPI_Gatherv(local_buf, stride*nlocal_coords, MPI_DOUBLE,
+              gather_buf, data_counts, data_displs, MPI_DOUBLE, 0, world);
+}
+
+/* ---------------------------------------------------------------------- */
+
+// copy the (optionally unwrapped) positions of the local colvar atoms into
+// local_buf, using "stride" values per atom
+
+void FixColvars::pack_positions(int stride)
+{
+  const double * const * const x = atom->x;
+  const imageint * const image = atom->image;
+
+  const double xprd = domain->xprd;
+  const double yprd = domain->yprd;
+  const double zprd = domain->zprd;
+  const double xy = domain->xy;
+  const double xz = domain->xz;
+  const double yz = domain->yz;
+
+  for (int i=0; i < nlocal_coords; ++i) {
+    const int k = local_atom_index[i];
+    double * const buf = local_buf + stride*i;
+    if (unwrap_flag) {
+      const int ix = (image[k] & IMGMASK) - IMGMAX;
+      const int iy = (image[k] >> IMGBITS & IMGMASK) - IMGMAX;
+      const int iz = (image[k] >> IMG2BITS) - IMGMAX;
+
+      buf[0] = x[k][0] + ix * xprd + iy * xy + iz * xz;
+      buf[1] = x[k][1] + iy * yprd + iz * yz;
+      buf[2] = x[k][2] + iz * zprd;
+    } else {
+      buf[0] = x[k][0];
+      buf[1] = x[k][1];
+      buf[2] = x[k][2];
+    }
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
 int FixColvars::modify_param(int narg, char **arg)
 {
   if (strcmp(arg[0],"configfile") == 0) {
@@ -505,40 +441,31 @@ int FixColvars::modify_param(int narg, char **arg)
 
 void FixColvars::setup(int vflag)
 {
-  const tagint * const tag  = atom->tag;
   const int * const type = atom->type;
-  int i,nme,tmp,ndata;
-  int nlocal = atom->nlocal;
-
-  MPI_Status status;
-  MPI_Request request;
 
   one_time_init();
 
-  // determine size of comm buffer
-  nme=0;
-  for (i=0; i < num_coords; ++i) {
-    const tagint k = atom->map(taglist[i]);
-    if ((k >= 0) && (k < nlocal))
-      ++nme;
-  }
+  update_local_map();
 
-  MPI_Allreduce(&nme,&nmax,1,MPI_INT,MPI_MAX,world);
-  memory->create(comm_buf,nmax,"colvars:comm_buf");
+  // pack positions, masses, charges and types of the local atoms
 
-  const double * const * const x = atom->x;
-  const imageint * const image = atom->image;
+  pack_positions(SETUP_STRIDE);
+  for (int i=0; i < nlocal_coords; ++i) {
+    const int k = local_atom_index[i];
+    double * const buf = local_buf + SETUP_STRIDE*i;
+    if (atom->rmass_flag) {
+      buf[3] = atom->rmass[k];
+    } else {
+      buf[3] = atom->mass[type[k]];
+    }
+    buf[4] = atom->q_flag ? atom->q[k] : 0.0;
+    buf[5] = type[k];
+  }
 
-  const double xprd = domain->xprd;
-  const double yprd = domain->yprd;
-  const double zprd = domain->zprd;
-  const double xy = domain->xy;
-  const double xz = domain->xz;
-  const double yz = domain->yz;
+  gather_atom_data(SETUP_STRIDE);
 
   if (me == 0) {
 
-    std::vector<int>     const &id = *(proxy->get_atom_ids());
     std::vector<int>           &tp = *(proxy->modify_atom_types());
     std::vector<cvm::atom_pos> &cd = *(proxy->modify_atom_positions());
     std::vector<cvm::rvector>  &of = *(proxy->modify_atom_total_forces());
@@ -547,108 +474,21 @@ void FixColvars::setup(int vflag)
 
     // store coordinate data in holding array, clear old forces
 
+    for (int i=0; i < ngathered; ++i) {
+      const int j = gather_index[i];
+      const double * const buf = gather_buf + SETUP_STRIDE*i;
 
-    for (i=0; i<num_coords; ++i) {
-      const tagint k = atom->map(taglist[i]);
-      if ((k >= 0) && (k < nlocal)) {
-
-        of[i].x = of[i].y = of[i].z = 0.0;
-
-        if (unwrap_flag) {
-          const int ix = (image[k] & IMGMASK) - IMGMAX;
-          const int iy = (image[k] >> IMGBITS & IMGMASK) - IMGMAX;
-          const int iz = (image[k] >> IMG2BITS) - IMGMAX;
-
-          cd[i].x = x[k][0] + ix * xprd + iy * xy + iz * xz;
-          cd[i].y = x[k][1] + iy * yprd + iz * yz;
-          cd[i].z = x[k][2] + iz * zprd;
-        } else {
-          cd[i].x = x[k][0];
-          cd[i].y = x[k][1];
-          cd[i].z = x[k][2];
-        }
-        if (atom->rmass_flag) {
-          m[i] = atom->rmass[k];
-        } else {
-          m[i] = atom->mass[type[k]];
-        }
-        if (atom->q_flag) {
-          q[i] = atom->q[k];
-        }
+      cd[j].x = buf[0];
+      cd[j].y = buf[1];
+      cd[j].z = buf[2];
+      m[j] = buf[3];
+      if (atom->q_flag) {
+        q[j] = buf[4];
       }
-    }
-
-    // loop over procs to receive and apply remote data
-
-    for (i=1; i < comm->nprocs; ++i) {
-      int maxbuf = nmax*size_one;
-      MPI_Irecv(comm_buf, maxbuf, MPI_BYTE, i, 0, world, &request);
-      MPI_Send(&tmp, 0, MPI_INT, i, 0, world);
-      MPI_Wait(&request, &status);
-      MPI_Get_count(&status, MPI_BYTE, &ndata);
-      ndata /= size_one;
+      tp[j] = static_cast<int>(buf[5]);
 
-      for (int k=0; k<ndata; ++k) {
-
-        const int j = inthash_lookup(idmap, comm_buf[k].tag);
-
-        if (j != HASH_FAIL) {
-
-          tp[j] = comm_buf[k].type;
-
-          cd[j].x = comm_buf[k].x;
-          cd[j].y = comm_buf[k].y;
-          cd[j].z = comm_buf[k].z;
-
-          m[j] = comm_buf[k].m;
-          q[j] = comm_buf[k].q;
-
-          of[j].x = of[j].y = of[j].z = 0.0;
-        }
-      }
+      of[j].x = of[j].y = of[j].z = 0.0;
     }
-  } else { // me != 0
-
-    // copy coordinate data into communication buffer
-
-    nme = 0;
-    for (i=0; i<num_coords; ++i) {
-      const tagint k = atom->map(taglist[i]);
-      if ((k >= 0) && (k < nlocal)) {
-
-        comm_buf[nme].tag  = tag[k];
-        comm_buf[nme].type = type[k];
-
-        if (unwrap_flag) {
-          const int ix = (image[k] & IMGMASK) - IMGMAX;
-          const int iy = (image[k] >> IMGBITS & IMGMASK) - IMGMAX;
-          const int iz = (image[k] >> IMG2BITS) - IMGMAX;
-
-          comm_buf[nme].x = x[k][0] + ix * xprd + iy * xy + iz * xz;
-          comm_buf[nme].y = x[k][1] + iy * yprd + iz * yz;
-          comm_buf[nme].z = x[k][2] + iz * zprd;
-        } else {
-          comm_buf[nme].x = x[k][0];
-          comm_buf[nme].y = x[k][1];
-          comm_buf[nme].z = x[k][2];
-        }
-
-        if (atom->rmass_flag) {
-          comm_buf[nme].m = atom->rmass[k];
-        } else {
-          comm_buf[nme].m = atom->mass[type[k]];
-        }
-
-        if (atom->q_flag) {
-          comm_buf[nme].q = atom->q[k];
-        }
-
-        ++nme;
-      }
-    }
-    /* blocking receive to wait until it is our turn to send data. */
-    MPI_Recv(&tmp, 0, MPI_INT, 0, 0, world, MPI_STATUS_IGNORE);
-    MPI_Rsend(comm_buf, nme*size_one, MPI_BYTE, 0, 0, world);
   }
 
   // run pre-run setup in colvarproxy
@@ -689,110 +529,23 @@ void FixColvars::post_force(int /*vflag*/)
     }
   }
 
-  const tagint * const tag = atom->tag;
-  const double * const * const x = atom->x;
-  double * const * const f = atom->f;
-  const imageint * const image = atom->image;
+  // the atoms owned by each rank only change when reneighboring (setup()
+  // has already built the map)
+  if ((neighbor->ago == 0) && !update->setupflag) update_local_map();
 
-  const double xprd = domain->xprd;
-  const double yprd = domain->yprd;
-  const double zprd = domain->zprd;
-  const double xy = domain->xy;
-  const double xz = domain->xz;
-  const double yz = domain->yz;
-  const int nlocal = atom->nlocal;
+  // collect the coordinates of the colvar atoms on the master
 
-  /* check and potentially grow local communication buffers. */
-  int i,nmax_new,nme=0;
-  for (i=0; i < num_coords; ++i) {
-    const tagint k = atom->map(taglist[i]);
-    if ((k >= 0) && (k < nlocal))
-      ++nme;
-  }
-
-  MPI_Allreduce(&nme,&nmax_new,1,MPI_INT,MPI_MAX,world);
-  if (nmax_new > nmax) {
-    nmax = nmax_new;
-    memory->grow(comm_buf,nmax,"colvars:comm_buf");
-  }
-
-  MPI_Status status;
-  MPI_Request request;
-  int tmp, ndata;
+  pack_positions(3);
+  gather_atom_data(3);
 
   if (me == 0) {
-
     std::vector<cvm::atom_pos> &cd = *(proxy->modify_atom_positions());
-
-    // store coordinate data
-
-    for (i=0; i<num_coords; ++i) {
-      const tagint k = atom->map(taglist[i]);
-      if ((k >= 0) && (k < nlocal)) {
-
-        if (unwrap_flag) {
-          const int ix = (image[k] & IMGMASK) - IMGMAX;
-          const int iy = (image[k] >> IMGBITS & IMGMASK) - IMGMAX;
-          const int iz = (image[k] >> IMG2BITS) - IMGMAX;
-
-          cd[i].x = x[k][0] + ix * xprd + iy * xy + iz * xz;
-          cd[i].y = x[k][1] + iy * yprd + iz * yz;
-          cd[i].z = x[k][2] + iz * zprd;
-        } else {
-          cd[i].x = x[k][0];
-          cd[i].y = x[k][1];
-          cd[i].z = x[k][2];
-        }
-      }
-    }
-
-    /* loop over procs to receive remote data */
-    for (i=1; i < comm->nprocs; ++i) {
-      int maxbuf = nmax*size_one;
-      MPI_Irecv(comm_buf, maxbuf, MPI_BYTE, i, 0, world, &request);
-      MPI_Send(&tmp, 0, MPI_INT, i, 0, world);
-      MPI_Wait(&request, &status);
-      MPI_Get_count(&status, MPI_BYTE, &ndata);
-      ndata /= size_one;
-
-      for (int k=0; k<ndata; ++k) {
-        const int j = inthash_lookup(idmap, comm_buf[k].tag);
-        if (j != HASH_FAIL) {
-          cd[j].x = comm_buf[k].x;
-          cd[j].y = comm_buf[k].y;
-          cd[j].z = comm_buf[k].z;
-        }
-      }
+    for (int i=0; i < ngathered; ++i) {
+      const int j = gather_index[i];
+      cd[j].x = gather_buf[3*i+0];
+      cd[j].y = gather_buf[3*i+1];
+      cd[j].z = gather_buf[3*i+2];
     }
-
-  } else { // me != 0
-    /* copy coordinate data into communication buffer */
-    nme = 0;
-    for (i=0; i<num_coords; ++i) {
-      const tagint k = atom->map(taglist[i]);
-      if ((k >= 0) && (k < nlocal)) {
-        comm_buf[nme].tag = tag[k];
-
-        if (unwrap_flag) {
-          const int ix = (image[k] & IMGMASK) - IMGMAX;
-          const int iy = (image[k] >> IMGBITS & IMGMASK) - IMGMAX;
-          const int iz = (image[k] >> IMG2BITS) - IMGMAX;
-
-          comm_buf[nme].x = x[k][0] + ix * xprd + iy * xy + iz * xz;
-          comm_buf[nme].y = x[k][1] + iy * yprd + iz * yz;
-          comm_buf[nme].z = x[k][2] + iz * zprd;
-        } else {
-          comm_buf[nme].x = x[k][0];
-          comm_buf[nme].y = x[k][1];
-          comm_buf[nme].z = x[k][2];
-        }
-
-        ++nme;
-      }
-    }
-    /* blocking receive to wait until it is our turn to send data. */
-    MPI_Recv(&tmp, 0, MPI_INT, 0, 0, world, MPI_STATUS_IGNORE);
-    MPI_Rsend(comm_buf, nme*size_one, MPI_BYTE, 0, 0, world);
   }
 
   ////////////////////////////////////////////////////////////////////////
@@ -807,27 +560,92 @@ void FixColvars::post_force(int /*vflag*/)
   MPI_Bcast(&energy, 1, MPI_DOUBLE, 0, world);
   MPI_Bcast(&store_forces, 1, MPI_INT, 0, world);
 
-  // broadcast and apply biasing forces
+  // send biasing forces only to the ranks that own the atoms, and apply them
+  scatter_forces();
+}
+
+/* ---------------------------------------------------------------------- */
+
+// send the forces applied by Colvars to the ranks that own the atoms, and
+// add them to the LAMMPS forces; ranks that own only a few of the atoms
+// that received a force get (position, force) records for those atoms,
+// the others get the forces of all the colvar atoms that they own
+
+void FixColvars::scatter_forces()
+{
+  int nforces = 0;
 
   if (me == 0) {
+    const int nprocs = comm->nprocs;
+    std::vector<cvm::rvector> const &fo = *(proxy->get_atom_applied_forces());
+    std::vector<int> const &fi = *(proxy->get_atoms_applied_force_indices());
+    const int nf = static_cast<int>(fi.size());
+
+    for (int iproc=0; iproc < nprocs; ++iproc) force_counts[iproc] = 0;
+    for (int n=0; n < nf; ++n) {
+      const int i = gather_position[fi[n]];
+      if (i >= 0) ++force_counts[gather_rank[i]];
+    }
+
+    int offset = 0;
+    for (int iproc=0; iproc < nprocs; ++iproc) {
+      if (SPARSE_FORCE_STRIDE*force_counts[iproc] < 3*gather_counts[iproc]) {
+        data_counts[iproc] = SPARSE_FORCE_STRIDE*force_counts[iproc];
+      } else {
+        force_counts[iproc] = -1;
+        data_counts[iproc] = 3*gather_counts[iproc];
+      }
+      data_displs[iproc] = force_offsets[iproc] = offset;
+      offset += data_counts[iproc];
+    }
 
-    std::vector<cvm::rvector> &fo = *(proxy->modify_atom_applied_forces());
+    for (int iproc=0; iproc < nprocs; ++iproc) {
+      if (force_counts[iproc] >= 0) continue;
+      for (int i=gather_displs[iproc]; i < gather_displs[iproc]+gather_counts[iproc]; ++i) {
+        const int j = gather_index[i];
+        double * const buf = gather_buf + force_offsets[iproc];
+        buf[0] = fo[j].x;
+        buf[1] = fo[j].y;
+        buf[2] = fo[j].z;
+        force_offsets[iproc] += 3;
+      }
+    }
 
-    double *fbuf = force_buf;
-    for (int j=0; j < num_coords; ++j) {
-      *fbuf++ = fo[j].x;
-      *fbuf++ = fo[j].y;
-      *fbuf++ = fo[j].z;
+    for (int n=0; n < nf; ++n) {
+      const int j = fi[n];
+      const int i = gather_position[j];
+      if (i < 0) continue;
+      const int iproc = gather_rank[i];
+      if (force_counts[iproc] < 0) continue;
+      double * const buf = gather_buf + force_offsets[iproc];
+      buf[0] = static_cast<double>(i - gather_displs[iproc]);
+      buf[1] = fo[j].x;
+      buf[2] = fo[j].y;
+      buf[3] = fo[j].z;
+      force_offsets[iproc] += SPARSE_FORCE_STRIDE;
     }
   }
-  MPI_Bcast(force_buf, 3*num_coords, MPI_DOUBLE, 0, world);
 
-  for (int i=0; i < num_coords; ++i) {
-    const tagint k = atom->map(taglist[i]);
-    if ((k >= 0) && (k < nlocal)) {
-      f[k][0] += force_buf[3*i+0];
-      f[k][1] += force_buf[3*i+1];
-      f[k][2] += force_buf[3*i+2];
+  MPI_Scatter(force_counts, 1, MPI_INT, &nforces, 1, MPI_INT, 0, world);
+  const int nrecv = (nforces < 0) ? 3*nlocal_coords : SPARSE_FORCE_STRIDE*nforces;
+  MPI_Scatterv(gather_buf, data_counts, data_displs, MPI_DOUBLE,
+               local_buf, nrecv, MPI_DOUBLE, 0, world);
+
+  double * const * const f = atom->f;
+  if (nforces < 0) {
+    for (int i=0; i < nlocal_coords; ++i) {
+      const int k = local_atom_index[i];
+      f[k][0] += local_buf[3*i+0];
+      f[k][1] += local_buf[3*i+1];
+      f[k][2] += local_buf[3*i+2];
+    }
+  } else {
+    for (int n=0; n < nforces; ++n) {
+      const double * const buf = local_buf + SPARSE_FORCE_STRIDE*n;
+      const int k = local_atom_index[static_cast<int>(buf[0])];
+      f[k][0] += buf[1];
+      f[k][1] += buf[2];
+      f[k][2] += buf[3];
     }
   }
 }
@@ -850,81 +668,28 @@ void FixColvars::end_of_step()
 {
   if (store_forces) {
 
-    const tagint * const tag = atom->tag;
-    double * const * const f = atom->f;
-    const int nlocal = atom->nlocal;
+    const double * const * const f = atom->f;
 
-    /* check and potentially grow local communication buffers. */
-    int i,nmax_new,nme=0;
-    for (i=0; i < num_coords; ++i) {
-      const tagint k = atom->map(taglist[i]);
-      if ((k >= 0) && (k < nlocal))
-        ++nme;
-    }
+    // collect total forces of the local atoms (no reneighboring since
+    // post_force(), so the same map applies)
 
-    MPI_Allreduce(&nme,&nmax_new,1,MPI_INT,MPI_MAX,world);
-    if (nmax_new > nmax) {
-      nmax = nmax_new;
-      memory->grow(comm_buf,nmax,"colvars:comm_buf");
+    for (int i=0; i < nlocal_coords; ++i) {
+      const int k = local_atom_index[i];
+      local_buf[3*i+0] = f[k][0];
+      local_buf[3*i+1] = f[k][1];
+      local_buf[3*i+2] = f[k][2];
     }
 
-    MPI_Status status;
-    MPI_Request request;
-    int tmp, ndata;
+    gather_atom_data(3);
 
     if (me == 0) {
-
-      // store old force data
       std::vector<cvm::rvector> &of = *(proxy->modify_atom_total_forces());
-
-      for (i=0; i<num_coords; ++i) {
-        const tagint k = atom->map(taglist[i]);
-        if ((k >= 0) && (k < nlocal)) {
-
-          const int j = inthash_lookup(idmap, tag[k]);
-          if (j != HASH_FAIL) {
-            of[j].x = f[k][0];
-            of[j].y = f[k][1];
-            of[j].z = f[k][2];
-          }
-        }
+      for (int i=0; i < ngathered; ++i) {
+        const int j = gather_index[i];
+        of[j].x = gather_buf[3*i+0];
+        of[j].y = gather_buf[3*i+1];
+        of[j].z = gather_buf[3*i+2];
       }
-
-      /* loop over procs to receive remote data */
-      for (i=1; i < comm->nprocs; ++i) {
-        int maxbuf = nmax*size_one;
-        MPI_Irecv(comm_buf, maxbuf, MPI_BYTE, i, 0, world, &request);
-        MPI_Send(&tmp, 0, MPI_INT, i, 0, world);
-        MPI_Wait(&request, &status);
-        MPI_Get_count(&status, MPI_BYTE, &ndata);
-        ndata /= size_one;
-
-        for (int k=0; k<ndata; ++k) {
-          const int j = inthash_lookup(idmap, comm_buf[k].tag);
-          if (j != HASH_FAIL) {
-            of[j].x = comm_buf[k].x;
-            of[j].y = comm_buf[k].y;
-            of[j].z = comm_buf[k].z;
-          }
-        }
-      }
-
-    } else { // me != 0
-      /* copy total force data into communication buffer */
-      nme = 0;
-      for (i=0; i<num_coords; ++i) {
-        const tagint k = atom->map(taglist[i]);
-        if ((k >= 0) && (k < nlocal)) {
-          comm_buf[nme].tag  = tag[k];
-          comm_buf[nme].x    = f[k][0];
-          comm_buf[nme].y    = f[k][1];
-          comm_buf[nme].z    = f[k][2];
-          ++nme;
-        }
-      }
-      /* blocking receive to wait until it is our turn to send data. */
-      MPI_Recv(&tmp, 0, MPI_INT, 0, 0, world, MPI_STATUS_IGNORE);
-      MPI_Rsend(comm_buf, nme*size_one, MPI_BYTE, 0, 0, world);
     }
   }
 }
@@ -979,7 +744,10 @@ double FixColvars::compute_scalar()
 /* local memory usage. approximately. */
 double FixColvars::memory_usage()
 {
-  double bytes = (double) (num_coords * (2*sizeof(int)+3*sizeof(double)));
-  bytes += (double)(double) (nmax*size_one) + sizeof(this);
+  double bytes = (double) (num_coords * sizeof(tagint));
+  bytes += (double) (nmax_local * (2*sizeof(int)+SETUP_STRIDE*sizeof(double)));
+  if (me == 0)
+    bytes += (double) (num_coords * (sizeof(int)+SETUP_STRIDE*sizeof(double)));
+  bytes += (double) sizeof(this);
   return bytes;
 }
@@ -75,13 +75,23 @@ class FixColvars : public Fix {
   int num_coords;     // total number of atoms controlled by this fix
   tagint *taglist;    // list of all atom IDs referenced by colvars.
 
-  int nmax;                     // size of atom communication buffer.
-  int size_one;                 // bytes per atom in communication buffer.
-  struct commdata *comm_buf;    // communication buffer
-  double *force_buf;            // communication buffer
-
-  void *idmap;       // hash for mapping atom indices to consistent order.
-  int *rev_idmap;    // list of the hash keys for reverse mapping.
+  int nlocal_coords;         // number of colvar atoms owned by this rank
+  int nmax_local;            // allocated size of the local arrays
+  int *local_atom_index;     // local LAMMPS indices of the owned colvar atoms
+  int *local_coord_index;    // indices of the owned atoms in the colvars arrays
+  double *local_buf;         // per-atom data of the owned atoms
+
+  int ngathered;             // number of atoms gathered on the master
+  int *gather_counts;        // number of colvar atoms owned by each rank
+  int *gather_displs;        // offset of each rank in the gathered arrays
+  int *gather_index;         // colvars index of each gathered atom
+  int *data_counts;          // gather_counts times values per atom
+  int *data_displs;          // gather_displs times values per atom
+  double *gather_buf;        // per-atom data of all colvar atoms (master only)
+  int *gather_rank;          // rank that owns each gathered atom
+  int *gather_position;      // position of each colvars atom in gather_index
+  int *force_counts;         // number of forces sent to each rank (-1: all)
+  int *force_offsets;        // next free slot of each rank in gather_buf
 
   int nlevels_respa;       // flag to determine respa levels.
   int store_forces;        // flag to determine whether to store total forces
@@ -91,6 +101,10 @@ class FixColvars : public Fix {
                            // only supports one instance at a time
   MPI_Comm root2root;      // inter-root communicator for multi-replica support
   void one_time_init();    // one time initialization
+  void update_local_map();          // find atoms owned by this rank
+  void pack_positions(int stride);  // copy positions of owned atoms
+  void gather_atom_data(int stride);     // collect per-atom data on master
+  void scatter_forces();                 // send applied forces to owners
 };
 
 }    // namespace LAMMPS_NS
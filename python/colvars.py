@@ -15,6 +15,41 @@ class colvarscript:
         else:
             return 'Colvarscript error.'
 
+    # Dtypes matching the COLVARSCRIPT_RESULT_* constants in colvarscript.h
+    _result_ctypes = { 1: ctypes.c_int, 2: ctypes.c_long, 3: ctypes.c_double }
+
+    def run_array(self, cmd, copy=False):
+        """Run a command and return its result as a NumPy array
+
+        By default, the array is a view of the Colvars-owned data (no copy is
+        made), which is only valid until the next call; use copy=True to keep
+        the result.  Returns None if the result is not available as an array.
+        """
+        import numpy
+        args = [a.encode('utf-8') for a in ['cv'] + cmd.split()]
+        self._interp.run_colvarscript_command_binary.argtypes = \
+            [ctypes.c_int, ctypes.POINTER(ctypes.c_char_p)]
+        self._interp.get_colvarscript_result_binary.argtypes = \
+            [ctypes.POINTER(ctypes.c_void_p), ctypes.POINTER(ctypes.c_int),
+             ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_size_t)]
+        if (self._interp.run_colvarscript_command_binary(len(args), \
+             (ctypes.c_char_p * len(args))(*args)) != 0):
+            return None
+        data = ctypes.c_void_p()
+        dtype = ctypes.c_int()
+        ndim = ctypes.c_int()
+        shape = (ctypes.c_size_t * 2)()
+        if (self._interp.get_colvarscript_result_binary( \
+             ctypes.byref(data), ctypes.byref(dtype), ctypes.byref(ndim), \
+             shape) != 0):
+            return None
+        dims = tuple(shape[:ndim.value])
+        ptr = ctypes.cast(data, ctypes.POINTER(self._result_ctypes[dtype.value]))
+        if (numpy.prod(dims) == 0):
+            return numpy.zeros(dims, dtype=ptr._type_)
+        result = numpy.ctypeslib.as_array(ptr, shape=dims)
+        return result.copy() if copy else result
+
 if __name__ == '__main__':
     # Example use
     cv = colvarscript()
@@ -22,4 +57,7 @@ if __name__ == '__main__':
     for b in cv.run('list biases').split():
         energy = float(cv.run("bias %s energy" % b))
         sys.stdout.write("Energy[%s] = %f\n" % (b, energy))
+    positions = cv.run_array('getatompositions')
+    if positions is not None:
+        sys.stdout.write("Positions array of shape %s\n" % str(positions.shape))
 
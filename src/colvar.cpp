@@ -8,6 +8,8 @@
 // Colvars repository at GitHub.
 
 #include <list>
+#include <map>
+#include <set>
 #include <vector>
 #include <algorithm>
 #include <iostream>
@@ -29,14 +31,11 @@ colvar::colvar()
   runave_os = NULL;
 
   prev_timestep = -1L;
+  cvc_gradients_deferred = false;
   after_restart = false;
   kinetic_energy = 0.0;
   potential_energy = 0.0;
 
-#ifdef LEPTON
-  dev_null = 0.0;
-#endif
-
   expand_boundaries = false;
 
   description = "uninitialized colvar";
@@ -279,6 +278,7 @@ int colvar::init(std::string const &conf)
   ft_reported.type(value());
   f_old.type(value());
   f_old.reset();
+  f_cvc.type(value());
 
   x_restart.type(value());
 
@@ -323,7 +323,6 @@ int colvar::init_custom_function(std::string const &conf)
   std::vector<Lepton::ParsedExpression> pexprs;
   Lepton::ParsedExpression pexpr;
   size_t pos = 0; // current position in config string
-  double *ref;
 
   if (!key_lookup(conf, "customFunction", &expr_in, &pos)) {
     return COLVARS_OK;
@@ -334,6 +333,24 @@ int colvar::init_custom_function(std::string const &conf)
   enable(f_cv_custom_function);
   cvm::log("This colvar uses a custom function.\n");
 
+  // Names of the scalar variables: one per CVC, or one per element of a
+  // vector-valued CVC
+  std::vector<std::string> input_names;
+  for (size_t i = 0; i < cvcs.size(); i++) {
+    for (size_t j = 0; j < cvcs[i]->value().size(); j++) {
+      input_names.push_back(cvcs[i]->name +
+                            (cvcs[i]->value().size() > 1 ? cvm::to_str(j+1) : ""));
+    }
+  }
+
+  // All evaluators read their variables from the same array, which is filled
+  // once per step by load_custom_function_inputs()
+  custom_function_inputs.assign(input_names.size(), 0.0);
+  std::map<std::string, double *> input_locations;
+  for (size_t k = 0; k < input_names.size(); k++) {
+    input_locations[input_names[k]] = &(custom_function_inputs[k]);
+  }
+
   do {
     expr = expr_in;
     if (cvm::debug())
@@ -350,22 +367,13 @@ int colvar::init_custom_function(std::string const &conf)
     try {
       value_evaluators.push_back(
           new Lepton::CompiledExpression(pexpr.createCompiledExpression()));
-      // Define variables for cvc values
-      // Stored in order: expr1, cvc1, cvc2, expr2, cvc1...
-      for (size_t i = 0; i < cvcs.size(); i++) {
-        for (size_t j = 0; j < cvcs[i]->value().size(); j++) {
-          std::string vn = cvcs[i]->name +
-              (cvcs[i]->value().size() > 1 ? cvm::to_str(j+1) : "");
-          try {
-            ref =&value_evaluators.back()->getVariableReference(vn);
-          }
-          catch (...) { // Variable is absent from expression
-            // To keep the same workflow, we use a pointer to a double here
-            // that will receive CVC values - even though none was allocated by Lepton
-            ref = &dev_null;
-            cvm::log("Warning: Variable " + vn + " is absent from expression \"" + expr + "\".\n");
-          }
-          value_eval_var_refs.push_back(ref);
+      value_evaluators.back()->setVariableLocations(input_locations);
+      std::set<std::string> const &variables =
+        value_evaluators.back()->getVariables();
+      for (size_t k = 0; k < input_names.size(); k++) {
+        if (variables.find(input_names[k]) == variables.end()) {
+          cvm::log("Warning: Variable " + input_names[k] +
+                   " is absent from expression \"" + expr + "\".\n");
         }
       }
     }
@@ -376,40 +384,40 @@ int colvar::init_custom_function(std::string const &conf)
   } while (key_lookup(conf, "customFunction", &expr_in, &pos));
 
 
-  // Now define derivative with respect to each scalar sub-component
-  for (size_t i = 0; i < cvcs.size(); i++) {
-    for (size_t j = 0; j < cvcs[i]->value().size(); j++) {
-      std::string vn = cvcs[i]->name +
-          (cvcs[i]->value().size() > 1 ? cvm::to_str(j+1) : "");
-      // Element ordering: we want the
-      // gradient vector of derivatives of all elements of the colvar
-      // wrt to a given element of a cvc ([i][j])
-      for (size_t c = 0; c < pexprs.size(); c++) {
-        gradient_evaluators.push_back(
-            new Lepton::CompiledExpression(pexprs[c].differentiate(vn).createCompiledExpression()));
-        // and record the refs to each variable in those expressions
-        for (size_t k = 0; k < cvcs.size(); k++) {
-          for (size_t l = 0; l < cvcs[k]->value().size(); l++) {
-            std::string vvn = cvcs[k]->name +
-                (cvcs[k]->value().size() > 1 ? cvm::to_str(l+1) : "");
-            try {
-              ref = &gradient_evaluators.back()->getVariableReference(vvn);
-            }
-            catch (...) { // Variable is absent from derivative
-              // To keep the same workflow, we use a pointer to a double here
-              // that will receive CVC values - even though none was allocated by Lepton
-              if (cvm::debug()) {
-                cvm::log("Warning: Variable " + vvn + " is absent from derivative of \"" + expr + "\" wrt " + vn + ".\n");
-              }
-              ref = &dev_null;
-            }
-            grad_eval_var_refs.push_back(ref);
-          }
+  // Now define the derivatives of all elements of the colvar with respect to
+  // each scalar input ([k][c] ordering); those that simplify to a constant
+  // (most often zero) are stored as numbers and never evaluated
+  for (size_t k = 0; k < input_names.size(); k++) {
+    for (size_t c = 0; c < pexprs.size(); c++) {
+      try {
+        Lepton::ParsedExpression const dexpr =
+          pexprs[c].differentiate(input_names[k]).optimize();
+        if (dexpr.getRootNode().getOperation().getId() ==
+            Lepton::Operation::CONSTANT) {
+          gradient_evaluator_index.push_back(-1);
+          gradient_constants.push_back(dexpr.evaluate());
+        } else {
+          gradient_evaluator_index.push_back(int(gradient_evaluators.size()));
+          gradient_constants.push_back(0.0);
+          gradient_evaluators.push_back(
+              new Lepton::CompiledExpression(dexpr.createCompiledExpression()));
+          gradient_evaluators.back()->setVariableLocations(input_locations);
         }
       }
+      catch (...) {
+        cvm::error("Error differentiating expression with respect to " +
+                   input_names[k] + ".\n", COLVARS_INPUT_ERROR);
+        return COLVARS_INPUT_ERROR;
+      }
     }
   }
 
+  if (cvm::debug()) {
+    cvm::log("Compiled " + cvm::to_str(gradient_evaluators.size()) +
+             " non-constant derivatives out of " +
+             cvm::to_str(gradient_evaluator_index.size()) + ".\n");
+  }
+
 
   if (value_evaluators.size() == 0) {
     cvm::error("Error: no custom function defined.\n", COLVARS_INPUT_ERROR);
@@ -461,6 +469,18 @@ int colvar::init_custom_function(std::string const &conf)
   return COLVARS_OK;
 }
 
+
+void colvar::load_custom_function_inputs()
+{
+  size_t k = 0;
+  for (size_t i = 0; i < cvcs.size(); i++) {
+    colvarvalue const &cvc_value = cvcs[i]->value();
+    for (size_t j = 0; j < cvc_value.size(); j++) {
+      custom_function_inputs[k++] = cvc_value[j];
+    }
+  }
+}
+
 #else
 
 int colvar::init_custom_function(std::string const &conf)
@@ -911,6 +931,7 @@ int colvar::init_components(std::string const &conf)
   error_code |= init_components_type<neuralNetwork>(conf, "neural network CV for other CVs", "NeuralNetwork");
 
   error_code |= init_components_type<map_total>(conf, "total value of atomic map", "mapTotal");
+  error_code |= init_components_type<plugin>(conf, "component loaded from a plugin library", "plugin");
 #if (__cplusplus >= 201103L)
   // iterate over all available CVC in the map
   for (auto it = global_cvc_map.begin(); it != global_cvc_map.end(); ++it) {
@@ -1001,6 +1022,18 @@ void colvar::build_atom_list(void)
 
   temp_id_list.clear();
 
+  // Map the atoms of each group onto the list, so that collect_gradients()
+  // does not need to search it at every step
+  for (size_t i = 0; i < cvcs.size(); i++) {
+    for (size_t j = 0; j < cvcs[i]->atom_groups.size(); j++) {
+      cvm::atom_group &ag = *(cvcs[i]->atom_groups[j]);
+      ag.update_collect_index(atom_ids);
+      if (ag.is_enabled(f_ag_fitting_group) && ag.is_enabled(f_ag_fit_gradients)) {
+        ag.fitting_group->update_collect_index(atom_ids);
+      }
+    }
+  }
+
   atomic_gradients.resize(atom_ids.size());
   if (atom_ids.size()) {
     if (cvm::debug())
@@ -1373,7 +1406,9 @@ int colvar::calc_cvcs(int first_cvc, size_t num_cvcs)
   }
   // atom coordinates are updated by the next line
   error_code |= calc_cvc_values(first_cvc, num_cvcs);
-  error_code |= calc_cvc_gradients(first_cvc, num_cvcs);
+  if (!cvc_gradients_deferred) {
+    error_code |= calc_cvc_gradients(first_cvc, num_cvcs);
+  }
   error_code |= calc_cvc_Jacobians(first_cvc, num_cvcs);
   if (proxy->total_forces_same_step()){
     // Use Jacobian derivative from this timestep
@@ -1387,6 +1422,26 @@ int colvar::calc_cvcs(int first_cvc, size_t num_cvcs)
 }
 
 
+bool colvar::can_defer_cvc_gradients() const
+{
+  if (!is_enabled(f_cv_gradient)) {
+    return false;
+  }
+  // These features use the gradients at every step, regardless of the force
+  if (is_enabled(f_cv_collect_gradient) ||
+      is_enabled(f_cv_total_force_calc) ||
+      is_enabled(f_cv_Jacobian)) {
+    return false;
+  }
+  for (size_t i = 0; i < cvcs.size(); i++) {
+    if (cvcs[i]->is_enabled(f_cvc_debug_gradient)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
 int colvar::collect_cvc_data()
 {
   if (cvm::debug())
@@ -1444,8 +1499,14 @@ int colvar::calc_cvc_values(int first_cvc, size_t num_cvcs)
        i++) {
     if (!cvcs[i]->is_enabled()) continue;
     cvc_count++;
-    (cvcs[i])->read_data();
-    (cvcs[i])->calc_value();
+    {
+      cvm::profile_timer const timer(cvcs[i]->read_data_profile_slot);
+      (cvcs[i])->read_data();
+    }
+    {
+      cvm::profile_timer const timer(cvcs[i]->calc_value_profile_slot);
+      (cvcs[i])->calc_value();
+    }
     if (cvm::debug())
       cvm::log("Colvar component no. "+cvm::to_str(i+1)+
                 " within colvar \""+this->name+"\" has value "+
@@ -1478,15 +1539,8 @@ int colvar::collect_cvc_values()
 #ifdef LEPTON
   } else if (is_enabled(f_cv_custom_function)) {
 
-    size_t l = 0; // index in the vector of variable references
-
+    load_custom_function_inputs();
     for (size_t i = 0; i < x.size(); i++) {
-      // Fill Lepton evaluator variables with CVC values, serialized into scalars
-      for (size_t j = 0; j < cvcs.size(); j++) {
-        for (size_t k = 0; k < cvcs[j]->value().size(); k++) {
-          *(value_eval_var_refs[l++]) = cvcs[j]->value()[k];
-        }
-      }
       x[i] = value_evaluators[i]->evaluate();
     }
 #endif
@@ -1547,6 +1601,7 @@ int colvar::calc_cvc_gradients(int first_cvc, size_t num_cvcs)
     cvc_count++;
 
     if ((cvcs[i])->is_enabled(f_cvc_gradient)) {
+      cvm::profile_timer const timer(cvcs[i]->calc_gradients_profile_slot);
       (cvcs[i])->calc_gradients();
       // if requested, propagate (via chain rule) the gradients above
       // to the atoms used to define the roto-translation
@@ -1935,6 +1990,18 @@ void colvar::communicate_forces()
     cvm::log("Force to be applied: " + cvm::to_str(f) + "\n");
   }
 
+  bool const gradients_deferred = cvc_gradients_deferred;
+  cvc_gradients_deferred = false;
+
+  if (gradients_deferred) {
+    if (f.norm2() == 0.0) {
+      // No bias acts on this variable at this step: there is nothing to
+      // apply, and the gradients are not needed
+      return;
+    }
+    calc_cvc_gradients(0, num_active_cvcs());
+  }
+
   if (is_enabled(f_cv_scripted)) {
     std::vector<cvm::matrix2d<cvm::real> > func_grads;
     func_grads.reserve(cvcs.size());
@@ -1957,6 +2024,7 @@ void colvar::communicate_forces()
     int grad_index = 0; // index in the scripted gradients, to account for some components being disabled
     for (i = 0; i < cvcs.size(); i++) {
       if (!cvcs[i]->is_enabled()) continue;
+      cvm::profile_timer const timer(cvcs[i]->apply_force_profile_slot);
       // cvc force is colvar force times colvar/cvc Jacobian
       // (vector-matrix product)
       (cvcs[i])->apply_force(colvarvalue(f.as_vector() * func_grads[grad_index++],
@@ -1966,23 +2034,20 @@ void colvar::communicate_forces()
 #ifdef LEPTON
   } else if (is_enabled(f_cv_custom_function)) {
 
-    size_t r = 0; // index in the vector of variable references
-    size_t e = 0; // index of the gradient evaluator
+    load_custom_function_inputs();
+
+    size_t g = 0; // index of the derivative, in [input][element] order
 
     for (i = 0; i < cvcs.size(); i++) {  // gradient with respect to cvc i
       cvm::matrix2d<cvm::real> jacobian (x.size(), cvcs[i]->value().size());
       for (size_t j = 0; j < cvcs[i]->value().size(); j++) { // j-th element
-        for (size_t c = 0; c < x.size(); c++) { // derivative of scalar element c of the colvarvalue
-
-          // Feed cvc values to the evaluator
-          for (size_t k = 0; k < cvcs.size(); k++) { //
-            for (size_t l = 0; l < cvcs[k]->value().size(); l++) {
-              *(grad_eval_var_refs[r++]) = cvcs[k]->value()[l];
-            }
-          }
-          jacobian[c][j] = gradient_evaluators[e++]->evaluate();
+        for (size_t c = 0; c < x.size(); c++, g++) { // derivative of scalar element c of the colvarvalue
+          int const e = gradient_evaluator_index[g];
+          jacobian[c][j] = (e < 0) ? gradient_constants[g] :
+            gradient_evaluators[e]->evaluate();
         }
       }
+      cvm::profile_timer const timer(cvcs[i]->apply_force_profile_slot);
       // cvc force is colvar force times colvar/cvc Jacobian
       // (vector-matrix product)
       (cvcs[i])->apply_force(colvarvalue(f.as_vector() * jacobian,
@@ -1994,6 +2059,7 @@ void colvar::communicate_forces()
 
     for (i = 0; i < cvcs.size(); i++) {
       if (!cvcs[i]->is_enabled()) continue;
+      cvm::profile_timer const timer(cvcs[i]->apply_force_profile_slot);
       (cvcs[i])->apply_force(f * (cvcs[i])->sup_coeff *
                              cvm::real((cvcs[i])->sup_np) *
                              (cvm::integer_power((cvcs[i])->value().real_value,
@@ -2004,7 +2070,14 @@ void colvar::communicate_forces()
 
     for (i = 0; i < cvcs.size(); i++) {
       if (!cvcs[i]->is_enabled()) continue;
-      (cvcs[i])->apply_force(f * (cvcs[i])->sup_coeff);
+      cvm::profile_timer const timer(cvcs[i]->apply_force_profile_slot);
+      if ((cvcs[i])->sup_coeff == 1.0) {
+        (cvcs[i])->apply_force(f);
+      } else {
+        f_cvc = f;
+        f_cvc *= (cvcs[i])->sup_coeff;
+        (cvcs[i])->apply_force(f_cvc);
+      }
     }
   }
 
@@ -2057,6 +2130,9 @@ int colvar::update_cvc_flags()
     update_active_cvc_square_norm();
   }
 
+  // Also called before the CVCs are computed in parallel
+  cvc_gradients_deferred = can_defer_cvc_gradients();
+
   return COLVARS_OK;
 }
 
@@ -2214,6 +2290,17 @@ colvarvalue colvar::dist2_lgrad(colvarvalue const &x1,
   }
 }
 
+void colvar::dist2_lgrad(colvarvalue const &x1, colvarvalue const &x2,
+                         colvarvalue &grad) const
+{
+  if (x1.type() == colvarvalue::type_vector) {
+    // Components with vector values do not redefine the metric
+    x1.dist2_grad(x2, grad);
+  } else {
+    grad = dist2_lgrad(x1, x2);
+  }
+}
+
 colvarvalue colvar::dist2_rgrad(colvarvalue const &x1,
                                  colvarvalue const &x2) const
 {
@@ -2526,6 +2613,139 @@ std::ostream & colvar::write_traj(std::ostream &os)
 }
 
 
+namespace {
+
+  /// Read the components of a value from the given column of a frame
+  bool read_traj_binary_value(std::map<std::string, size_t> const &columns,
+                              std::string const &label,
+                              std::vector<cvm::real> const &frame,
+                              colvarvalue &x)
+  {
+    std::map<std::string, size_t>::const_iterator const col =
+      columns.find(label);
+    if ((col == columns.end()) || (col->second + x.size() > frame.size())) {
+      return false;
+    }
+    for (size_t i = 0; i < x.size(); i++) {
+      x[i] = frame[col->second + i];
+    }
+    return true;
+  }
+}
+
+
+std::ostream & colvar::write_traj_binary_label(std::ostream &os)
+{
+  bool const extended = is_enabled(f_cv_extended_Lagrangian) &&
+    !is_enabled(f_cv_external);
+
+  if (is_enabled(f_cv_output_value)) {
+    cvm::write_traj_binary_column(os, name, x);
+    if (extended) {
+      cvm::write_traj_binary_column(os, "r_"+name, x);
+    }
+  }
+
+  if (is_enabled(f_cv_output_velocity)) {
+    cvm::write_traj_binary_column(os, "v_"+name, x);
+    if (extended) {
+      cvm::write_traj_binary_column(os, "vr_"+name, x);
+    }
+  }
+
+  if (is_enabled(f_cv_output_energy)) {
+    os << "Ep_" << name << " scalar 1\n"
+       << "Ek_" << name << " scalar 1\n";
+  }
+
+  if (is_enabled(f_cv_output_total_force)) {
+    cvm::write_traj_binary_column(os, "ft_"+name, x);
+  }
+
+  if (is_enabled(f_cv_output_applied_force)) {
+    cvm::write_traj_binary_column(os, "fa_"+name, x);
+  }
+
+  return os;
+}
+
+
+void colvar::write_traj_binary(std::vector<cvm::real> &frame) const
+{
+  // Same columns as write_traj(), without formatting
+  bool const extended = is_enabled(f_cv_extended_Lagrangian) &&
+    !is_enabled(f_cv_external);
+
+  if (is_enabled(f_cv_output_value)) {
+    if (extended) {
+      cvm::append_traj_binary(frame, x);
+    }
+    cvm::append_traj_binary(frame, x_reported);
+  }
+
+  if (is_enabled(f_cv_output_velocity)) {
+    if (extended) {
+      cvm::append_traj_binary(frame, v_fdiff);
+    }
+    cvm::append_traj_binary(frame, v_reported);
+  }
+
+  if (is_enabled(f_cv_output_energy)) {
+    frame.push_back(potential_energy);
+    frame.push_back(kinetic_energy);
+  }
+
+  if (is_enabled(f_cv_output_total_force)) {
+    cvm::append_traj_binary(frame, ft_reported);
+  }
+
+  if (is_enabled(f_cv_output_applied_force)) {
+    cvm::append_traj_binary(frame, is_enabled(f_cv_extended_Lagrangian) ? fr : f);
+  }
+}
+
+
+int colvar::read_traj_binary(std::map<std::string, size_t> const &columns,
+                             std::vector<cvm::real> const &frame)
+{
+  // Same variables as read_traj()
+  if (is_enabled(f_cv_output_value)) {
+    if (!read_traj_binary_value(columns, name, frame, x)) {
+      return cvm::error("Error: in reading the value of colvar \""+
+                        this->name+"\" from trajectory.\n",
+                        COLVARS_FILE_ERROR);
+    }
+    if (is_enabled(f_cv_extended_Lagrangian) &&
+        read_traj_binary_value(columns, "r_"+name, frame, x_ext)) {
+      x_reported = x_ext;
+    } else {
+      x_reported = x;
+    }
+  }
+
+  if (is_enabled(f_cv_output_velocity) &&
+      read_traj_binary_value(columns, "v_"+name, frame, v_fdiff)) {
+    if (is_enabled(f_cv_extended_Lagrangian) &&
+        read_traj_binary_value(columns, "vr_"+name, frame, v_ext)) {
+      v_reported = v_ext;
+    } else {
+      v_reported = v_fdiff;
+    }
+  }
+
+  if (is_enabled(f_cv_output_total_force) &&
+      read_traj_binary_value(columns, "ft_"+name, frame, ft)) {
+    ft_reported = ft;
+  }
+
+  if (is_enabled(f_cv_output_applied_force)) {
+    read_traj_binary_value(columns, "fa_"+name, frame, f);
+  }
+
+  return COLVARS_OK;
+}
+
+
 int colvar::write_output_files()
 {
   int error_code = COLVARS_OK;
@@ -219,6 +219,9 @@ public:
   /// Applied force at the previous step (to be subtracted from total force if needed)
   colvarvalue f_old;
 
+  /// Force applied to each component (work buffer for communicate_forces())
+  colvarvalue f_cvc;
+
   /// \brief Total force, as derived from the atomic trajectory;
   /// should equal the system force plus \link f \endlink
   colvarvalue ft;
@@ -310,6 +313,9 @@ public:
   int calc_cvc_values(int first, size_t num_cvcs);
   /// \brief Same as \link colvar::calc_cvc_values \endlink but for gradients
   int calc_cvc_gradients(int first, size_t num_cvcs);
+  /// \brief Whether the CVC gradients can be computed in communicate_forces()
+  /// rather than in calc(), i.e. only when a non-zero force is applied
+  bool can_defer_cvc_gradients() const;
   /// \brief Same as \link colvar::calc_cvc_values \endlink but for total forces
   int calc_cvc_total_force(int first, size_t num_cvcs);
   /// \brief Same as \link colvar::calc_cvc_values \endlink but for Jacobian derivatives/forces
@@ -341,11 +347,12 @@ public:
   /// Set the total biasing force to zero
   void reset_bias_force();
 
-  /// Add to the total force from biases
-  void add_bias_force(colvarvalue const &force);
+  /// Add to the total force from biases (optionally multiplied by scale)
+  void add_bias_force(colvarvalue const &force, cvm::real scale = 1.0);
 
   /// Apply a force to the actual value (only meaningful with extended Lagrangian)
-  void add_bias_force_actual_value(colvarvalue const &force);
+  void add_bias_force_actual_value(colvarvalue const &force,
+                                   cvm::real scale = 1.0);
 
   /// \brief Collect all forces on this colvar, integrate internal
   /// equations of motion of internal degrees of freedom; see also
@@ -363,7 +370,8 @@ public:
   /// \brief Enables and disables individual CVCs based on the given array
   int set_cvc_flags(std::vector<bool> const &flags);
 
-  /// \brief Updates the flags in the CVC objects, and their number
+  /// \brief Updates the flags in the CVC objects, and their number, and
+  /// whether their gradients can be deferred at this step
   int update_cvc_flags();
 
   /// \brief Modify the configuration of CVCs (currently, only base class data)
@@ -398,6 +406,10 @@ protected:
   /// \brief Absolute timestep number when this colvar was last updated
   cvm::step_number prev_timestep;
 
+  /// \brief Whether the CVC gradients of this step are left to
+  /// communicate_forces() (see can_defer_cvc_gradients())
+  bool cvc_gradients_deferred;
+
 public:
 
   /// \brief Number of dimensions of the value of this colvar
@@ -433,6 +445,11 @@ public:
   colvarvalue dist2_lgrad(colvarvalue const &x1,
                           colvarvalue const &x2) const;
 
+  /// \brief Same as dist2_lgrad(x1, x2), but stores the result in grad,
+  /// whose storage is reused for vector values
+  void dist2_lgrad(colvarvalue const &x1, colvarvalue const &x2,
+                   colvarvalue &grad) const;
+
   /// \brief Use the internal metrics (as from \link colvar::cvc
   /// \endlink objects) to calculate square distances and gradients
   ///
@@ -460,6 +477,18 @@ public:
   /// Write a label to the trajectory file (comment line)
   std::ostream & write_traj_label(std::ostream &os);
 
+  /// \brief Describe the columns of the binary trajectory, one per line:
+  /// label, type of value and number of components
+  std::ostream & write_traj_binary_label(std::ostream &os);
+
+  /// Append the values of the binary trajectory columns to frame
+  void write_traj_binary(std::vector<cvm::real> &frame) const;
+
+  /// \brief Read the values from a frame of a binary trajectory, given the
+  /// position of the first component of each column
+  int read_traj_binary(std::map<std::string, size_t> const &columns,
+                       std::vector<cvm::real> const &frame);
+
   /// Read the collective variable from a restart file
   std::istream & read_state(std::istream &is);
   /// Write the collective variable to a restart file
@@ -628,6 +657,9 @@ public:
   // components that do not handle any atoms directly
   class map_total;
 
+  // components loaded from a shared library
+  class plugin;
+
   /// getter of the global cvc map
 #if (__cplusplus >= 201103L)
   /// A global mapping of cvc names to the cvc constructors
@@ -662,15 +694,24 @@ protected:
   /// Vector of evaluators for custom functions using Lepton
   std::vector<Lepton::CompiledExpression *> value_evaluators;
 
-  /// Vector of evaluators for gradients of custom functions
+  /// Vector of evaluators for the non-constant gradients of custom functions
   std::vector<Lepton::CompiledExpression *> gradient_evaluators;
 
-  /// Vector of references to cvc values to be passed to Lepton evaluators
-  std::vector<double *> value_eval_var_refs;
-  std::vector<double *> grad_eval_var_refs;
+  /// \brief For each scalar CVC input and each element of the colvar (in this
+  /// order), index of the derivative in gradient_evaluators, or -1 if it is
+  /// constant
+  std::vector<int> gradient_evaluator_index;
+
+  /// Values of the derivatives that simplify to constants (same indexing as
+  /// gradient_evaluator_index)
+  std::vector<cvm::real> gradient_constants;
 
-  /// Unused value that is written to when a variable simplifies out of a Lepton expression
-  double dev_null;
+  /// \brief Current values of the CVCs serialized into scalars; all Lepton
+  /// evaluators read their variables from this array
+  std::vector<double> custom_function_inputs;
+
+  /// Copy the current CVC values into custom_function_inputs
+  void load_custom_function_inputs();
 #endif
 
 #if (__cplusplus >= 201103L)
@@ -736,23 +777,27 @@ inline colvarvalue const & colvar::total_force() const
 }
 
 
-inline void colvar::add_bias_force(colvarvalue const &force)
+inline void colvar::add_bias_force(colvarvalue const &force, cvm::real scale)
 {
-  check_enabled(f_cv_gradient,
-                std::string("applying a force to the variable \""+name+"\""));
+  if (!is_enabled(f_cv_gradient)) {
+    // Only build the message when needed
+    check_enabled(f_cv_gradient,
+                  std::string("applying a force to the variable \""+name+"\""));
+  }
   if (cvm::debug()) {
-    cvm::log("Adding biasing force "+cvm::to_str(force)+" to colvar \""+name+"\".\n");
+    cvm::log("Adding biasing force "+cvm::to_str(scale * force)+" to colvar \""+name+"\".\n");
   }
-  fb += force;
+  fb.add_scaled(force, scale);
 }
 
 
-inline void colvar::add_bias_force_actual_value(colvarvalue const &force)
+inline void colvar::add_bias_force_actual_value(colvarvalue const &force,
+                                                cvm::real scale)
 {
   if (cvm::debug()) {
-    cvm::log("Adding biasing force "+cvm::to_str(force)+" to colvar \""+name+"\".\n");
+    cvm::log("Adding biasing force "+cvm::to_str(scale * force)+" to colvar \""+name+"\".\n");
   }
-  fb_actual += force;
+  fb_actual.add_scaled(force, scale);
 }
 
 
@@ -21,9 +21,10 @@
 
 cvm::atom::atom()
 {
-  index = -1;
+  use_own_data();
+  own_index = -1;
   id = -1;
-  mass = 1.0;
+  own_mass = 1.0;
   charge = 0.0;
   reset_data();
 }
@@ -31,13 +32,14 @@ cvm::atom::atom()
 
 cvm::atom::atom(int atom_number)
 {
+  use_own_data();
   colvarproxy *p = cvm::proxy;
-  index = p->init_atom(atom_number);
+  own_index = p->init_atom(atom_number);
   if (cvm::debug()) {
     cvm::log("The index of this atom in the colvarproxy arrays is "+
-             cvm::to_str(index)+".\n");
+             cvm::to_str(own_index)+".\n");
   }
-  id = p->get_atom_id(index);
+  id = p->get_atom_id(own_index);
   update_mass();
   update_charge();
   reset_data();
@@ -48,13 +50,14 @@ cvm::atom::atom(cvm::residue_id const &residue,
                 std::string const     &atom_name,
                 std::string const     &segment_id)
 {
+  use_own_data();
   colvarproxy *p = cvm::proxy;
-  index = p->init_atom(residue, atom_name, segment_id);
+  own_index = p->init_atom(residue, atom_name, segment_id);
   if (cvm::debug()) {
     cvm::log("The index of this atom in the colvarproxy_namd arrays is "+
-             cvm::to_str(index)+".\n");
+             cvm::to_str(own_index)+".\n");
   }
-  id = p->get_atom_id(index);
+  id = p->get_atom_id(own_index);
   update_mass();
   update_charge();
   reset_data();
@@ -62,9 +65,10 @@ cvm::atom::atom(cvm::residue_id const &residue,
 
 
 cvm::atom::atom(atom const &a)
-  : index(a.index)
+  : own_index(a.proxy_index())
 {
-  id = (cvm::proxy)->get_atom_id(index);
+  use_own_data();
+  id = (cvm::proxy)->get_atom_id(own_index);
   update_mass();
   update_charge();
   reset_data();
@@ -73,16 +77,16 @@ cvm::atom::atom(atom const &a)
 
 cvm::atom::~atom()
 {
-  if (index >= 0) {
-    (cvm::proxy)->clear_atom(index);
+  if (proxy_index() >= 0) {
+    (cvm::proxy)->clear_atom(proxy_index());
   }
 }
 
 
 cvm::atom & cvm::atom::operator = (cvm::atom const &a)
 {
-  index = a.index;
-  id = (cvm::proxy)->get_atom_id(index);
+  *index_ptr = a.proxy_index();
+  id = (cvm::proxy)->get_atom_id(*index_ptr);
   update_mass();
   update_charge();
   reset_data();
@@ -108,12 +112,16 @@ cvm::atom_group::atom_group(std::vector<cvm::atom> const &atoms_in)
 {
   init();
   atoms = atoms_in;
+  init_atoms_arrays();
   setup();
 }
 
 
 cvm::atom_group::~atom_group()
 {
+  // The arrays are destroyed before the atoms, which still need their index
+  release_atoms();
+
   if (is_enabled(f_ag_scalable) && !b_dummy) {
     (cvm::proxy)->clear_atom_group(index);
     index = -1;
@@ -146,8 +154,19 @@ int cvm::atom_group::add_atom(cvm::atom const &a)
   // for consistency with add_atom_id(), we update the list as well
   atoms_ids.push_back(a.id);
   atoms.push_back(a);
-  total_mass += a.mass;
+  atoms_proxy_index.push_back(a.proxy_index());
+  atoms_pos.push_back(a.pos());
+  atoms_grad.push_back(a.grad());
+  atoms_mass.push_back(a.mass());
+  // Rebind all atoms only if either the atoms or the arrays were moved
+  cvm::atom const &first = atoms.front();
+  bool const moved = (first.index_ptr != &(atoms_proxy_index[0])) ||
+    (first.pos_ptr != &(atoms_pos[0])) || (first.grad_ptr != &(atoms_grad[0])) ||
+    (first.mass_ptr != &(atoms_mass[0]));
+  bind_atoms(moved ? 0 : atoms.size()-1);
+  total_mass += a.mass();
   total_charge += a.charge;
+  atoms_collect_index.clear();
 
   return COLVARS_OK;
 }
@@ -184,10 +203,15 @@ int cvm::atom_group::remove_atom(cvm::atom_iter ai)
     cvm::error("Error: trying to remove an atom from an empty group.\n", COLVARS_INPUT_ERROR);
     return COLVARS_ERROR;
   } else {
-    total_mass -= ai->mass;
+    total_mass -= ai->mass();
     total_charge -= ai->charge;
     atoms_ids.erase(atoms_ids.begin() + (ai - atoms.begin()));
+    // The following atoms are shifted by assignment, which must not write
+    // into the arrays
+    release_atoms();
     atoms.erase(ai);
+    init_atoms_arrays();
+    atoms_collect_index.clear();
   }
 
   return COLVARS_OK;
@@ -223,9 +247,14 @@ int cvm::atom_group::init()
 {
   if (!key.size()) key = "unnamed";
   description = "atom group " + key;
+  fit_profile_slot = cvm::main()->profile_slot(description, "fit");
   // These may be overwritten by parse(), if a name is provided
 
   atoms.clear();
+  atoms_proxy_index.clear();
+  atoms_pos.clear();
+  atoms_grad.clear();
+  atoms_mass.clear();
   atom_group::init_dependencies();
   index = -1;
 
@@ -335,8 +364,8 @@ void cvm::atom_group::update_total_mass()
     total_mass = (cvm::proxy)->get_atom_group_mass(index);
   } else {
     total_mass = 0.0;
-    for (cvm::atom_iter ai = this->begin(); ai != this->end(); ai++) {
-      total_mass += ai->mass;
+    for (size_t i = 0; i < atoms_mass.size(); i++) {
+      total_mass += atoms_mass[i];
     }
   }
   if (total_mass < 1e-15) {
@@ -345,6 +374,47 @@ void cvm::atom_group::update_total_mass()
 }
 
 
+void cvm::atom_group::bind_atoms(size_t first)
+{
+  for (size_t i = first; i < atoms.size(); i++) {
+    atoms[i].index_ptr = &(atoms_proxy_index[i]);
+    atoms[i].pos_ptr = &(atoms_pos[i]);
+    atoms[i].grad_ptr = &(atoms_grad[i]);
+    atoms[i].mass_ptr = &(atoms_mass[i]);
+  }
+}
+
+
+void cvm::atom_group::init_atoms_arrays()
+{
+  size_t const n = atoms.size();
+  atoms_proxy_index.resize(n);
+  atoms_pos.resize(n);
+  atoms_grad.resize(n);
+  atoms_mass.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    atoms_proxy_index[i] = atoms[i].own_index;
+    atoms_pos[i] = atoms[i].own_pos;
+    atoms_grad[i] = atoms[i].own_grad;
+    atoms_mass[i] = atoms[i].own_mass;
+  }
+  bind_atoms();
+}
+
+
+void cvm::atom_group::release_atoms()
+{
+  for (size_t i = 0; i < atoms.size(); i++) {
+    cvm::atom &a = atoms[i];
+    a.own_index = a.proxy_index();
+    a.own_pos = a.pos();
+    a.own_grad = a.grad();
+    a.own_mass = a.mass();
+    a.use_own_data();
+  }
+}
+
+
 void cvm::atom_group::update_total_charge()
 {
   if (b_dummy) {
@@ -402,6 +472,7 @@ int cvm::atom_group::parse(std::string const &group_conf)
     }
     cvm::main()->register_named_atom_group(this);
     description = "atom group " + name;
+    fit_profile_slot = cvm::main()->profile_slot(description, "fit");
   }
 
   // We need to know about fitting to decide whether the group is scalable
@@ -925,6 +996,24 @@ void cvm::atom_group::do_feature_side_effects(int id)
 }
 
 
+int cvm::atom_group::update_collect_index(std::vector<int> const &atom_ids)
+{
+  atoms_collect_index.resize(atoms.size());
+  for (size_t i = 0; i < atoms.size(); i++) {
+    std::vector<int>::const_iterator const it =
+      std::lower_bound(atom_ids.begin(), atom_ids.end(), atoms[i].id);
+    if ((it == atom_ids.end()) || (*it != atoms[i].id)) {
+      atoms_collect_index.clear();
+      return cvm::error("Error: atom "+cvm::to_str(atoms[i].id+1)+
+                        " of group \""+key+"\" is missing from the list "
+                        "of atoms of its colvar.\n", COLVARS_BUG_ERROR);
+    }
+    atoms_collect_index[i] = it - atom_ids.begin();
+  }
+  return COLVARS_OK;
+}
+
+
 int cvm::atom_group::create_sorted_ids()
 {
   // Only do the work if the vector is not yet populated
@@ -991,8 +1080,8 @@ void cvm::atom_group::read_positions()
 {
   if (b_dummy) return;
 
-  for (cvm::atom_iter ai = this->begin(); ai != this->end(); ai++) {
-    ai->read_position();
+  if (atoms.size() > 0) {
+    (cvm::proxy)->get_atoms_positions(atoms_proxy_index, &(atoms_pos[0]));
   }
 
   if (fitting_group)
@@ -1023,7 +1112,8 @@ int cvm::atom_group::calc_required_properties()
     }
   }
 
-  // TODO calculate elements of scalable cvc's here before reduction
+  // Other properties of scalable groups are reduced by the MD engine (see
+  // request_reduction())
 
   return (cvm::get_error() ? COLVARS_ERROR : COLVARS_OK);
 }
@@ -1031,6 +1121,8 @@ int cvm::atom_group::calc_required_properties()
 
 void cvm::atom_group::calc_apply_roto_translation()
 {
+  cvm::profile_timer const timer(fit_profile_slot);
+
   // store the laborarory-frame COGs for when they are needed later
   cog_orig = this->center_of_geometry();
   if (fitting_group) {
@@ -1050,19 +1142,12 @@ void cvm::atom_group::calc_apply_roto_translation()
   if (is_enabled(f_ag_rotate)) {
     // rotate the group (around the center of geometry if f_ag_center is
     // enabled, around the origin otherwise)
-    rot.calc_optimal_rotation(fitting_group ?
-                              fitting_group->positions() :
-                              this->positions(),
+    rot.calc_optimal_rotation((fitting_group ? fitting_group : this)->atoms_pos,
                               ref_pos);
 
-    cvm::atom_iter ai;
-    for (ai = this->begin(); ai != this->end(); ai++) {
-      ai->pos = rot.rotate(ai->pos);
-    }
+    rotate_positions();
     if (fitting_group) {
-      for (ai = fitting_group->begin(); ai != fitting_group->end(); ai++) {
-        ai->pos = rot.rotate(ai->pos);
-      }
+      fitting_group->rotate_positions();
     }
   }
 
@@ -1089,8 +1174,16 @@ void cvm::atom_group::apply_translation(cvm::rvector const &t)
     return;
   }
 
-  for (cvm::atom_iter ai = this->begin(); ai != this->end(); ai++) {
-    ai->pos += t;
+  for (size_t i = 0; i < atoms_pos.size(); i++) {
+    atoms_pos[i] += t;
+  }
+}
+
+
+void cvm::atom_group::rotate_positions()
+{
+  for (size_t i = 0; i < atoms_pos.size(); i++) {
+    atoms_pos[i] = rot.rotate(atoms_pos[i]);
   }
 }
 
@@ -1141,10 +1234,14 @@ int cvm::atom_group::calc_center_of_geometry()
   if (b_dummy) {
     cog = dummy_atom_pos;
   } else {
-    cog.reset();
-    for (cvm::atom_const_iter ai = this->begin(); ai != this->end(); ai++) {
-      cog += ai->pos;
+    cvm::real x = 0.0, y = 0.0, z = 0.0;
+    size_t const n = atoms_pos.size();
+    for (size_t i = 0; i < n; i++) {
+      x += atoms_pos[i].x;
+      y += atoms_pos[i].y;
+      z += atoms_pos[i].z;
     }
+    cog = cvm::atom_pos(x, y, z);
     cog /= cvm::real(this->size());
   }
   return COLVARS_OK;
@@ -1161,10 +1258,14 @@ int cvm::atom_group::calc_center_of_mass()
   } else if (is_enabled(f_ag_scalable)) {
     com = (cvm::proxy)->get_atom_group_com(index);
   } else {
-    com.reset();
-    for (cvm::atom_const_iter ai = this->begin(); ai != this->end(); ai++) {
-      com += ai->mass * ai->pos;
+    cvm::real x = 0.0, y = 0.0, z = 0.0;
+    size_t const n = atoms_pos.size();
+    for (size_t i = 0; i < n; i++) {
+      x += atoms_mass[i] * atoms_pos[i].x;
+      y += atoms_mass[i] * atoms_pos[i].y;
+      z += atoms_mass[i] * atoms_pos[i].z;
     }
+    com = cvm::atom_pos(x, y, z);
     com /= total_mass;
   }
   return COLVARS_OK;
@@ -1179,7 +1280,7 @@ int cvm::atom_group::calc_dipole(cvm::atom_pos const &dipole_center)
   }
   dip.reset();
   for (cvm::atom_const_iter ai = this->begin(); ai != this->end(); ai++) {
-    dip += ai->charge * (ai->pos - dipole_center);
+    dip += ai->charge * (ai->pos() - dipole_center);
   }
   return COLVARS_OK;
 }
@@ -1192,8 +1293,8 @@ void cvm::atom_group::set_weighted_gradient(cvm::rvector const &grad)
   scalar_com_gradient = grad;
 
   if (!is_enabled(f_ag_scalable)) {
-    for (cvm::atom_iter ai = this->begin(); ai != this->end(); ai++) {
-      ai->grad = (ai->mass/total_mass) * grad;
+    for (size_t i = 0; i < atoms_grad.size(); i++) {
+      atoms_grad[i] = (atoms_mass[i]/total_mass) * grad;
     }
   }
 }
@@ -1213,7 +1314,7 @@ void cvm::atom_group::calc_fit_gradients()
     cvm::rvector atom_grad;
 
     for (size_t i = 0; i < this->size(); i++) {
-      atom_grad += atoms[i].grad;
+      atom_grad += atoms_grad[i];
     }
     if (is_enabled(f_ag_rotate)) atom_grad = (rot.inverse()).rotate(atom_grad);
     atom_grad *= (-1.0)/(cvm::real(group_for_fit->size()));
@@ -1232,11 +1333,11 @@ void cvm::atom_group::calc_fit_gradients()
 
       // compute centered, unrotated position
       cvm::atom_pos const pos_orig =
-        rot_inv.rotate((is_enabled(f_ag_center) ? (atoms[i].pos - ref_pos_cog) : (atoms[i].pos)));
+        rot_inv.rotate((is_enabled(f_ag_center) ? (atoms_pos[i] - ref_pos_cog) : (atoms_pos[i])));
 
       // calculate \partial(R(q) \vec{x}_i)/\partial q) \cdot \partial\xi/\partial\vec{x}_i
       cvm::quaternion const dxdq =
-        rot.q.position_derivative_inner(pos_orig, atoms[i].grad);
+        rot.q.position_derivative_inner(pos_orig, atoms_grad[i]);
 
       for (size_t j = 0; j < group_for_fit->size(); j++) {
         // multiply by {\partial q}/\partial\vec{x}_j and add it to the fit gradients
@@ -1264,13 +1365,7 @@ std::vector<cvm::atom_pos> cvm::atom_group::positions() const
                "from a scalable atom group.\n", COLVARS_INPUT_ERROR);
   }
 
-  std::vector<cvm::atom_pos> x(this->size(), 0.0);
-  cvm::atom_const_iter ai = this->begin();
-  std::vector<cvm::atom_pos>::iterator xi = x.begin();
-  for ( ; ai != this->end(); ++xi, ++ai) {
-    *xi = ai->pos;
-  }
-  return x;
+  return atoms_pos;
 }
 
 std::vector<cvm::atom_pos> cvm::atom_group::positions_shifted(cvm::rvector const &shift) const
@@ -1286,10 +1381,8 @@ std::vector<cvm::atom_pos> cvm::atom_group::positions_shifted(cvm::rvector const
   }
 
   std::vector<cvm::atom_pos> x(this->size(), 0.0);
-  cvm::atom_const_iter ai = this->begin();
-  std::vector<cvm::atom_pos>::iterator xi = x.begin();
-  for ( ; ai != this->end(); ++xi, ++ai) {
-    *xi = (ai->pos + shift);
+  for (size_t i = 0; i < atoms_pos.size(); i++) {
+    x[i] = atoms_pos[i] + shift;
   }
   return x;
 }
@@ -1357,6 +1450,16 @@ cvm::rvector cvm::atom_group::total_force() const
 }
 
 
+int cvm::atom_group::request_reduction(int type, int weight)
+{
+  if (b_dummy || !is_enabled(f_ag_scalable)) {
+    return cvm::error("Error: reductions can only be requested for scalable "
+                      "atom groups.\n", COLVARS_BUG_ERROR);
+  }
+  return (cvm::proxy)->request_atom_group_reduction(index, type, weight);
+}
+
+
 void cvm::atom_group::apply_colvar_force(cvm::real const &force)
 {
   if (cvm::debug()) {
@@ -1371,24 +1474,27 @@ void cvm::atom_group::apply_colvar_force(cvm::real const &force)
     return;
   }
 
+  if (force == 0.0) {
+    // Nothing to apply: skip the loops over atoms
+    return;
+  }
+
   if (is_enabled(f_ag_scalable)) {
     (cvm::proxy)->apply_atom_group_force(index, force * scalar_com_gradient);
     return;
   }
 
-  if (is_enabled(f_ag_rotate)) {
+  atoms_new_forces.resize(atoms.size());
+  for (size_t i = 0; i < atoms.size(); i++) {
+    atoms_new_forces[i] = force * atoms_grad[i];
+  }
 
+  if (is_enabled(f_ag_rotate)) {
     // rotate forces back to the original frame
     cvm::rotation const rot_inv = rot.inverse();
-    for (cvm::atom_iter ai = this->begin(); ai != this->end(); ai++) {
-      ai->apply_force(rot_inv.rotate(force * ai->grad));
-    }
-
+    apply_atoms_new_forces(&rot_inv);
   } else {
-
-    for (cvm::atom_iter ai = this->begin(); ai != this->end(); ai++) {
-      ai->apply_force(force * ai->grad);
-    }
+    apply_atoms_new_forces(NULL);
   }
 
   if ((is_enabled(f_ag_center) || is_enabled(f_ag_rotate)) && is_enabled(f_ag_fit_gradients)) {
@@ -1396,9 +1502,11 @@ void cvm::atom_group::apply_colvar_force(cvm::real const &force)
     atom_group *group_for_fit = fitting_group ? fitting_group : this;
 
     // Fit gradients are already calculated in "laboratory" frame
+    group_for_fit->atoms_new_forces.resize(group_for_fit->size());
     for (size_t j = 0; j < group_for_fit->size(); j++) {
-      (*group_for_fit)[j].apply_force(force * group_for_fit->fit_gradients[j]);
+      group_for_fit->atoms_new_forces[j] = force * group_for_fit->fit_gradients[j];
     }
+    group_for_fit->apply_atoms_new_forces(NULL);
   }
 }
 
@@ -1422,19 +1530,30 @@ void cvm::atom_group::apply_force(cvm::rvector const &force)
     return;
   }
 
-  if (is_enabled(f_ag_rotate)) {
+  atoms_new_forces.resize(atoms.size());
+  for (size_t i = 0; i < atoms.size(); i++) {
+    atoms_new_forces[i] = (atoms_mass[i]/total_mass) * force;
+  }
 
+  if (is_enabled(f_ag_rotate)) {
     cvm::rotation const rot_inv = rot.inverse();
-    for (cvm::atom_iter ai = this->begin(); ai != this->end(); ai++) {
-      ai->apply_force(rot_inv.rotate((ai->mass/total_mass) * force));
-    }
-
+    apply_atoms_new_forces(&rot_inv);
   } else {
+    apply_atoms_new_forces(NULL);
+  }
+}
 
-    for (cvm::atom_iter ai = this->begin(); ai != this->end(); ai++) {
-      ai->apply_force((ai->mass/total_mass) * force);
+
+void cvm::atom_group::apply_atoms_new_forces(cvm::rotation const *rot_inv)
+{
+  size_t const n = atoms.size();
+  if (n == 0) return;
+  if (rot_inv) {
+    for (size_t i = 0; i < n; i++) {
+      atoms_new_forces[i] = rot_inv->rotate(atoms_new_forces[i]);
     }
   }
+  (cvm::proxy)->apply_atoms_forces(atoms_proxy_index, &(atoms_new_forces[0]));
 }
 
 
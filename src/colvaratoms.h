@@ -24,29 +24,61 @@
 /// There may be multiple instances with identical
 /// numeric id, all acting independently: forces communicated through
 /// these instances will be summed together.
+///
+/// The proxy index, position, gradient and mass of an atom that belongs to an
+/// \link atom_group \endlink are stored in contiguous arrays of the group,
+/// and are accessed through proxy_index(), pos(), grad() and mass(); an atom
+/// created on its own (or copied) keeps them in its own members until it is
+/// added to a group.
 
 class colvarmodule::atom {
 
 protected:
 
-  /// Index in the colvarproxy arrays (\b NOT in the global topology!)
-  int index;
+  /// Index in the colvarproxy arrays of an atom that is not part of a group
+  int own_index;
+
+  /// Position of an atom that is not part of a group
+  cvm::atom_pos own_pos;
+
+  /// Gradient of an atom that is not part of a group
+  cvm::rvector own_grad;
+
+  /// Mass of an atom that is not part of a group
+  cvm::real own_mass;
+
+  /// \brief Location of the index in the colvarproxy arrays (\b NOT in the
+  /// global topology!), either own_index or an element of a group's array
+  int *index_ptr;
+
+  /// Location of the position (own_pos, or an element of a group's array)
+  cvm::atom_pos *pos_ptr;
+
+  /// Location of the gradient (own_grad, or an element of a group's array)
+  cvm::rvector *grad_ptr;
+
+  /// Location of the mass (own_mass, or an element of a group's array)
+  cvm::real *mass_ptr;
+
+  /// Use the own members to store index, position, gradient and mass
+  inline void use_own_data()
+  {
+    index_ptr = &own_index;
+    pos_ptr = &own_pos;
+    grad_ptr = &own_grad;
+    mass_ptr = &own_mass;
+  }
+
+  friend class colvarmodule::atom_group;
 
 public:
 
   /// Identifier for the MD program (0-based)
   int             id;
 
-  /// Mass
-  cvm::real       mass;
-
   /// Charge
   cvm::real       charge;
 
-  /// \brief Current position (copied from the program, can be
-  /// modified if necessary)
-  cvm::atom_pos   pos;
-
   /// \brief Current velocity (copied from the program, can be
   /// modified if necessary)
   cvm::rvector    vel;
@@ -55,6 +87,19 @@ public:
   /// program, can be modified if necessary)
   cvm::rvector    total_force;
 
+  /// \brief Current position (copied from the program, can be
+  /// modified if necessary)
+  inline cvm::atom_pos & pos()
+  {
+    return *pos_ptr;
+  }
+
+  /// Current position
+  inline cvm::atom_pos const & pos() const
+  {
+    return *pos_ptr;
+  }
+
   /// \brief Gradient of a scalar collective variable with respect
   /// to this atom
   ///
@@ -65,7 +110,22 @@ public:
   /// colvarvalue \endlink objects, atomic gradients should be
   /// defined within the specific \link colvar::cvc \endlink
   /// implementation
-  cvm::rvector   grad;
+  inline cvm::rvector & grad()
+  {
+    return *grad_ptr;
+  }
+
+  /// Gradient of a scalar collective variable with respect to this atom
+  inline cvm::rvector const & grad() const
+  {
+    return *grad_ptr;
+  }
+
+  /// Mass
+  inline cvm::real mass() const
+  {
+    return *mass_ptr;
+  }
 
   /// \brief Default constructor (sets index and id both to -1)
   atom();
@@ -84,52 +144,60 @@ public:
        std::string const     &atom_name,
        std::string const     &segment_id);
 
-  /// Copy constructor
+  /// Copy constructor (the copy stores its data in its own members)
   atom(atom const &a);
 
   /// Destructor
   ~atom();
 
-  /// Assignment operator (added to appease LGTM)
+  /// \brief Assignment operator; an atom of a group is replaced in place, and
+  /// keeps using the group's arrays
   atom & operator = (atom const &a);
 
   /// Set mutable data (everything except id and mass) to zero
   inline void reset_data()
   {
-    pos = cvm::atom_pos(0.0);
-    vel = grad = total_force = cvm::rvector(0.0);
+    pos() = cvm::atom_pos(0.0);
+    grad() = cvm::rvector(0.0);
+    vel = total_force = cvm::rvector(0.0);
+  }
+
+  /// Index of this atom in the colvarproxy arrays
+  inline int proxy_index() const
+  {
+    return *index_ptr;
   }
 
   /// Get the latest value of the mass
   inline void update_mass()
   {
     colvarproxy *p = cvm::proxy;
-    mass = p->get_atom_mass(index);
+    *mass_ptr = p->get_atom_mass(*index_ptr);
   }
 
   /// Get the latest value of the charge
   inline void update_charge()
   {
     colvarproxy *p = cvm::proxy;
-    charge = p->get_atom_charge(index);
+    charge = p->get_atom_charge(*index_ptr);
   }
 
   /// Get the current position
   inline void read_position()
   {
-    pos = (cvm::proxy)->get_atom_position(index);
+    pos() = (cvm::proxy)->get_atom_position(*index_ptr);
   }
 
   /// Get the current velocity
   inline void read_velocity()
   {
-    vel = (cvm::proxy)->get_atom_velocity(index);
+    vel = (cvm::proxy)->get_atom_velocity(*index_ptr);
   }
 
   /// Get the total force
   inline void read_total_force()
   {
-    total_force = (cvm::proxy)->get_atom_total_force(index);
+    total_force = (cvm::proxy)->get_atom_total_force(*index_ptr);
   }
 
   /// \brief Apply a force to the atom
@@ -143,7 +211,7 @@ public:
   /// \link id \endlink will all be added together.
   inline void apply_force(cvm::rvector const &new_force) const
   {
-    (cvm::proxy)->apply_atom_force(index, new_force);
+    (cvm::proxy)->apply_atom_force(*index_ptr, new_force);
   }
 };
 
@@ -251,6 +319,44 @@ protected:
   /// Map entries of sorted_atoms_ids onto the original positions in the group
   std::vector<int> sorted_atoms_ids_map;
 
+  /// \brief Positions of the atoms, received from the proxy in one call (the
+  /// pos() of each atom object refers to its element)
+  std::vector<cvm::atom_pos> atoms_pos;
+
+  /// Gradients of the atoms (the grad() of each atom refers to its element)
+  std::vector<cvm::rvector> atoms_grad;
+
+  /// Masses of the atoms (the mass() of each atom refers to its element)
+  std::vector<cvm::real> atoms_mass;
+
+  /// \brief Indices of the atoms in the colvarproxy arrays, used to
+  /// exchange data with the proxy in a single call for the whole group (the
+  /// proxy_index() of each atom refers to its element)
+  std::vector<int> atoms_proxy_index;
+
+  /// \brief Point the atom objects from first onwards to their elements of
+  /// the arrays above, which must have the same size as atoms
+  void bind_atoms(size_t first = 0);
+
+  /// \brief Copy the data that the atoms hold in their own members into the
+  /// arrays above, then bind the atoms to them
+  void init_atoms_arrays();
+
+  /// \brief Copy the data of the atoms from the arrays above into their own
+  /// members, and make the atoms use those
+  void release_atoms();
+
+  /// Buffer of the forces to be applied to each atom
+  std::vector<cvm::rvector> atoms_new_forces;
+
+  /// \brief Send the forces stored in atoms_new_forces to the proxy (with the
+  /// optional rotation to the laboratory frame)
+  void apply_atoms_new_forces(cvm::rotation const *rot_inv);
+
+  /// \brief Position of each atom in the sorted list of atom IDs of the
+  /// parent colvar (colvar::atom_ids), used to collect atomic gradients
+  std::vector<int> atoms_collect_index;
+
   /// \brief Dummy atom position
   cvm::atom_pos dummy_atom_pos;
 
@@ -323,6 +429,20 @@ public:
     return sorted_atoms_ids_map;
   }
 
+  /// \brief Compute the position of each atom in atom_ids (a sorted list of
+  /// IDs containing all atoms of this group)
+  int update_collect_index(std::vector<int> const &atom_ids);
+
+  /// \brief Position of each atom in atom_ids, computed by
+  /// update_collect_index(); recomputed here if the group has changed since
+  inline std::vector<int> const &collect_index(std::vector<int> const &atom_ids)
+  {
+    if (atoms_collect_index.size() != atoms.size()) {
+      update_collect_index(atom_ids);
+    }
+    return atoms_collect_index;
+  }
+
   /// Detect whether two groups share atoms
   /// If yes, returns 1-based number of a common atom; else, returns 0
   static int overlap(const atom_group &g1, const atom_group &g2);
@@ -369,6 +489,9 @@ public:
   /// \brief (Re)calculate the optimal roto-translation
   void calc_apply_roto_translation();
 
+  /// Slot of the profile for calc_apply_roto_translation()
+  int fit_profile_slot;
+
   /// \brief Save aside the center of geometry of the reference positions,
   /// then subtract it from them
   ///
@@ -381,6 +504,9 @@ public:
   /// \brief Move all positions
   void apply_translation(cvm::rvector const &t);
 
+  /// \brief Rotate all positions using the current value of rot
+  void rotate_positions();
+
   /// \brief Get the current velocities; this must be called always
   /// *after* read_positions(); if f_ag_rotate is defined, the same
   /// rotation applied to the coordinates will be used
@@ -406,6 +532,13 @@ public:
   /// \brief Return a copy of the current atom positions
   std::vector<cvm::atom_pos> positions() const;
 
+  /// \brief Return a reference to the contiguous array of the current atom
+  /// positions (no copy is made)
+  inline std::vector<cvm::atom_pos> const &positions_view() const
+  {
+    return atoms_pos;
+  }
+
   /// \brief Calculate the center of geometry of the atomic positions, assuming
   /// that they are already pbc-wrapped
   int calc_center_of_geometry();
@@ -483,6 +616,12 @@ public:
   /// \brief Return a copy of the aggregated total force on the group
   cvm::rvector total_force() const;
 
+  /// \brief Request that the MD engine computes an additive reduction over
+  /// the atoms of this scalable group (see
+  /// colvarproxy_atom_groups::request_atom_group_reduction()); returns the
+  /// index of the reduction, or a negative error code
+  int request_reduction(int type, int weight);
+
 
   /// \brief Shorthand: save the specified gradient on each atom,
   /// weighting with the atom mass (mostly used in combination with
@@ -8,6 +8,7 @@
 // Colvars repository at GitHub.
 
 #include <iostream>
+#include <sstream>
 #include <cstring>
 
 #include "colvarmodule.h"
@@ -24,6 +25,8 @@ colvarbias::colvarbias(char const *key)
 
   rank = -1;
   description = "uninitialized " + bias_type + " bias";
+  update_profile_slot = -1;
+  output_profile_slot = -1;
 
   colvarbias::init_dependencies();
 
@@ -67,6 +70,9 @@ int colvarbias::init(std::string const &conf)
       }
     }
     description = "bias " + name;
+    update_profile_slot = cvm::main()->profile_slot(description, "update");
+    output_profile_slot = cvm::main()->profile_slot(description,
+                                                    "write_output_files");
 
     {
       // lookup the associated colvars
@@ -397,9 +403,13 @@ void colvarbias::communicate_forces()
     // which is why rescaling has to happen now: the colvar is not
     // aware of this bias' time_step_factor
     if (is_enabled(f_cvb_bypass_ext_lagrangian)) {
-      variables(i)->add_bias_force_actual_value(cvm::real(time_step_factor) * colvar_forces[i] * biasing_force_factor);
+      variables(i)->add_bias_force_actual_value(colvar_forces[i],
+                                                cvm::real(time_step_factor) *
+                                                biasing_force_factor);
     } else {
-      variables(i)->add_bias_force(cvm::real(time_step_factor) * colvar_forces[i] * biasing_force_factor);
+      variables(i)->add_bias_force(colvar_forces[i],
+                                   cvm::real(time_step_factor) *
+                                   biasing_force_factor);
     }
     previous_colvar_forces[i] = colvar_forces[i];
   }
@@ -674,6 +684,23 @@ std::ostream & colvarbias::write_traj(std::ostream &os)
 }
 
 
+std::ostream & colvarbias::write_traj_binary_label(std::ostream &os)
+{
+  if (b_output_energy) {
+    os << "E_" << this->name << " scalar 1\n";
+  }
+  return os;
+}
+
+
+void colvarbias::write_traj_binary(std::vector<cvm::real> &frame)
+{
+  if (b_output_energy) {
+    frame.push_back(bias_energy);
+  }
+}
+
+
 
 colvarbias_ti::colvarbias_ti(char const *key)
   : colvarbias(key)
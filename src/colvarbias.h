@@ -177,6 +177,15 @@ public:
   /// Output quantities such as the bias energy to the trajectory file
   virtual std::ostream & write_traj(std::ostream &os);
 
+  /// \brief Describe the columns of the binary trajectory, one per line:
+  /// label, type of value and number of components (should match
+  /// write_traj_label())
+  virtual std::ostream & write_traj_binary_label(std::ostream &os);
+
+  /// \brief Append the values of the binary trajectory columns to frame
+  /// (should match write_traj())
+  virtual void write_traj_binary(std::vector<cvm::real> &frame);
+
   /// (Re)initialize the output files (does not write them yet)
   virtual int setup_output()
   {
@@ -186,6 +195,9 @@ public:
   /// Frequency for writing output files
   size_t output_freq;
 
+  /// Slots of the profile for update() and write_output_files()
+  int update_profile_slot, output_profile_slot;
+
   /// Write any output files that this bias may have (e.g. PMF files)
   virtual int write_output_files()
   {
@@ -16,6 +16,9 @@
 
 colvarbias_abf::colvarbias_abf(char const *key)
   : colvarbias(key),
+    interpolation_order(0),
+    b_history_binary(false),
+    history_keyframe_freq(100),
     b_UI_estimator(false),
     b_CZAR_estimator(false),
     pabf_freq(0),
@@ -27,8 +30,11 @@ colvarbias_abf::colvarbias_abf(char const *key)
     z_samples(NULL),
     czar_gradients(NULL),
     czar_pmf(NULL),
+    czar_full_update(false),
     last_gradients(NULL),
-    last_samples(NULL)
+    last_samples(NULL),
+    shared_async(false),
+    shared_pending(false)
 {
   colvarproxy *proxy = cvm::main()->proxy;
   if (!proxy->total_forces_same_step()) {
@@ -78,6 +84,17 @@ int colvarbias_abf::init(std::string const &conf)
   min_samples = full_samples / 2;
   // full_samples - min_samples >= 1 is guaranteed
 
+  std::string interpolation("none");
+  get_keyval(conf, "gridInterpolation", interpolation, interpolation);
+  if (interpolation == "linear") {
+    interpolation_order = 1;
+  } else if (interpolation == "cubic") {
+    interpolation_order = 3;
+  } else if (interpolation != "none") {
+    return cvm::error("Error: gridInterpolation must be \"none\", "
+                      "\"linear\" or \"cubic\".\n", COLVARS_INPUT_ERROR);
+  }
+
   get_keyval(conf, "inputPrefix",  input_prefix, std::vector<std::string>());
 
   get_keyval(conf, "historyFreq", history_freq, 0);
@@ -93,6 +110,18 @@ int colvarbias_abf::init(std::string const &conf)
     }
   }
   b_history_files = (history_freq > 0);
+  if (b_history_files) {
+    std::string history_format("text");
+    get_keyval(conf, "historyFormat", history_format, history_format);
+    if (history_format == "binary") {
+      b_history_binary = true;
+    } else if (history_format != "text") {
+      return cvm::error("Error: historyFormat must be \"text\" or \"binary\".\n",
+                        COLVARS_INPUT_ERROR);
+    }
+    get_keyval(conf, "historyKeyframeFreq", history_keyframe_freq,
+               history_keyframe_freq);
+  }
 
   // shared ABF
   get_keyval(conf, "shared", shared_on, false);
@@ -114,6 +143,13 @@ int colvarbias_abf::init(std::string const &conf)
 
     // If shared_freq is not set, we default to output_freq
     get_keyval(conf, "sharedFreq", shared_freq, output_freq);
+    get_keyval(conf, "sharedAsync", shared_async, shared_async);
+    if (shared_async && (proxy->replica_comm_async() != COLVARS_OK)) {
+      cvm::log("Warning: non-blocking communication between replicas is not "
+               "available in this build; samples will be shared "
+               "synchronously.\n");
+      shared_async = false;
+    }
   }
 
   // ************* checking the associated colvars *******************
@@ -213,6 +249,7 @@ int colvarbias_abf::init(std::string const &conf)
     z_gradients->samples = z_samples;
     z_samples->has_parent_data = true;
     czar_gradients = new colvar_grid_gradient(colvars);
+    czar_full_update = true;
   }
 
   get_keyval(conf, "integrate", b_integrate, num_variables() <= 3); // Integrate for output if d<=3
@@ -235,6 +272,10 @@ int colvarbias_abf::init(std::string const &conf)
     get_keyval(conf, "pABFintegrateTol", pabf_integrate_tol, 1e-4, colvarparse::parse_silent);
   }
 
+  if (pabf_freq && interpolation_order) {
+    cvm::log("Warning: gridInterpolation is not used by projected ABF.\n");
+  }
+
   // For shared ABF, we store a second set of grids.
   // This used to be only if "shared" was defined,
   // but now we allow calling share externally (e.g. from Tcl).
@@ -395,6 +436,9 @@ int colvarbias_abf::update()
           update_system_force(i);
         }
         z_gradients->acc_force(z_bin, system_force);
+        if (b_CZAR_estimator) {
+          czar_gradients->flag_czar_bin(z_bin);
+        }
       }
     }
 
@@ -426,22 +470,19 @@ int colvarbias_abf::update()
   // Compute and apply the new bias, if applicable
   if (is_enabled(f_cvb_apply_force) && samples->index_ok(bin)) {
 
-    cvm::real count = cvm::real(samples->value(bin));
-    cvm::real fact = 1.0;
-
-    // Factor that ensures smooth introduction of the force
-    if ( count < full_samples ) {
-      fact = (count < min_samples) ? 0.0 :
-        (cvm::real(count - min_samples)) / (cvm::real(full_samples - min_samples));
-    }
-
     std::vector<cvm::real>  grad(num_variables());
+    cvm::real fact = 1.0;
 
     if ( pabf_freq ) {
       // In projected ABF, the force is the PMF gradient estimate
+      fact = force_ramp_factor(samples->value(bin));
       pmf->vector_gradient_finite_diff(bin, grad);
+    } else if (interpolation_order) {
+      // Normal ABF, interpolating between bins
+      interpolate_biasing_force(grad, fact);
     } else {
       // Normal ABF
+      fact = force_ramp_factor(samples->value(bin));
       gradients->vector_value(bin, grad);
     }
 
@@ -479,9 +520,20 @@ int colvarbias_abf::update()
     output_prefix = cvm::output_prefix() + "." + this->name;
   }
 
+  if (shared_on && shared_async) {
+    // Apply the samples of the other replicas if they have arrived
+    replica_share_progress(false);
+  }
+
   if (shared_on && shared_last_step >= 0 && cvm::step_absolute() % shared_freq == 0) {
     // Share gradients and samples for shared ABF.
-    replica_share();
+    if (shared_async) {
+      replica_share_progress(true);
+      replica_share_start();
+      replica_share_progress(false);
+    } else {
+      replica_share();
+    }
   }
 
   // Prepare for the first sharing.
@@ -514,6 +566,81 @@ int colvarbias_abf::update()
 }
 
 
+void colvarbias_abf::interpolate_biasing_force(std::vector<cvm::real> &grad,
+                                               cvm::real &fact)
+{
+  size_t const n = num_variables();
+  size_t ip, i;
+  grad.assign(n, 0.0);
+  interp_bin_grad.resize(n);
+
+  // Linear weights are non-negative: the ramp factor is in [0, 1], and each
+  // bin contributes in proportion to its own ramp factor
+  samples->interpolation_stencil(NULL, 1, interp_points, interp_weights);
+
+  // Cubic weights can be negative, and would not give a meaningful average
+  // of the ramp factors: the cubic interpolant replaces the linear one by a
+  // fraction that is the linear interpolation of the lowest ramp factor
+  // around each bin, i.e. 1 where the whole cubic stencil is full and
+  // continuous elsewhere, so that the force does not jump
+  cvm::real cubic_fact = 0.0;
+  if (interpolation_order == 3) {
+    samples->interpolation_stencil(NULL, 3, interp_cubic_points,
+                                   interp_cubic_weights);
+    interp_ramps.resize(interp_cubic_points.size());
+    for (ip = 0; ip < interp_cubic_points.size(); ip++) {
+      interp_ramps[ip] = force_ramp_factor(samples->value(interp_cubic_points[ip]));
+    }
+    // Linear point j is at the offsets j+1 of the cubic stencil, and its
+    // neighbors at the offsets j to j+2 (last dimension first in both)
+    size_t n_neighbors = 1;
+    for (i = 0; i < n; i++) n_neighbors *= 3;
+    for (ip = 0; ip < interp_points.size(); ip++) {
+      cvm::real ramp_min = 1.0;
+      for (size_t in = 0; in < n_neighbors; in++) {
+        size_t ic = 0, stride = 1, jl = ip, jn = in;
+        for (i = 0; i < n; i++) {
+          ic += ((jl % 2) + (jn % 3)) * stride;
+          stride *= 4;
+          jl /= 2;
+          jn /= 3;
+        }
+        if (interp_ramps[ic] < ramp_min) ramp_min = interp_ramps[ic];
+      }
+      cubic_fact += interp_weights[ip] * ramp_min;
+    }
+  }
+
+  fact = 0.0;
+  for (ip = 0; ip < interp_points.size(); ip++) {
+    cvm::real const ramp = force_ramp_factor(samples->value(interp_points[ip]));
+    fact += interp_weights[ip] * ramp;
+    cvm::real const w = interp_weights[ip] * (ramp - cubic_fact);
+    if (w == 0.0) continue;
+    gradients->vector_value(interp_points[ip], interp_bin_grad);
+    for (i = 0; i < n; i++) {
+      grad[i] += w * interp_bin_grad[i];
+    }
+  }
+  if (cubic_fact > 0.0) {
+    for (ip = 0; ip < interp_cubic_points.size(); ip++) {
+      cvm::real const w = cubic_fact * interp_cubic_weights[ip];
+      if (w == 0.0) continue;
+      gradients->vector_value(interp_cubic_points[ip], interp_bin_grad);
+      for (i = 0; i < n; i++) {
+        grad[i] += w * interp_bin_grad[i];
+      }
+    }
+  }
+  // The caller scales the result by the interpolated ramp factor
+  if (fact > 0.0) {
+    for (i = 0; i < n; i++) {
+      grad[i] /= fact;
+    }
+  }
+}
+
+
 int colvarbias_abf::replica_share() {
 
   colvarproxy *proxy = cvm::main()->proxy;
@@ -528,79 +655,113 @@ int colvarbias_abf::replica_share() {
     return COLVARS_ERROR;
   }
 
+  int error_code = replica_share_progress(true);
+  error_code |= replica_share_start();
+  error_code |= replica_share_progress(true);
+  return error_code;
+}
+
+
+int colvarbias_abf::replica_share_start() {
+
+  colvarproxy *proxy = cvm::main()->proxy;
+
   // Share gradients for shared ABF.
   cvm::log("shared ABF: Sharing gradient and samples among replicas at step "+cvm::to_str(cvm::step_absolute()) );
 
-  // Count of data items.
-  size_t data_n = gradients->raw_data_num();
-  size_t samp_start = data_n*sizeof(cvm::real);
-  size_t msg_total = data_n*sizeof(size_t) + samp_start;
-  char* msg_data = new char[msg_total];
-
-  if (proxy->replica_index() == 0) {
-    int p;
-    // Replica 0 collects the delta gradient and count from the others.
-    for (p = 1; p < proxy->num_replicas(); p++) {
-      // Receive the deltas.
-      proxy->replica_comm_recv(msg_data, msg_total, p);
+  size_t const mult = gradients->multiplicity();
+  size_t const nbins = samples->raw_data_num();
+  size_t const record_size = 1 + mult;
 
-      // Map the deltas from the others into the grids.
-      last_gradients->raw_data_in((cvm::real*)(&msg_data[0]));
-      last_samples->raw_data_in((size_t*)(&msg_data[samp_start]));
+  if (!shared_sum.initialized()) {
+    shared_sum.init(proxy, nbins, record_size);
+  }
 
-      // Combine the delta gradient and count of the other replicas
-      // with Replica 0's current state (including its delta).
-      gradients->add_grid( *last_gradients );
-      samples->add_grid( *last_samples );
+  // Only the bins whose count changed since the last exchange have new
+  // samples; their deltas are sent, and last is brought up to date
+  shared_own_bins.clear();
+  shared_own_deltas.clear();
+  for (size_t ib = 0; ib < nbins; ib++) {
+    size_t const count = samples->value(ib);
+    if (count == last_samples->value(ib)) continue;
+    shared_own_bins.push_back(ib);
+    shared_own_deltas.push_back(cvm::real(count - last_samples->value(ib)));
+    last_samples->set_value(ib, count);
+    for (size_t k = 0; k < mult; k++) {
+      size_t const i = ib * mult + k;
+      shared_own_deltas.push_back(gradients->value(i) -
+                                  last_gradients->value(i));
+      last_gradients->set_value(i, gradients->value(i));
     }
+  }
+
+  shared_last_step = cvm::step_absolute();
+  shared_pending = true;
+  return shared_sum.start(shared_own_bins, shared_own_deltas);
+}
+
+
+int colvarbias_abf::replica_share_progress(bool block) {
+
+  if (!shared_pending) {
+    // Complete the sends of the last exchange
+    return shared_sum.initialized() ? shared_sum.progress(block) : COLVARS_OK;
+  }
 
-    // Now we must send the combined gradient to the other replicas.
-    gradients->raw_data_out((cvm::real*)(&msg_data[0]));
-    samples->raw_data_out((size_t*)(&msg_data[samp_start]));
-    for (p = 1; p < proxy->num_replicas(); p++) {
-      proxy->replica_comm_send(msg_data, msg_total, p);
+  int error_code = shared_sum.progress(block);
+  if (!shared_sum.complete()) {
+    return error_code;
+  }
+
+  // Add the samples of the other replicas, i.e. the total minus the deltas
+  // of this replica, to both the current and the last grids
+  size_t const mult = gradients->multiplicity();
+  size_t const record_size = 1 + mult;
+  std::vector<size_t> const &bins = shared_sum.records();
+  std::vector<cvm::real> const &deltas = shared_sum.values();
+  size_t ir, io = 0;
+  for (ir = 0; ir < bins.size(); ir++) {
+    size_t const ib = bins[ir];
+    cvm::real const *delta = &(deltas[ir * record_size]);
+    cvm::real const *own_delta = NULL;
+    if ((io < shared_own_bins.size()) && (shared_own_bins[io] == ib)) {
+      own_delta = &(shared_own_deltas[io * record_size]);
+      io++;
+    }
+    size_t const count_delta = size_t(delta[0] + 0.5) -
+      (own_delta ? size_t(own_delta[0] + 0.5) : 0);
+    samples->set_value(ib, samples->value(ib) + count_delta);
+    last_samples->set_value(ib, last_samples->value(ib) + count_delta);
+    for (size_t k = 0; k < mult; k++) {
+      size_t const i = ib * mult + k;
+      cvm::real const grad_delta = delta[1+k] - (own_delta ? own_delta[1+k] : 0.0);
+      gradients->set_value(i, gradients->value(i) + grad_delta);
+      last_gradients->set_value(i, last_gradients->value(i) + grad_delta);
     }
+  }
 
-  } else {
-    // All other replicas send their delta gradient and count.
-    // Calculate the delta gradient and count.
-    last_gradients->delta_grid(*gradients);
-    last_samples->delta_grid(*samples);
-
-    // Cast the raw char data to the gradient and samples.
-    last_gradients->raw_data_out((cvm::real*)(&msg_data[0]));
-    last_samples->raw_data_out((size_t*)(&msg_data[samp_start]));
-    proxy->replica_comm_send(msg_data, msg_total, 0);
-
-    // We now receive the combined gradient from Replica 0.
-    proxy->replica_comm_recv(msg_data, msg_total, 0);
-    // We sync to the combined gradient computed by Replica 0.
-    gradients->raw_data_in((cvm::real*)(&msg_data[0]));
-    samples->raw_data_in((size_t*)(&msg_data[samp_start]));
-  }
-
-  // Without a barrier it's possible that one replica starts
-  // share 2 when other replicas haven't finished share 1.
-  proxy->replica_comm_barrier();
-  // Done syncing the replicas.
-  delete[] msg_data;
-
-  // Copy the current gradient and count values into last.
-  last_gradients->copy_grid(*gradients);
-  last_samples->copy_grid(*samples);
-  shared_last_step = cvm::step_absolute();
+  shared_pending = false;
 
   if (b_integrate) {
     // Update divergence to account for newly shared gradients
     pmf->set_div();
   }
-  return COLVARS_OK;
+  return error_code;
 }
 
 
 template <class T> int colvarbias_abf::write_grid_to_file(T const *grid,
                                                           std::string const &filename,
                                                           bool close) {
+  if (!close && b_history_binary) {
+    // Append only the changed values to the binary history file
+    colvar_grid_history &history = history_binary_files[filename];
+    if (history.file_name().empty()) {
+      history.init(filename + ".bin", history_keyframe_freq);
+    }
+    return history.write_frame(*grid, cvm::step_absolute());
+  }
+
   std::ostream *os = cvm::proxy->output_stream(filename);
   if (!os) {
     return cvm::error("Error opening file " + filename + " for writing.\n", COLVARS_ERROR | COLVARS_FILE_ERROR);
@@ -657,20 +818,30 @@ void colvarbias_abf::write_gradients_samples(const std::string &prefix, bool clo
       write_grid_to_file<colvar_grid_gradient>(z_gradients, prefix + ".zgrad", close);
     }
 
-    // Calculate CZAR estimator of gradients
-    for (std::vector<int> ix = czar_gradients->new_index();
-          czar_gradients->index_ok(ix); czar_gradients->incr(ix)) {
-      for (size_t n = 0; n < czar_gradients->multiplicity(); n++) {
-        czar_gradients->set_value(ix, z_gradients->value_output(ix, n)
-          - cvm::temperature() * cvm::boltzmann() * z_samples->log_gradient_finite_diff(ix, n), n);
+    // Calculate CZAR estimator of gradients, only where the z grids changed
+    // since the last output
+    cvm::real const kT = cvm::temperature() * cvm::boltzmann();
+    if (czar_full_update) {
+      czar_gradients->set_czar(*z_gradients, *z_samples, kT);
+      if (b_integrate) {
+        czar_pmf->set_div();
+      }
+      czar_full_update = false;
+    } else {
+      czar_gradients->update_czar(*z_gradients, *z_samples, kT,
+                                  czar_updated_bins);
+      if (b_integrate) {
+        for (size_t i = 0; i < czar_updated_bins.size(); i++) {
+          czar_pmf->update_div_neighbors(czar_updated_bins[i]);
+        }
       }
     }
     write_grid_to_file<colvar_grid_gradient>(czar_gradients, prefix + ".czar.grad", close);
 
     if (b_integrate) {
-      // Do numerical integration (to high precision) and output a PMF
+      // Do numerical integration (to high precision) and output a PMF,
+      // starting from the previous solution
       cvm::real err;
-      czar_pmf->set_div();
       czar_pmf->integrate(integrate_iterations, integrate_tol, err);
       czar_pmf->set_zero_minimum();
       write_grid_to_file<colvar_grid_scalar>(czar_pmf, prefix + ".czar.pmf", close);
@@ -732,6 +903,7 @@ int colvarbias_abf::read_gradients_samples()
       error_code |= z_gradients->read_multicol(z_gradients_in_name,
                                                "eABF z-gradient file",
                                                true);
+      czar_full_update = true;
     }
   }
 
@@ -804,6 +976,7 @@ std::istream & colvarbias_abf::read_state_data(std::istream& is)
     if (! z_gradients->read_raw(is)) {
       return is;
     }
+    czar_full_update = true;
   }
 
   return is;
@@ -871,11 +1044,7 @@ int colvarbias_abf::calc_energy(std::vector<colvarvalue> const *values)
 
     // Include the full_samples factor if necessary.
     unsigned int count = samples->value(ix);
-    cvm::real fact = 1.0;
-    if ( count < full_samples ) {
-      fact = (count < min_samples) ? 0.0 :
-        (cvm::real(count - min_samples)) / (cvm::real(full_samples - min_samples));
-    }
+    cvm::real const fact = force_ramp_factor(count);
     if (count > 0) sum += fact*gradients->value(ix)/count*gradients->widths[0];
   }
 
@@ -883,11 +1052,7 @@ int colvarbias_abf::calc_energy(std::vector<colvarvalue> const *values)
   std::vector<int> ix(1,home);
   cvm::real frac = gradients->current_bin_scalar_fraction(0);
   unsigned int count = samples->value(ix);
-  cvm::real fact = 1.0;
-  if ( count < full_samples ) {
-    fact = (count < min_samples) ? 0.0 :
-      (cvm::real(count - min_samples)) / (cvm::real(full_samples - min_samples));
-  }
+  cvm::real const fact = force_ramp_factor(count);
   if (count > 0)
     sum += fact*gradients->value(ix)/count*gradients->widths[0]*frac;
 
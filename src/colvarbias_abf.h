@@ -12,6 +12,7 @@
 
 #include <vector>
 #include <list>
+#include <map>
 #include <sstream>
 #include <iomanip>
 
@@ -57,12 +58,20 @@ private:
   size_t  full_samples;
   /// Number of samples per bin before applying a scaled-down biasing force
   size_t  min_samples;
+  /// Order of the interpolation of the biasing force between bins (0 = none)
+  int     interpolation_order;
   /// Write combined files with a history of all output data?
   bool    b_history_files;
   /// Write CZAR output file for stratified eABF (.zgrad)
   bool    b_czar_window_file;
   /// Number of timesteps between recording data in history files (if non-zero)
   size_t  history_freq;
+  /// Write history files in compact binary format?
+  bool    b_history_binary;
+  /// Number of frames between keyframes in binary history files
+  size_t  history_keyframe_freq;
+  /// Binary history files, indexed by the name of the corresponding text file
+  std::map<std::string, colvar_grid_history> history_binary_files;
   /// Umbrella Integration estimator of free energy from eABF
   UIestimator::UIestimator eabf_UI;
   /// Run UI estimator?
@@ -112,6 +121,30 @@ private:
   colvar_grid_gradient  *czar_gradients;
   /// n-dim grid of CZAR pmf (dimension 1 to 3)
   integrate_potential   *czar_pmf;
+  /// Whether the CZAR gradients must be recomputed over the whole grid
+  bool czar_full_update;
+  /// Points where the CZAR gradients were last updated
+  std::vector< std::vector<int> > czar_updated_bins;
+
+  /// Factor that ensures smooth introduction of the force in a bin
+  inline cvm::real force_ramp_factor(size_t count) const
+  {
+    if (count >= full_samples) return 1.0;
+    return (count < min_samples) ? 0.0 :
+      (cvm::real(count - min_samples)) / (cvm::real(full_samples - min_samples));
+  }
+
+  /// \brief Interpolate the mean force at the current values of the colvars
+  /// (each bin scaled by its own ramp factor), and the ramp factor itself;
+  /// the cubic interpolant is blended into the linear one as the bins
+  /// around the current point reach full samples
+  void interpolate_biasing_force(std::vector<cvm::real> &grad,
+                                 cvm::real &fact);
+
+  /// Work buffers of interpolate_biasing_force(), kept between calls
+  std::vector<size_t> interp_points, interp_cubic_points;
+  std::vector<cvm::real> interp_weights, interp_cubic_weights;
+  std::vector<cvm::real> interp_ramps, interp_bin_grad;
 
   inline int update_system_force(size_t i)
   {
@@ -143,6 +176,29 @@ private:
   colvar_grid_gradient  *last_gradients;
   colvar_grid_count     *last_samples;
 
+  /// \brief Whether the exchange of samples between replicas overlaps with
+  /// the following steps
+  bool shared_async;
+
+  /// Sum over replicas of the samples collected since the last exchange
+  colvarproxy_replicas::sparse_sum shared_sum;
+
+  /// Whether shared_sum was started and its result not yet applied
+  bool shared_pending;
+
+  /// Bins sent by this replica in the pending exchange
+  std::vector<size_t> shared_own_bins;
+
+  /// Count and gradient deltas sent by this replica in the pending exchange
+  std::vector<cvm::real> shared_own_deltas;
+
+  /// \brief Send the samples collected since the last exchange (only in the
+  /// bins that were visited)
+  int replica_share_start();
+
+  /// \brief Advance the pending exchange and apply its result once complete
+  int replica_share_progress(bool block);
+
   // For Tcl implementation of selection rules.
   /// Give the total number of bins for a given bias.
   virtual int bin_num();
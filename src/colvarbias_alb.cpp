@@ -403,6 +403,51 @@ std::ostream & colvarbias_alb::write_traj(std::ostream &os)
 }
 
 
+std::ostream & colvarbias_alb::write_traj_binary_label(std::ostream &os)
+{
+  colvarbias::write_traj_binary_label(os);
+
+  if (b_output_coupling)
+    for (size_t i = 0; i < current_coupling.size(); i++) {
+      os << "ForceConst_" << i << " scalar 1\n";
+    }
+
+  if (b_output_centers)
+    for (size_t i = 0; i < num_variables(); i++) {
+      cvm::write_traj_binary_column(os, "x0_"+colvars[i]->name,
+                                    colvar_centers[i]);
+    }
+
+  if (b_output_grad)
+    for (size_t i = 0; i < means.size(); i++) {
+      os << "Grad_" << colvars[i]->name << " scalar 1\n";
+    }
+
+  return os;
+}
+
+
+void colvarbias_alb::write_traj_binary(std::vector<cvm::real> &frame)
+{
+  colvarbias::write_traj_binary(frame);
+
+  if (b_output_coupling)
+    for (size_t i = 0; i < current_coupling.size(); i++) {
+      frame.push_back(current_coupling[i]);
+    }
+
+  if (b_output_centers)
+    for (size_t i = 0; i < num_variables(); i++) {
+      cvm::append_traj_binary(frame, colvar_centers[i]);
+    }
+
+  if (b_output_grad)
+    for (size_t i = 0; i < means.size(); i++) {
+      frame.push_back(-2.0 * (means[i] / (static_cast<cvm::real>(colvar_centers[i])) - 1) * ssd[i] / (fmax(update_calls, 2.0) - 1));
+    }
+}
+
+
 cvm::real colvarbias_alb::restraint_potential(cvm::real k,
                                               colvar const *x,
                                               colvarvalue const &xcenter) const
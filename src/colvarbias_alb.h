@@ -27,6 +27,8 @@ public:
   virtual int set_state_params(std::string const &conf);
   virtual std::ostream & write_traj_label(std::ostream &os);
   virtual std::ostream & write_traj(std::ostream &os);
+  virtual std::ostream & write_traj_binary_label(std::ostream &os);
+  virtual void write_traj_binary(std::vector<cvm::real> &frame);
 
 protected:
 
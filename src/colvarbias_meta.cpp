@@ -12,6 +12,7 @@
 #include <fstream>
 #include <iomanip>
 #include <algorithm>
+#include <iterator>
 
 // used to set the absolute path of a replica file
 #if defined(WIN32) && !defined(__CYGWIN__)
@@ -45,6 +46,7 @@ colvarbias_meta::colvarbias_meta(char const *key)
 
   use_grids = true;
   grids_freq = 0;
+  interpolation_order = 0;
   rebin_grids = false;
   hills_energy = NULL;
   hills_energy_gradients = NULL;
@@ -53,12 +55,20 @@ colvarbias_meta::colvarbias_meta(char const *key)
   keep_hills = false;
   restart_keep_hills = false;
   dump_fes_save = false;
+  dump_fes_history_binary = false;
+  history_keyframe_freq = 100;
   dump_replica_fes = false;
 
   b_hills_traj = false;
 
   ebmeta_equil_steps = 0L;
 
+  merge_replicas_grids = false;
+  replicas_hills_energy = NULL;
+  replicas_hills_energy_gradients = NULL;
+  borrowed_grids = false;
+  merged_state_read = false;
+
   replica_update_freq = 0;
   replica_id.clear();
 }
@@ -112,9 +122,9 @@ int colvarbias_meta::init(std::string const &conf)
   }
 
   if (colvar_sigmas.size() == 0) {
-    error_code |= cvm::error("Error: positive values are required for "
-                             "either hillWidth or gaussianSigmas.",
-                             COLVARS_INPUT_ERROR);
+    return error_code | cvm::error("Error: positive values are required for "
+                                   "either hillWidth or gaussianSigmas.\n",
+                                   COLVARS_INPUT_ERROR);
   }
 
   {
@@ -142,6 +152,17 @@ int colvarbias_meta::init(std::string const &conf)
     get_keyval(conf, "gridsUpdateFrequency", grids_freq, grids_freq);
     get_keyval(conf, "rebinGrids", rebin_grids, rebin_grids);
 
+    std::string interpolation("none");
+    get_keyval(conf, "gridInterpolation", interpolation, interpolation);
+    if (interpolation == "linear") {
+      interpolation_order = 1;
+    } else if (interpolation == "cubic") {
+      interpolation_order = 3;
+    } else if (interpolation != "none") {
+      return cvm::error("Error: gridInterpolation must be \"none\", "
+                        "\"linear\" or \"cubic\".\n", COLVARS_INPUT_ERROR);
+    }
+
     expand_grids = false;
     for (i = 0; i < num_variables(); i++) {
       variables(i)->enable(f_cv_grid); // Could be a child dependency of a f_cvb_use_grids feature
@@ -158,6 +179,18 @@ int colvarbias_meta::init(std::string const &conf)
 
     get_keyval(conf, "keepHills", keep_hills, keep_hills);
     get_keyval(conf, "keepFreeEnergyFiles", dump_fes_save, dump_fes_save);
+    if (dump_fes_save) {
+      std::string history_format("text");
+      get_keyval(conf, "historyFormat", history_format, history_format);
+      if (history_format == "binary") {
+        dump_fes_history_binary = true;
+      } else if (history_format != "text") {
+        return cvm::error("Error: historyFormat must be \"text\" or \"binary\".\n",
+                          COLVARS_INPUT_ERROR);
+      }
+      get_keyval(conf, "historyKeyframeFreq", history_keyframe_freq,
+                 history_keyframe_freq);
+    }
 
     if (hills_energy == NULL) {
       hills_energy           = new colvar_grid_scalar(colvars);
@@ -232,6 +265,19 @@ int colvarbias_meta::init_replicas_params(std::string const &conf)
                         COLVARS_INPUT_ERROR);
     }
 
+    get_keyval(conf, "mergeReplicaGrids", merge_replicas_grids,
+               merge_replicas_grids);
+    if (merge_replicas_grids) {
+      if (!use_grids) {
+        return cvm::error("Error: mergeReplicaGrids requires useGrids.\n",
+                          COLVARS_INPUT_ERROR);
+      }
+      if (replicas_hills_energy == NULL) {
+        replicas_hills_energy = new colvar_grid_scalar(colvars);
+        replicas_hills_energy_gradients = new colvar_grid_gradient(colvars);
+      }
+    }
+
     if (expand_grids) {
       return cvm::error("Error: expandBoundaries is not supported when "
                         "using more than one replicas; please allocate "
@@ -349,6 +395,12 @@ colvarbias_meta::~colvarbias_meta()
 
 int colvarbias_meta::clear_state_data()
 {
+  if (borrowed_grids) {
+    // These grids are owned by the local replica
+    hills_energy = NULL;
+    hills_energy_gradients = NULL;
+  }
+
   if (hills_energy) {
     delete hills_energy;
     hills_energy = NULL;
@@ -359,6 +411,16 @@ int colvarbias_meta::clear_state_data()
     hills_energy_gradients = NULL;
   }
 
+  if (replicas_hills_energy) {
+    delete replicas_hills_energy;
+    replicas_hills_energy = NULL;
+  }
+
+  if (replicas_hills_energy_gradients) {
+    delete replicas_hills_energy_gradients;
+    replicas_hills_energy_gradients = NULL;
+  }
+
   hills.clear();
   hills_off_grid.clear();
 
@@ -600,7 +662,9 @@ int colvarbias_meta::update_bias()
       cvm::real hills_energy_sum_here = 0.0;
       if (use_grids) {
         std::vector<int> curr_bin = hills_energy->get_colvars_index();
-        hills_energy_sum_here = hills_energy->value(curr_bin);
+        hills_energy_sum_here = interpolation_order ?
+          hills_energy->value_interpolated(NULL, interpolation_order) :
+          hills_energy->value(curr_bin);
       } else {
         calc_hills(new_hills_begin, hills.end(), hills_energy_sum_here, NULL);
       }
@@ -640,9 +704,7 @@ int colvarbias_meta::update_grid_data()
 {
   if ((cvm::step_absolute() % grids_freq) == 0) {
     // map the most recent gaussians to the grids
-    project_hills(new_hills_begin, hills.end(),
-                  hills_energy,    hills_energy_gradients);
-    new_hills_begin = hills.end();
+    project_new_hills();
 
     // TODO: we may want to condense all into one replicas array,
     // including "this" as the first element
@@ -651,6 +713,7 @@ int colvarbias_meta::update_grid_data()
         replicas[ir]->project_hills(replicas[ir]->new_hills_begin,
                                     replicas[ir]->hills.end(),
                                     replicas[ir]->hills_energy,
+                                    interpolation_order ? NULL :
                                     replicas[ir]->hills_energy_gradients);
         replicas[ir]->new_hills_begin = replicas[ir]->hills.end();
       }
@@ -677,7 +740,11 @@ int colvarbias_meta::calc_energy(std::vector<colvarvalue> const *values)
     // index is within the grid: get the energy from there
     for (ir = 0; ir < replicas.size(); ir++) {
 
-      bias_energy += replicas[ir]->hills_energy->value(curr_bin);
+      if (!replica_grids_counted(ir)) continue;
+      bias_energy += interpolation_order ?
+        replicas[ir]->hills_energy->value_interpolated(values,
+                                                       interpolation_order) :
+        replicas[ir]->hills_energy->value(curr_bin);
       if (cvm::debug()) {
         cvm::log("Metadynamics bias \""+this->name+"\""+
                  ((comm != single_replica) ? ", replica \""+replica_id+"\"" : "")+
@@ -727,8 +794,18 @@ int colvarbias_meta::calc_forces(std::vector<colvarvalue> const *values)
     hills_energy->get_colvars_index();
 
   if (hills_energy->index_ok(curr_bin)) {
+    std::vector<cvm::real> grad(num_variables());
     for (ir = 0; ir < replicas.size(); ir++) {
-      cvm::real const *f = &(replicas[ir]->hills_energy_gradients->value(curr_bin));
+      if (!replica_grids_counted(ir)) continue;
+      cvm::real const *f = &(grad[0]);
+      if (interpolation_order) {
+        // Derivative of the same function used to interpolate the energy
+        replicas[ir]->hills_energy->value_interpolated(values,
+                                                       interpolation_order,
+                                                       &(grad[0]));
+      } else {
+        f = &(replicas[ir]->hills_energy_gradients->value(curr_bin));
+      }
       for (ic = 0; ic < num_variables(); ic++) {
         // the gradients are stored, not the forces
         colvar_forces[ic].real_value += -1.0 * f[ic];
@@ -777,11 +854,13 @@ int colvarbias_meta::calc_forces(std::vector<colvarvalue> const *values)
 void colvarbias_meta::calc_hills(colvarbias_meta::hill_iter      h_first,
                                  colvarbias_meta::hill_iter      h_last,
                                  cvm::real                      &energy,
-                                 std::vector<colvarvalue> const *values)
+                                 std::vector<colvarvalue> const *values,
+                                 std::vector<cvm::real>         *hill_values)
 {
   size_t i = 0;
+  size_t ih = 0;
 
-  for (hill_iter h = h_first; h != h_last; h++) {
+  for (hill_iter h = h_first; h != h_last; h++, ih++) {
 
     // compute the gaussian exponent
     cvm::real cv_sqdev = 0.0;
@@ -792,14 +871,15 @@ void colvarbias_meta::calc_hills(colvarbias_meta::hill_iter      h_first,
       cv_sqdev += (variables(i)->dist2(x, center)) / (sigma*sigma);
     }
 
-    // compute the gaussian
-    if (cv_sqdev > 23.0) {
-      // set it to zero if the exponent is more negative than log(1.0E-06)
-      h->value(0.0);
+    // compute the gaussian (set it to zero if the exponent is more negative
+    // than log(1.0E-06))
+    cvm::real const value = (cv_sqdev > 23.0) ? 0.0 : cvm::exp(-0.5*cv_sqdev);
+    if (hill_values) {
+      (*hill_values)[ih] = value;
     } else {
-      h->value(cvm::exp(-0.5*cv_sqdev));
+      h->value(value);
     }
-    energy += h->energy();
+    energy += h->weight() * value;
   }
 }
 
@@ -808,7 +888,8 @@ void colvarbias_meta::calc_hills_force(size_t const &i,
                                        colvarbias_meta::hill_iter      h_first,
                                        colvarbias_meta::hill_iter      h_last,
                                        std::vector<colvarvalue>       &forces,
-                                       std::vector<colvarvalue> const *values)
+                                       std::vector<colvarvalue> const *values,
+                                       std::vector<cvm::real> const   *hill_values)
 {
   // Retrieve the value of the colvar
   colvarvalue const x(values ? (*values)[i] : colvar_values[i]);
@@ -818,15 +899,17 @@ void colvarbias_meta::calc_hills_force(size_t const &i,
   // colvars)
 
   hill_iter h;
+  size_t ih = 0;
   switch (x.type()) {
 
   case colvarvalue::type_scalar:
-    for (h = h_first; h != h_last; h++) {
-      if (h->value() == 0.0) continue;
+    for (h = h_first; h != h_last; h++, ih++) {
+      cvm::real const value = hill_values ? (*hill_values)[ih] : h->value();
+      if (value == 0.0) continue;
       colvarvalue const &center = h->centers[i];
       cvm::real const sigma = h->sigmas[i];
       forces[i].real_value +=
-        ( h->weight() * h->value() * (0.5 / (sigma*sigma)) *
+        ( h->weight() * value * (0.5 / (sigma*sigma)) *
           (variables(i)->dist2_lgrad(x, center)).real_value );
     }
     break;
@@ -834,35 +917,38 @@ void colvarbias_meta::calc_hills_force(size_t const &i,
   case colvarvalue::type_3vector:
   case colvarvalue::type_unit3vector:
   case colvarvalue::type_unit3vectorderiv:
-    for (h = h_first; h != h_last; h++) {
-      if (h->value() == 0.0) continue;
+    for (h = h_first; h != h_last; h++, ih++) {
+      cvm::real const value = hill_values ? (*hill_values)[ih] : h->value();
+      if (value == 0.0) continue;
       colvarvalue const &center = h->centers[i];
       cvm::real const sigma = h->sigmas[i];
       forces[i].rvector_value +=
-        ( h->weight() * h->value() * (0.5 / (sigma*sigma)) *
+        ( h->weight() * value * (0.5 / (sigma*sigma)) *
           (variables(i)->dist2_lgrad(x, center)).rvector_value );
     }
     break;
 
   case colvarvalue::type_quaternion:
   case colvarvalue::type_quaternionderiv:
-    for (h = h_first; h != h_last; h++) {
-      if (h->value() == 0.0) continue;
+    for (h = h_first; h != h_last; h++, ih++) {
+      cvm::real const value = hill_values ? (*hill_values)[ih] : h->value();
+      if (value == 0.0) continue;
       colvarvalue const &center = h->centers[i];
       cvm::real const sigma = h->sigmas[i];
       forces[i].quaternion_value +=
-        ( h->weight() * h->value() * (0.5 / (sigma*sigma)) *
+        ( h->weight() * value * (0.5 / (sigma*sigma)) *
           (variables(i)->dist2_lgrad(x, center)).quaternion_value );
     }
     break;
 
   case colvarvalue::type_vector:
-    for (h = h_first; h != h_last; h++) {
-      if (h->value() == 0.0) continue;
+    for (h = h_first; h != h_last; h++, ih++) {
+      cvm::real const value = hill_values ? (*hill_values)[ih] : h->value();
+      if (value == 0.0) continue;
       colvarvalue const &center = h->centers[i];
       cvm::real const sigma = h->sigmas[i];
       forces[i].vector1d_value +=
-        ( h->weight() * h->value() * (0.5 / (sigma*sigma)) *
+        ( h->weight() * value * (0.5 / (sigma*sigma)) *
           (variables(i)->dist2_lgrad(x, center)).vector1d_value );
     }
     break;
@@ -879,6 +965,16 @@ void colvarbias_meta::calc_hills_force(size_t const &i,
 // grid management functions
 // **********************************************************************
 
+struct colvarbias_meta::project_hills_args {
+  colvarbias_meta *bias;
+  hill_iter h_first;
+  hill_iter h_last;
+  colvar_grid_scalar *he;
+  colvar_grid_gradient *hg;
+  size_t num_tasks;
+};
+
+
 void colvarbias_meta::project_hills(colvarbias_meta::hill_iter  h_first,
                                     colvarbias_meta::hill_iter  h_last,
                                     colvar_grid_scalar         *he,
@@ -892,67 +988,142 @@ void colvarbias_meta::project_hills(colvarbias_meta::hill_iter  h_first,
 
   // TODO: improve it by looping over a small subgrid instead of the whole grid
 
+  if ((he != NULL) || (hg != NULL)) {
+
+    colvarproxy *proxy = cvm::proxy;
+    int const nx0 = static_cast<int>(he ? he->number_of_points(0) :
+                                     hg->number_of_points(0));
+    size_t const num_tasks =
+      (proxy->smp_enabled() == COLVARS_OK) ?
+      std::min(static_cast<size_t>(nx0),
+               static_cast<size_t>(4 * proxy->smp_num_threads())) : 1;
+
+    if (num_tasks > 1) {
+      // Split the grids into slices along the first variable
+      project_hills_args args = { this, h_first, h_last, he, hg, num_tasks };
+      proxy->smp_tasks(num_tasks, &colvarbias_meta::project_hills_task,
+                       reinterpret_cast<void *>(&args));
+    } else {
+      project_hills_slice(h_first, h_last, he, hg, 0, nx0, print_progress);
+    }
+
+  } else {
+    cvm::error("No grid object provided in metadynamics::project_hills()\n",
+               COLVARS_BUG_ERROR);
+  }
+
+  if (print_progress) {
+    cvm::log("100.00% done.\n");
+  }
+
+  if (! keep_hills) {
+    hills.erase(hills.begin(), hills.end());
+  }
+}
+
+
+void colvarbias_meta::project_new_hills()
+{
+  if (interpolation_order) {
+    // The forces are derived from the energy grid
+    hills_gradients_pending.insert(hills_gradients_pending.end(),
+                                   new_hills_begin, hills.end());
+    project_hills(new_hills_begin, hills.end(), hills_energy, NULL);
+  } else {
+    project_hills(new_hills_begin, hills.end(),
+                  hills_energy,    hills_energy_gradients);
+  }
+  new_hills_begin = hills.end();
+}
+
+
+void colvarbias_meta::project_pending_hills_gradients()
+{
+  if (hills_gradients_pending.empty()) return;
+  project_hills(hills_gradients_pending.begin(), hills_gradients_pending.end(),
+                NULL, hills_energy_gradients);
+  hills_gradients_pending.clear();
+}
+
+
+int colvarbias_meta::project_hills_task(size_t i, void *args_in)
+{
+  project_hills_args const &args =
+    *reinterpret_cast<project_hills_args *>(args_in);
+  int const nx0 = static_cast<int>(args.he ? args.he->number_of_points(0) :
+                                   args.hg->number_of_points(0));
+  int const ix0_begin = static_cast<int>((nx0 * i) / args.num_tasks);
+  int const ix0_end = static_cast<int>((nx0 * (i+1)) / args.num_tasks);
+  args.bias->project_hills_slice(args.h_first, args.h_last,
+                                 args.he, args.hg, ix0_begin, ix0_end, false);
+  return COLVARS_OK;
+}
+
+
+void colvarbias_meta::project_hills_slice(colvarbias_meta::hill_iter h_first,
+                                          colvarbias_meta::hill_iter h_last,
+                                          colvar_grid_scalar *he,
+                                          colvar_grid_gradient *hg,
+                                          int ix0_begin, int ix0_end,
+                                          bool print_progress)
+{
   std::vector<colvarvalue> new_colvar_values(num_variables());
   std::vector<cvm::real> colvar_forces_scalar(num_variables());
-
-  std::vector<int> he_ix = he->new_index();
-  std::vector<int> hg_ix = (hg != NULL) ? hg->new_index() : std::vector<int> (0);
+  // The values of the hills are stored here, so that the list of hills may
+  // be shared by concurrent tasks
+  std::vector<cvm::real> hill_values(std::distance(h_first, h_last));
+
+  // Both grids have the same points
+  colvar_grid<cvm::real> const *grid = he ?
+    static_cast<colvar_grid<cvm::real> const *>(he) :
+    static_cast<colvar_grid<cvm::real> const *>(hg);
+  std::vector<int> ix = grid->new_index();
+  ix[0] = ix0_begin;
   cvm::real hills_energy_here = 0.0;
   std::vector<colvarvalue> hills_forces_here(num_variables(), 0.0);
 
   size_t count = 0;
   size_t const print_frequency = ((hills.size() >= 1000000) ? 1 : (1000000/(hills.size()+1)));
 
-  if (hg != NULL) {
-
-    // loop over the points of the grid
-    for ( ;
-          (he->index_ok(he_ix)) && (hg->index_ok(hg_ix));
-          count++) {
-      size_t i;
-      for (i = 0; i < num_variables(); i++) {
-        new_colvar_values[i] = he->bin_to_value_scalar(he_ix[i], i);
-      }
+  // loop over the points of the grid
+  for ( ;
+        (grid->index_ok(ix)) && (ix[0] < ix0_end);
+        count++) {
+    size_t i;
+    for (i = 0; i < num_variables(); i++) {
+      new_colvar_values[i] = grid->bin_to_value_scalar(ix[i], i);
+    }
 
-      // loop over the hills and increment the energy grid locally
-      hills_energy_here = 0.0;
-      calc_hills(h_first, h_last, hills_energy_here, &new_colvar_values);
-      he->acc_value(he_ix, hills_energy_here);
+    // loop over the hills and increment the energy grid locally (this also
+    // computes the value of each hill, used by calc_hills_force())
+    hills_energy_here = 0.0;
+    calc_hills(h_first, h_last, hills_energy_here, &new_colvar_values,
+               &hill_values);
+    if (he) he->acc_value(ix, hills_energy_here);
 
+    if (hg) {
       for (i = 0; i < num_variables(); i++) {
         hills_forces_here[i].reset();
-        calc_hills_force(i, h_first, h_last, hills_forces_here, &new_colvar_values);
+        calc_hills_force(i, h_first, h_last, hills_forces_here,
+                         &new_colvar_values, &hill_values);
         colvar_forces_scalar[i] = hills_forces_here[i].real_value;
       }
-      hg->acc_force(hg_ix, &(colvar_forces_scalar.front()));
-
-      he->incr(he_ix);
-      hg->incr(hg_ix);
-
-      if ((count % print_frequency) == 0) {
-        if (print_progress) {
-          cvm::real const progress = cvm::real(count) / cvm::real(hg->number_of_points());
-          std::ostringstream os;
-          os.setf(std::ios::fixed, std::ios::floatfield);
-          os << std::setw(6) << std::setprecision(2)
-             << 100.0 * progress
-             << "% done.";
-          cvm::log(os.str());
-        }
-      }
+      hg->acc_force(ix, &(colvar_forces_scalar.front()));
     }
 
-  } else {
-    cvm::error("No grid object provided in metadynamics::project_hills()\n",
-               COLVARS_BUG_ERROR);
-  }
+    grid->incr(ix);
 
-  if (print_progress) {
-    cvm::log("100.00% done.\n");
-  }
-
-  if (! keep_hills) {
-    hills.erase(hills.begin(), hills.end());
+    if ((count % print_frequency) == 0) {
+      if (print_progress) {
+        cvm::real const progress = cvm::real(count) / cvm::real(grid->number_of_points());
+        std::ostringstream os;
+        os.setf(std::ios::fixed, std::ios::floatfield);
+        os << std::setw(6) << std::setprecision(2)
+           << 100.0 * progress
+           << "% done.";
+        cvm::log(os.str());
+      }
+    }
   }
 }
 
@@ -1070,7 +1241,12 @@ void colvarbias_meta::update_replicas_registry()
 
         (replicas.back())->comm = multiple_replicas;
 
-        if (use_grids) {
+        if (merge_replicas_grids) {
+          // Hills are projected directly onto the merged grids
+          (replicas.back())->borrowed_grids = true;
+          (replicas.back())->hills_energy           = replicas_hills_energy;
+          (replicas.back())->hills_energy_gradients = replicas_hills_energy_gradients;
+        } else if (use_grids) {
           (replicas.back())->hills_energy           = new colvar_grid_scalar(colvars);
           (replicas.back())->hills_energy_gradients = new colvar_grid_gradient(colvars);
         }
@@ -1128,6 +1304,31 @@ void colvarbias_meta::update_replicas_registry()
 
 void colvarbias_meta::read_replica_files()
 {
+  if (merge_replicas_grids) {
+    // A replica whose state was never read has no contribution yet, and its
+    // state is simply added to the merged grids below; the contribution of
+    // a replica that was already read cannot be removed: when its state file
+    // must be read again, rebuild the grids from all replicas
+    bool rebuild = false;
+    for (size_t ir = 1; ir < replicas.size(); ir++) {
+      if ((replicas[ir])->merged_state_read &&
+          (! (replicas[ir])->replica_state_file_in_sync) &&
+          (replicas[ir])->replica_state_file.size()) {
+        rebuild = true;
+      }
+    }
+    if (rebuild) {
+      cvm::log("Metadynamics bias \""+this->name+"\""+
+               ": rebuilding the grids of the other replicas.\n");
+      replicas_hills_energy->reset();
+      replicas_hills_energy_gradients->reset();
+      for (size_t ir = 1; ir < replicas.size(); ir++) {
+        (replicas[ir])->replica_state_file_in_sync = false;
+        (replicas[ir])->merged_state_read = false;
+      }
+    }
+  }
+
   // Note: we start from the 2nd replica.
   for (size_t ir = 1; ir < replicas.size(); ir++) {
 
@@ -1140,7 +1341,24 @@ void colvarbias_meta::read_replica_files()
                  (replicas[ir])->replica_id+"\" from file \""+
                  (replicas[ir])->replica_state_file+"\".\n");
         std::ifstream is((replicas[ir])->replica_state_file.c_str());
-        if ((replicas[ir])->read_state(is)) {
+        if ((replicas[ir])->borrowed_grids) {
+          // Read the grids of this replica into temporary grids
+          (replicas[ir])->hills_energy = new colvar_grid_scalar(colvars);
+          (replicas[ir])->hills_energy_gradients = new colvar_grid_gradient(colvars);
+        }
+        bool const state_read = !((replicas[ir])->read_state(is)).fail();
+        if ((replicas[ir])->borrowed_grids) {
+          if (state_read) {
+            replicas_hills_energy->add_grid(*((replicas[ir])->hills_energy));
+            replicas_hills_energy_gradients->add_grid(*((replicas[ir])->hills_energy_gradients));
+            (replicas[ir])->merged_state_read = true;
+          }
+          delete (replicas[ir])->hills_energy;
+          delete (replicas[ir])->hills_energy_gradients;
+          (replicas[ir])->hills_energy = replicas_hills_energy;
+          (replicas[ir])->hills_energy_gradients = replicas_hills_energy_gradients;
+        }
+        if (state_read) {
           // state file has been read successfully
           (replicas[ir])->replica_state_file_in_sync = true;
           (replicas[ir])->update_status = 0;
@@ -1168,8 +1386,11 @@ void colvarbias_meta::read_replica_files()
       (replicas[ir])->replica_hills_file_pos = 0;
     }
 
-    // now read the hills added after writing the state file
-    if ((replicas[ir])->replica_hills_file.size()) {
+    // now read the hills added after writing the state file (with merged
+    // grids, not before the state itself has been added)
+    if ((replicas[ir])->replica_hills_file.size() &&
+        !((replicas[ir])->borrowed_grids &&
+          !(replicas[ir])->merged_state_read)) {
 
       if (cvm::debug())
         cvm::log("Metadynamics bias \""+this->name+"\""+
@@ -1396,6 +1617,7 @@ std::istream & colvarbias_meta::read_state_data(std::istream& is)
                ((comm != single_replica) ? ", replica \""+replica_id+"\"" : "")+"\n");
 
     cvm::log("  read biasing energy and forces from grids.\n");
+    hills_gradients_pending.clear();
 
     if (hills_energy_backup != NULL) {
       // now that we have successfully updated the grids, delete the
@@ -1754,9 +1976,8 @@ std::ostream & colvarbias_meta::write_state_data(std::ostream& os)
 
     // this is a very good time to project hills, if you haven't done
     // it already!
-    project_hills(new_hills_begin, hills.end(),
-                  hills_energy,    hills_energy_gradients);
-    new_hills_begin = hills.end();
+    project_new_hills();
+    project_pending_hills_gradients();
 
     // write down the grids to the restart file
     os << "  hills_energy\n";
@@ -1822,6 +2043,16 @@ void colvarbias_meta::write_pmf()
     pmf->reset();
     pmf->add_grid(*hills_energy);
 
+    if (dump_fes_save && dump_fes_history_binary) {
+      // The sum of the hills changes only where new hills were added
+      if (replica_fes_history.file_name().empty()) {
+        replica_fes_history.init(this->output_prefix +
+                                 ((comm != single_replica) ? ".partial" : "") +
+                                 ".hist.pmf.bin", history_keyframe_freq);
+      }
+      replica_fes_history.write_frame(*pmf, cvm::step_absolute());
+    }
+
     if (ebmeta) {
       int nt_points=pmf->number_of_points();
       for (int i = 0; i < nt_points; i++) {
@@ -1845,7 +2076,7 @@ void colvarbias_meta::write_pmf()
     {
       std::string const fes_file_name(this->output_prefix +
                                       ((comm != single_replica) ? ".partial" : "") +
-                                      (dump_fes_save ?
+                                      ((dump_fes_save && !dump_fes_history_binary) ?
                                        "."+cvm::to_str(cvm::step_absolute()) : "") +
                                       ".pmf");
       cvm::proxy->backup_file(fes_file_name);
@@ -1860,9 +2091,18 @@ void colvarbias_meta::write_pmf()
     pmf->reset();
     // current replica already included in the pools of replicas
     for (size_t ir = 0; ir < replicas.size(); ir++) {
+      if (!replica_grids_counted(ir)) continue;
       pmf->add_grid(*(replicas[ir]->hills_energy));
     }
 
+    if (dump_fes_save && dump_fes_history_binary) {
+      if (fes_history.file_name().empty()) {
+        fes_history.init(this->output_prefix + ".hist.pmf.bin",
+                         history_keyframe_freq);
+      }
+      fes_history.write_frame(*pmf, cvm::step_absolute());
+    }
+
     if (ebmeta) {
       int nt_points=pmf->number_of_points();
       for (int i = 0; i < nt_points; i++) {
@@ -1884,7 +2124,7 @@ void colvarbias_meta::write_pmf()
       pmf->multiply_constant(well_temper_scale);
     }
     std::string const fes_file_name(this->output_prefix +
-                                    (dump_fes_save ?
+                                    ((dump_fes_save && !dump_fes_history_binary) ?
                                      "."+cvm::to_str(cvm::step_absolute()) : "") +
                                     ".pmf");
     cvm::proxy->backup_file(fes_file_name);
@@ -122,20 +122,24 @@ protected:
   std::list<hill>::const_iterator delete_hill(hill_iter &h);
 
   /// \brief Calculate the values of the hills, incrementing
-  /// bias_energy
+  /// bias_energy; if hill_values is given, the values are stored there
+  /// (in the order of the hills) instead of in each hill
   virtual void calc_hills(hill_iter  h_first,
                           hill_iter  h_last,
                           cvm::real &energy,
-                          std::vector<colvarvalue> const *values);
+                          std::vector<colvarvalue> const *values,
+                          std::vector<cvm::real> *hill_values = NULL);
 
   /// \brief Calculate the forces acting on the i-th colvar,
   /// incrementing colvar_forces[i]; must be called after calc_hills
-  /// each time the values of the colvars are changed
+  /// each time the values of the colvars are changed (with the same
+  /// hill_values, if given)
   virtual void calc_hills_force(size_t const &i,
                                 hill_iter h_first,
                                 hill_iter h_last,
                                 std::vector<colvarvalue> &forces,
-                                std::vector<colvarvalue> const *values);
+                                std::vector<colvarvalue> const *values,
+                                std::vector<cvm::real> const *hill_values = NULL);
 
 
   /// Height of new hills
@@ -154,6 +158,9 @@ protected:
   /// \brief How often the hills should be projected onto the grids
   size_t     grids_freq;
 
+  /// \brief Order of the interpolation of the grids between bins (0 = none)
+  int        interpolation_order;
+
   /// Keep hills in the restart file (e.g. to accurately rebin later)
   bool       keep_hills;
 
@@ -171,6 +178,20 @@ protected:
   /// time steps, appending the step number to each file
   bool       dump_fes_save;
 
+  /// \brief Instead of separate PMF files, append the sum of the hills
+  /// (before shifting and scaling it into a PMF) to a compact binary history
+  /// file
+  bool       dump_fes_history_binary;
+
+  /// Number of frames between keyframes in binary history files
+  size_t     history_keyframe_freq;
+
+  /// Binary history of the sum of the hills
+  colvar_grid_history fes_history;
+
+  /// Binary history of the sum of the hills from this replica only
+  colvar_grid_history replica_fes_history;
+
   /// \brief Whether to use well-tempered metadynamics
   bool       well_tempered;
 
@@ -198,11 +219,36 @@ protected:
   /// Hill forces, cached on a grid
   colvar_grid_gradient  *hills_energy_gradients;
 
-  /// \brief Project the selected hills onto grids
+  /// \brief Hills projected onto hills_energy but not yet onto
+  /// hills_energy_gradients, which are not used to compute the forces when
+  /// interpolating the grids (they are needed only for state files)
+  std::list<hill> hills_gradients_pending;
+
+  /// \brief Project the selected hills onto grids (either grid may be NULL)
   void project_hills(hill_iter h_first, hill_iter h_last,
                       colvar_grid_scalar *ge, colvar_grid_gradient *gf,
                       bool print_progress = false);
 
+  /// \brief Project the hills from new_hills_begin onto the grids (only
+  /// onto hills_energy when interpolating, see hills_gradients_pending)
+  void project_new_hills();
+
+  /// Project hills_gradients_pending onto hills_energy_gradients
+  void project_pending_hills_gradients();
+
+  /// \brief Project the selected hills onto the grid points whose first
+  /// index is between ix0_begin (included) and ix0_end (excluded)
+  void project_hills_slice(hill_iter h_first, hill_iter h_last,
+                           colvar_grid_scalar *he, colvar_grid_gradient *hg,
+                           int ix0_begin, int ix0_end, bool print_progress);
+
+  /// Arguments of project_hills_task()
+  struct project_hills_args;
+
+  /// \brief Project the hills onto the i-th slice of the grids (run as a
+  /// task by project_hills())
+  static int project_hills_task(size_t i, void *args);
+
 
   // Multiple Replicas variables and functions
 
@@ -231,6 +277,31 @@ protected:
   /// other replicas, and not be modified by the "local" replica
   std::vector<colvarbias_meta *> replicas;
 
+  /// \brief Accumulate the hills of all other replicas onto a single pair
+  /// of grids, instead of one pair for each "mirror" bias
+  bool                   merge_replicas_grids;
+
+  /// Energy of the hills of all other replicas (if merge_replicas_grids)
+  colvar_grid_scalar    *replicas_hills_energy;
+
+  /// Gradients of the hills of all other replicas (if merge_replicas_grids)
+  colvar_grid_gradient  *replicas_hills_energy_gradients;
+
+  /// \brief If true (only in "mirror" biases), hills_energy and
+  /// hills_energy_gradients point to the merged grids of the local replica
+  bool                   borrowed_grids;
+
+  /// \brief If true (only in "mirror" biases with borrowed grids), the
+  /// state of this replica has been added to the merged grids
+  bool                   merged_state_read;
+
+  /// \brief Whether the grids of replicas[ir] are included when summing
+  /// over replicas (the merged grids are counted only once)
+  inline bool replica_grids_counted(size_t ir) const
+  {
+    return !(replicas[ir]->borrowed_grids && (ir > 1));
+  }
+
   /// \brief Frequency at which data the "mirror" biases are updated
   size_t                 replica_update_freq;
 
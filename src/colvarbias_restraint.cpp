@@ -49,7 +49,7 @@ int colvarbias_restraint::update()
     bias_energy += restraint_potential(i);
     colvar_forces[i].type(variables(i)->value());
     colvar_forces[i].is_derivative();
-    colvar_forces[i] = restraint_force(i);
+    calc_restraint_force(i, colvar_forces[i]);
   }
 
   if (cvm::debug())
@@ -68,6 +68,13 @@ colvarbias_restraint::~colvarbias_restraint()
 }
 
 
+void colvarbias_restraint::calc_restraint_force(size_t i,
+                                                colvarvalue &force) const
+{
+  force = restraint_force(i);
+}
+
+
 std::string const colvarbias_restraint::get_state_params() const
 {
   return colvarbias::get_state_params();
@@ -491,6 +498,37 @@ std::ostream & colvarbias_restraint_centers_moving::write_traj(std::ostream &os)
 }
 
 
+std::ostream & colvarbias_restraint_centers_moving::write_traj_binary_label(std::ostream &os)
+{
+  if (b_output_centers) {
+    for (size_t i = 0; i < num_variables(); i++) {
+      cvm::write_traj_binary_column(os, "x0_"+variables(i)->name,
+                                    colvar_centers[i]);
+    }
+  }
+
+  if (b_chg_centers && is_enabled(f_cvb_output_acc_work)) {
+    os << "W_" << this->name << " scalar 1\n";
+  }
+
+  return os;
+}
+
+
+void colvarbias_restraint_centers_moving::write_traj_binary(std::vector<cvm::real> &frame)
+{
+  if (b_output_centers) {
+    for (size_t i = 0; i < num_variables(); i++) {
+      cvm::append_traj_binary(frame, colvar_centers[i]);
+    }
+  }
+
+  if (b_chg_centers && is_enabled(f_cvb_output_acc_work)) {
+    frame.push_back(acc_work);
+  }
+}
+
+
 
 colvarbias_restraint_k_moving::colvarbias_restraint_k_moving(char const *key)
   : colvarbias(key),
@@ -709,6 +747,23 @@ std::ostream & colvarbias_restraint_k_moving::write_traj(std::ostream &os)
 }
 
 
+std::ostream & colvarbias_restraint_k_moving::write_traj_binary_label(std::ostream &os)
+{
+  if (b_chg_force_k && is_enabled(f_cvb_output_acc_work)) {
+    os << "W_" << this->name << " scalar 1\n";
+  }
+  return os;
+}
+
+
+void colvarbias_restraint_k_moving::write_traj_binary(std::vector<cvm::real> &frame)
+{
+  if (b_chg_force_k && is_enabled(f_cvb_output_acc_work)) {
+    frame.push_back(acc_work);
+  }
+}
+
+
 
 colvarbias_restraint_harmonic::colvarbias_restraint_harmonic(char const *key)
   : colvarbias(key),
@@ -780,6 +835,19 @@ colvarvalue const colvarbias_restraint_harmonic::restraint_force(size_t i) const
 }
 
 
+void colvarbias_restraint_harmonic::calc_restraint_force(size_t i,
+                                                         colvarvalue &force) const
+{
+  if (variables(i)->value().type() != colvarvalue::type_vector) {
+    // Other types have no dynamically allocated storage
+    force = restraint_force(i);
+    return;
+  }
+  variables(i)->dist2_lgrad(variables(i)->value(), colvar_centers[i], force);
+  force *= -0.5 * force_k / (variables(i)->width * variables(i)->width);
+}
+
+
 cvm::real colvarbias_restraint_harmonic::d_restraint_potential_dk(size_t i) const
 {
   return 0.5 / (variables(i)->width * variables(i)->width) *
@@ -837,6 +905,23 @@ std::ostream & colvarbias_restraint_harmonic::write_traj(std::ostream &os)
 }
 
 
+std::ostream & colvarbias_restraint_harmonic::write_traj_binary_label(std::ostream &os)
+{
+  colvarbias_restraint::write_traj_binary_label(os);
+  colvarbias_restraint_centers_moving::write_traj_binary_label(os);
+  colvarbias_restraint_k_moving::write_traj_binary_label(os);
+  return os;
+}
+
+
+void colvarbias_restraint_harmonic::write_traj_binary(std::vector<cvm::real> &frame)
+{
+  colvarbias_restraint::write_traj_binary(frame);
+  colvarbias_restraint_centers_moving::write_traj_binary(frame);
+  colvarbias_restraint_k_moving::write_traj_binary(frame);
+}
+
+
 int colvarbias_restraint_harmonic::change_configuration(std::string const &conf)
 {
   return colvarbias_restraint_centers::change_configuration(conf) |
@@ -1134,6 +1219,21 @@ std::ostream & colvarbias_restraint_harmonic_walls::write_traj(std::ostream &os)
 }
 
 
+std::ostream & colvarbias_restraint_harmonic_walls::write_traj_binary_label(std::ostream &os)
+{
+  colvarbias_restraint::write_traj_binary_label(os);
+  colvarbias_restraint_k_moving::write_traj_binary_label(os);
+  return os;
+}
+
+
+void colvarbias_restraint_harmonic_walls::write_traj_binary(std::vector<cvm::real> &frame)
+{
+  colvarbias_restraint::write_traj_binary(frame);
+  colvarbias_restraint_k_moving::write_traj_binary(frame);
+}
+
+
 
 colvarbias_restraint_linear::colvarbias_restraint_linear(char const *key)
   : colvarbias(key),
@@ -1293,6 +1393,23 @@ std::ostream & colvarbias_restraint_linear::write_traj(std::ostream &os)
 }
 
 
+std::ostream & colvarbias_restraint_linear::write_traj_binary_label(std::ostream &os)
+{
+  colvarbias_restraint::write_traj_binary_label(os);
+  colvarbias_restraint_centers_moving::write_traj_binary_label(os);
+  colvarbias_restraint_k_moving::write_traj_binary_label(os);
+  return os;
+}
+
+
+void colvarbias_restraint_linear::write_traj_binary(std::vector<cvm::real> &frame)
+{
+  colvarbias_restraint::write_traj_binary(frame);
+  colvarbias_restraint_centers_moving::write_traj_binary(frame);
+  colvarbias_restraint_k_moving::write_traj_binary(frame);
+}
+
+
 
 colvarbias_restraint_histogram::colvarbias_restraint_histogram(char const *key)
   : colvarbias(key)
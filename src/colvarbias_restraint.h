@@ -59,6 +59,10 @@ protected:
   /// \brief Force function for the i-th colvar
   virtual colvarvalue const restraint_force(size_t i) const = 0;
 
+  /// \brief Store the force for the i-th colvar in force (by default, a
+  /// copy of restraint_force(i)); derived classes may reuse its storage
+  virtual void calc_restraint_force(size_t i, colvarvalue &force) const;
+
   /// \brief Derivative of the potential function with respect to the force constant
   virtual cvm::real d_restraint_potential_dk(size_t i) const = 0;
 };
@@ -158,6 +162,8 @@ public:
   virtual int set_state_params(std::string const &conf);
   virtual std::ostream & write_traj_label(std::ostream &os);
   virtual std::ostream & write_traj(std::ostream &os);
+  virtual std::ostream & write_traj_binary_label(std::ostream &os);
+  virtual void write_traj_binary(std::vector<cvm::real> &frame);
 
 protected:
 
@@ -197,6 +203,8 @@ public:
   virtual int set_state_params(std::string const &conf);
   virtual std::ostream & write_traj_label(std::ostream &os);
   virtual std::ostream & write_traj(std::ostream &os);
+  virtual std::ostream & write_traj_binary_label(std::ostream &os);
+  virtual void write_traj_binary(std::vector<cvm::real> &frame);
 
 protected:
 
@@ -240,6 +248,8 @@ public:
   virtual std::istream & read_state_data(std::istream &os);
   virtual std::ostream & write_traj_label(std::ostream &os);
   virtual std::ostream & write_traj(std::ostream &os);
+  virtual std::ostream & write_traj_binary_label(std::ostream &os);
+  virtual void write_traj_binary(std::vector<cvm::real> &frame);
   virtual int change_configuration(std::string const &conf);
   virtual cvm::real energy_difference(std::string const &conf);
 
@@ -247,6 +257,7 @@ protected:
 
   virtual cvm::real restraint_potential(size_t i) const;
   virtual colvarvalue const restraint_force(size_t i) const;
+  virtual void calc_restraint_force(size_t i, colvarvalue &force) const;
   virtual cvm::real d_restraint_potential_dk(size_t i) const;
 };
 
@@ -267,6 +278,8 @@ public:
   virtual std::istream & read_state_data(std::istream &os);
   virtual std::ostream & write_traj_label(std::ostream &os);
   virtual std::ostream & write_traj(std::ostream &os);
+  virtual std::ostream & write_traj_binary_label(std::ostream &os);
+  virtual void write_traj_binary(std::vector<cvm::real> &frame);
 
 protected:
 
@@ -309,6 +322,8 @@ public:
   virtual std::istream & read_state_data(std::istream &os);
   virtual std::ostream & write_traj_label(std::ostream &os);
   virtual std::ostream & write_traj(std::ostream &os);
+  virtual std::ostream & write_traj_binary_label(std::ostream &os);
+  virtual void write_traj_binary(std::vector<cvm::real> &frame);
 
 protected:
 
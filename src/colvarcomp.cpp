@@ -20,6 +20,10 @@ colvar::cvc::cvc()
 {
   description = "uninitialized colvar component";
   b_try_scalable = true;
+  read_data_profile_slot = -1;
+  calc_value_profile_slot = -1;
+  calc_gradients_profile_slot = -1;
+  apply_force_profile_slot = -1;
   sup_coeff = 1.0;
   sup_np = 1;
   period = 0.0;
@@ -33,6 +37,10 @@ colvar::cvc::cvc(std::string const &conf)
 {
   description = "uninitialized colvar component";
   b_try_scalable = true;
+  read_data_profile_slot = -1;
+  calc_value_profile_slot = -1;
+  calc_gradients_profile_slot = -1;
+  apply_force_profile_slot = -1;
   sup_coeff = 1.0;
   sup_np = 1;
   period = 0.0;
@@ -172,9 +180,13 @@ cvm::atom_group *colvar::cvc::parse_group(std::string const &conf,
         // The CVC makes the feature available;
         // the atom group will enable it unless it needs to compute a rotational fit
         group->provide(f_ag_scalable_com);
+      } else if (is_available(f_cvc_scalable_reductions)
+                 && !is_enabled(f_cvc_debug_gradient)) {
+        disable(f_cvc_explicit_gradient);
+        enable(f_cvc_scalable_reductions);
+        // Scalable groups always compute their center of mass as well
+        group->provide(f_ag_scalable_com);
       }
-
-      // TODO check for other types of parallelism here
     }
 
     if (group_conf.size() == 0) {
@@ -262,6 +274,10 @@ int colvar::cvc::init_dependencies() {
     // CVC cannot compute atom-level gradients if computed on atom group COM
     exclude_feature_self(f_cvc_scalable_com, f_cvc_explicit_gradient);
 
+    init_feature(f_cvc_scalable_reductions, "scalable_calculation_of_reductions", f_type_static);
+    require_feature_self(f_cvc_scalable_reductions, f_cvc_scalable);
+    exclude_feature_self(f_cvc_scalable_reductions, f_cvc_explicit_gradient);
+
     init_feature(f_cvc_collect_atom_ids, "collect_atom_ids", f_type_dynamic);
     require_feature_children(f_cvc_collect_atom_ids, f_ag_collect_atom_ids);
 
@@ -306,7 +322,10 @@ int colvar::cvc::init_dependencies() {
 
   // Features That are implemented only for certain simulation engine configurations
   feature_states[f_cvc_scalable_com].available = (cvm::proxy->scalable_group_coms() == COLVARS_OK);
-  feature_states[f_cvc_scalable].available = feature_states[f_cvc_scalable_com].available;
+  // Provided by the CVCs that can use reductions, if the engine supports them
+  feature_states[f_cvc_scalable_reductions].available = false;
+  feature_states[f_cvc_scalable].available = feature_states[f_cvc_scalable_com].available ||
+    (cvm::proxy->scalable_group_reductions() == COLVARS_OK);
 
   return COLVARS_OK;
 }
@@ -315,6 +334,12 @@ int colvar::cvc::init_dependencies() {
 int colvar::cvc::setup()
 {
   description = "cvc " + name;
+  read_data_profile_slot = cvm::main()->profile_slot(description, "read_data");
+  calc_value_profile_slot = cvm::main()->profile_slot(description, "calc_value");
+  calc_gradients_profile_slot = cvm::main()->profile_slot(description,
+                                                          "calc_gradients");
+  apply_force_profile_slot = cvm::main()->profile_slot(description,
+                                                       "apply_force");
   return COLVARS_OK;
 }
 
@@ -458,33 +483,29 @@ void colvar::cvc::collect_gradients(std::vector<int> const &atom_ids, std::vecto
   for (size_t j = 0; j < atom_groups.size(); j++) {
 
     cvm::atom_group &ag = *(atom_groups[j]);
+    std::vector<int> const &ag_index = ag.collect_index(atom_ids);
 
     // If necessary, apply inverse rotation to get atomic
     // gradient in the laboratory frame
     if (ag.is_enabled(f_ag_rotate)) {
       cvm::rotation const rot_inv = ag.rot.inverse();
 
-      for (size_t k = 0; k < ag.size(); k++) {
-        size_t a = std::lower_bound(atom_ids.begin(), atom_ids.end(),
-                                    ag[k].id) - atom_ids.begin();
-        atomic_gradients[a] += coeff * rot_inv.rotate(ag[k].grad);
+      for (size_t k = 0; k < ag_index.size(); k++) {
+        atomic_gradients[ag_index[k]] += coeff * rot_inv.rotate(ag[k].grad());
       }
 
     } else {
 
-      for (size_t k = 0; k < ag.size(); k++) {
-        size_t a = std::lower_bound(atom_ids.begin(), atom_ids.end(),
-                                    ag[k].id) - atom_ids.begin();
-        atomic_gradients[a] += coeff * ag[k].grad;
+      for (size_t k = 0; k < ag_index.size(); k++) {
+        atomic_gradients[ag_index[k]] += coeff * ag[k].grad();
       }
     }
     if (ag.is_enabled(f_ag_fitting_group) && ag.is_enabled(f_ag_fit_gradients)) {
-      cvm::atom_group const &fg = *(ag.fitting_group);
-      for (size_t k = 0; k < fg.size(); k++) {
-        size_t a = std::lower_bound(atom_ids.begin(), atom_ids.end(),
-                                    fg[k].id) - atom_ids.begin();
+      cvm::atom_group &fg = *(ag.fitting_group);
+      std::vector<int> const &fg_index = fg.collect_index(atom_ids);
+      for (size_t k = 0; k < fg_index.size(); k++) {
         // fit gradients are in the unrotated (simulation) frame
-        atomic_gradients[a] += coeff * fg.fit_gradients[k];
+        atomic_gradients[fg_index[k]] += coeff * fg.fit_gradients[k];
       }
     }
   }
@@ -561,15 +582,15 @@ void colvar::cvc::debug_gradients()
 
       // tests are best conducted in the unrotated (simulation) frame
       cvm::rvector const atom_grad = (group->is_enabled(f_ag_rotate) ?
-                                      rot_inv.rotate((*group)[ia].grad) :
-                                      (*group)[ia].grad);
+                                      rot_inv.rotate((*group)[ia].grad()) :
+                                      (*group)[ia].grad());
       gradient_sum += atom_grad;
 
       for (size_t id = 0; id < 3; id++) {
         // (re)read original positions
         group->read_positions();
         // change one coordinate
-        (*group)[ia].pos[id] += cvm::debug_gradients_step_size;
+        (*group)[ia].pos()[id] += cvm::debug_gradients_step_size;
         group->calc_required_properties();
         calc_value();
         cvm::real x_1 = x.real_value;
@@ -604,7 +625,7 @@ void colvar::cvc::debug_gradients()
           group->read_positions();
           ref_group->read_positions();
           // change one coordinate
-          (*ref_group)[ia].pos[id] += cvm::debug_gradients_step_size;
+          (*ref_group)[ia].pos()[id] += cvm::debug_gradients_step_size;
           group->calc_required_properties();
           calc_value();
 
@@ -275,6 +275,11 @@ public:
   /// \brief Whether or not this CVC will be computed in parallel whenever possible
   bool b_try_scalable;
 
+  /// Slots of the profile for read_data(), calc_value(), calc_gradients()
+  /// and apply_force()
+  int read_data_profile_slot, calc_value_profile_slot,
+    calc_gradients_profile_slot, apply_force_profile_slot;
+
   /// Forcibly set value of CVC - useful for driving an external coordinate,
   /// eg. lambda dynamics
   inline void set_value(colvarvalue const &new_value) {
@@ -592,6 +597,10 @@ protected:
   cvm::atom_group  *group1;
   /// Second atom group
   cvm::atom_group  *group2;
+  /// Distance vectors between one atom of group1 and all atoms of group2
+  std::vector<cvm::rvector> pair_dists;
+  /// Compute pair_dists for the atom i1 of group1
+  void calc_pair_dists(size_t i1);
 public:
   distance_pairs(std::string const &conf);
   distance_pairs();
@@ -640,6 +649,33 @@ class colvar::gyration
 protected:
   /// Atoms involved
   cvm::atom_group  *atoms;
+
+  /// Reduction computing the sum of the positions (scalable group only)
+  int sum_pos_reduction;
+
+  /// \brief Reduction computing the sum of the outer products of the
+  /// positions (scalable group only)
+  int sum_pos2_reduction;
+
+  /// \brief Reference point of the reductions when their current values
+  /// were computed, as reported by the engine (scalable group only)
+  cvm::atom_pos scalable_center;
+
+  /// \brief Reference point of the reductions from the next evaluation,
+  /// i.e. the current center of geometry (scalable group only)
+  cvm::atom_pos scalable_center_next;
+
+  /// \brief Scatter matrix of the positions around their center, computed
+  /// from the reductions of a scalable group; also moves the reference point
+  /// of the reductions to the current center, so that their sums do not
+  /// grow with the distance of the group from the origin
+  cvm::rmatrix calc_scalable_scatter_matrix();
+
+  /// \brief Apply force times the gradient of a function of the scatter
+  /// matrix through the reductions of a scalable group \param dxdq Derivatives
+  /// of the function with respect to the scatter matrix (symmetric)
+  void apply_scalable_force(cvm::real force, cvm::rmatrix const &dxdq) const;
+
 public:
   gyration(std::string const &conf);
   virtual ~gyration() {}
@@ -871,6 +907,23 @@ public:
   virtual ~dihedral() {}
   virtual void calc_value();
   virtual void calc_gradients();
+
+  /// \brief Value (in degrees, not wrapped) of the dihedral angle defined by
+  /// the inter-site vectors r12, r23 and r34
+  static cvm::real dihedral_value(cvm::rvector const &r12,
+                                  cvm::rvector const &r23,
+                                  cvm::rvector const &r34);
+
+  /// \brief Compute the vectors f1, f2 and f3 such that the gradients of the
+  /// dihedral angle (in degrees) with respect to the four sites are -f1,
+  /// f1-f2, f2-f3 and f3, respectively
+  static void dihedral_gradients(cvm::rvector const &r12,
+                                 cvm::rvector const &r23,
+                                 cvm::rvector const &r34,
+                                 cvm::rvector &f1,
+                                 cvm::rvector &f2,
+                                 cvm::rvector &f3);
+
   virtual void calc_force_invgrads();
   virtual void calc_Jacobian_derivative();
   virtual void apply_force(colvarvalue const &force);
@@ -917,12 +970,29 @@ protected:
   /// Tolerance for the pair list
   cvm::real tolerance;
 
-  /// Frequency of update of the pair list
+  /// Frequency of update of the pair list, in number of evaluations
   int pairlist_freq;
 
   /// Pair list
   bool *pairlist;
 
+  /// \brief Pair list skin: if positive, the pair list is rebuilt only
+  /// when an atom moved by more than half of it since the last build
+  cvm::real pairlist_skin;
+
+  /// Number of evaluations since the last build of the pair list (-1 if never
+  /// built)
+  int pairlist_num_evals;
+
+  /// Positions of group1 and group2 (or its center) at the last build
+  std::vector<cvm::atom_pos> pairlist_ref_pos;
+
+  /// Whether the pair list must be rebuilt at this evaluation
+  bool pairlist_needs_rebuild();
+
+  /// Distance vectors between one atom of group1 and all atoms of group2
+  std::vector<cvm::rvector> pair_dists;
+
 public:
 
   coordnum(std::string const &conf);
@@ -961,7 +1031,31 @@ public:
                                       cvm::atom &A1,
                                       cvm::atom &A2,
                                       bool **pairlist_elem,
-                                      cvm::real tolerance);
+                                      cvm::real tolerance,
+                                      cvm::real pairlist_skin = 0.0);
+
+  /// \brief Same as above, using the precomputed distance vector diff
+  /// between A1 and A2 (pair list elements are only written, not read)
+  /// \param pairlist_skin When rebuilding the pair list, include the pair
+  /// if it would be within the tolerance with its distance shortened by this
+  /// amount (in units of the cutoff)
+  template<int flags>
+  static cvm::real switching_function(cvm::real const &r0,
+                                      cvm::rvector const &r0_vec,
+                                      int en,
+                                      int ed,
+                                      cvm::rvector const &diff,
+                                      cvm::atom &A1,
+                                      cvm::atom &A2,
+                                      bool **pairlist_elem,
+                                      cvm::real tolerance,
+                                      cvm::real pairlist_skin = 0.0);
+
+  /// \brief Whether any of the n positions pos moved from ref_pos by more
+  /// than sqrt(max_disp2) (minimum-image convention)
+  static bool positions_displaced(cvm::atom_pos const *ref_pos,
+                                  cvm::atom_pos const *pos, size_t n,
+                                  cvm::real max_disp2);
 
   /// Workhorse function
   template<int flags> int compute_coordnum();
@@ -992,6 +1086,22 @@ protected:
   int pairlist_freq;
   bool *pairlist;
 
+  /// Pair list skin (see coordnum::pairlist_skin)
+  cvm::real pairlist_skin;
+
+  /// Number of evaluations since the last build of the pair list (-1 if never
+  /// built)
+  int pairlist_num_evals;
+
+  /// Positions of group1 at the last build of the pair list
+  std::vector<cvm::atom_pos> pairlist_ref_pos;
+
+  /// Whether the pair list must be rebuilt at this evaluation
+  bool pairlist_needs_rebuild();
+
+  /// Distance vectors between one atom and all the following ones
+  std::vector<cvm::rvector> pair_dists;
+
 public:
 
   selfcoordnum(std::string const &conf);
@@ -1009,6 +1119,10 @@ public:
 
   /// Main workhorse function
   template<int flags> int compute_selfcoordnum();
+
+  /// Loop over all pairs using batched distance calculations
+  template<int flags> void main_loop(cvm::rvector const &r0_vec,
+                                     bool **pairlist_elem);
 };
 
 
@@ -1140,11 +1254,37 @@ protected:
   /// Tolerance on the Calpha-Calpha angle
   cvm::real theta_tol;
 
-  /// List of Calpha-Calpha angles
-  std::vector<angle *> theta;
+  /// \brief Indices in atom_groups[0] of the three atoms of each
+  /// Calpha-Calpha-Calpha angle
+  std::vector<int> theta_atoms;
+
+  /// Values of the Calpha-Calpha-Calpha angles (degrees)
+  std::vector<cvm::real> theta;
+
+  /// Distance vectors from the central to the first Calpha of each angle
+  std::vector<cvm::rvector> theta_r21;
+
+  /// Distance vectors from the central to the third Calpha of each angle
+  std::vector<cvm::rvector> theta_r23;
+
+  /// \brief Indices in atom_groups[0] of the acceptor and donor atoms of each
+  /// hydrogen bond
+  std::vector<int> hb_atoms;
+
+  /// Values of the hydrogen bond terms
+  std::vector<cvm::real> hb;
+
+  /// Distance vectors between acceptor and donor of each hydrogen bond
+  std::vector<cvm::rvector> hb_dists;
 
-  /// List of hydrogen bonds
-  std::vector<h_bond *>   hb;
+  /// Cutoff of the hydrogen bond terms
+  cvm::real hb_r0;
+
+  /// Numerator exponent of the hydrogen bond terms
+  int hb_en;
+
+  /// Denominator exponent of the hydrogen bond terms
+  int hb_ed;
 
   /// Contribution of the hb terms
   cvm::real hb_coeff;
@@ -1156,8 +1296,6 @@ public:
   virtual ~alpha_angles();
   void calc_value();
   void calc_gradients();
-  /// Re-implementation of cvc::collect_gradients() to carry over atomic gradients of sub-cvcs
-  void collect_gradients(std::vector<int> const &atom_ids, std::vector<cvm::rvector> &atomic_gradients);
   void apply_force(colvarvalue const &force);
   virtual cvm::real dist2(colvarvalue const &x1,
                           colvarvalue const &x2) const;
@@ -1172,13 +1310,21 @@ public:
 /// \brief Colvar component: dihedPC
 /// Projection of the config onto a dihedral principal component
 /// See e.g. Altis et al., J. Chem. Phys 126, 244111 (2007)
-/// Based on a set of 'dihedral' cvcs
+/// Based on a set of backbone dihedral angles
 class colvar::dihedPC
   : public colvar::cvc
 {
 protected:
 
-  std::vector<dihedral *> theta;
+  /// \brief Indices in atom_groups[0] of the four atoms of each dihedral
+  std::vector<int> theta_atoms;
+
+  /// Values of the dihedral angles (degrees)
+  std::vector<cvm::real> theta;
+
+  /// Inter-site vectors of each dihedral
+  std::vector<cvm::rvector> theta_r12, theta_r23, theta_r34;
+
   std::vector<cvm::real> coeffs;
 
 public:
@@ -1188,8 +1334,6 @@ public:
   virtual  ~dihedPC();
   void calc_value();
   void calc_gradients();
-  /// Re-implementation of cvc::collect_gradients() to carry over atomic gradients of sub-cvcs
-  void collect_gradients(std::vector<int> const &atom_ids, std::vector<cvm::rvector> &atomic_gradients);
   void apply_force(colvarvalue const &force);
   virtual cvm::real dist2(colvarvalue const &x1,
                           colvarvalue const &x2) const;
@@ -1862,6 +2006,9 @@ protected:
   /// Index of the map objet in the proxy arrays
   int volmap_index;
 
+  /// OpenDX file from which the map is loaded by Colvars (optional)
+  std::string volmap_file;
+
   /// Group of atoms selected internally (optional)
   cvm::atom_group *atoms;
 
@@ -1871,6 +2018,62 @@ protected:
 
 
 
+/// \brief Component computed by a user function compiled in a shared library
+/// (see colvarcomp_plugin_api.h for the interface)
+class colvar::plugin
+  : public colvar::cvc
+{
+public:
+
+  plugin(std::string const &conf);
+  virtual ~plugin();
+  virtual void calc_value();
+  virtual void calc_gradients();
+  virtual void apply_force(colvarvalue const &force);
+  virtual cvm::real dist2(colvarvalue const &x1,
+                          colvarvalue const &x2) const;
+  virtual colvarvalue dist2_lgrad(colvarvalue const &x1,
+                                  colvarvalue const &x2) const;
+  virtual colvarvalue dist2_rgrad(colvarvalue const &x1,
+                                  colvarvalue const &x2) const;
+
+protected:
+
+  /// Load the library and create an instance of the plugin
+  int load_plugin(std::string const &parameters);
+
+  /// \brief Contiguous array of the positions of the atoms: the group's own
+  /// array if its layout is three doubles per atom, a copy otherwise
+  double const *plugin_positions();
+
+  /// Atoms passed to the plugin
+  cvm::atom_group *atoms;
+
+  /// Path of the shared library
+  std::string library_path;
+
+  /// Handle of the shared library
+  void *library_handle;
+
+  /// Functions exported by the library (opaque pointer to the C struct)
+  void const *plugin_functions;
+
+  /// Instance created by the plugin
+  void *plugin_instance;
+
+  /// Positions passed to the plugin by calc_value(), reused by calc_gradients()
+  double const *positions;
+
+  /// \brief Copy of the positions, used only if the positions of the group
+  /// cannot be passed directly
+  std::vector<double> positions_buffer;
+
+  /// Gradients computed by the plugin
+  std::vector<double> gradients_buffer;
+};
+
+
+
 // metrics functions for cvc implementations
 
 // simple definitions of the distance functions; these are useful only
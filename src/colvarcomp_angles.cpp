@@ -216,15 +216,15 @@ void colvar::dipole_angle::calc_gradients()
 
   size_t i;
   for (i = 0; i < group1->size(); i++) {
-    (*group1)[i].grad =((*group1)[i].charge + (-1)* (*group1)[i].mass * aux1) * (dxdr1);
+    (*group1)[i].grad() =((*group1)[i].charge + (-1)* (*group1)[i].mass() * aux1) * (dxdr1);
   }
 
   for (i = 0; i < group2->size(); i++) {
-    (*group2)[i].grad = ((*group2)[i].mass/group2->total_mass)* dxdr3 * (-1.0);
+    (*group2)[i].grad() = ((*group2)[i].mass()/group2->total_mass)* dxdr3 * (-1.0);
   }
 
   for (i = 0; i < group3->size(); i++) {
-    (*group3)[i].grad =((*group3)[i].mass/group3->total_mass) * (dxdr3);
+    (*group3)[i].grad() =((*group3)[i].mass()/group3->total_mass) * (dxdr3);
   }
 }
 
@@ -316,18 +316,43 @@ void colvar::dihedral::calc_value()
     cvm::position_distance(g3_pos, g4_pos) :
     g4_pos - g3_pos;
 
+  x.real_value = dihedral_value(r12, r23, r34);
+  this->wrap(x);
+}
+
+
+cvm::real colvar::dihedral::dihedral_value(cvm::rvector const &r12,
+                                           cvm::rvector const &r23,
+                                           cvm::rvector const &r34)
+{
   cvm::rvector const n1 = cvm::rvector::outer(r12, r23);
   cvm::rvector const n2 = cvm::rvector::outer(r23, r34);
 
   cvm::real const cos_phi = n1 * n2;
   cvm::real const sin_phi = n1 * r34 * r23.norm();
 
-  x.real_value = (180.0/PI) * cvm::atan2(sin_phi, cos_phi);
-  this->wrap(x);
+  return (180.0/PI) * cvm::atan2(sin_phi, cos_phi);
 }
 
 
 void colvar::dihedral::calc_gradients()
+{
+  cvm::rvector f1, f2, f3;
+  dihedral_gradients(r12, r23, r34, f1, f2, f3);
+
+  group1->set_weighted_gradient(-f1);
+  group2->set_weighted_gradient(-f2 + f1);
+  group3->set_weighted_gradient(-f3 + f2);
+  group4->set_weighted_gradient(f3);
+}
+
+
+void colvar::dihedral::dihedral_gradients(cvm::rvector const &r12,
+                                          cvm::rvector const &r23,
+                                          cvm::rvector const &r34,
+                                          cvm::rvector &f1,
+                                          cvm::rvector &f2,
+                                          cvm::rvector &f3)
 {
   cvm::rvector A = cvm::rvector::outer(r12, r23);
   cvm::real   rA = A.norm();
@@ -339,8 +364,6 @@ void colvar::dihedral::calc_gradients()
   cvm::real const cos_phi = (A*B)/(rA*rB);
   cvm::real const sin_phi = (C*B)/(rC*rB);
 
-  cvm::rvector f1, f2, f3;
-
   rB = 1.0/rB;
   B *= rB;
 
@@ -393,11 +416,6 @@ void colvar::dihedral::calc_gradients()
               +(2.0*r23.z*r12.y - r12.z*r23.y)*dsindC.y
               +dsindB.y*r34.x - dsindB.x*r34.y);
   }
-
-  group1->set_weighted_gradient(-f1);
-  group2->set_weighted_gradient(-f2 + f1);
-  group3->set_weighted_gradient(-f3 + f2);
-  group4->set_weighted_gradient(f3);
 }
 
 
@@ -7,6 +7,8 @@
 // If you wish to distribute your changes, please submit them to the
 // Colvars repository at GitHub.
 
+#include <algorithm>
+
 #include "colvarmodule.h"
 #include "colvarparse.h"
 #include "colvaratoms.h"
@@ -24,7 +26,8 @@ cvm::real colvar::coordnum::switching_function(cvm::real const &r0,
                                                cvm::atom &A1,
                                                cvm::atom &A2,
                                                bool **pairlist_elem,
-                                               cvm::real pairlist_tol)
+                                               cvm::real pairlist_tol,
+                                               cvm::real pairlist_skin)
 {
   if ((flags & ef_use_pairlist) && !(flags & ef_rebuild_pairlist)) {
     bool const within = **pairlist_elem;
@@ -34,12 +37,29 @@ cvm::real colvar::coordnum::switching_function(cvm::real const &r0,
     }
   }
 
+  cvm::rvector const diff = cvm::position_distance(A1.pos(), A2.pos());
+
+  return switching_function<flags>(r0, r0_vec, en, ed, diff, A1, A2,
+                                   pairlist_elem, pairlist_tol, pairlist_skin);
+}
+
+
+template<int flags>
+cvm::real colvar::coordnum::switching_function(cvm::real const &r0,
+                                               cvm::rvector const &r0_vec,
+                                               int en,
+                                               int ed,
+                                               cvm::rvector const &diff,
+                                               cvm::atom &A1,
+                                               cvm::atom &A2,
+                                               bool **pairlist_elem,
+                                               cvm::real pairlist_tol,
+                                               cvm::real pairlist_skin)
+{
   cvm::rvector const r0sq_vec(r0_vec.x*r0_vec.x,
                               r0_vec.y*r0_vec.y,
                               r0_vec.z*r0_vec.z);
 
-  cvm::rvector const diff = cvm::position_distance(A1.pos, A2.pos);
-
   cvm::rvector const scal_diff(diff.x/((flags & ef_anisotropic) ?
                                        r0_vec.x : r0),
                                diff.y/((flags & ef_anisotropic) ?
@@ -58,8 +78,21 @@ cvm::real colvar::coordnum::switching_function(cvm::real const &r0,
   cvm::real const func = (((1.0-xn)/(1.0-xd)) - pairlist_tol) / (1.0-pairlist_tol);
 
   if (flags & ef_rebuild_pairlist) {
+    cvm::real func_list = func;
+    if (pairlist_skin > 0.0) {
+      // Use the value that the pair would have if it came closer by the skin,
+      // so that the list remains valid until an atom moves by half of it
+      cvm::real const ls = cvm::sqrt(l2) - pairlist_skin;
+      if (ls > 0.0) {
+        cvm::real const xns = cvm::integer_power(ls*ls, en2);
+        cvm::real const xds = cvm::integer_power(ls*ls, ed2);
+        func_list = (((1.0-xns)/(1.0-xds)) - pairlist_tol) / (1.0-pairlist_tol);
+      } else {
+        func_list = 1.0;
+      }
+    }
     //Particles just outside of the cutoff also are considered if they come near.
-    **pairlist_elem = (func > (-pairlist_tol * 0.5)) ? true : false;
+    **pairlist_elem = (func_list > (-pairlist_tol * 0.5)) ? true : false;
     (*pairlist_elem)++;
   }
   //If the value is too small, we need to exclude it, rather than let it contribute to the sum or the gradients.
@@ -82,16 +115,41 @@ cvm::real colvar::coordnum::switching_function(cvm::real const &r0,
                                    r0*r0)) * diff.y,
                              (2.0/((flags & ef_anisotropic) ? r0sq_vec.z :
                                    r0*r0)) * diff.z);
-    A1.grad += (-1.0)*dFdl2*dl2dx;
-    A2.grad +=        dFdl2*dl2dx;
+    A1.grad() += (-1.0)*dFdl2*dl2dx;
+    A2.grad() +=        dFdl2*dl2dx;
   }
 
   return func;
 }
 
 
+// Instantiations used by the hydrogen bond terms of alpha_angles
+
+template cvm::real colvar::coordnum::switching_function<colvar::coordnum::ef_null>
+(cvm::real const &, cvm::rvector const &, int, int, cvm::rvector const &,
+ cvm::atom &, cvm::atom &, bool **, cvm::real, cvm::real);
+
+template cvm::real colvar::coordnum::switching_function<colvar::coordnum::ef_gradients>
+(cvm::real const &, cvm::rvector const &, int, int, cvm::rvector const &,
+ cvm::atom &, cvm::atom &, bool **, cvm::real, cvm::real);
+
+
+bool colvar::coordnum::positions_displaced(cvm::atom_pos const *ref_pos,
+                                           cvm::atom_pos const *pos, size_t n,
+                                           cvm::real max_disp2)
+{
+  for (size_t i = 0; i < n; i++) {
+    if (cvm::position_distance(ref_pos[i], pos[i]).norm2() > max_disp2) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
 colvar::coordnum::coordnum(std::string const &conf)
-  : cvc(conf), b_anisotropic(false), pairlist(NULL)
+  : cvc(conf), b_anisotropic(false), pairlist(NULL), pairlist_skin(0.0),
+    pairlist_num_evals(-1)
 
 {
   set_function_type("coordNum");
@@ -169,6 +227,12 @@ colvar::coordnum::coordnum(std::string const &conf)
                  COLVARS_INPUT_ERROR);
       return; // and do not allocate the pairlists below
     }
+    get_keyval(conf, "pairListSkin", pairlist_skin, 0.0);
+    if (pairlist_skin < 0.0) {
+      cvm::error("Error: negative pairListSkin provided.\n",
+                 COLVARS_INPUT_ERROR);
+      return;
+    }
     if (b_group2_center_only) {
       pairlist = new bool[group1->size()];
     }
@@ -194,19 +258,25 @@ colvar::coordnum::~coordnum()
 
 template<int flags> void colvar::coordnum::main_loop(bool **pairlist_elem)
 {
+  // Pair list skin in units of the cutoff (the shortest one if anisotropic)
+  cvm::real const skin = (flags & ef_anisotropic) ?
+    pairlist_skin / std::min(r0_vec.x, std::min(r0_vec.y, r0_vec.z)) :
+    pairlist_skin / r0;
+
   if (b_group2_center_only) {
     cvm::atom group2_com_atom;
-    group2_com_atom.pos = group2->center_of_mass();
+    group2_com_atom.pos() = group2->center_of_mass();
     for (cvm::atom_iter ai1 = group1->begin(); ai1 != group1->end(); ai1++) {
       x.real_value += switching_function<flags>(r0, r0_vec, en, ed,
                                                 *ai1, group2_com_atom,
                                                 pairlist_elem,
-                                                tolerance);
+                                                tolerance, skin);
     }
     if (b_group2_center_only) {
-      group2->set_weighted_gradient(group2_com_atom.grad);
+      group2->set_weighted_gradient(group2_com_atom.grad());
     }
-  } else {
+  } else if ((flags & ef_use_pairlist) && !(flags & ef_rebuild_pairlist)) {
+    // Only compute the distances of pairs in the pair list
     for (cvm::atom_iter ai1 = group1->begin(); ai1 != group1->end(); ai1++) {
       for (cvm::atom_iter ai2 = group2->begin(); ai2 != group2->end(); ai2++) {
         x.real_value += switching_function<flags>(r0, r0_vec, en, ed,
@@ -215,15 +285,67 @@ template<int flags> void colvar::coordnum::main_loop(bool **pairlist_elem)
                                                   tolerance);
       }
     }
+  } else {
+    // Compute the distances from each atom of group1 to all of group2 at once
+    std::vector<cvm::atom_pos> const &group2_pos = group2->positions_view();
+    size_t const n2 = group2_pos.size();
+    if (n2 == 0) return;
+    pair_dists.resize(n2);
+    for (cvm::atom_iter ai1 = group1->begin(); ai1 != group1->end(); ai1++) {
+      cvm::position_distances(ai1->pos(), &(group2_pos[0]), n2,
+                              &(pair_dists[0]));
+      for (size_t i2 = 0; i2 < n2; i2++) {
+        x.real_value += switching_function<flags>(r0, r0_vec, en, ed,
+                                                  pair_dists[i2],
+                                                  *ai1, (*group2)[i2],
+                                                  pairlist_elem,
+                                                  tolerance, skin);
+      }
+    }
+  }
+}
+
+
+bool colvar::coordnum::pairlist_needs_rebuild()
+{
+  std::vector<cvm::atom_pos> const &pos1 = group1->positions_view();
+  size_t const n1 = pos1.size();
+  cvm::atom_pos const com2 = b_group2_center_only ?
+    group2->center_of_mass() : cvm::atom_pos(0.0);
+  size_t const n2 = b_group2_center_only ? 1 : group2->size();
+  cvm::atom_pos const *pos2 = b_group2_center_only ? &com2 :
+    (n2 > 0 ? &(group2->positions_view()[0]) : NULL);
+
+  bool rebuild = (pairlist_num_evals < 0);
+  if (!rebuild) {
+    if (pairlist_skin > 0.0) {
+      cvm::real const max_disp2 = 0.25 * pairlist_skin * pairlist_skin;
+      rebuild = (pairlist_ref_pos.size() != n1 + n2) ||
+        ((n1 > 0) && positions_displaced(&(pairlist_ref_pos[0]), &(pos1[0]),
+                                         n1, max_disp2)) ||
+        ((n2 > 0) && positions_displaced(&(pairlist_ref_pos[n1]), pos2, n2,
+                                         max_disp2));
+    } else {
+      rebuild = (pairlist_num_evals >= pairlist_freq);
+    }
   }
+
+  if (rebuild) {
+    pairlist_num_evals = 0;
+    if (pairlist_skin > 0.0) {
+      pairlist_ref_pos.assign(pos1.begin(), pos1.end());
+      pairlist_ref_pos.insert(pairlist_ref_pos.end(), pos2, pos2 + n2);
+    }
+  }
+  pairlist_num_evals++;
+  return rebuild;
 }
 
 
 template<int compute_flags> int colvar::coordnum::compute_coordnum()
 {
   bool const use_pairlist = (pairlist != NULL);
-  bool const rebuild_pairlist = (pairlist != NULL) &&
-    (cvm::step_relative() % pairlist_freq == 0);
+  bool const rebuild_pairlist = use_pairlist && pairlist_needs_rebuild();
 
   bool *pairlist_elem = use_pairlist ? pairlist : NULL;
 
@@ -396,7 +518,7 @@ simple_scalar_dist_functions(h_bond)
 
 
 colvar::selfcoordnum::selfcoordnum(std::string const &conf)
-  : cvc(conf), pairlist(NULL)
+  : cvc(conf), pairlist(NULL), pairlist_skin(0.0), pairlist_num_evals(-1)
 {
   set_function_type("selfCoordNum");
   x.type(colvarvalue::type_scalar);
@@ -432,6 +554,12 @@ colvar::selfcoordnum::selfcoordnum(std::string const &conf)
                  COLVARS_INPUT_ERROR);
       return;
     }
+    get_keyval(conf, "pairListSkin", pairlist_skin, 0.0);
+    if (pairlist_skin < 0.0) {
+      cvm::error("Error: negative pairListSkin provided.\n",
+                 COLVARS_INPUT_ERROR);
+      return;
+    }
     pairlist = new bool[(group1->size()-1) * (group1->size()-1)];
   }
 
@@ -448,13 +576,66 @@ colvar::selfcoordnum::~selfcoordnum()
 }
 
 
+template<int flags>
+void colvar::selfcoordnum::main_loop(cvm::rvector const &r0_vec,
+                                     bool **pairlist_elem)
+{
+  // Compute the distances from each atom to all following atoms at once
+  std::vector<cvm::atom_pos> const &group1_pos = group1->positions_view();
+  size_t const n = group1_pos.size();
+  if (n < 2) return;
+  pair_dists.resize(n);
+  for (size_t i = 0; i < n - 1; i++) {
+    cvm::position_distances(group1_pos[i], &(group1_pos[i+1]), n-i-1,
+                            &(pair_dists[0]));
+    for (size_t j = i + 1; j < n; j++) {
+      x.real_value +=
+        coordnum::switching_function<flags>(r0, r0_vec, en, ed,
+                                            pair_dists[j-i-1],
+                                            (*group1)[i],
+                                            (*group1)[j],
+                                            pairlist_elem,
+                                            tolerance,
+                                            pairlist_skin / r0);
+    }
+  }
+}
+
+
+bool colvar::selfcoordnum::pairlist_needs_rebuild()
+{
+  std::vector<cvm::atom_pos> const &pos1 = group1->positions_view();
+  size_t const n1 = pos1.size();
+
+  bool rebuild = (pairlist_num_evals < 0);
+  if (!rebuild) {
+    if (pairlist_skin > 0.0) {
+      rebuild = (pairlist_ref_pos.size() != n1) ||
+        ((n1 > 0) &&
+         coordnum::positions_displaced(&(pairlist_ref_pos[0]), &(pos1[0]), n1,
+                                       0.25 * pairlist_skin * pairlist_skin));
+    } else {
+      rebuild = (pairlist_num_evals >= pairlist_freq);
+    }
+  }
+
+  if (rebuild) {
+    pairlist_num_evals = 0;
+    if (pairlist_skin > 0.0) {
+      pairlist_ref_pos.assign(pos1.begin(), pos1.end());
+    }
+  }
+  pairlist_num_evals++;
+  return rebuild;
+}
+
+
 template<int compute_flags> int colvar::selfcoordnum::compute_selfcoordnum()
 {
   cvm::rvector const r0_vec(0.0); // TODO enable the flag?
 
   bool const use_pairlist = (pairlist != NULL);
-  bool const rebuild_pairlist = (pairlist != NULL) &&
-    (cvm::step_relative() % pairlist_freq == 0);
+  bool const rebuild_pairlist = use_pairlist && pairlist_needs_rebuild();
 
   bool *pairlist_elem = use_pairlist ? pairlist : NULL;
   size_t i = 0, j = 0;
@@ -467,16 +648,7 @@ template<int compute_flags> int colvar::selfcoordnum::compute_selfcoordnum()
     if (rebuild_pairlist) {
       int const flags = compute_flags | coordnum::ef_use_pairlist |
         coordnum::ef_rebuild_pairlist;
-      for (i = 0; i < n - 1; i++) {
-        for (j = i + 1; j < n; j++) {
-          x.real_value +=
-            coordnum::switching_function<flags>(r0, r0_vec, en, ed,
-                                                (*group1)[i],
-                                                (*group1)[j],
-                                                &pairlist_elem,
-                                                tolerance);
-        }
-      }
+      main_loop<flags>(r0_vec, &pairlist_elem);
     } else {
       int const flags = compute_flags | coordnum::ef_use_pairlist;
       for (i = 0; i < n - 1; i++) {
@@ -494,16 +666,7 @@ template<int compute_flags> int colvar::selfcoordnum::compute_selfcoordnum()
   } else { // if (use_pairlist) {
 
     int const flags = compute_flags | coordnum::ef_null;
-    for (i = 0; i < n - 1; i++) {
-      for (j = i + 1; j < n; j++) {
-        x.real_value +=
-          coordnum::switching_function<flags>(r0, r0_vec, en, ed,
-                                              (*group1)[i],
-                                              (*group1)[j],
-                                              &pairlist_elem,
-                                              tolerance);
-      }
-    }
+    main_loop<flags>(r0_vec, &pairlist_elem);
   }
 
   return COLVARS_OK;
@@ -598,8 +761,8 @@ void colvar::groupcoordnum::calc_value()
   // create fake atoms to hold the com coordinates
   cvm::atom group1_com_atom;
   cvm::atom group2_com_atom;
-  group1_com_atom.pos = group1->center_of_mass();
-  group2_com_atom.pos = group2->center_of_mass();
+  group1_com_atom.pos() = group1->center_of_mass();
+  group2_com_atom.pos() = group2->center_of_mass();
   if (b_anisotropic) {
     int const flags = coordnum::ef_anisotropic;
     x.real_value = coordnum::switching_function<flags>(r0, r0_vec, en, ed,
@@ -620,8 +783,8 @@ void colvar::groupcoordnum::calc_gradients()
 {
   cvm::atom group1_com_atom;
   cvm::atom group2_com_atom;
-  group1_com_atom.pos = group1->center_of_mass();
-  group2_com_atom.pos = group2->center_of_mass();
+  group1_com_atom.pos() = group1->center_of_mass();
+  group2_com_atom.pos() = group2->center_of_mass();
 
   if (b_anisotropic) {
     int const flags = coordnum::ef_gradients | coordnum::ef_anisotropic;
@@ -637,8 +800,8 @@ void colvar::groupcoordnum::calc_gradients()
                                         NULL, 0.0);
   }
 
-  group1->set_weighted_gradient(group1_com_atom.grad);
-  group2->set_weighted_gradient(group2_com_atom.grad);
+  group1->set_weighted_gradient(group1_com_atom.grad());
+  group2->set_weighted_gradient(group2_com_atom.grad());
 }
 
 
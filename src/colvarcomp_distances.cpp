@@ -12,6 +12,7 @@
 #include "colvarmodule.h"
 #include "colvarvalue.h"
 #include "colvarparse.h"
+#include "colvarproxy.h"
 #include "colvar.h"
 #include "colvarcomp.h"
 
@@ -599,25 +600,25 @@ void colvar::distance_inv::calc_value()
   if (!is_enabled(f_cvc_pbc_minimum_image)) {
     for (cvm::atom_iter ai1 = group1->begin(); ai1 != group1->end(); ai1++) {
       for (cvm::atom_iter ai2 = group2->begin(); ai2 != group2->end(); ai2++) {
-        cvm::rvector const dv = ai2->pos - ai1->pos;
+        cvm::rvector const dv = ai2->pos() - ai1->pos();
         cvm::real const d2 = dv.norm2();
         cvm::real const dinv = cvm::integer_power(d2, -1*(exponent/2));
         x.real_value += dinv;
         cvm::rvector const dsumddv = -1.0*(exponent/2) * dinv/d2 * 2.0 * dv;
-        ai1->grad += -1.0 * dsumddv;
-        ai2->grad +=        dsumddv;
+        ai1->grad() += -1.0 * dsumddv;
+        ai2->grad() +=        dsumddv;
       }
     }
   } else {
     for (cvm::atom_iter ai1 = group1->begin(); ai1 != group1->end(); ai1++) {
       for (cvm::atom_iter ai2 = group2->begin(); ai2 != group2->end(); ai2++) {
-        cvm::rvector const dv = cvm::position_distance(ai1->pos, ai2->pos);
+        cvm::rvector const dv = cvm::position_distance(ai1->pos(), ai2->pos());
         cvm::real const d2 = dv.norm2();
         cvm::real const dinv = cvm::integer_power(d2, -1*(exponent/2));
         x.real_value += dinv;
         cvm::rvector const dsumddv = -1.0*(exponent/2) * dinv/d2 * 2.0 * dv;
-        ai1->grad += -1.0 * dsumddv;
-        ai2->grad +=        dsumddv;
+        ai1->grad() += -1.0 * dsumddv;
+        ai2->grad() +=        dsumddv;
       }
     }
   }
@@ -629,10 +630,10 @@ void colvar::distance_inv::calc_value()
     cvm::integer_power(x.real_value, exponent+1) /
     cvm::real(group1->size() * group2->size());
   for (cvm::atom_iter ai1 = group1->begin(); ai1 != group1->end(); ai1++) {
-    ai1->grad *= dxdsum;
+    ai1->grad() *= dxdsum;
   }
   for (cvm::atom_iter ai2 = group2->begin(); ai2 != group2->end(); ai2++) {
-    ai2->grad *= dxdsum;
+    ai2->grad() *= dxdsum;
   }
 }
 
@@ -678,6 +679,18 @@ colvar::distance_pairs::distance_pairs()
 }
 
 
+void colvar::distance_pairs::calc_pair_dists(size_t i1)
+{
+  std::vector<cvm::atom_pos> const &group2_pos = group2->positions_view();
+  size_t const n2 = group2_pos.size();
+  pair_dists.resize(n2);
+  if (n2 > 0) {
+    cvm::position_distances((*group1)[i1].pos(), &(group2_pos[0]), n2,
+                            &(pair_dists[0]));
+  }
+}
+
+
 void colvar::distance_pairs::calc_value()
 {
   x.vector1d_value.resize(group1->size() * group2->size());
@@ -686,23 +699,23 @@ void colvar::distance_pairs::calc_value()
     size_t i1, i2;
     for (i1 = 0; i1 < group1->size(); i1++) {
       for (i2 = 0; i2 < group2->size(); i2++) {
-        cvm::rvector const dv = (*group2)[i2].pos - (*group1)[i1].pos;
+        cvm::rvector const dv = (*group2)[i2].pos() - (*group1)[i1].pos();
         cvm::real const d = dv.norm();
         x.vector1d_value[i1*group2->size() + i2] = d;
-        (*group1)[i1].grad = -1.0 * dv.unit();
-        (*group2)[i2].grad =  dv.unit();
+        (*group1)[i1].grad() = -1.0 * dv.unit();
+        (*group2)[i2].grad() =  dv.unit();
       }
     }
   } else {
     size_t i1, i2;
     for (i1 = 0; i1 < group1->size(); i1++) {
+      calc_pair_dists(i1);
       for (i2 = 0; i2 < group2->size(); i2++) {
-        cvm::rvector const dv = cvm::position_distance((*group1)[i1].pos,
-                                                       (*group2)[i2].pos);
+        cvm::rvector const &dv = pair_dists[i2];
         cvm::real const d = dv.norm();
         x.vector1d_value[i1*group2->size() + i2] = d;
-        (*group1)[i1].grad = -1.0 * dv.unit();
-        (*group2)[i2].grad =  dv.unit();
+        (*group1)[i1].grad() = -1.0 * dv.unit();
+        (*group2)[i2].grad() =  dv.unit();
       }
     }
   }
@@ -721,7 +734,7 @@ void colvar::distance_pairs::apply_force(colvarvalue const &force)
     size_t i1, i2;
     for (i1 = 0; i1 < group1->size(); i1++) {
       for (i2 = 0; i2 < group2->size(); i2++) {
-        cvm::rvector const dv = (*group2)[i2].pos - (*group1)[i1].pos;
+        cvm::rvector const dv = (*group2)[i2].pos() - (*group1)[i1].pos();
         (*group1)[i1].apply_force(force[i1*group2->size() + i2] * (-1.0) * dv.unit());
         (*group2)[i2].apply_force(force[i1*group2->size() + i2] * dv.unit());
       }
@@ -729,9 +742,9 @@ void colvar::distance_pairs::apply_force(colvarvalue const &force)
   } else {
     size_t i1, i2;
     for (i1 = 0; i1 < group1->size(); i1++) {
+      calc_pair_dists(i1);
       for (i2 = 0; i2 < group2->size(); i2++) {
-        cvm::rvector const dv = cvm::position_distance((*group1)[i1].pos,
-                                                       (*group2)[i2].pos);
+        cvm::rvector const &dv = pair_dists[i2];
         (*group1)[i1].apply_force(force[i1*group2->size() + i2] * (-1.0) * dv.unit());
         (*group2)[i2].apply_force(force[i1*group2->size() + i2] * dv.unit());
       }
@@ -782,7 +795,7 @@ void colvar::dipole_magnitude::calc_gradients()
   cvm::atom_pos const dipVunit = dipoleV.unit();
 
   for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++) {
-    ai->grad = (ai->charge - aux1*ai->mass) * dipVunit;
+    ai->grad() = (ai->charge - aux1*ai->mass()) * dipVunit;
   }
 }
 
@@ -800,16 +813,30 @@ simple_scalar_dist_functions(dipole_magnitude)
 
 
 colvar::gyration::gyration(std::string const &conf)
-  : cvc(conf)
+  : cvc(conf), sum_pos_reduction(-1), sum_pos2_reduction(-1),
+    scalable_center(0.0), scalable_center_next(0.0)
 {
   set_function_type("gyration");
   init_as_distance();
 
   provide(f_cvc_inv_gradient);
   provide(f_cvc_Jacobian);
+  if (cvm::proxy->scalable_group_reductions() == COLVARS_OK) {
+    provide(f_cvc_scalable_reductions);
+  }
   atoms = parse_group(conf, "atoms");
 
-  if (atoms->b_user_defined_fit) {
+  if (atoms->is_enabled(f_ag_scalable)) {
+    // The center of geometry is subtracted from the sums of the positions
+    sum_pos_reduction =
+      atoms->request_reduction(colvarproxy::reduction_sum_positions,
+                               colvarproxy::reduction_weight_unit);
+    sum_pos2_reduction =
+      atoms->request_reduction(colvarproxy::reduction_sum_positions_outer,
+                               colvarproxy::reduction_weight_unit);
+    // Total forces on individual atoms are not available
+    provide(f_cvc_inv_gradient, false);
+  } else if (atoms->b_user_defined_fit) {
     cvm::log("WARNING: explicit fitting parameters were provided for atom group \"atoms\".\n");
   } else {
     atoms->enable(f_ag_center);
@@ -819,11 +846,72 @@ colvar::gyration::gyration(std::string const &conf)
 }
 
 
+cvm::rmatrix colvar::gyration::calc_scalable_scatter_matrix()
+{
+  // The engine computed the current values around the last center set, or
+  // at the first step around the center of mass of the group
+  std::vector<cvm::real> const &c =
+    cvm::proxy->get_atom_group_reduction_params(sum_pos_reduction);
+  if (c.size() >= 3) {
+    scalable_center = cvm::atom_pos(c[0], c[1], c[2]);
+  }
+  cvm::real const *s1 = cvm::proxy->get_atom_group_reduction(sum_pos_reduction);
+  cvm::real const *s2 = cvm::proxy->get_atom_group_reduction(sum_pos2_reduction);
+  cvm::real const n = cvm::real(atoms->ids().size());
+  cvm::real const xx = s2[0] - s1[0]*s1[0]/n;
+  cvm::real const xy = s2[1] - s1[0]*s1[1]/n;
+  cvm::real const xz = s2[2] - s1[0]*s1[2]/n;
+  cvm::real const yy = s2[3] - s1[1]*s1[1]/n;
+  cvm::real const yz = s2[4] - s1[1]*s1[2]/n;
+  cvm::real const zz = s2[5] - s1[2]*s1[2]/n;
+
+  scalable_center_next = scalable_center +
+    cvm::rvector(s1[0], s1[1], s1[2]) / n;
+  std::vector<cvm::real> params(3);
+  params[0] = scalable_center_next.x;
+  params[1] = scalable_center_next.y;
+  params[2] = scalable_center_next.z;
+  cvm::proxy->set_atom_group_reduction_params(sum_pos_reduction, params);
+  cvm::proxy->set_atom_group_reduction_params(sum_pos2_reduction, params);
+
+  return cvm::rmatrix(xx, xy, xz,
+                      xy, yy, yz,
+                      xz, yz, zz);
+}
+
+
+void colvar::gyration::apply_scalable_force(cvm::real force,
+                                            cvm::rmatrix const &dxdq) const
+{
+  if (force == 0.0) return;
+  cvm::real const *s1 = cvm::proxy->get_atom_group_reduction(sum_pos_reduction);
+  cvm::real const n = cvm::real(atoms->ids().size());
+  // Chain rule through the subtraction of the center; the forces are
+  // computed by the engine around the new reference point
+  cvm::rvector const g1 = (2.0 * force) *
+    (dxdq * ((scalable_center_next - scalable_center) -
+             cvm::rvector(s1[0], s1[1], s1[2]) / n));
+  cvm::real const c1[3] = { g1.x, g1.y, g1.z };
+  // Off-diagonal elements are reduced once for two matrix elements
+  cvm::real const c2[6] = { force * dxdq.xx(), 2.0 * force * dxdq.xy(),
+                            2.0 * force * dxdq.xz(), force * dxdq.yy(),
+                            2.0 * force * dxdq.yz(), force * dxdq.zz() };
+  cvm::proxy->apply_atom_group_reduction_force(sum_pos_reduction, c1);
+  cvm::proxy->apply_atom_group_reduction_force(sum_pos2_reduction, c2);
+}
+
+
 void colvar::gyration::calc_value()
 {
+  if (atoms->is_enabled(f_ag_scalable)) {
+    cvm::rmatrix const q = calc_scalable_scatter_matrix();
+    x.real_value = cvm::sqrt((q.xx() + q.yy() + q.zz()) /
+                             cvm::real(atoms->ids().size()));
+    return;
+  }
   x.real_value = 0.0;
   for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++) {
-    x.real_value += (ai->pos).norm2();
+    x.real_value += (ai->pos()).norm2();
   }
   x.real_value = cvm::sqrt(x.real_value / cvm::real(atoms->size()));
 }
@@ -831,9 +919,10 @@ void colvar::gyration::calc_value()
 
 void colvar::gyration::calc_gradients()
 {
+  if (atoms->is_enabled(f_ag_scalable)) return;
   cvm::real const drdx = 1.0/(cvm::real(atoms->size()) * x.real_value);
   for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++) {
-    ai->grad = drdx * ai->pos;
+    ai->grad() = drdx * ai->pos();
   }
 }
 
@@ -846,21 +935,31 @@ void colvar::gyration::calc_force_invgrads()
   ft.real_value = 0.0;
 
   for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++) {
-    ft.real_value += dxdr * ai->pos * ai->total_force;
+    ft.real_value += dxdr * ai->pos() * ai->total_force;
   }
 }
 
 
 void colvar::gyration::calc_Jacobian_derivative()
 {
-  jd = x.real_value ? (3.0 * cvm::real(atoms->size()) - 4.0) / x.real_value : 0.0;
+  jd = x.real_value ?
+    (3.0 * cvm::real(atoms->ids().size()) - 4.0) / x.real_value : 0.0;
 }
 
 
 void colvar::gyration::apply_force(colvarvalue const &force)
 {
-  if (!atoms->noforce)
-    atoms->apply_colvar_force(force.real_value);
+  if (atoms->noforce) return;
+  if (atoms->is_enabled(f_ag_scalable)) {
+    if (x.real_value > 0.0) {
+      cvm::real const d = 0.5 / (cvm::real(atoms->ids().size()) * x.real_value);
+      apply_scalable_force(force.real_value, cvm::rmatrix(d, 0.0, 0.0,
+                                                          0.0, d, 0.0,
+                                                          0.0, 0.0, d));
+    }
+    return;
+  }
+  atoms->apply_colvar_force(force.real_value);
 }
 
 
@@ -878,25 +977,37 @@ colvar::inertia::inertia(std::string const &conf)
 
 void colvar::inertia::calc_value()
 {
+  if (atoms->is_enabled(f_ag_scalable)) {
+    cvm::rmatrix const q = calc_scalable_scatter_matrix();
+    x.real_value = q.xx() + q.yy() + q.zz();
+    return;
+  }
   x.real_value = 0.0;
   for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++) {
-    x.real_value += (ai->pos).norm2();
+    x.real_value += (ai->pos()).norm2();
   }
 }
 
 
 void colvar::inertia::calc_gradients()
 {
+  if (atoms->is_enabled(f_ag_scalable)) return;
   for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++) {
-    ai->grad = 2.0 * ai->pos;
+    ai->grad() = 2.0 * ai->pos();
   }
 }
 
 
 void colvar::inertia::apply_force(colvarvalue const &force)
 {
-  if (!atoms->noforce)
-    atoms->apply_colvar_force(force.real_value);
+  if (atoms->noforce) return;
+  if (atoms->is_enabled(f_ag_scalable)) {
+    apply_scalable_force(force.real_value, cvm::rmatrix(1.0, 0.0, 0.0,
+                                                        0.0, 1.0, 0.0,
+                                                        0.0, 0.0, 1.0));
+    return;
+  }
+  atoms->apply_colvar_force(force.real_value);
 }
 
 
@@ -924,9 +1035,13 @@ colvar::inertia_z::inertia_z(std::string const &conf)
 
 void colvar::inertia_z::calc_value()
 {
+  if (atoms->is_enabled(f_ag_scalable)) {
+    x.real_value = axis * (calc_scalable_scatter_matrix() * axis);
+    return;
+  }
   x.real_value = 0.0;
   for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++) {
-    cvm::real const iprod = ai->pos * axis;
+    cvm::real const iprod = ai->pos() * axis;
     x.real_value += iprod * iprod;
   }
 }
@@ -934,16 +1049,24 @@ void colvar::inertia_z::calc_value()
 
 void colvar::inertia_z::calc_gradients()
 {
+  if (atoms->is_enabled(f_ag_scalable)) return;
   for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++) {
-    ai->grad = 2.0 * (ai->pos * axis) * axis;
+    ai->grad() = 2.0 * (ai->pos() * axis) * axis;
   }
 }
 
 
 void colvar::inertia_z::apply_force(colvarvalue const &force)
 {
-  if (!atoms->noforce)
-    atoms->apply_colvar_force(force.real_value);
+  if (atoms->noforce) return;
+  if (atoms->is_enabled(f_ag_scalable)) {
+    apply_scalable_force(force.real_value,
+                         cvm::rmatrix(axis.x*axis.x, axis.x*axis.y, axis.x*axis.z,
+                                      axis.y*axis.x, axis.y*axis.y, axis.y*axis.z,
+                                      axis.z*axis.x, axis.z*axis.y, axis.z*axis.z));
+    return;
+  }
+  atoms->apply_colvar_force(force.real_value);
 }
 
 
@@ -1096,7 +1219,7 @@ void colvar::rmsd::calc_value()
 
   x.real_value = 0.0;
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    x.real_value += ((*atoms)[ia].pos - ref_pos[ia]).norm2();
+    x.real_value += ((*atoms)[ia].pos() - ref_pos[ia]).norm2();
   }
   best_perm_index = 0;
 
@@ -1105,7 +1228,7 @@ void colvar::rmsd::calc_value()
   for (size_t ip = 1; ip < n_permutations; ip++) {
     cvm::real value = 0.0;
     for (size_t ia = 0; ia < atoms->size(); ia++) {
-      value += ((*atoms)[ia].pos - ref_pos[ref_pos_index++]).norm2();
+      value += ((*atoms)[ia].pos() - ref_pos[ref_pos_index++]).norm2();
     }
     if (value < x.real_value) {
       x.real_value = value;
@@ -1126,7 +1249,7 @@ void colvar::rmsd::calc_gradients()
   // Use the appropriate symmetry permutation of reference positions to calculate gradients
   size_t const start = atoms->size() * best_perm_index;
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = (drmsddx2 * 2.0 * ((*atoms)[ia].pos - ref_pos[start + ia]));
+    (*atoms)[ia].grad() = (drmsddx2 * 2.0 * ((*atoms)[ia].pos() - ref_pos[start + ia]));
   }
 }
 
@@ -1146,7 +1269,7 @@ void colvar::rmsd::calc_force_invgrads()
   // Note: gradient square norm is 1/N_atoms
 
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    ft.real_value += (*atoms)[ia].grad * (*atoms)[ia].total_force;
+    ft.real_value += (*atoms)[ia].grad() * (*atoms)[ia].total_force;
   }
   ft.real_value *= atoms->size();
 }
@@ -1422,7 +1545,7 @@ void colvar::eigenvector::calc_value()
 {
   x.real_value = 0.0;
   for (size_t i = 0; i < atoms->size(); i++) {
-    x.real_value += ((*atoms)[i].pos - ref_pos[i]) * eigenvec[i];
+    x.real_value += ((*atoms)[i].pos() - ref_pos[i]) * eigenvec[i];
   }
 }
 
@@ -1430,7 +1553,7 @@ void colvar::eigenvector::calc_value()
 void colvar::eigenvector::calc_gradients()
 {
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = eigenvec[ia];
+    (*atoms)[ia].grad() = eigenvec[ia];
   }
 }
 
@@ -1448,7 +1571,7 @@ void colvar::eigenvector::calc_force_invgrads()
   ft.real_value = 0.0;
 
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    ft.real_value += eigenvec_invnorm2 * (*atoms)[ia].grad *
+    ft.real_value += eigenvec_invnorm2 * (*atoms)[ia].grad() *
       (*atoms)[ia].total_force;
   }
 }
@@ -1544,7 +1667,7 @@ void colvar::cartesian::calc_value()
   size_t ia, j;
   for (ia = 0; ia < atoms->size(); ia++) {
     for (j = 0; j < dim; j++) {
-      x.vector1d_value[dim*ia + j] = (*atoms)[ia].pos[axes[j]];
+      x.vector1d_value[dim*ia + j] = (*atoms)[ia].pos()[axes[j]];
     }
   }
 }
@@ -117,7 +117,7 @@ void colvar::CartesianBasedPath::computeDistanceToReferenceFrames(std::vector<cv
     for (size_t i_frame = 0; i_frame < reference_frames.size(); ++i_frame) {
         cvm::real frame_rmsd = 0.0;
         for (size_t i_atom = 0; i_atom < atoms->size(); ++i_atom) {
-            frame_rmsd += ((*(comp_atoms[i_frame]))[i_atom].pos - reference_frames[i_frame][i_atom]).norm2();
+            frame_rmsd += ((*(comp_atoms[i_frame]))[i_atom].pos() - reference_frames[i_frame][i_atom]).norm2();
         }
         frame_rmsd /= cvm::real(atoms->size());
         frame_rmsd = cvm::sqrt(frame_rmsd);
@@ -156,9 +156,9 @@ void colvar::gspath::prepareVectors() {
     size_t i_atom;
     for (i_atom = 0; i_atom < atoms->size(); ++i_atom) {
         // v1 = s_m - z
-        v1[i_atom] = reference_frames[min_frame_index_1][i_atom] - (*(comp_atoms[min_frame_index_1]))[i_atom].pos;
+        v1[i_atom] = reference_frames[min_frame_index_1][i_atom] - (*(comp_atoms[min_frame_index_1]))[i_atom].pos();
         // v2 = z - s_(m-1)
-        v2[i_atom] = (*(comp_atoms[min_frame_index_2]))[i_atom].pos - reference_frames[min_frame_index_2][i_atom];
+        v2[i_atom] = (*(comp_atoms[min_frame_index_2]))[i_atom].pos() - reference_frames[min_frame_index_2][i_atom];
     }
     if (min_frame_index_3 < 0 || min_frame_index_3 > M) {
         cvm::atom_pos reference_cog_1, reference_cog_2;
@@ -255,8 +255,8 @@ void colvar::gspath::calc_gradients() {
         tmp_atom_grad_v2[0] = sign * 0.5 * dfdv2[i_atom][0] / M;
         tmp_atom_grad_v2[1] = sign * 0.5 * dfdv2[i_atom][1] / M;
         tmp_atom_grad_v2[2] = sign * 0.5 * dfdv2[i_atom][2] / M;
-        (*(comp_atoms[min_frame_index_1]))[i_atom].grad += tmp_atom_grad_v1;
-        (*(comp_atoms[min_frame_index_2]))[i_atom].grad += tmp_atom_grad_v2;
+        (*(comp_atoms[min_frame_index_1]))[i_atom].grad() += tmp_atom_grad_v1;
+        (*(comp_atoms[min_frame_index_2]))[i_atom].grad() += tmp_atom_grad_v2;
     }
 }
 
@@ -336,8 +336,8 @@ void colvar::gzpath::prepareVectors() {
         rot_v4.calc_optimal_rotation(tmp_reference_frame_1, tmp_reference_frame_2);
     }
     for (i_atom = 0; i_atom < atoms->size(); ++i_atom) {
-        v1[i_atom] = reference_frames[min_frame_index_1][i_atom] - (*(comp_atoms[min_frame_index_1]))[i_atom].pos;
-        v2[i_atom] = (*(comp_atoms[min_frame_index_2]))[i_atom].pos - reference_frames[min_frame_index_2][i_atom];
+        v1[i_atom] = reference_frames[min_frame_index_1][i_atom] - (*(comp_atoms[min_frame_index_1]))[i_atom].pos();
+        v2[i_atom] = (*(comp_atoms[min_frame_index_2]))[i_atom].pos() - reference_frames[min_frame_index_2][i_atom];
         // v4 only computes in gzpath
         // v4 = s_m - s_(m-1)
         v4[i_atom] = rot_v4.q.rotate(tmp_reference_frame_1[i_atom]) - tmp_reference_frame_2[i_atom];
@@ -386,8 +386,8 @@ void colvar::gzpath::calc_gradients() {
     for (size_t i_atom = 0; i_atom < atoms->size(); ++i_atom) {
         tmp_atom_grad_v1 = -1.0 * dzdv1[i_atom];
         tmp_atom_grad_v2 = dzdv2[i_atom];
-        (*(comp_atoms[min_frame_index_1]))[i_atom].grad += tmp_atom_grad_v1;
-        (*(comp_atoms[min_frame_index_2]))[i_atom].grad += tmp_atom_grad_v2;
+        (*(comp_atoms[min_frame_index_1]))[i_atom].grad() += tmp_atom_grad_v1;
+        (*(comp_atoms[min_frame_index_2]))[i_atom].grad() += tmp_atom_grad_v2;
     }
 }
 
@@ -638,7 +638,7 @@ void colvar::gspathCV::calc_gradients() {
                     // Loop over all atoms in the k-th atom group
                     for (size_t l_atom = 0; l_atom < (cv[i_cv]->atom_groups)[k_ag]->size(); ++l_atom) {
                         // Chain rule
-                        (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad = factor_polynomial * ((*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad * tmp_cv_grad_v1[j_elem] + (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad * tmp_cv_grad_v2[j_elem]);
+                        (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad() = factor_polynomial * ((*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad() * tmp_cv_grad_v1[j_elem] + (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad() * tmp_cv_grad_v2[j_elem]);
                     }
                 }
             }
@@ -767,7 +767,7 @@ void colvar::gzpathCV::calc_gradients() {
                     // Loop over all atoms in the k-th atom group
                     for (size_t l_atom = 0; l_atom < (cv[i_cv]->atom_groups)[k_ag]->size(); ++l_atom) {
                         // Chain rule
-                        (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad = factor_polynomial * ((*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad * tmp_cv_grad_v1[j_elem] + (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad * tmp_cv_grad_v2[j_elem]);
+                        (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad() = factor_polynomial * ((*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad() * tmp_cv_grad_v1[j_elem] + (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad() * tmp_cv_grad_v2[j_elem]);
                     }
                 }
             }
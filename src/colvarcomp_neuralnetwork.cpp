@@ -159,7 +159,7 @@ void colvar::neuralNetwork::calc_gradients() {
             for (size_t j_elem = 0; j_elem < cv[i_cv]->value().size(); ++j_elem) {
                 for (size_t k_ag = 0 ; k_ag < cv[i_cv]->atom_groups.size(); ++k_ag) {
                     for (size_t l_atom = 0; l_atom < (cv[i_cv]->atom_groups)[k_ag]->size(); ++l_atom) {
-                        (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad = factor_polynomial * factor * (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad;
+                        (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad() = factor_polynomial * factor * (*(cv[i_cv]->atom_groups)[k_ag])[l_atom].grad();
                     }
                 }
             }
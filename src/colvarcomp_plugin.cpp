@@ -0,0 +1,206 @@
+// -*- c++ -*-
+
+// This file is part of the Collective Variables module (Colvars).
+// The original version of Colvars and its updates are located at:
+// https://github.com/Colvars/colvars
+// Please update all Colvars source files before making any changes.
+// If you wish to distribute your changes, please submit them to the
+// Colvars repository at GitHub.
+
+#include <cstring>
+
+#if defined(COLVARS_PLUGINS)
+#include <dlfcn.h>
+#endif
+
+#include "colvarmodule.h"
+#include "colvarvalue.h"
+#include "colvarparse.h"
+#include "colvar.h"
+#include "colvarcomp.h"
+#include "colvarcomp_plugin_api.h"
+
+
+namespace {
+  inline colvars_cvc_plugin const *plugin_api(void const *p)
+  {
+    return reinterpret_cast<colvars_cvc_plugin const *>(p);
+  }
+}
+
+
+colvar::plugin::plugin(std::string const &conf)
+  : cvc(conf), atoms(NULL), library_handle(NULL), plugin_functions(NULL),
+    plugin_instance(NULL), positions(NULL)
+{
+  set_function_type("plugin");
+  x.type(colvarvalue::type_scalar);
+  provide(f_cvc_explicit_gradient);
+
+  atoms = parse_group(conf, "atoms");
+  if (atoms == NULL) return;
+
+  get_keyval(conf, "library", library_path, library_path);
+  if (library_path.size() == 0) {
+    cvm::error("Error: missing the \"library\" keyword.\n",
+               COLVARS_INPUT_ERROR);
+    return;
+  }
+
+  // The parameters are passed verbatim, either one line or a {...} block
+  std::string parameters;
+  key_lookup(conf, "parameters", &parameters);
+
+  load_plugin(parameters);
+}
+
+
+int colvar::plugin::load_plugin(std::string const &parameters)
+{
+#if defined(COLVARS_PLUGINS)
+  library_handle = dlopen(library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (library_handle == NULL) {
+    return cvm::error("Error: cannot load plugin library \""+library_path+
+                      "\": "+std::string(dlerror())+".\n",
+                      COLVARS_INPUT_ERROR);
+  }
+
+  // Function and object pointers are not interconvertible in ISO C++
+  void *symbol = dlsym(library_handle, COLVARS_CVC_PLUGIN_ENTRY);
+  if (symbol == NULL) {
+    return cvm::error("Error: library \""+library_path+"\" does not export "
+                      "the function \"" COLVARS_CVC_PLUGIN_ENTRY "\".\n",
+                      COLVARS_INPUT_ERROR);
+  }
+  colvars_cvc_plugin_entry_fn entry = NULL;
+  std::memcpy(&entry, &symbol, sizeof(symbol));
+
+  colvars_cvc_plugin const *api = (*entry)();
+  if (api == NULL) {
+    return cvm::error("Error: library \""+library_path+"\" did not return "
+                      "a plugin interface.\n", COLVARS_INPUT_ERROR);
+  }
+  if (api->api_version != COLVARS_CVC_PLUGIN_API_VERSION) {
+    return cvm::error("Error: library \""+library_path+"\" implements "
+                      "version "+cvm::to_str(api->api_version)+
+                      " of the plugin interface, but version "+
+                      cvm::to_str(COLVARS_CVC_PLUGIN_API_VERSION)+
+                      " is required.\n", COLVARS_INPUT_ERROR);
+  }
+  if ((api->create == NULL) || (api->destroy == NULL) ||
+      (api->calc_value == NULL) || (api->calc_gradients == NULL)) {
+    return cvm::error("Error: library \""+library_path+"\" does not define "
+                      "all the functions of the plugin interface.\n",
+                      COLVARS_INPUT_ERROR);
+  }
+  plugin_functions = api;
+
+  char error_msg[1024];
+  error_msg[0] = '\0';
+  plugin_instance = (*api->create)(parameters.c_str(), int(atoms->size()),
+                                   error_msg, int(sizeof(error_msg)));
+  if (plugin_instance == NULL) {
+    error_msg[sizeof(error_msg)-1] = '\0';
+    return cvm::error("Error: plugin \""+
+                      std::string(api->name ? api->name : "")+
+                      "\" could not be initialized: "+
+                      std::string(error_msg)+"\n", COLVARS_INPUT_ERROR);
+  }
+
+  cvm::log("Loaded plugin \""+std::string(api->name ? api->name : "")+
+           "\" from library \""+library_path+"\".\n");
+
+  if (sizeof(cvm::atom_pos) != 3*sizeof(double)) {
+    positions_buffer.resize(3*atoms->size());
+  }
+  gradients_buffer.resize(3*atoms->size());
+  return COLVARS_OK;
+#else
+  (void) parameters;
+  return cvm::error("Error: plugin components are not supported in this "
+                    "build of Colvars.\n", COLVARS_NOT_IMPLEMENTED);
+#endif
+}
+
+
+colvar::plugin::~plugin()
+{
+#if defined(COLVARS_PLUGINS)
+  if (plugin_instance != NULL) {
+    (*plugin_api(plugin_functions)->destroy)(plugin_instance);
+    plugin_instance = NULL;
+  }
+  if (library_handle != NULL) {
+    dlclose(library_handle);
+    library_handle = NULL;
+  }
+#endif
+}
+
+
+double const *colvar::plugin::plugin_positions()
+{
+  std::vector<cvm::atom_pos> const &pos = atoms->positions_view();
+  if (pos.empty()) return NULL;
+  if (sizeof(cvm::atom_pos) == 3*sizeof(double)) {
+    // The group's array already has the layout of the interface
+    return reinterpret_cast<double const *>(&(pos[0]));
+  }
+  for (size_t i = 0; i < pos.size(); i++) {
+    positions_buffer[3*i]   = pos[i].x;
+    positions_buffer[3*i+1] = pos[i].y;
+    positions_buffer[3*i+2] = pos[i].z;
+  }
+  return &(positions_buffer[0]);
+}
+
+
+void colvar::plugin::calc_value()
+{
+  if (plugin_instance == NULL) return;
+  double value = 0.0;
+  positions = plugin_positions();
+  int const ret =
+    (*plugin_api(plugin_functions)->calc_value)(plugin_instance,
+                                                int(atoms->size()),
+                                                positions, &value);
+  if (ret != 0) {
+    cvm::error("Error: plugin \""+library_path+"\" returned error code "+
+               cvm::to_str(ret)+" while computing its value.\n",
+               COLVARS_ERROR);
+  }
+  x.real_value = value;
+}
+
+
+void colvar::plugin::calc_gradients()
+{
+  if (plugin_instance == NULL) return;
+  // Same positions as in calc_value()
+  int const ret =
+    (*plugin_api(plugin_functions)->calc_gradients)(plugin_instance,
+                                                    int(atoms->size()),
+                                                    positions,
+                                                    &(gradients_buffer[0]));
+  if (ret != 0) {
+    cvm::error("Error: plugin \""+library_path+"\" returned error code "+
+               cvm::to_str(ret)+" while computing its gradients.\n",
+               COLVARS_ERROR);
+  }
+  size_t i = 0;
+  for (cvm::atom_iter ai = atoms->begin(); ai != atoms->end(); ai++, i++) {
+    ai->grad() = cvm::rvector(gradients_buffer[3*i], gradients_buffer[3*i+1],
+                              gradients_buffer[3*i+2]);
+  }
+}
+
+
+void colvar::plugin::apply_force(colvarvalue const &force)
+{
+  if (!atoms->noforce) {
+    atoms->apply_colvar_force(force.real_value);
+  }
+}
+
+
+simple_scalar_dist_functions(plugin)
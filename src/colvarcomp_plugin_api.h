@@ -0,0 +1,76 @@
+// -*- c++ -*-
+
+// This file is part of the Collective Variables module (Colvars).
+// The original version of Colvars and its updates are located at:
+// https://github.com/Colvars/colvars
+// Please update all Colvars source files before making any changes.
+// If you wish to distribute your changes, please submit them to the
+// Colvars repository at GitHub.
+
+#ifndef COLVARCOMP_PLUGIN_API_H
+#define COLVARCOMP_PLUGIN_API_H
+
+/// \file colvarcomp_plugin_api.h
+/// \brief C interface for colvar components compiled as shared libraries,
+/// loaded at run time by the "plugin" component.  This header does not
+/// depend on any other Colvars header, and can be included from C or C++.
+///
+/// A plugin library exports a function named COLVARS_CVC_PLUGIN_ENTRY with
+/// C linkage, of type colvars_cvc_plugin_entry_fn, which returns a pointer
+/// to a statically allocated colvars_cvc_plugin structure.  Positions and
+/// gradients are contiguous arrays of 3*num_atoms numbers (x1, y1, z1, x2,
+/// ...), in the length unit used by Colvars with the MD engine.  The
+/// positions are those of the atom group after its optional fitting, without
+/// periodic wrapping; they may point to Colvars' own data, which must not be
+/// modified, and are valid only during each call.  Functions returning int
+/// return 0 on success.
+
+/// Version of the interface implemented by this header
+#define COLVARS_CVC_PLUGIN_API_VERSION 1
+
+/// Name of the function exported by each plugin library
+#define COLVARS_CVC_PLUGIN_ENTRY "colvars_cvc_plugin_entry"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Functions implemented by a component plugin
+typedef struct colvars_cvc_plugin {
+
+  /// Version of the interface (must be COLVARS_CVC_PLUGIN_API_VERSION)
+  int api_version;
+
+  /// Name of the plugin, used in log messages
+  char const *name;
+
+  /// \brief Create an instance of the component, given the contents of the
+  /// "parameters" keyword and the number of atoms; on failure, return NULL
+  /// and write a null-terminated message of at most error_msg_len characters
+  /// into error_msg
+  void *(*create)(char const *parameters, int num_atoms, char *error_msg,
+                  int error_msg_len);
+
+  /// Destroy an instance
+  void (*destroy)(void *instance);
+
+  /// Compute the value of the component
+  int (*calc_value)(void *instance, int num_atoms, double const *positions,
+                    double *value);
+
+  /// \brief Compute the gradients of the value with respect to the
+  /// positions; called after calc_value() with the same positions, only at
+  /// the steps when the gradients are needed
+  int (*calc_gradients)(void *instance, int num_atoms,
+                        double const *positions, double *gradients);
+
+} colvars_cvc_plugin;
+
+/// Type of the function exported by each plugin library
+typedef colvars_cvc_plugin const *(*colvars_cvc_plugin_entry_fn)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
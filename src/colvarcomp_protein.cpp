@@ -16,6 +16,26 @@
 #include "colvarcomp.h"
 
 
+namespace {
+
+  /// Add the atom to the group unless already there, and return its index
+  int add_residue_atom(cvm::atom_group &group, cvm::residue_id residue,
+                       std::string const &atom_name,
+                       std::string const &segment_id)
+  {
+    cvm::atom const a(residue, atom_name, segment_id);
+    for (size_t i = 0; i < group.size(); i++) {
+      if (group[i].id == a.id) {
+        return static_cast<int>(i);
+      }
+    }
+    group.add_atom(a);
+    return static_cast<int>(group.size()) - 1;
+  }
+
+}
+
+
 colvar::alpha_angles::alpha_angles(std::string const &conf)
   : cvc(conf)
 {
@@ -68,15 +88,16 @@ colvar::alpha_angles::alpha_angles(std::string const &conf)
   get_keyval(conf, "angleRef", theta_ref, 88.0);
   get_keyval(conf, "angleTol", theta_tol, 15.0);
 
+  // All atoms are stored in one group, and each term refers to them by index
+  register_atom_group(new cvm::atom_group);
+  cvm::atom_group &group = *(atom_groups[0]);
+
   if (hb_coeff < 1.0) {
 
     for (size_t i = 0; i < residues.size()-2; i++) {
-      theta.push_back(new colvar::angle(cvm::atom(r[i  ], "CA", sid),
-                                        cvm::atom(r[i+1], "CA", sid),
-                                        cvm::atom(r[i+2], "CA", sid)));
-      register_atom_group(theta.back()->atom_groups[0]);
-      register_atom_group(theta.back()->atom_groups[1]);
-      register_atom_group(theta.back()->atom_groups[2]);
+      theta_atoms.push_back(add_residue_atom(group, r[i  ], "CA", sid));
+      theta_atoms.push_back(add_residue_atom(group, r[i+1], "CA", sid));
+      theta_atoms.push_back(add_residue_atom(group, r[i+2], "CA", sid));
     }
 
   } else {
@@ -84,25 +105,30 @@ colvar::alpha_angles::alpha_angles(std::string const &conf)
   }
 
   {
-    cvm::real r0;
     size_t en, ed;
-    get_keyval(conf, "hBondCutoff",   r0, (3.3 * proxy->angstrom_value));
+    get_keyval(conf, "hBondCutoff",   hb_r0, (3.3 * proxy->angstrom_value));
     get_keyval(conf, "hBondExpNumer", en, 6);
     get_keyval(conf, "hBondExpDenom", ed, 8);
+    hb_en = en;
+    hb_ed = ed;
 
     if (hb_coeff > 0.0) {
 
       for (size_t i = 0; i < residues.size()-4; i++) {
-        hb.push_back(new colvar::h_bond(cvm::atom(r[i  ], "O",  sid),
-                                        cvm::atom(r[i+4], "N",  sid),
-                                        r0, en, ed));
-        register_atom_group(hb.back()->atom_groups[0]);
+        hb_atoms.push_back(add_residue_atom(group, r[i  ], "O",  sid));
+        hb_atoms.push_back(add_residue_atom(group, r[i+4], "N",  sid));
       }
 
     } else {
       cvm::log("The hBondCoeff specified will disable the hydrogen bond terms.\n");
     }
   }
+
+  theta.resize(theta_atoms.size()/3);
+  theta_r21.resize(theta.size());
+  theta_r23.resize(theta.size());
+  hb.resize(hb_atoms.size()/2);
+  hb_dists.resize(hb.size());
 }
 
 
@@ -117,16 +143,6 @@ colvar::alpha_angles::alpha_angles()
 
 colvar::alpha_angles::~alpha_angles()
 {
-  while (theta.size() != 0) {
-    delete theta.back();
-    theta.pop_back();
-  }
-  while (hb.size() != 0) {
-    delete hb.back();
-    hb.pop_back();
-  }
-  // Our references to atom groups have become invalid now that children cvcs are deleted
-  atom_groups.clear();
 }
 
 
@@ -134,16 +150,26 @@ void colvar::alpha_angles::calc_value()
 {
   x.real_value = 0.0;
 
+  cvm::atom_group const &atoms = *(atom_groups[0]);
+
   if (theta.size()) {
 
     cvm::real const theta_norm =
       (1.0-hb_coeff) / cvm::real(theta.size());
 
+    for (size_t i = 0; i < theta.size(); i++) {
+      cvm::atom_pos const &pos2 = atoms[theta_atoms[3*i+1]].pos();
+      theta_r21[i] = cvm::position_distance(pos2, atoms[theta_atoms[3*i  ]].pos());
+      theta_r23[i] = cvm::position_distance(pos2, atoms[theta_atoms[3*i+2]].pos());
+    }
+
     for (size_t i = 0; i < theta.size(); i++) {
 
-      (theta[i])->calc_value();
+      cvm::real const cos_theta = (theta_r21[i]*theta_r23[i]) /
+        (theta_r21[i].norm()*theta_r23[i].norm());
+      theta[i] = (180.0/PI) * cvm::acos(cos_theta);
 
-      cvm::real const t = ((theta[i])->value().real_value-theta_ref)/theta_tol;
+      cvm::real const t = (theta[i]-theta_ref)/theta_tol;
       cvm::real const f = ( (1.0 - (t*t)) /
                             (1.0 - (t*t*t*t)) );
 
@@ -152,7 +178,7 @@ void colvar::alpha_angles::calc_value()
       if (cvm::debug())
         cvm::log("Calpha-Calpha angle no. "+cvm::to_str(i+1)+" in \""+
                   this->name+"\" has a value of "+
-                  (cvm::to_str((theta[i])->value().real_value))+
+                  (cvm::to_str(theta[i]))+
                   " degrees, f = "+cvm::to_str(f)+".\n");
     }
   }
@@ -162,13 +188,26 @@ void colvar::alpha_angles::calc_value()
     cvm::real const hb_norm =
       hb_coeff / cvm::real(hb.size());
 
+    cvm::atom_group &group = *(atom_groups[0]);
+    int const flags = coordnum::ef_null;
+    cvm::rvector const r0_vec(0.0);
+
+    for (size_t i = 0; i < hb.size(); i++) {
+      hb_dists[i] = cvm::position_distance(atoms[hb_atoms[2*i  ]].pos(),
+                                           atoms[hb_atoms[2*i+1]].pos());
+    }
+
     for (size_t i = 0; i < hb.size(); i++) {
-      (hb[i])->calc_value();
-      x.real_value += hb_norm * (hb[i])->value().real_value;
+      hb[i] = coordnum::switching_function<flags>(hb_r0, r0_vec, hb_en, hb_ed,
+                                                  hb_dists[i],
+                                                  group[hb_atoms[2*i  ]],
+                                                  group[hb_atoms[2*i+1]],
+                                                  NULL, 0.0);
+      x.real_value += hb_norm * hb[i];
       if (cvm::debug())
         cvm::log("Hydrogen bond no. "+cvm::to_str(i+1)+" in \""+
                   this->name+"\" has a value of "+
-                  (cvm::to_str((hb[i])->value().real_value))+".\n");
+                  (cvm::to_str(hb[i]))+".\n");
     }
   }
 }
@@ -176,62 +215,69 @@ void colvar::alpha_angles::calc_value()
 
 void colvar::alpha_angles::calc_gradients()
 {
-  size_t i;
-  for (i = 0; i < theta.size(); i++)
-    (theta[i])->calc_gradients();
+  cvm::atom_group &group = *(atom_groups[0]);
+  for (size_t ia = 0; ia < group.size(); ia++) {
+    group[ia].grad().reset();
+  }
 
-  for (i = 0; i < hb.size(); i++)
-    (hb[i])->calc_gradients();
-}
+  if (theta.size()) {
+
+    cvm::real const theta_norm =
+      (1.0-hb_coeff) / cvm::real(theta.size());
 
+    for (size_t i = 0; i < theta.size(); i++) {
 
-void colvar::alpha_angles::collect_gradients(std::vector<int> const &atom_ids, std::vector<cvm::rvector> &atomic_gradients)
-{
-  cvm::real cvc_coeff = sup_coeff * cvm::real(sup_np) * cvm::integer_power(value().real_value, sup_np-1);
+      cvm::rvector const &r21 = theta_r21[i];
+      cvm::rvector const &r23 = theta_r23[i];
+      cvm::real const r21l = r21.norm();
+      cvm::real const r23l = r23.norm();
+      cvm::real const cos_theta = (r21*r23)/(r21l*r23l);
+      cvm::real const dxdcos = -1.0 / cvm::sqrt(1.0 - cos_theta*cos_theta);
 
-  if (theta.size()) {
-    cvm::real const theta_norm = (1.0-hb_coeff) / cvm::real(theta.size());
+      cvm::rvector const dxdr1 = (180.0/PI) * dxdcos *
+        (1.0/r21l) * ( r23/r23l + (-1.0) * cos_theta * r21/r21l );
+      cvm::rvector const dxdr3 = (180.0/PI) * dxdcos *
+        (1.0/r23l) * ( r21/r21l + (-1.0) * cos_theta * r23/r23l );
 
-    for (size_t i = 0; i < theta.size(); i++) {
-      cvm::real const t = ((theta[i])->value().real_value-theta_ref)/theta_tol;
+      cvm::real const t = (theta[i]-theta_ref)/theta_tol;
       cvm::real const f = ( (1.0 - (t*t)) /
                             (1.0 - (t*t*t*t)) );
       cvm::real const dfdt =
         1.0/(1.0 - (t*t*t*t)) *
         ( (-2.0 * t) + (-1.0*f)*(-4.0 * (t*t*t)) );
 
-      // Coefficient of this CVC's gradient in the colvar gradient, times coefficient of this
-      // angle's gradient in the CVC's gradient
-      cvm::real const coeff = cvc_coeff * theta_norm * dfdt * (1.0/theta_tol);
+      cvm::real const coeff = theta_norm * dfdt * (1.0/theta_tol);
 
-      for (size_t j = 0; j < theta[i]->atom_groups.size(); j++) {
-        cvm::atom_group &ag = *(theta[i]->atom_groups[j]);
-        for (size_t k = 0; k < ag.size(); k++) {
-          size_t a = std::lower_bound(atom_ids.begin(), atom_ids.end(),
-                                      ag[k].id) - atom_ids.begin();
-          atomic_gradients[a] += coeff * ag[k].grad;
-        }
-      }
+      group[theta_atoms[3*i  ]].grad() += coeff * dxdr1;
+      group[theta_atoms[3*i+1]].grad() += (-1.0 * coeff) * (dxdr1 + dxdr3);
+      group[theta_atoms[3*i+2]].grad() += coeff * dxdr3;
     }
   }
 
   if (hb.size()) {
 
-    cvm::real const hb_norm = hb_coeff / cvm::real(hb.size());
+    // The hydrogen bond terms carry an additional factor 0.5 in the
+    // gradients and forces (as when they were computed by h_bond objects)
+    cvm::real const hb_norm =
+      hb_coeff / cvm::real(hb.size());
+
+    int const flags = coordnum::ef_gradients;
+    cvm::rvector const r0_vec(0.0);
 
     for (size_t i = 0; i < hb.size(); i++) {
-      // Coefficient of this CVC's gradient in the colvar gradient, times coefficient of this
-      // hbond's gradient in the CVC's gradient
-      cvm::real const coeff = cvc_coeff * 0.5 * hb_norm;
-
-      for (size_t j = 0; j < hb[i]->atom_groups.size(); j++) {
-        cvm::atom_group &ag = *(hb[i]->atom_groups[j]);
-        for (size_t k = 0; k < ag.size(); k++) {
-          size_t a = std::lower_bound(atom_ids.begin(), atom_ids.end(),
-                                      ag[k].id) - atom_ids.begin();
-          atomic_gradients[a] += coeff * ag[k].grad;
-        }
-      }
+      cvm::atom &acceptor = group[hb_atoms[2*i  ]];
+      cvm::atom &donor    = group[hb_atoms[2*i+1]];
+      // Scale only this term's contribution: the same atoms may already
+      // hold gradients of other terms
+      cvm::rvector const acceptor_grad = acceptor.grad();
+      cvm::rvector const donor_grad = donor.grad();
+      acceptor.grad().reset();
+      donor.grad().reset();
+      coordnum::switching_function<flags>(hb_r0, r0_vec, hb_en, hb_ed,
+                                          hb_dists[i], acceptor, donor,
+                                          NULL, 0.0);
+      acceptor.grad() = acceptor_grad + (0.5 * hb_norm) * acceptor.grad();
+      donor.grad() = donor_grad + (0.5 * hb_norm) * donor.grad();
     }
   }
 }
@@ -239,36 +285,8 @@ void colvar::alpha_angles::collect_gradients(std::vector<int> const &atom_ids, s
 
 void colvar::alpha_angles::apply_force(colvarvalue const &force)
 {
-
-  if (theta.size()) {
-
-    cvm::real const theta_norm =
-      (1.0-hb_coeff) / cvm::real(theta.size());
-
-    for (size_t i = 0; i < theta.size(); i++) {
-
-      cvm::real const t = ((theta[i])->value().real_value-theta_ref)/theta_tol;
-      cvm::real const f = ( (1.0 - (t*t)) /
-                            (1.0 - (t*t*t*t)) );
-
-      cvm::real const dfdt =
-        1.0/(1.0 - (t*t*t*t)) *
-        ( (-2.0 * t) + (-1.0*f)*(-4.0 * (t*t*t)) );
-
-      (theta[i])->apply_force(theta_norm *
-                               dfdt * (1.0/theta_tol) *
-                               force.real_value );
-    }
-  }
-
-  if (hb.size()) {
-
-    cvm::real const hb_norm =
-      hb_coeff / cvm::real(hb.size());
-
-    for (size_t i = 0; i < hb.size(); i++) {
-      (hb[i])->apply_force(0.5 * hb_norm * force.real_value);
-    }
+  if (!atom_groups[0]->noforce) {
+    atom_groups[0]->apply_colvar_force(force.real_value);
   }
 }
 
@@ -288,7 +306,6 @@ colvar::dihedPC::dihedPC(std::string const &conf)
     cvm::log("Initializing dihedral PC object.\n");
 
   set_function_type("dihedPC");
-  // Supported through references to atom groups of children cvcs
   enable(f_cvc_explicit_gradient);
   x.type(colvarvalue::type_scalar);
 
@@ -390,27 +407,28 @@ colvar::dihedPC::dihedPC(std::string const &conf)
     return;
   }
 
+  // All atoms are stored in one group, and each dihedral refers to them by index
+  register_atom_group(new cvm::atom_group);
+  cvm::atom_group &group = *(atom_groups[0]);
+
   for (size_t i = 0; i < residues.size()-1; i++) {
     // Psi
-    theta.push_back(new colvar::dihedral(cvm::atom(r[i  ], "N", sid),
-                                         cvm::atom(r[i  ], "CA", sid),
-                                         cvm::atom(r[i  ], "C", sid),
-                                         cvm::atom(r[i+1], "N", sid)));
-    register_atom_group(theta.back()->atom_groups[0]);
-    register_atom_group(theta.back()->atom_groups[1]);
-    register_atom_group(theta.back()->atom_groups[2]);
-    register_atom_group(theta.back()->atom_groups[3]);
+    theta_atoms.push_back(add_residue_atom(group, r[i  ], "N", sid));
+    theta_atoms.push_back(add_residue_atom(group, r[i  ], "CA", sid));
+    theta_atoms.push_back(add_residue_atom(group, r[i  ], "C", sid));
+    theta_atoms.push_back(add_residue_atom(group, r[i+1], "N", sid));
     // Phi (next res)
-    theta.push_back(new colvar::dihedral(cvm::atom(r[i  ], "C", sid),
-                                         cvm::atom(r[i+1], "N", sid),
-                                         cvm::atom(r[i+1], "CA", sid),
-                                         cvm::atom(r[i+1], "C", sid)));
-    register_atom_group(theta.back()->atom_groups[0]);
-    register_atom_group(theta.back()->atom_groups[1]);
-    register_atom_group(theta.back()->atom_groups[2]);
-    register_atom_group(theta.back()->atom_groups[3]);
+    theta_atoms.push_back(add_residue_atom(group, r[i  ], "C", sid));
+    theta_atoms.push_back(add_residue_atom(group, r[i+1], "N", sid));
+    theta_atoms.push_back(add_residue_atom(group, r[i+1], "CA", sid));
+    theta_atoms.push_back(add_residue_atom(group, r[i+1], "C", sid));
   }
 
+  theta.resize(theta_atoms.size()/4);
+  theta_r12.resize(theta.size());
+  theta_r23.resize(theta.size());
+  theta_r34.resize(theta.size());
+
   if (cvm::debug())
     cvm::log("Done initializing dihedPC object.\n");
 }
@@ -420,7 +438,6 @@ colvar::dihedPC::dihedPC()
   : cvc()
 {
   set_function_type("dihedPC");
-  // Supported through references to atom groups of children cvcs
   enable(f_cvc_explicit_gradient);
   x.type(colvarvalue::type_scalar);
 }
@@ -428,21 +445,28 @@ colvar::dihedPC::dihedPC()
 
 colvar::dihedPC::~dihedPC()
 {
-  while (theta.size() != 0) {
-    delete theta.back();
-    theta.pop_back();
-  }
-  // Our references to atom groups have become invalid now that children cvcs are deleted
-  atom_groups.clear();
 }
 
 
 void colvar::dihedPC::calc_value()
 {
+  cvm::atom_group const &atoms = *(atom_groups[0]);
+
+  for (size_t i = 0; i < theta.size(); i++) {
+    cvm::atom_pos const &pos1 = atoms[theta_atoms[4*i  ]].pos();
+    cvm::atom_pos const &pos2 = atoms[theta_atoms[4*i+1]].pos();
+    cvm::atom_pos const &pos3 = atoms[theta_atoms[4*i+2]].pos();
+    cvm::atom_pos const &pos4 = atoms[theta_atoms[4*i+3]].pos();
+    theta_r12[i] = cvm::position_distance(pos1, pos2);
+    theta_r23[i] = cvm::position_distance(pos2, pos3);
+    theta_r34[i] = cvm::position_distance(pos3, pos4);
+  }
+
   x.real_value = 0.0;
   for (size_t i = 0; i < theta.size(); i++) {
-    theta[i]->calc_value();
-    cvm::real const t = (PI / 180.) * theta[i]->value().real_value;
+    theta[i] = dihedral::dihedral_value(theta_r12[i], theta_r23[i],
+                                        theta_r34[i]);
+    cvm::real const t = (PI / 180.) * theta[i];
     x.real_value += coeffs[2*i  ] * cvm::cos(t)
                   + coeffs[2*i+1] * cvm::sin(t);
   }
@@ -451,44 +475,33 @@ void colvar::dihedPC::calc_value()
 
 void colvar::dihedPC::calc_gradients()
 {
-  for (size_t i = 0; i < theta.size(); i++) {
-    theta[i]->calc_gradients();
+  cvm::atom_group &group = *(atom_groups[0]);
+  for (size_t ia = 0; ia < group.size(); ia++) {
+    group[ia].grad().reset();
   }
-}
 
-
-void colvar::dihedPC::collect_gradients(std::vector<int> const &atom_ids, std::vector<cvm::rvector> &atomic_gradients)
-{
-  cvm::real cvc_coeff = sup_coeff * cvm::real(sup_np) * cvm::integer_power(value().real_value, sup_np-1);
+  cvm::rvector f1, f2, f3;
   for (size_t i = 0; i < theta.size(); i++) {
-    cvm::real const t = (PI / 180.) * theta[i]->value().real_value;
+    cvm::real const t = (PI / 180.) * theta[i];
     cvm::real const dcosdt = - (PI / 180.) * cvm::sin(t);
     cvm::real const dsindt =   (PI / 180.) * cvm::cos(t);
-    // Coefficient of this dihedPC's gradient in the colvar gradient, times coefficient of this
-    // dihedral's gradient in the dihedPC's gradient
-    cvm::real const coeff = cvc_coeff * (coeffs[2*i] * dcosdt + coeffs[2*i+1] * dsindt);
-
-    for (size_t j = 0; j < theta[i]->atom_groups.size(); j++) {
-      cvm::atom_group &ag = *(theta[i]->atom_groups[j]);
-      for (size_t k = 0; k < ag.size(); k++) {
-        size_t a = std::lower_bound(atom_ids.begin(), atom_ids.end(),
-                                    ag[k].id) - atom_ids.begin();
-        atomic_gradients[a] += coeff * ag[k].grad;
-      }
-    }
+    cvm::real const coeff = coeffs[2*i] * dcosdt + coeffs[2*i+1] * dsindt;
+
+    dihedral::dihedral_gradients(theta_r12[i], theta_r23[i], theta_r34[i],
+                                 f1, f2, f3);
+
+    group[theta_atoms[4*i  ]].grad() += coeff * (-1.0 * f1);
+    group[theta_atoms[4*i+1]].grad() += coeff * (f1 - f2);
+    group[theta_atoms[4*i+2]].grad() += coeff * (f2 - f3);
+    group[theta_atoms[4*i+3]].grad() += coeff * f3;
   }
 }
 
 
 void colvar::dihedPC::apply_force(colvarvalue const &force)
 {
-  for (size_t i = 0; i < theta.size(); i++) {
-    cvm::real const t = (PI / 180.) * theta[i]->value().real_value;
-    cvm::real const dcosdt = - (PI / 180.) * cvm::sin(t);
-    cvm::real const dsindt =   (PI / 180.) * cvm::cos(t);
-
-    theta[i]->apply_force((coeffs[2*i  ] * dcosdt +
-                           coeffs[2*i+1] * dsindt) * force);
+  if (!atom_groups[0]->noforce) {
+    atom_groups[0]->apply_colvar_force(force.real_value);
   }
 }
 
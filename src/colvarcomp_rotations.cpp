@@ -200,7 +200,7 @@ void colvar::orientation_angle::calc_gradients()
       0.0 );
 
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = (dxdq0 * (rot.dQ0_2[ia])[0]);
+    (*atoms)[ia].grad() = (dxdq0 * (rot.dQ0_2[ia])[0]);
   }
 }
 
@@ -247,7 +247,7 @@ void colvar::orientation_proj::calc_gradients()
 {
   cvm::real const dxdq0 = 2.0 * 2.0 * (rot.q).q0;
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = (dxdq0 * (rot.dQ0_2[ia])[0]);
+    (*atoms)[ia].grad() = (dxdq0 * (rot.dQ0_2[ia])[0]);
   }
 }
 
@@ -308,9 +308,9 @@ void colvar::tilt::calc_gradients()
   cvm::quaternion const dxdq = rot.dcos_theta_dq(axis);
 
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = cvm::rvector(0.0, 0.0, 0.0);
+    (*atoms)[ia].grad() = cvm::rvector(0.0, 0.0, 0.0);
     for (size_t iq = 0; iq < 4; iq++) {
-      (*atoms)[ia].grad += (dxdq[iq] * (rot.dQ0_2[ia])[iq]);
+      (*atoms)[ia].grad() += (dxdq[iq] * (rot.dQ0_2[ia])[iq]);
     }
   }
 }
@@ -384,9 +384,9 @@ void colvar::spin_angle::calc_gradients()
   cvm::quaternion const dxdq = rot.dspin_angle_dq(axis);
 
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = cvm::rvector(0.0, 0.0, 0.0);
+    (*atoms)[ia].grad() = cvm::rvector(0.0, 0.0, 0.0);
     for (size_t iq = 0; iq < 4; iq++) {
-      (*atoms)[ia].grad += (dxdq[iq] * (rot.dQ0_2[ia])[iq]);
+      (*atoms)[ia].grad() += (dxdq[iq] * (rot.dQ0_2[ia])[iq]);
     }
   }
 }
@@ -500,7 +500,7 @@ void colvar::euler_phi::calc_gradients()
   const cvm::real dxdq2 = (180.0/PI) * (-4 * q2 * (-2 * q0 * q1 - 2 * q2 * q3) + 2 * q3 * (-2 * q1 * q1 - 2 * q2 * q2 + 1)) / denominator;
   const cvm::real dxdq3 = (180.0/PI) * 2 * q2 * (-2 * q1 * q1 - 2 * q2 * q2 + 1) / denominator;
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = (dxdq0 * (rot.dQ0_2[ia])[0]) +
+    (*atoms)[ia].grad() = (dxdq0 * (rot.dQ0_2[ia])[0]) +
                         (dxdq1 * (rot.dQ0_2[ia])[1]) +
                         (dxdq2 * (rot.dQ0_2[ia])[2]) +
                         (dxdq3 * (rot.dQ0_2[ia])[3]);
@@ -615,7 +615,7 @@ void colvar::euler_psi::calc_gradients()
   const cvm::real dxdq2 = (180.0/PI) * (2 * q1 * (-2 * q2 * q2 - 2 * q3 * q3 + 1) - 4 * q2 * (-2 * q0 * q3 - 2 * q1 * q2)) / denominator;
   const cvm::real dxdq3 = (180.0/PI) * (2 * q0 * (-2 * q2 * q2 - 2 * q3 * q3 + 1) - 4 * q3 * (-2 * q0 * q3 - 2 * q1 * q2)) / denominator;
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = (dxdq0 * (rot.dQ0_2[ia])[0]) +
+    (*atoms)[ia].grad() = (dxdq0 * (rot.dQ0_2[ia])[0]) +
                         (dxdq1 * (rot.dQ0_2[ia])[1]) +
                         (dxdq2 * (rot.dQ0_2[ia])[2]) +
                         (dxdq3 * (rot.dQ0_2[ia])[3]);
@@ -728,7 +728,7 @@ void colvar::euler_theta::calc_gradients()
   const cvm::real dxdq2 = (180.0/PI) * 2 * q0 / denominator;
   const cvm::real dxdq3 = (180.0/PI) * -2 * q1 / denominator;
   for (size_t ia = 0; ia < atoms->size(); ia++) {
-    (*atoms)[ia].grad = (dxdq0 * (rot.dQ0_2[ia])[0]) +
+    (*atoms)[ia].grad() = (dxdq0 * (rot.dQ0_2[ia])[0]) +
                         (dxdq1 * (rot.dQ0_2[ia])[1]) +
                         (dxdq2 * (rot.dQ0_2[ia])[2]) +
                         (dxdq3 * (rot.dQ0_2[ia])[3]);
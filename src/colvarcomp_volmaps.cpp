@@ -45,6 +45,7 @@ int colvar::map_total::init(std::string const &conf)
   get_keyval(conf, "mapName", volmap_name, volmap_name);
   get_keyval(conf, "mapID", volmap_id, volmap_id);
   register_param("mapID", reinterpret_cast<void *>(&volmap_id));
+  get_keyval(conf, "mapFile", volmap_file, volmap_file);
 
   cvm::main()->cite_feature("Volumetric map-based collective variables");
 
@@ -53,9 +54,31 @@ int colvar::map_total::init(std::string const &conf)
       cvm::error("Error: mapName and mapID are mutually exclusive.\n");
   }
 
+  if ((volmap_file.size() > 0) && ((volmap_name.size() > 0) ||
+                                   (volmap_id >= 0))) {
+    error_code |=
+      cvm::error("Error: mapFile is mutually exclusive with mapName and "
+                 "mapID.\n", COLVARS_INPUT_ERROR);
+  }
+
   // Parse optional group
-  atoms = parse_group(conf, "atoms", true);
-  if (atoms != NULL) {
+  atoms = parse_group(conf, "atoms", volmap_file.size() == 0);
+
+  if (volmap_file.size() > 0) {
+
+    // Map loaded and interpolated by Colvars, atoms are required
+    if (atoms == NULL) {
+      return error_code | cvm::error("Error: mapFile requires defining "
+                                     "\"atoms\".\n", COLVARS_INPUT_ERROR);
+    }
+    bool b_periodic = false;
+    get_keyval(conf, "mapPeriodic", b_periodic, b_periodic);
+    volmap_id = proxy->load_internal_volmap(volmap_file, b_periodic);
+    if (volmap_id < 0) {
+      error_code |= COLVARS_INPUT_ERROR;
+    }
+
+  } else if (atoms != NULL) {
 
     // Using internal selection
     if (volmap_name.size()) {
@@ -116,8 +139,14 @@ void colvar::map_total::calc_value()
       flags |= colvarproxy::volmap_flag_use_atom_field;
       w = &(atom_weights[0]);
     }
-    proxy->compute_volmap(flags, volmap_id, atoms->begin(), atoms->end(),
-                          &(x.real_value), w);
+    if (volmap_file.size() > 0) {
+      proxy->compute_internal_volmap(flags, volmap_id,
+                                     atoms->begin(), atoms->end(),
+                                     &(x.real_value), w);
+    } else {
+      proxy->compute_volmap(flags, volmap_id, atoms->begin(), atoms->end(),
+                            &(x.real_value), w);
+    }
   } else {
     // Get the externally computed value
     x.real_value = proxy->get_volmap_value(volmap_index);
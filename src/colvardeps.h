@@ -376,6 +376,9 @@ public:
     f_cvc_scalable,
     /// Centers-of-mass used in this CVC can be computed in parallel
     f_cvc_scalable_com,
+    /// \brief Additive reductions over the atoms of the groups used in this
+    /// CVC can be computed in parallel
+    f_cvc_scalable_reductions,
     /// \brief Build list of atoms involved in CVC calculation
     f_cvc_collect_atom_ids,
     /// Number of CVC features
@@ -120,6 +120,33 @@ cvm::real colvar_grid_scalar::minimum_pos_value() const
   return minpos;
 }
 
+cvm::real colvar_grid_scalar::value_interpolated(std::vector<colvarvalue> const *values,
+                                                 int order,
+                                                 cvm::real *gradient)
+{
+  std::vector<size_t> const &points = interp_points;
+  std::vector<cvm::real> const &weights = interp_weights;
+  std::vector<cvm::real> const &dweights = interp_dweights;
+  interpolation_stencil(values, order, interp_points, interp_weights,
+                        gradient ? &interp_dweights : NULL);
+  cvm::real result = 0.0;
+  size_t ip, i;
+  if (gradient) {
+    for (i = 0; i < nd; i++) gradient[i] = 0.0;
+  }
+  for (ip = 0; ip < points.size(); ip++) {
+    cvm::real const v = data[points[ip]];
+    result += weights[ip] * v;
+    if (gradient) {
+      for (i = 0; i < nd; i++) {
+        gradient[i] += dweights[ip*nd+i] * v;
+      }
+    }
+  }
+  return result;
+}
+
+
 cvm::real colvar_grid_scalar::integral() const
 {
   cvm::real sum = 0.0;
@@ -247,6 +274,86 @@ int colvar_grid_gradient::read_multicol(std::string const &filename,
   return colvar_grid<cvm::real>::read_multicol(filename, description, add);
 }
 
+void colvar_grid_gradient::set_czar_value(std::vector<int> const &ix,
+                                          colvar_grid_gradient const &z_gradients,
+                                          colvar_grid_count &z_samples,
+                                          cvm::real kT)
+{
+  for (size_t n = 0; n < mult; n++) {
+    set_value(ix, z_gradients.value_output(ix, n)
+              - kT * z_samples.log_gradient_finite_diff(ix, n), n);
+  }
+}
+
+
+void colvar_grid_gradient::set_czar(colvar_grid_gradient const &z_gradients,
+                                    colvar_grid_count &z_samples, cvm::real kT)
+{
+  for (std::vector<int> ix = new_index(); index_ok(ix); incr(ix)) {
+    set_czar_value(ix, z_gradients, z_samples, kT);
+  }
+  for (size_t i = 0; i < czar_flagged_bins.size(); i++) {
+    czar_flags[address(czar_flagged_bins[i])] = false;
+  }
+  czar_flagged_bins.clear();
+}
+
+
+void colvar_grid_gradient::flag_czar_bin(std::vector<int> const &z_bin)
+{
+  if (czar_flags.size() != nt) {
+    czar_flags.assign(nt, false);
+  }
+  size_t const addr = address(z_bin);
+  if (!czar_flags[addr]) {
+    czar_flags[addr] = true;
+    czar_flagged_bins.push_back(z_bin);
+  }
+}
+
+
+void colvar_grid_gradient::update_czar(colvar_grid_gradient const &z_gradients,
+                                       colvar_grid_count &z_samples,
+                                       cvm::real kT,
+                                       std::vector< std::vector<int> > &updated_bins)
+{
+  updated_bins.clear();
+  size_t i;
+  for (i = 0; i < czar_flagged_bins.size(); i++) {
+    czar_flags[address(czar_flagged_bins[i])] = false;
+  }
+
+  // The gradient at a point depends on the sample counts up to two points
+  // away along each dimension (at the edges)
+  for (i = 0; i < czar_flagged_bins.size(); i++) {
+    std::vector<int> const &z_bin = czar_flagged_bins[i];
+    for (size_t n = 0; n < nd; n++) {
+      for (int d = -2; d <= 2; d++) {
+        if ((d == 0) && (n > 0)) continue;
+        std::vector<int> ix(z_bin);
+        ix[n] += d;
+        if (periodic[n]) {
+          wrap(ix);
+        } else if ((ix[n] < 0) || (ix[n] >= nx[n])) {
+          continue;
+        }
+        size_t const addr = address(ix);
+        if (!czar_flags[addr]) {
+          czar_flags[addr] = true;
+          updated_bins.push_back(ix);
+          set_czar_value(ix, z_gradients, z_samples, kT);
+        }
+      }
+    }
+  }
+
+  for (i = 0; i < updated_bins.size(); i++) {
+    czar_flags[address(updated_bins[i])] = false;
+  }
+  czar_flagged_bins.clear();
+}
+
+
 void colvar_grid_gradient::write_1D_integral(std::ostream &os)
 {
   cvm::real bin, min, integral;
@@ -993,3 +1100,87 @@ cvm::real integrate_potential::l2norm(const std::vector<cvm::real> &x)
     sum += x[i]*x[i];
   return sqrt(sum);
 }
+
+
+colvar_grid_history::colvar_grid_history()
+  : keyframe_freq(1), num_frames(0), header_written(false)
+{}
+
+
+void colvar_grid_history::init(std::string const &filename_in,
+                               size_t keyframe_freq_in)
+{
+  filename = filename_in;
+  keyframe_freq = (keyframe_freq_in > 0) ? keyframe_freq_in : 1;
+  num_frames = 0;
+  header_written = false;
+  last_data.clear();
+}
+
+
+int colvar_grid_history::write_new_data(cvm::step_number step)
+{
+  colvarproxy *proxy = cvm::main()->proxy;
+  std::ostream *os = proxy->output_stream(filename, std::ios::out |
+                                          std::ios::binary);
+  if (!os) {
+    return cvm::error("Error opening file " + filename + " for writing.\n",
+                      COLVARS_FILE_ERROR);
+  }
+
+  if (!header_written) {
+    os->write("CVGRIDH2", 8);
+    os->write(reinterpret_cast<char const *>(&(header[0])),
+              header.size() * sizeof(cvm::real));
+    header_written = true;
+  }
+
+  bool keyframe = ((num_frames % keyframe_freq) == 0) ||
+    (last_data.size() != new_data.size());
+
+  delta_indices.clear();
+  delta_values.clear();
+  if (!keyframe) {
+    for (size_t i = 0; i < new_data.size(); i++) {
+      if (new_data[i] != last_data[i]) {
+        delta_indices.push_back(int(i));
+        delta_values.push_back(new_data[i]);
+      }
+    }
+    // A delta frame would not be smaller than a keyframe
+    keyframe = (2 * delta_indices.size() >= new_data.size());
+  }
+
+  cvm::real frame_header[3];
+  frame_header[0] = cvm::real(step);
+  if (keyframe) {
+    frame_header[1] = 0.0;
+    frame_header[2] = cvm::real(new_data.size());
+    os->write(reinterpret_cast<char const *>(frame_header), sizeof(frame_header));
+    if (new_data.size() > 0) {
+      os->write(reinterpret_cast<char const *>(&(new_data[0])),
+                new_data.size() * sizeof(cvm::real));
+    }
+  } else {
+    size_t const n = delta_indices.size();
+    frame_header[1] = 1.0;
+    frame_header[2] = cvm::real(n);
+    os->write(reinterpret_cast<char const *>(frame_header), sizeof(frame_header));
+    if (n > 0) {
+      os->write(reinterpret_cast<char const *>(&(delta_indices[0])),
+                n * sizeof(int));
+      os->write(reinterpret_cast<char const *>(&(delta_values[0])),
+                n * sizeof(cvm::real));
+    }
+  }
+
+  last_data = new_data;
+  num_frames++;
+
+  if (!*os) {
+    return cvm::error("Error writing to file " + filename + ".\n",
+                      COLVARS_FILE_ERROR);
+  }
+  return proxy->flush_output_stream(os);
+}
+
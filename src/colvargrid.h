@@ -54,6 +54,11 @@ protected:
   /// Do we request actual value (for extended-system colvars)?
   std::vector<bool> use_actual_value;
 
+  /// Work buffers of interpolation_stencil(), kept between calls
+  std::vector<int> stencil_ix0;
+  std::vector<size_t> stencil_offsets;
+  std::vector<cvm::real> stencil_w1, stencil_dw1;
+
   /// Get the low-level index corresponding to an index
   inline size_t address(std::vector<int> const &ix) const
   {
@@ -634,6 +639,100 @@ public:
     return index;
   }
 
+  /// \brief Compute the grid points and weights needed to interpolate the
+  /// grid at the provided values of the colvars (or the current values if
+  /// NULL), with order 1 (multilinear) or 3 (cubic Catmull-Rom spline)
+  /// \param points Addresses of the first element of each grid point
+  /// \param weights Interpolation weight of each point
+  /// \param dweights If not NULL, derivatives of each weight with respect
+  /// to each colvar (nd numbers per point)
+  /// Points beyond non-periodic edges are replaced by the edge points
+  void interpolation_stencil(std::vector<colvarvalue> const *values,
+                             int order,
+                             std::vector<size_t> &points,
+                             std::vector<cvm::real> &weights,
+                             std::vector<cvm::real> *dweights = NULL)
+  {
+    size_t const np = (order == 3) ? 4 : 2;
+    std::vector<int> &ix0 = stencil_ix0;
+    std::vector<cvm::real> &w1 = stencil_w1, &dw1 = stencil_dw1;
+    ix0.resize(nd);
+    w1.resize(nd*np);
+    dw1.resize(nd*np);
+    size_t i, k, n_points = 1;
+
+    for (i = 0; i < nd; i++) {
+      cvm::real const x = values ? (*values)[i].real_value :
+        (use_actual_value[i] ? cv[i]->actual_value() : cv[i]->value()).real_value;
+      // Position relative to the centers of the bins
+      cvm::real const u = (x - lower_boundaries[i].real_value) / widths[i] - 0.5;
+      cvm::real const u0 = cvm::floor(u);
+      cvm::real const t = u - u0, t2 = t*t, t3 = t2*t;
+      cvm::real *w = &(w1[i*np]), *dw = &(dw1[i*np]);
+      if (np == 4) {
+        ix0[i] = int(u0) - 1;
+        w[0] = 0.5 * (-t3 + 2.0*t2 - t);
+        w[1] = 0.5 * (3.0*t3 - 5.0*t2 + 2.0);
+        w[2] = 0.5 * (-3.0*t3 + 4.0*t2 + t);
+        w[3] = 0.5 * (t3 - t2);
+        dw[0] = 0.5 * (-3.0*t2 + 4.0*t - 1.0);
+        dw[1] = 0.5 * (9.0*t2 - 10.0*t);
+        dw[2] = 0.5 * (-9.0*t2 + 8.0*t + 1.0);
+        dw[3] = 0.5 * (3.0*t2 - 2.0*t);
+      } else {
+        ix0[i] = int(u0);
+        w[0] = 1.0 - t;
+        w[1] = t;
+        dw[0] = -1.0;
+        dw[1] = 1.0;
+      }
+      for (k = 0; k < np; k++) {
+        dw[k] /= widths[i];
+      }
+      n_points *= np;
+    }
+
+    points.resize(n_points);
+    weights.resize(n_points);
+    if (dweights) dweights->resize(n_points*nd);
+
+    // Offsets of the current point within the stencil
+    std::vector<size_t> &ik = stencil_offsets;
+    ik.assign(nd, 0);
+    for (size_t ip = 0; ip < n_points; ip++) {
+      size_t addr = 0;
+      cvm::real w = 1.0;
+      for (i = 0; i < nd; i++) {
+        int ix = ix0[i] + int(ik[i]);
+        if (periodic[i]) {
+          ix = ((ix % nx[i]) + nx[i]) % nx[i];
+        } else if (ix < 0) {
+          ix = 0;
+        } else if (ix >= nx[i]) {
+          ix = nx[i] - 1;
+        }
+        addr += ix * static_cast<size_t>(nxc[i]);
+        w *= w1[i*np+ik[i]];
+      }
+      points[ip] = addr;
+      weights[ip] = w;
+      if (dweights) {
+        for (i = 0; i < nd; i++) {
+          cvm::real dw = dw1[i*np+ik[i]];
+          for (k = 0; k < nd; k++) {
+            if (k != i) dw *= w1[k*np+ik[k]];
+          }
+          (*dweights)[ip*nd+i] = dw;
+        }
+      }
+      // Increment the offsets, last dimension first
+      for (int id = int(nd)-1; id >= 0; id--) {
+        if (++ik[id] < np) break;
+        ik[id] = 0;
+      }
+    }
+  }
+
   /// \brief Get the minimal distance (in number of bins) from the
   /// boundaries; a negative number is returned if the given point is
   /// off-grid
@@ -1469,6 +1568,14 @@ public:
     has_data = true;
   }
 
+  /// \brief Interpolate the (unnormalized) values of the grid at the
+  /// provided values of the colvars (or the current values if NULL), see
+  /// interpolation_stencil(); if gradient is not NULL, store there the
+  /// gradient of the same interpolating function
+  cvm::real value_interpolated(std::vector<colvarvalue> const *values,
+                               int order,
+                               cvm::real *gradient = NULL);
+
   /// \brief Return the highest value
   cvm::real maximum_value() const;
 
@@ -1484,6 +1591,12 @@ public:
   /// \brief Assuming that the map is a normalized probability density,
   ///        calculates the entropy (uses widths if they are defined)
   cvm::real entropy() const;
+
+protected:
+
+  /// Work buffers of value_interpolated(), kept between calls
+  std::vector<size_t> interp_points;
+  std::vector<cvm::real> interp_weights, interp_dweights;
 };
 
 
@@ -1548,6 +1661,19 @@ public:
     }
   }
 
+  /// \brief Same as above, with the bin given by its linear index (i.e. its
+  /// address in a grid of multiplicity 1, such as samples)
+  inline void vector_value(size_t i_bin, std::vector<cvm::real> &v) const
+  {
+    cvm::real const * p = &(data[i_bin * mult]);
+    cvm::real const invcount = samples ?
+      (samples->value(i_bin) ? 1.0 / cvm::real(samples->value(i_bin)) : 0.0) :
+      1.0;
+    for (size_t i = 0; i < mult; i++) {
+      v[i] = invcount * p[i];
+    }
+  }
+
   /// \brief Accumulate the value
   inline void acc_value(std::vector<int> const &ix, std::vector<colvarvalue> const &values) {
     for (size_t imult = 0; imult < mult; imult++) {
@@ -1614,6 +1740,23 @@ public:
   }
 
 
+  /// \brief Set all values to the CZAR estimate of the free energy
+  /// gradient, from the gradients and samples accumulated along the
+  /// extended coordinates (grids with the same geometry as this one)
+  void set_czar(colvar_grid_gradient const &z_gradients,
+                colvar_grid_count &z_samples, cvm::real kT);
+
+  /// \brief Record that the bin z_bin of the extended-coordinate grids
+  /// changed since the last call to set_czar() or update_czar()
+  void flag_czar_bin(std::vector<int> const &z_bin);
+
+  /// \brief Recompute the CZAR estimate only at the points whose finite
+  /// differences involve the bins flagged since the last call, and list
+  /// those points in updated_bins
+  void update_czar(colvar_grid_gradient const &z_gradients,
+                   colvar_grid_count &z_samples, cvm::real kT,
+                   std::vector< std::vector<int> > &updated_bins);
+
   /// Compute and return average value for a 1D gradient grid
   inline cvm::real average()
   {
@@ -1642,6 +1785,19 @@ public:
   /// integral to a file
   void write_1D_integral(std::ostream &os);
 
+
+protected:
+
+  /// Bins of the extended-coordinate grids flagged by flag_czar_bin()
+  std::vector< std::vector<int> > czar_flagged_bins;
+
+  /// Flags of the bins in czar_flagged_bins (and work buffer)
+  std::vector<bool> czar_flags;
+
+  /// Set the CZAR estimate at the point ix
+  void set_czar_value(std::vector<int> const &ix,
+                      colvar_grid_gradient const &z_gradients,
+                      colvar_grid_count &z_samples, cvm::real kT);
 };
 
 
@@ -1713,5 +1869,94 @@ class integrate_potential : public colvar_grid_scalar
 //   void asolve(const std::vector<cvm::real> &b, std::vector<cvm::real> &x);
 };
 
-#endif
 
+/// \brief Compact binary history of a grid: each frame contains only the
+/// values that changed since the previous frame, and a complete copy of the
+/// data (keyframe) is written every keyframe_freq frames, or when at least
+/// half of the values changed.
+///
+/// Numbers are stored in native byte order, after an 8-character signature
+/// ("CVGRIDH2"); all are 64-bit floating-point values, except the indices
+/// of the changed values (32-bit integers):
+/// - header: nd, mult, then for each variable: lower boundary, width,
+///   number of points, periodic flag
+/// - keyframe: step, 0, number of values, values (the same values as in
+///   the multicolumn files, in the same order)
+/// - delta frame: step, 1, number of changed values, their indices, their
+///   new values
+///
+/// See colvartools/colvars_grid.py for a reader.
+class colvar_grid_history {
+
+public:
+
+  colvar_grid_history();
+
+  /// Set the output file and the number of frames between keyframes
+  void init(std::string const &filename, size_t keyframe_freq);
+
+  /// Name of the output file
+  inline std::string const &file_name() const
+  {
+    return filename;
+  }
+
+  /// Append the current data of the grid as a new frame
+  template <class T>
+  int write_frame(colvar_grid<T> const &grid, cvm::step_number step)
+  {
+    if (!header_written) {
+      header.clear();
+      header.push_back(cvm::real(grid.num_variables()));
+      header.push_back(cvm::real(grid.multiplicity()));
+      for (size_t i = 0; i < grid.num_variables(); i++) {
+        header.push_back(grid.lower_boundaries[i].real_value);
+        header.push_back(grid.widths[i]);
+        header.push_back(cvm::real(grid.number_of_points(i)));
+        header.push_back(grid.periodic[i] ? 1.0 : 0.0);
+      }
+    }
+    new_data.clear();
+    for (std::vector<int> ix = grid.new_index(); grid.index_ok(ix);
+         grid.incr(ix)) {
+      for (size_t imult = 0; imult < grid.multiplicity(); imult++) {
+        new_data.push_back(cvm::real(grid.value_output(ix, imult)));
+      }
+    }
+    return write_new_data(step);
+  }
+
+protected:
+
+  /// Name of the output file
+  std::string filename;
+
+  /// Number of frames between keyframes
+  size_t keyframe_freq;
+
+  /// Number of frames written so far
+  size_t num_frames;
+
+  /// Whether the header was written to the file
+  bool header_written;
+
+  /// Contents of the header
+  std::vector<cvm::real> header;
+
+  /// Data of the last frame written
+  std::vector<cvm::real> last_data;
+
+  /// Data of the frame being written
+  std::vector<cvm::real> new_data;
+
+  /// Indices of the changed data (work buffer)
+  std::vector<int> delta_indices;
+
+  /// Values of the changed data (work buffer)
+  std::vector<cvm::real> delta_values;
+
+  /// Write new_data as a keyframe or delta frame
+  int write_new_data(cvm::step_number step);
+};
+
+#endif
@@ -14,6 +14,13 @@
 #include <cstring>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <ctime>
+#if (__cplusplus >= 201103L)
+#include <chrono>
+#include <system_error>
+#include <thread>
+#endif
 
 #include "colvarmodule.h"
 #include "colvarparse.h"
@@ -69,6 +76,67 @@ protected:
 };
 
 
+namespace {
+  /// Name of the module object in the profile report
+  std::string const module_profile_name("colvarmodule");
+}
+
+
+/// Timings of the Colvars objects
+class colvarmodule::profiler {
+
+public:
+
+  /// Return the slot of the record with the given label, adding it if needed
+  int add_slot(std::string const &label, size_t num_threads);
+
+  /// Number of threads that have their own row of records
+  inline size_t num_threads() const
+  {
+    return counts_.empty() ? 0 : counts_.size() - 1;
+  }
+
+  /// Add the time t to the record in the given slot and row
+  inline void add_time(int slot, size_t row, double t)
+  {
+    counts_[row][slot] += 1;
+    times_[row][slot] += t;
+  }
+
+  /// Generate a report sorted by total time, in percent of the given slot
+  std::string report(int total_slot) const;
+
+  /// Reset the counts and times of all records
+  void clear();
+
+protected:
+
+  /// Labels of the records
+  std::vector<std::string> labels_;
+
+  /// Slots of the records indexed by their labels
+  std::map<std::string, int> slots_;
+
+  /// Number of calls and total time of each record, one row per thread,
+  /// plus a last row for the threads started after the rows were allocated
+  std::vector< std::vector<size_t> > counts_;
+  std::vector< std::vector<double> > times_;
+
+  /// Timings of one object and operation, summed over all threads
+  struct record {
+    std::string label;
+    size_t count;
+    double time;
+  };
+
+  /// Sort records by decreasing total time
+  static bool compare_time(record const &r1, record const &r2)
+  {
+    return r1.time > r2.time;
+  }
+};
+
+
 colvarmodule::colvarmodule(colvarproxy *proxy_in)
 {
   depth_s = 0;
@@ -81,12 +149,19 @@ colvarmodule::colvarmodule(colvarproxy *proxy_in)
   num_biases_types_used_ =
     reinterpret_cast<void *>(new std::map<std::string, int>());
 
+  calc_async_thread_ = NULL;
+  calc_async_pending_ = false;
+  calc_async_error_code_ = COLVARS_OK;
+  calc_async_buffer_messages_ = false;
+
   restart_version_str.clear();
   restart_version_int = 0;
 
   usage_ = new usage();
   usage_->cite_feature("Colvars module");
 
+  profiler_ = new profiler();
+
   if (proxy != NULL) {
     // TODO relax this error to handle multiple molecules in VMD
     // once the module is not static anymore
@@ -97,6 +172,10 @@ colvarmodule::colvarmodule(colvarproxy *proxy_in)
 
   proxy = proxy_in; // Pointer to the proxy object
   parse = new colvarparse(); // Parsing object for global options
+
+  calc_profile_slot_ = profile_slot(module_profile_name, "calc");
+  traj_profile_slot_ = profile_slot(module_profile_name, "write_traj_files");
+  restart_profile_slot_ = profile_slot(module_profile_name, "write_restart_file");
   version_int = proxy->get_version_from_string(COLVARS_VERSION);
 
   cvm::log(cvm::line_marker);
@@ -138,6 +217,8 @@ colvarmodule::colvarmodule(colvarproxy *proxy_in)
   // by default overwrite the existing trajectory file
   cv_traj_append = false;
   cv_traj_write_labels = true;
+  cv_traj_binary = false;
+  cv_traj_flush_freq = 0;
 
   // Removes the need for proxy specializations to create this
   proxy->script = new colvarscript(proxy, this);
@@ -385,6 +466,26 @@ int colvarmodule::parse_global_params(std::string const &conf)
                     colvarparse::parse_silent);
 
   parse->get_keyval(conf, "colvarsTrajFrequency", cv_traj_freq, cv_traj_freq);
+
+  {
+    std::string traj_format(cv_traj_binary ? "binary" : "text");
+    if (parse->get_keyval(conf, "colvarsTrajFormat", traj_format, traj_format)) {
+      traj_format = colvarparse::to_lower_cppstr(traj_format);
+      if ((traj_format != "text") && (traj_format != "binary")) {
+        return cvm::error("Error: invalid value \""+traj_format+
+                          "\" for colvarsTrajFormat.\n", COLVARS_INPUT_ERROR);
+      }
+      bool const binary = (traj_format == "binary");
+      if ((binary != cv_traj_binary) && (cv_traj_os != NULL)) {
+        return cvm::error("Error: colvarsTrajFormat cannot be changed after "
+                          "the trajectory file was opened.\n",
+                          COLVARS_INPUT_ERROR);
+      }
+      cv_traj_binary = binary;
+    }
+  }
+  parse->get_keyval(conf, "colvarsTrajFlushFrequency",
+                    cv_traj_flush_freq, cv_traj_flush_freq);
   parse->get_keyval(conf, "colvarsRestartFrequency",
                     restart_out_freq, restart_out_freq);
 
@@ -398,6 +499,13 @@ int colvarmodule::parse_global_params(std::string const &conf)
   parse->get_keyval(conf, "scriptingAfterBiases",
                     scripting_after_biases, scripting_after_biases);
 
+  {
+    bool b_profiling = profiling_;
+    if (parse->get_keyval(conf, "profiling", b_profiling, b_profiling)) {
+      set_profiling(b_profiling);
+    }
+  }
+
 #if defined(COLVARS_TCL)
   parse->get_keyval(conf, "sourceTclFile", source_Tcl_script);
 #endif
@@ -788,6 +896,8 @@ int colvarmodule::calc()
              cvm::to_str(cvm::step_absolute())+"\n");
   }
 
+  profile_timer const calc_timer(calc_profile_slot_);
+
   error_code |= calc_colvars();
   error_code |= calc_biases();
   error_code |= update_colvar_forces();
@@ -796,6 +906,7 @@ int colvarmodule::calc()
 
   // write trajectory files, if needed
   if (cv_traj_freq && cv_traj_name.size()) {
+    profile_timer const timer(traj_profile_slot_);
     error_code |= write_traj_files();
   }
 
@@ -803,6 +914,8 @@ int colvarmodule::calc()
   if (restart_out_freq && (cvm::step_relative() > 0) &&
       ((cvm::step_absolute() % restart_out_freq) == 0) ) {
 
+    profile_timer const timer(restart_profile_slot_);
+
     if (restart_out_name.size()) {
       // Write restart file, if different from main output
       error_code |= write_restart_file(restart_out_name);
@@ -833,6 +946,7 @@ int colvarmodule::calc()
     if ((*bi)->output_freq > 0) {
       if ((cvm::step_relative() > 0) &&
           ((cvm::step_absolute() % (*bi)->output_freq) == 0) ) {
+        profile_timer const timer((*bi)->output_profile_slot);
         error_code |= (*bi)->write_output_files();
       }
     }
@@ -848,6 +962,78 @@ int colvarmodule::calc()
 }
 
 
+int colvarmodule::calc_async_start()
+{
+  if (calc_async_pending_) {
+    return cvm::error("Error: calc_async_start() called before the previous "
+                      "calculation was joined by calc_async_wait().\n",
+                      COLVARS_BUG_ERROR);
+  }
+  calc_async_pending_ = true;
+  calc_async_error_code_ = COLVARS_OK;
+#if (__cplusplus >= 201103L)
+  // The proxy's log() and error() are not called from the thread
+  calc_async_buffer_messages_ = true;
+  try {
+    calc_async_thread_ = reinterpret_cast<void *>(
+      new std::thread(&colvarmodule::calc_async_run, this));
+    return COLVARS_OK;
+  } catch (std::system_error const &) {
+    // Threads are not available at run time: compute synchronously
+    calc_async_thread_ = NULL;
+    calc_async_buffer_messages_ = false;
+  }
+#endif
+  calc_async_run();
+  return COLVARS_OK;
+}
+
+
+void colvarmodule::calc_async_run()
+{
+  calc_async_error_code_ = calc();
+}
+
+
+int colvarmodule::calc_async_wait()
+{
+  if (!calc_async_pending_) {
+    return COLVARS_OK;
+  }
+#if (__cplusplus >= 201103L)
+  if (calc_async_thread_ != NULL) {
+    std::thread *t = reinterpret_cast<std::thread *>(calc_async_thread_);
+    t->join();
+    delete t;
+    calc_async_thread_ = NULL;
+  }
+#endif
+  calc_async_pending_ = false;
+  calc_async_buffer_messages_ = false;
+  calc_async_replay_messages();
+  return calc_async_error_code_;
+}
+
+
+void colvarmodule::calc_async_replay_messages()
+{
+  for (size_t i = 0; i < calc_async_messages_.size(); i++) {
+    if (calc_async_messages_[i].first) {
+      proxy->error(calc_async_messages_[i].second);
+    } else {
+      proxy->log(calc_async_messages_[i].second);
+    }
+  }
+  calc_async_messages_.clear();
+}
+
+
+bool colvarmodule::calc_async_pending() const
+{
+  return calc_async_pending_;
+}
+
+
 int colvarmodule::calc_colvars()
 {
   if (cvm::debug())
@@ -988,6 +1174,7 @@ int colvarmodule::calc_biases()
 
     cvm::increase_depth();
     for (bi = biases_active()->begin(); bi != biases_active()->end(); bi++) {
+      profile_timer const timer((*bi)->update_profile_slot);
       error_code |= (*bi)->update();
       if (cvm::get_error()) {
         return error_code;
@@ -1099,10 +1286,8 @@ int colvarmodule::write_restart_file(std::string const &out_name)
     return cvm::error("Error: in writing restart file.\n", COLVARS_FILE_ERROR);
   }
   proxy->close_output_stream(out_name);
-  if (cv_traj_os != NULL) {
-    // Take the opportunity to flush colvars.traj
-    proxy->flush_output_stream(cv_traj_os);
-  }
+  // Take the opportunity to flush colvars.traj
+  flush_traj_buffer();
   return (cvm::get_error() ? COLVARS_ERROR : COLVARS_OK);
 }
 
@@ -1133,23 +1318,41 @@ int colvarmodule::write_traj_files()
     }
   }
 
+  // If requested, hold the frames in memory until the next flush
+  std::ostream &os = cv_traj_flush_freq ?
+    static_cast<std::ostream &>(cv_traj_buffer) : *cv_traj_os;
+
   // write labels in the traj file every 1000 lines and at first timestep
+  // (the binary header is only written again when the columns change)
   if ((cvm::step_absolute() % (cv_traj_freq * 1000)) == 0 ||
       cvm::step_relative() == 0 ||
       cv_traj_write_labels) {
-    write_traj_label(*cv_traj_os);
+    if (cv_traj_binary) {
+      write_traj_binary_label(os);
+    } else {
+      write_traj_label(os);
+    }
   }
   cv_traj_write_labels = false;
 
   if ((cvm::step_absolute() % cv_traj_freq) == 0) {
-    write_traj(*cv_traj_os);
+    if (cv_traj_binary) {
+      write_traj_binary(os);
+    } else {
+      write_traj(os);
+    }
+  }
+
+  if (cv_traj_flush_freq &&
+      ((cvm::step_absolute() % cv_traj_flush_freq) == 0)) {
+    flush_traj_buffer();
   }
 
   if (restart_out_freq && (cv_traj_os != NULL) &&
       ((cvm::step_absolute() % restart_out_freq) == 0)) {
     cvm::log("Synchronizing (emptying the buffer of) trajectory file \""+
              cv_traj_name+"\".\n");
-    proxy->flush_output_stream(cv_traj_os);
+    flush_traj_buffer();
   }
 
   return (cvm::get_error() ? COLVARS_ERROR : COLVARS_OK);
@@ -1224,7 +1427,8 @@ int colvarmodule::setup()
 
 colvarmodule::~colvarmodule()
 {
-  if ((proxy->smp_thread_id() == COLVARS_NOT_IMPLEMENTED) ||
+  if ((proxy->smp_thread_id() < 0) || // Not using threads
+      (proxy->smp_thread_id() == COLVARS_NOT_IMPLEMENTED) ||
       (proxy->smp_thread_id() == 0)) {
 
     reset();
@@ -1245,6 +1449,9 @@ colvarmodule::~colvarmodule()
     delete usage_;
     usage_ = NULL;
 
+    delete profiler_;
+    profiler_ = NULL;
+
     // The proxy object will be deallocated last (if at all)
     proxy = NULL;
   }
@@ -1253,6 +1460,9 @@ colvarmodule::~colvarmodule()
 
 int colvarmodule::reset()
 {
+  // Objects cannot be deleted while they are being computed
+  calc_async_wait();
+
   cvm::log("Resetting the Collective Variables module.\n");
 
   parse->clear();
@@ -1279,6 +1489,10 @@ int colvarmodule::reset()
 
   reset_index_groups();
 
+  // Records refer to the objects just deleted
+  reset_profile();
+
+  flush_traj_buffer();
   proxy->flush_output_streams();
   proxy->reset();
 
@@ -1579,6 +1793,7 @@ int colvarmodule::write_output_files()
     error_code |= (*bi)->write_state_to_replicas();
   }
   cvm::decrease_depth();
+  error_code |= flush_traj_buffer();
   return (cvm::get_error() ? COLVARS_ERROR : COLVARS_OK);
 }
 
@@ -1592,6 +1807,18 @@ int colvarmodule::read_traj(char const *traj_filename,
   // NB: this function is not currently used, but when it will it should
   // retain the ability for direct file-based access (in case traj files
   // exceed memory)
+  {
+    // Binary trajectories begin with a signature
+    std::ifstream traj_binary_is(traj_filename, std::ios::binary);
+    std::string const signature(traj_binary_signature());
+    std::string first(signature.size(), ' ');
+    traj_binary_is.read(&(first[0]), signature.size());
+    if (traj_binary_is && (first == signature)) {
+      traj_binary_is.seekg(0, std::ios::beg);
+      return read_traj_binary(traj_binary_is, traj_read_begin, traj_read_end);
+    }
+  }
+
   std::ifstream traj_is(traj_filename);
 
   while (true) {
@@ -1699,14 +1926,19 @@ int colvarmodule::open_traj_file(std::string const &file_name)
     return COLVARS_OK;
   }
 
+  std::ios_base::openmode const format_mode =
+    cv_traj_binary ? std::ios::binary : std::ios_base::openmode(0);
+
   // (re)open trajectory file
   if (cv_traj_append) {
     cvm::log("Appending to trajectory file \""+file_name+"\".\n");
-    cv_traj_os = (cvm::proxy)->output_stream(file_name, std::ios::app);
+    cv_traj_os = (cvm::proxy)->output_stream(file_name,
+                                             std::ios::app | format_mode);
   } else {
     cvm::log("Opening trajectory file \""+file_name+"\".\n");
     proxy->backup_file(file_name.c_str());
-    cv_traj_os = (cvm::proxy)->output_stream(file_name);
+    cv_traj_os = (cvm::proxy)->output_stream(file_name,
+                                             std::ios::out | format_mode);
   }
 
   if (cv_traj_os == NULL) {
@@ -1714,6 +1946,9 @@ int colvarmodule::open_traj_file(std::string const &file_name)
                COLVARS_FILE_ERROR);
   }
 
+  // A new or appended file needs its own header
+  cv_traj_binary_header.clear();
+
   return cvm::get_error();
 }
 
@@ -1721,6 +1956,7 @@ int colvarmodule::open_traj_file(std::string const &file_name)
 int colvarmodule::close_traj_file()
 {
   if (cv_traj_os != NULL) {
+    flush_traj_buffer();
     cvm::log("Closing trajectory file \""+cv_traj_name+"\".\n");
     proxy->close_output_stream(cv_traj_name);
     cv_traj_os = NULL;
@@ -1758,6 +1994,219 @@ std::ostream & colvarmodule::write_traj_label(std::ostream &os)
 }
 
 
+char const *colvarmodule::traj_binary_signature()
+{
+  return "CVTRAJB2";
+}
+
+
+char const *colvarmodule::traj_binary_frame_tag()
+{
+  return "CVTRAJFR";
+}
+
+
+namespace {
+
+  /// \brief Write the tag and length of a record of the binary trajectory
+  /// (length in bytes for headers, in values for frames)
+  void write_traj_binary_record(std::ostream &os, char const *tag, int length)
+  {
+    os.write(tag, std::strlen(tag));
+    os.write(reinterpret_cast<char const *>(&length), sizeof(int));
+  }
+}
+
+
+std::ostream & colvarmodule::write_traj_binary_column(std::ostream &os,
+                                                      std::string const &label,
+                                                      colvarvalue const &x)
+{
+  std::string const keyword(colvarvalue::type_keyword(x.type()));
+  os << label << " " << (keyword.size() ? keyword : std::string("vector"))
+     << " " << x.size() << "\n";
+  return os;
+}
+
+
+void colvarmodule::append_traj_binary(std::vector<real> &frame,
+                                      colvarvalue const &x)
+{
+  for (size_t i = 0; i < x.size(); i++) {
+    frame.push_back(x[i]);
+  }
+}
+
+
+std::ostream & colvarmodule::write_traj_binary_label(std::ostream &os)
+{
+  std::ostringstream header;
+  header << "step integer 1\n";
+  for (std::vector<colvar *>::iterator cvi = colvars.begin();
+       cvi != colvars.end();
+       cvi++) {
+    (*cvi)->write_traj_binary_label(header);
+  }
+  for (std::vector<colvarbias *>::iterator bi = biases.begin();
+       bi != biases.end();
+       bi++) {
+    (*bi)->write_traj_binary_label(header);
+  }
+
+  if (header.str() != cv_traj_binary_header) {
+    cv_traj_binary_header = header.str();
+    write_traj_binary_record(os, traj_binary_signature(),
+                             static_cast<int>(cv_traj_binary_header.size()));
+    os << cv_traj_binary_header;
+  }
+  return os;
+}
+
+
+std::ostream & colvarmodule::write_traj_binary(std::ostream &os)
+{
+  cv_traj_frame.clear();
+  cv_traj_frame.push_back(real(it));
+  for (std::vector<colvar *>::iterator cvi = colvars.begin();
+       cvi != colvars.end();
+       cvi++) {
+    (*cvi)->write_traj_binary(cv_traj_frame);
+  }
+  for (std::vector<colvarbias *>::iterator bi = biases.begin();
+       bi != biases.end();
+       bi++) {
+    (*bi)->write_traj_binary(cv_traj_frame);
+  }
+  write_traj_binary_record(os, traj_binary_frame_tag(),
+                           static_cast<int>(cv_traj_frame.size()));
+  os.write(reinterpret_cast<char const *>(&(cv_traj_frame[0])),
+           cv_traj_frame.size() * sizeof(real));
+  return os;
+}
+
+
+int colvarmodule::flush_traj_buffer()
+{
+  if (cv_traj_os == NULL) {
+    return COLVARS_OK;
+  }
+  // Look up the file by name, because the proxy may have closed it already
+  std::ostream *os = proxy->get_output_stream(cv_traj_name);
+  if (os == NULL) {
+    cv_traj_buffer.str("");
+    return COLVARS_OK;
+  }
+  if (cv_traj_buffer.tellp() > 0) {
+    *os << cv_traj_buffer.str();
+    cv_traj_buffer.str("");
+  }
+  return proxy->flush_output_stream(os);
+}
+
+
+int colvarmodule::read_traj_binary(std::istream &is,
+                                   long traj_read_begin,
+                                   long traj_read_end)
+{
+  std::string const signature(traj_binary_signature());
+  std::string const frame_tag(traj_binary_frame_tag());
+  std::map<std::string, size_t> columns;
+  std::vector<real> frame;
+
+  while (true) {
+
+    // Each record begins with a tag and a length
+    std::string tag(signature.size(), ' ');
+    int length = 0;
+    if (!is.read(&(tag[0]), tag.size())) {
+      cvm::log("End of binary trajectory file reached.\n");
+      return COLVARS_OK;
+    }
+    if (!is.read(reinterpret_cast<char *>(&length), sizeof(int)) ||
+        (length < 0)) {
+      return cvm::error("Error: truncated record in binary trajectory.\n",
+                        COLVARS_FILE_ERROR);
+    }
+
+    if (tag == signature) {
+      // A header precedes the first frame, and each change of columns
+      std::string header(length, ' ');
+      if ((length > 0) && !is.read(&(header[0]), length)) {
+        return cvm::error("Error: truncated header in binary trajectory.\n",
+                          COLVARS_FILE_ERROR);
+      }
+      std::istringstream header_is(header);
+      std::string line;
+      columns.clear();
+      size_t num_values = 0;
+      while (std::getline(header_is, line)) {
+        std::istringstream line_is(line);
+        std::string label, type;
+        size_t n = 0;
+        if (!(line_is >> label >> type >> n)) {
+          return cvm::error("Error: invalid column \""+line+
+                            "\" in binary trajectory.\n", COLVARS_FILE_ERROR);
+        }
+        columns[label] = num_values;
+        num_values += n;
+      }
+      frame.resize(num_values);
+      if (columns.count("step") == 0 || columns["step"] != 0) {
+        return cvm::error("Error: binary trajectory does not begin with "
+                          "the step number.\n", COLVARS_FILE_ERROR);
+      }
+      continue;
+    }
+
+    if (tag != frame_tag) {
+      return cvm::error("Error: unknown record \""+tag+
+                        "\" in binary trajectory.\n", COLVARS_FILE_ERROR);
+    }
+
+    if (frame.size() == 0) {
+      return cvm::error("Error: missing header in binary trajectory.\n",
+                        COLVARS_FILE_ERROR);
+    }
+
+    if (static_cast<size_t>(length) != frame.size()) {
+      return cvm::error("Error: frame of "+cvm::to_str(length)+
+                        " values in binary trajectory, expected "+
+                        cvm::to_str(frame.size())+".\n", COLVARS_FILE_ERROR);
+    }
+
+    if (!is.read(reinterpret_cast<char *>(&(frame[0])),
+                 frame.size() * sizeof(real))) {
+      // e.g. the simulation was interrupted while writing this frame
+      cvm::log("Warning: ignoring the incomplete last frame of the binary "
+               "trajectory.\n");
+      return COLVARS_OK;
+    }
+
+    it = static_cast<step_number>(frame[0]);
+
+    if (it < traj_read_begin) {
+      continue;
+    }
+
+    if ((traj_read_end > traj_read_begin) && (it > traj_read_end)) {
+      return cvm::error("Reached the end of the trajectory, "
+                        "read_end = "+cvm::to_str(traj_read_end)+"\n",
+                        COLVARS_FILE_ERROR);
+    }
+
+    for (std::vector<colvar *>::iterator cvi = colvars.begin();
+         cvi != colvars.end();
+         cvi++) {
+      if ((*cvi)->read_traj_binary(columns, frame) != COLVARS_OK) {
+        return cvm::get_error();
+      }
+    }
+  }
+
+  return COLVARS_OK;
+}
+
+
 std::ostream & colvarmodule::write_traj(std::ostream &os)
 {
   os.setf(std::ios::scientific, std::ios::floatfield);
@@ -1791,12 +2240,17 @@ void colvarmodule::log(std::string const &message, int min_log_level)
 {
   if (cvm::log_level() < min_log_level) return;
   // allow logging when the module is not fully initialized
-  size_t const d = (cvm::main() != NULL) ? depth() : 0;
-  if (d > 0) {
-    proxy->log((std::string(2*d, ' '))+message);
-  } else {
-    proxy->log(message);
+  colvarmodule *cv = cvm::main();
+  size_t const d = (cv != NULL) ? depth() : 0;
+  std::string const indented_message = (d > 0) ?
+    (std::string(2*d, ' '))+message : message;
+  if ((cv != NULL) && cv->calc_async_buffer_messages_) {
+    proxy->smp_lock();
+    cv->calc_async_messages_.push_back(std::make_pair(false, indented_message));
+    proxy->smp_unlock();
+    return;
   }
+  proxy->log(indented_message);
 }
 
 
@@ -1864,6 +2318,13 @@ void colvarmodule::clear_error()
 int colvarmodule::error(std::string const &message, int code)
 {
   set_error_bits(code);
+  colvarmodule *cv = cvm::main();
+  if ((cv != NULL) && cv->calc_async_buffer_messages_) {
+    proxy->smp_lock();
+    cv->calc_async_messages_.push_back(std::make_pair(true, message));
+    proxy->smp_unlock();
+    return get_error();
+  }
   proxy->error(message);
   return get_error();
 }
@@ -2140,6 +2601,15 @@ cvm::rvector cvm::position_distance(cvm::atom_pos const &pos1,
 }
 
 
+void cvm::position_distances(cvm::atom_pos const &pos1,
+                             cvm::atom_pos const *pos2,
+                             size_t n,
+                             cvm::rvector *dist)
+{
+  proxy->position_distances(pos1, pos2, n, dist);
+}
+
+
 cvm::real cvm::rand_gaussian(void)
 {
   return proxy->rand_gaussian();
@@ -2404,6 +2874,142 @@ std::string colvarmodule::usage::report(int flag)
 }
 
 
+int colvarmodule::set_profiling(bool flag)
+{
+  if (flag && !profiling_) {
+    cvm::log("Measuring the time spent by each colvar component, bias and "
+             "output operation.\n");
+  }
+  profiling_ = flag;
+  return COLVARS_OK;
+}
+
+
+int colvarmodule::profile_slot(std::string const &name,
+                               char const *operation)
+{
+  int const num_threads = proxy ? proxy->smp_num_threads() : 1;
+  return profiler_->add_slot(name + ": " + operation,
+                             (num_threads > 1) ? size_t(num_threads) : 1);
+}
+
+
+void colvarmodule::add_profile_time(int slot, double t)
+{
+  if (slot < 0) return;
+  int const thread = proxy->smp_thread_id();
+  if (thread < 0) {
+    // No threads: use the first row
+    profiler_->add_time(slot, 0, t);
+  } else if (size_t(thread) < profiler_->num_threads()) {
+    // Each thread only updates its own row
+    profiler_->add_time(slot, thread, t);
+  } else {
+    // Threads beyond those counted at setup share the last row
+    proxy->smp_lock();
+    profiler_->add_time(slot, profiler_->num_threads(), t);
+    proxy->smp_unlock();
+  }
+}
+
+
+std::string colvarmodule::profile_report() const
+{
+  return profiler_->report(calc_profile_slot_);
+}
+
+
+int colvarmodule::reset_profile()
+{
+  profiler_->clear();
+  return COLVARS_OK;
+}
+
+
+double colvarmodule::wall_time()
+{
+#if (__cplusplus >= 201103L)
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+  // Processor time is the best portable approximation in C++98
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+
+int colvarmodule::profiler::add_slot(std::string const &label,
+                                     size_t num_threads)
+{
+  std::map<std::string, int>::const_iterator const it = slots_.find(label);
+  if (it != slots_.end()) {
+    return it->second;
+  }
+  int const slot = int(labels_.size());
+  labels_.push_back(label);
+  slots_[label] = slot;
+  if (counts_.size() < num_threads + 1) {
+    counts_.resize(num_threads + 1);
+    times_.resize(num_threads + 1);
+  }
+  for (size_t row = 0; row < counts_.size(); row++) {
+    counts_[row].resize(labels_.size(), 0);
+    times_[row].resize(labels_.size(), 0.0);
+  }
+  return slot;
+}
+
+
+std::string colvarmodule::profiler::report(int total_slot) const
+{
+  std::vector<record> sorted;
+  double total = 0.0;
+  for (size_t slot = 0; slot < labels_.size(); slot++) {
+    record r;
+    r.label = labels_[slot];
+    r.count = 0;
+    r.time = 0.0;
+    for (size_t row = 0; row < counts_.size(); row++) {
+      r.count += counts_[row][slot];
+      r.time += times_[row][slot];
+    }
+    if (int(slot) == total_slot) {
+      total = r.time;
+    }
+    if (r.count > 0) {
+      sorted.push_back(r);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(), compare_time);
+
+  std::ostringstream os;
+  os << "# " << std::setw(10) << "calls" << " "
+     << std::setw(14) << "total_time(s)" << " "
+     << std::setw(14) << "avg_time(us)" << " "
+     << std::setw(8) << "percent" << "  item\n";
+  for (size_t i = 0; i < sorted.size(); i++) {
+    record const &r = sorted[i];
+    os << "  " << std::setw(10) << r.count << " "
+       << std::setw(14) << std::setprecision(6) << r.time << " "
+       << std::setw(14) << std::setprecision(6)
+       << (r.count ? 1.0e6 * r.time / cvm::real(r.count) : 0.0) << " "
+       << std::setw(8) << std::setprecision(4)
+       << (total > 0.0 ? 100.0 * r.time / total : 0.0) << "  "
+       << r.label << "\n";
+  }
+  return os.str();
+}
+
+
+void colvarmodule::profiler::clear()
+{
+  for (size_t row = 0; row < counts_.size(); row++) {
+    counts_[row].assign(labels_.size(), 0);
+    times_[row].assign(labels_.size(), 0.0);
+  }
+}
+
+
 // shared pointer to the proxy object
 colvarproxy *colvarmodule::proxy = NULL;
 
@@ -2417,6 +3023,7 @@ size_t    colvarmodule::restart_out_freq = 0;
 size_t    colvarmodule::cv_traj_freq = 0;
 bool      colvarmodule::use_scripted_forces = false;
 bool      colvarmodule::scripting_after_biases = true;
+bool      colvarmodule::profiling_ = false;
 
 // i/o constants
 size_t const colvarmodule::it_width = 12;
@@ -191,6 +191,7 @@ public:
   class quaternion;
   class rotation;
   class usage;
+  class profiler;
 
   /// Residue identifier
   typedef int residue_id;
@@ -321,6 +322,28 @@ private:
   /// Pointer to a map counting how many biases of each type were used
   void *num_biases_types_used_;
 
+  /// Pointer to the thread running calc() in the background (C++11 only)
+  void *calc_async_thread_;
+
+  /// Whether calc_async_start() was called, and calc_async_wait() not yet
+  bool calc_async_pending_;
+
+  /// Error code of the calculation started by calc_async_start()
+  int calc_async_error_code_;
+
+  /// \brief If true, log() and error() store their messages instead of
+  /// passing them to the proxy (set while the background thread runs)
+  bool calc_async_buffer_messages_;
+
+  /// Messages stored during the background calculation (true for errors)
+  std::vector<std::pair<bool, std::string> > calc_async_messages_;
+
+  /// Body of the background calculation
+  void calc_async_run();
+
+  /// Pass the stored messages to the proxy, in their original order
+  void calc_async_replay_messages();
+
   /// Array of active collective variable biases
   std::vector<colvarbias *> biases_active_;
 
@@ -472,6 +495,13 @@ public:
   std::ostream & write_traj(std::ostream &os);
   /// Write explanatory labels in the trajectory file
   std::ostream & write_traj_label(std::ostream &os);
+  /// \brief Write the header of the binary trajectory file, if the list of
+  /// columns changed since it was last written
+  std::ostream & write_traj_binary_label(std::ostream &os);
+  /// Write one frame in the binary trajectory file
+  std::ostream & write_traj_binary(std::ostream &os);
+  /// Write the buffered trajectory frames to the file, and flush it
+  int flush_traj_buffer();
 
   /// Write all trajectory files
   int write_traj_files();
@@ -508,6 +538,21 @@ public:
   /// Main worker function
   int calc();
 
+  /// \brief Start calc() in the background, on a separate thread when the
+  /// build supports it (otherwise, calc() is run before returning); until
+  /// calc_async_wait() is called, the proxy's atomic data must not be
+  /// modified and no other function of the module may be called, and the
+  /// proxy must accept callbacks (e.g. file output) from that thread;
+  /// messages and errors are passed to the proxy by calc_async_wait()
+  int calc_async_start();
+
+  /// \brief Wait for the calculation started by calc_async_start(), and
+  /// return its error code; the forces are then available in the proxy
+  int calc_async_wait();
+
+  /// Whether a calculation started by calc_async_start() is not joined yet
+  bool calc_async_pending() const;
+
   /// Calculate collective variables
   int calc_colvars();
 
@@ -529,6 +574,23 @@ public:
                 long        traj_read_begin,
                 long        traj_read_end);
 
+  /// \brief Tag of the header records of a binary trajectory file (also
+  /// its signature, because the file begins with a header)
+  static char const *traj_binary_signature();
+
+  /// Tag of the frame records of a binary trajectory file
+  static char const *traj_binary_frame_tag();
+
+  /// \brief Describe one column of the binary trajectory, holding the
+  /// components of x
+  static std::ostream & write_traj_binary_column(std::ostream &os,
+                                                 std::string const &label,
+                                                 colvarvalue const &x);
+
+  /// Append the components of x to a frame of the binary trajectory
+  static void append_traj_binary(std::vector<real> &frame,
+                                 colvarvalue const &x);
+
   /// Convert to string for output purposes
   static std::string to_str(char const *s);
 
@@ -650,6 +712,52 @@ public:
   /// Report usage of the Colvars features
   std::string feature_report(int flag = 0);
 
+  /// Whether the time spent by each object is being measured
+  static inline bool profiling()
+  {
+    return profiling_;
+  }
+
+  /// Enable or disable the measurement of the time spent by each object
+  int set_profiling(bool flag);
+
+  /// \brief Return the slot of the profile for the given operation of the
+  /// object identified by name, adding it if needed; to be called when the
+  /// object is set up, outside of parallel regions
+  int profile_slot(std::string const &name, char const *operation);
+
+  /// \brief Add the time t (in seconds) to the given slot of the profile;
+  /// each thread accumulates its own times
+  void add_profile_time(int slot, double t);
+
+  /// Report of the time spent by each object and operation, most costly first
+  std::string profile_report() const;
+
+  /// Clear the timings collected so far
+  int reset_profile();
+
+  /// Wall-clock time in seconds since an arbitrary origin
+  static double wall_time();
+
+  /// \brief Measure the wall-clock time between construction and
+  /// destruction, and add it to the given slot of the profile (nothing is
+  /// done unless profiling is enabled)
+  class profile_timer {
+  public:
+    inline profile_timer(int slot)
+      : slot_(slot), start_(profiling_ ? wall_time() : -1.0)
+    {}
+    inline ~profile_timer()
+    {
+      if (start_ >= 0.0) {
+        main()->add_profile_time(slot_, wall_time() - start_);
+      }
+    }
+  private:
+    int const slot_;
+    double const start_;
+  };
+
   /// Print a message to the main log
   /// \param message Message to print
   /// \param min_log_level Only print if cvm::log_level() >= min_log_level
@@ -706,6 +814,13 @@ public:
   static rvector position_distance(atom_pos const &pos1,
                                    atom_pos const &pos2);
 
+  /// \brief Get the distances between pos1 and each of the n positions in
+  /// pos2 with pbcs handled correctly (batched version of position_distance)
+  static void position_distances(atom_pos const &pos1,
+                                 atom_pos const *pos2,
+                                 size_t n,
+                                 rvector *dist);
+
   /// \brief Names of .ndx files that have been loaded
   std::vector<std::string> index_file_names;
 
@@ -779,6 +894,27 @@ protected:
   /// Write labels at the next iteration
   bool cv_traj_write_labels;
 
+  /// Write the trajectory file in binary format (colvarsTrajFormat)
+  bool cv_traj_binary;
+
+  /// \brief If non-zero, keep the trajectory frames in memory and write them
+  /// to the file at this frequency (colvarsTrajFlushFrequency)
+  size_t cv_traj_flush_freq;
+
+  /// Trajectory frames not yet written to the file
+  std::ostringstream cv_traj_buffer;
+
+  /// Values of the current frame of the binary trajectory
+  std::vector<real> cv_traj_frame;
+
+  /// Most recent header written to the binary trajectory file
+  std::string cv_traj_binary_header;
+
+  /// Read a trajectory file written in binary format
+  int read_traj_binary(std::istream &is,
+                       long traj_read_begin,
+                       long traj_read_end);
+
   /// Version of the most recent state file read
   std::string restart_version_str;
 
@@ -797,6 +933,15 @@ protected:
   /// Track usage of Colvars features
   usage *usage_;
 
+  /// Whether timings are being collected
+  static bool profiling_;
+
+  /// Timings of each object and operation
+  profiler *profiler_;
+
+  /// Slots of the profile for the operations of the module itself
+  int calc_profile_slot_, traj_profile_slot_, restart_profile_slot_;
+
 public:
 
   /// Version of the most recent state file read
@@ -8,6 +8,7 @@
 // Colvars repository at GitHub.
 
 #include <fstream>
+#include <algorithm>
 
 #if defined(_OPENMP)
 #include <omp.h>
@@ -30,6 +31,7 @@ colvarproxy_system::colvarproxy_system()
   indirect_lambda_biasing_force = 0.0;
   cached_alch_lambda_changed = false;
   cached_alch_lambda = -1.0;
+  batched_cell_distances = false;
   reset_pbc_lattice();
 }
 
@@ -170,6 +172,78 @@ cvm::rvector colvarproxy_system::position_distance(cvm::atom_pos const &pos1,
 }
 
 
+void colvarproxy_system::position_distances(cvm::atom_pos const &pos1,
+                                            cvm::atom_pos const *pos2,
+                                            size_t n,
+                                            cvm::rvector *dist) const
+{
+  // Each branch below is a simple loop over independent elements, which the
+  // compiler can vectorize; floor() is used directly instead of
+  // round_to_integer() to avoid conversions to int
+  size_t i;
+
+  if (!batched_cell_distances) {
+    // The engine's own minimum-image convention may differ from the cell math
+    for (i = 0; i < n; i++) {
+      dist[i] = position_distance(pos1, pos2[i]);
+    }
+    return;
+  }
+
+  switch (boundaries_type) {
+
+  case boundaries_non_periodic:
+    for (i = 0; i < n; i++) {
+      dist[i].x = pos2[i].x - pos1.x;
+      dist[i].y = pos2[i].y - pos1.y;
+      dist[i].z = pos2[i].z - pos1.z;
+    }
+    break;
+
+  case boundaries_pbc_ortho: {
+    // Only the diagonal elements of the cell are non-zero
+    cvm::real const a = unit_cell_x.x, b = unit_cell_y.y, c = unit_cell_z.z;
+    cvm::real const inv_a = reciprocal_cell_x.x, inv_b = reciprocal_cell_y.y,
+      inv_c = reciprocal_cell_z.z;
+    for (i = 0; i < n; i++) {
+      cvm::real const dx = pos2[i].x - pos1.x;
+      cvm::real const dy = pos2[i].y - pos1.y;
+      cvm::real const dz = pos2[i].z - pos1.z;
+      dist[i].x = dx - a * cvm::floor(inv_a*dx + 0.5);
+      dist[i].y = dy - b * cvm::floor(inv_b*dy + 0.5);
+      dist[i].z = dz - c * cvm::floor(inv_c*dz + 0.5);
+    }
+    break;
+  }
+
+  case boundaries_pbc_triclinic: {
+    cvm::rvector const &ax = unit_cell_x, &ay = unit_cell_y, &az = unit_cell_z;
+    cvm::rvector const &rx = reciprocal_cell_x, &ry = reciprocal_cell_y,
+      &rz = reciprocal_cell_z;
+    for (i = 0; i < n; i++) {
+      cvm::real const dx = pos2[i].x - pos1.x;
+      cvm::real const dy = pos2[i].y - pos1.y;
+      cvm::real const dz = pos2[i].z - pos1.z;
+      cvm::real const x_shift = cvm::floor(rx.x*dx + rx.y*dy + rx.z*dz + 0.5);
+      cvm::real const y_shift = cvm::floor(ry.x*dx + ry.y*dy + ry.z*dz + 0.5);
+      cvm::real const z_shift = cvm::floor(rz.x*dx + rz.y*dy + rz.z*dz + 0.5);
+      dist[i].x = dx - (x_shift*ax.x + y_shift*ay.x + z_shift*az.x);
+      dist[i].y = dy - (x_shift*ax.y + y_shift*ay.y + z_shift*az.y);
+      dist[i].z = dz - (x_shift*ax.z + y_shift*ay.z + z_shift*az.z);
+    }
+    break;
+  }
+
+  default:
+    // Unsupported boundaries: position_distance() raises the error
+    for (i = 0; i < n; i++) {
+      dist[i] = position_distance(pos1, pos2[i]);
+    }
+    break;
+  }
+}
+
+
 int colvarproxy_system::get_molid(int &)
 {
   cvm::error("Error: only VMD allows the use of multiple \"molecules\", "
@@ -243,6 +317,8 @@ int colvarproxy_atoms::reset()
   atoms_positions.clear();
   atoms_total_forces.clear();
   atoms_new_colvar_forces.clear();
+  atoms_applied_force_flags.clear();
+  atoms_applied_force_indices.clear();
   return COLVARS_OK;
 }
 
@@ -256,10 +332,55 @@ int colvarproxy_atoms::add_atom_slot(int atom_id)
   atoms_positions.push_back(cvm::rvector(0.0, 0.0, 0.0));
   atoms_total_forces.push_back(cvm::rvector(0.0, 0.0, 0.0));
   atoms_new_colvar_forces.push_back(cvm::rvector(0.0, 0.0, 0.0));
+  atoms_applied_force_flags.push_back(0);
   return (atoms_ids.size() - 1);
 }
 
 
+void colvarproxy_atoms::get_atoms_positions(std::vector<int> const &indices,
+                                            cvm::atom_pos *pos) const
+{
+  size_t const n = indices.size();
+  for (size_t i = 0; i < n; i++) {
+    pos[i] = atoms_positions[indices[i]];
+  }
+}
+
+
+void colvarproxy_atoms::apply_atoms_forces(std::vector<int> const &indices,
+                                           cvm::rvector const *new_forces)
+{
+  size_t const n = indices.size();
+  for (size_t i = 0; i < n; i++) {
+    atoms_new_colvar_forces[indices[i]] += new_forces[i];
+    flag_atom_applied_force(indices[i], new_forces[i]);
+  }
+}
+
+
+std::vector<cvm::rvector> *colvarproxy_atoms::modify_atom_applied_forces()
+{
+  for (size_t i = 0; i < atoms_applied_force_flags.size(); i++) {
+    if (!atoms_applied_force_flags[i]) {
+      atoms_applied_force_flags[i] = 1;
+      atoms_applied_force_indices.push_back(i);
+    }
+  }
+  return &atoms_new_colvar_forces;
+}
+
+
+void colvarproxy_atoms::reset_atoms_applied_forces()
+{
+  for (size_t n = 0; n < atoms_applied_force_indices.size(); n++) {
+    int const i = atoms_applied_force_indices[n];
+    atoms_new_colvar_forces[i].reset();
+    atoms_applied_force_flags[i] = 0;
+  }
+  atoms_applied_force_indices.clear();
+}
+
+
 int colvarproxy_atoms::init_atom(int /* atom_number */)
 {
   return COLVARS_NOT_IMPLEMENTED;
@@ -376,6 +497,13 @@ int colvarproxy_atom_groups::reset()
   atom_groups_coms.clear();
   atom_groups_total_forces.clear();
   atom_groups_new_colvar_forces.clear();
+  atom_groups_reductions_groups.clear();
+  atom_groups_reductions_types.clear();
+  atom_groups_reductions_weights.clear();
+  atom_groups_reductions_params.clear();
+  atom_groups_reductions_offsets.clear();
+  atom_groups_reductions_values.clear();
+  atom_groups_reductions_coeffs.clear();
   return COLVARS_OK;
 }
 
@@ -399,6 +527,161 @@ int colvarproxy_atom_groups::scalable_group_coms()
 }
 
 
+int colvarproxy_atom_groups::scalable_group_reductions()
+{
+  return COLVARS_NOT_IMPLEMENTED;
+}
+
+
+size_t colvarproxy_atom_groups::atom_group_reduction_size(int type)
+{
+  switch (type) {
+  case reduction_sum_positions:
+    return 3;
+  case reduction_sum_positions_outer:
+    return 6;
+  }
+  return 0;
+}
+
+
+int colvarproxy_atom_groups::request_atom_group_reduction(int group_index,
+                                                          int type,
+                                                          int weight)
+{
+  if (scalable_group_reductions() != COLVARS_OK) {
+    return cvm::error("Error: reductions over atom groups are not "
+                      "supported by this build.\n", COLVARS_NOT_IMPLEMENTED);
+  }
+  if ((group_index < 0) || (((size_t) group_index) >= atom_groups_ids.size())) {
+    return cvm::error("Error: requesting a reduction over an atom group "
+                      "that was not previously requested.\n",
+                      COLVARS_BUG_ERROR);
+  }
+  size_t const n_values = atom_group_reduction_size(type);
+  if ((n_values == 0) || (weight < reduction_weight_unit) ||
+      (weight > reduction_weight_mass)) {
+    return cvm::error("Error: invalid atom group reduction requested.\n",
+                      COLVARS_BUG_ERROR);
+  }
+
+  atom_groups_reductions_groups.push_back(group_index);
+  atom_groups_reductions_types.push_back(type);
+  atom_groups_reductions_weights.push_back(weight);
+  atom_groups_reductions_params.push_back(std::vector<cvm::real>());
+  atom_groups_reductions_offsets.push_back(atom_groups_reductions_values.size());
+  atom_groups_reductions_values.resize(atom_groups_reductions_values.size() +
+                                       n_values, 0.0);
+  atom_groups_reductions_coeffs.resize(atom_groups_reductions_values.size(),
+                                       0.0);
+  return atom_groups_reductions_groups.size() - 1;
+}
+
+
+int colvarproxy_atom_groups::set_atom_group_reduction_params(int index,
+                                                             std::vector<cvm::real> const &params)
+{
+  if ((index < 0) ||
+      (((size_t) index) >= atom_groups_reductions_params.size())) {
+    return cvm::error("Error: setting the parameters of a reduction that "
+                      "was not previously requested.\n", COLVARS_BUG_ERROR);
+  }
+  atom_groups_reductions_params[index] = params;
+  return COLVARS_OK;
+}
+
+
+void colvarproxy_atom_groups::apply_atom_group_reduction_force(int index,
+                                                               cvm::real const *coeffs)
+{
+  size_t const offset = atom_groups_reductions_offsets[index];
+  size_t const n =
+    atom_group_reduction_size(atom_groups_reductions_types[index]);
+  for (size_t k = 0; k < n; k++) {
+    atom_groups_reductions_coeffs[offset+k] += coeffs[k];
+  }
+}
+
+
+/// Reference point of a reduction (the origin if not set by the engine)
+static inline cvm::atom_pos reduction_center(std::vector<cvm::real> const &params)
+{
+  return (params.size() >= 3) ?
+    cvm::atom_pos(params[0], params[1], params[2]) : cvm::atom_pos(0.0);
+}
+
+
+void colvarproxy_atom_groups::compute_atom_group_reduction(int type,
+                                                           std::vector<cvm::real> const &params,
+                                                           size_t n,
+                                                           cvm::atom_pos const *pos,
+                                                           cvm::real const *weights,
+                                                           cvm::real *values)
+{
+  cvm::atom_pos const c = reduction_center(params);
+  size_t i;
+  switch (type) {
+
+  case reduction_sum_positions:
+    for (i = 0; i < n; i++) {
+      cvm::rvector const r = pos[i] - c;
+      values[0] += weights[i] * r.x;
+      values[1] += weights[i] * r.y;
+      values[2] += weights[i] * r.z;
+    }
+    break;
+
+  case reduction_sum_positions_outer:
+    for (i = 0; i < n; i++) {
+      cvm::rvector const r = pos[i] - c;
+      values[0] += weights[i] * r.x * r.x;
+      values[1] += weights[i] * r.x * r.y;
+      values[2] += weights[i] * r.x * r.z;
+      values[3] += weights[i] * r.y * r.y;
+      values[4] += weights[i] * r.y * r.z;
+      values[5] += weights[i] * r.z * r.z;
+    }
+    break;
+  }
+}
+
+
+void colvarproxy_atom_groups::compute_atom_group_reduction_forces(int type,
+                                                                  std::vector<cvm::real> const &params,
+                                                                  cvm::real const *coeffs,
+                                                                  size_t n,
+                                                                  cvm::atom_pos const *pos,
+                                                                  cvm::real const *weights,
+                                                                  cvm::rvector *forces)
+{
+  size_t i;
+  switch (type) {
+
+  case reduction_sum_positions:
+    {
+      cvm::rvector const c(coeffs[0], coeffs[1], coeffs[2]);
+      for (i = 0; i < n; i++) {
+        forces[i] += weights[i] * c;
+      }
+    }
+    break;
+
+  case reduction_sum_positions_outer:
+    {
+      cvm::atom_pos const c = reduction_center(params);
+      // Symmetric matrix of the derivatives with respect to r_i (x) r_i
+      cvm::rmatrix const m(2.0 * coeffs[0], coeffs[1], coeffs[2],
+                           coeffs[1], 2.0 * coeffs[3], coeffs[4],
+                           coeffs[2], coeffs[4], 2.0 * coeffs[5]);
+      for (i = 0; i < n; i++) {
+        forces[i] += weights[i] * (m * (pos[i] - c));
+      }
+    }
+    break;
+  }
+}
+
+
 int colvarproxy_atom_groups::init_atom_group(std::vector<int> const & /* atoms_ids */)
 {
   cvm::error("Error: initializing a group outside of the Colvars module "
@@ -440,6 +723,7 @@ colvarproxy_smp::colvarproxy_smp()
 {
   b_smp_active = true; // May be disabled by user option
   omp_lock_state = NULL;
+  smp_items = &smp_colvars_items;
 #if defined(_OPENMP)
   if (omp_get_thread_num() == 0) {
     omp_lock_state = reinterpret_cast<void *>(new omp_lock_t);
@@ -474,23 +758,87 @@ int colvarproxy_smp::smp_enabled()
 }
 
 
+namespace {
+
+  /// \brief Compare two items of a parallel loop by decreasing cost; items
+  /// never measured go first, because their cost is unknown
+  class compare_smp_costs {
+  public:
+    compare_smp_costs(std::vector<double> const &costs) : costs_(costs) {}
+    bool operator () (size_t i, size_t j) const
+    {
+      double const ci = (costs_[i] < 0.0) ? 1.0e+30 : costs_[i];
+      double const cj = (costs_[j] < 0.0) ? 1.0e+30 : costs_[j];
+      return (ci > cj) || ((ci == cj) && (i < j));
+    }
+  private:
+    std::vector<double> const &costs_;
+  };
+}
+
+
+void colvarproxy_smp::smp_init_items(smp_loop_items &loop, size_t n)
+{
+  smp_items = &loop;
+  loop.objects.resize(n, NULL);
+  loop.indices.resize(n, -1);
+  loop.costs.resize(n, -1.0);
+}
+
+
+void colvarproxy_smp::smp_schedule_items()
+{
+  size_t const n = smp_items->costs.size();
+  smp_items_times.assign(n, 0.0);
+  smp_items_order.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    smp_items_order[i] = i;
+  }
+  // The most expensive items start first, and the cheap ones fill the gaps
+  std::sort(smp_items_order.begin(), smp_items_order.end(),
+            compare_smp_costs(smp_items->costs));
+}
+
+
+void colvarproxy_smp::smp_update_costs()
+{
+  std::vector<double> &costs = smp_items->costs;
+  for (size_t i = 0; i < costs.size(); i++) {
+    // Running average, to smooth out fluctuations between steps
+    costs[i] = (costs[i] < 0.0) ? smp_items_times[i] :
+      0.5 * (costs[i] + smp_items_times[i]);
+  }
+}
+
+
 int colvarproxy_smp::smp_colvars_loop()
 {
 #if defined(_OPENMP)
   colvarmodule *cv = cvm::main();
   colvarproxy *proxy = cv->proxy;
-#pragma omp parallel for
-  for (size_t i = 0; i < cv->variables_active_smp()->size(); i++) {
-    colvar *x = (*(cv->variables_active_smp()))[i];
-    int x_item = (*(cv->variables_active_smp_items()))[i];
+  std::vector<colvar *> const &variables = *(cv->variables_active_smp());
+  std::vector<int> const &items = *(cv->variables_active_smp_items());
+  smp_init_items(smp_colvars_items, variables.size());
+  for (size_t i = 0; i < variables.size(); i++) {
+    smp_set_item(i, variables[i], items[i]);
+  }
+  smp_schedule_items();
+#pragma omp parallel for schedule(dynamic, 1)
+  for (size_t k = 0; k < smp_items_order.size(); k++) {
+    size_t const i = smp_items_order[k];
+    colvar *x = variables[i];
+    int x_item = items[i];
     if (cvm::debug()) {
       cvm::log("["+cvm::to_str(proxy->smp_thread_id())+"/"+
                cvm::to_str(proxy->smp_num_threads())+
                "]: calc_colvars_items_smp(), i = "+cvm::to_str(i)+", cv = "+
                x->name+", cvc = "+cvm::to_str(x_item)+"\n");
     }
+    double const start = omp_get_wtime();
     x->calc_cvcs(x_item, 1);
+    smp_items_times[i] = omp_get_wtime() - start;
   }
+  smp_update_costs();
   return cvm::get_error();
 #else
   return COLVARS_NOT_IMPLEMENTED;
@@ -498,22 +846,54 @@ int colvarproxy_smp::smp_colvars_loop()
 }
 
 
+#if defined(_OPENMP)
+namespace {
+
+  /// Update a bias from within a parallel loop, and measure the time taken
+  void smp_update_bias(colvarbias *b, double &time)
+  {
+    if (cvm::debug()) {
+      cvm::log("Calculating bias \""+b->name+"\" on thread "+
+               cvm::to_str(omp_get_thread_num())+"\n");
+    }
+    double const start = omp_get_wtime();
+    {
+      cvm::profile_timer const timer(b->update_profile_slot);
+      b->update();
+    }
+    time = omp_get_wtime() - start;
+  }
+}
+#endif
+
+
 int colvarproxy_smp::smp_biases_loop()
 {
 #if defined(_OPENMP)
   colvarmodule *cv = cvm::main();
+  std::vector<colvarbias *> const &biases = *(cv->biases_active());
+  smp_init_items(smp_biases_items, biases.size());
+  for (size_t i = 0; i < biases.size(); i++) {
+    smp_set_item(i, biases[i], 0);
+  }
+  smp_schedule_items();
+  // The first bias runs on the main thread (as with a static schedule),
+  // so that it can access output files
+  smp_items_order.erase(std::remove(smp_items_order.begin(),
+                                    smp_items_order.end(), size_t(0)),
+                        smp_items_order.end());
 #pragma omp parallel
   {
-#pragma omp for
-    for (size_t i = 0; i < cv->biases_active()->size(); i++) {
-      colvarbias *b = (*(cv->biases_active()))[i];
-      if (cvm::debug()) {
-        cvm::log("Calculating bias \""+b->name+"\" on thread "+
-                 cvm::to_str(smp_thread_id())+"\n");
-      }
-      b->update();
+    if ((omp_get_thread_num() == 0) && (biases.size() > 0)) {
+      smp_update_bias(biases[0], smp_items_times[0]);
+    }
+#pragma omp for schedule(dynamic, 1)
+    for (size_t k = 0; k < smp_items_order.size(); k++) {
+      size_t const i = smp_items_order[k];
+      smp_update_bias(biases[i], smp_items_times[i]);
     }
   }
+  smp_update_costs();
   return cvm::get_error();
 #else
   return COLVARS_NOT_IMPLEMENTED;
@@ -525,22 +905,33 @@ int colvarproxy_smp::smp_biases_script_loop()
 {
 #if defined(_OPENMP)
   colvarmodule *cv = cvm::main();
+  std::vector<colvarbias *> const &biases = *(cv->biases_active());
+  smp_init_items(smp_biases_items, biases.size());
+  for (size_t i = 0; i < biases.size(); i++) {
+    smp_set_item(i, biases[i], 0);
+  }
+  smp_schedule_items();
+  // The first bias runs on the main thread (as with a static schedule),
+  // so that it can access output files
+  smp_items_order.erase(std::remove(smp_items_order.begin(),
+                                    smp_items_order.end(), size_t(0)),
+                        smp_items_order.end());
 #pragma omp parallel
   {
 #pragma omp single nowait
     {
       cv->calc_scripted_forces();
     }
-#pragma omp for
-    for (size_t i = 0; i < cv->biases_active()->size(); i++) {
-      colvarbias *b = (*(cv->biases_active()))[i];
-      if (cvm::debug()) {
-        cvm::log("Calculating bias \""+b->name+"\" on thread "+
-                 cvm::to_str(smp_thread_id())+"\n");
-      }
-      b->update();
+    if ((omp_get_thread_num() == 0) && (biases.size() > 0)) {
+      smp_update_bias(biases[0], smp_items_times[0]);
+    }
+#pragma omp for schedule(dynamic, 1)
+    for (size_t k = 0; k < smp_items_order.size(); k++) {
+      size_t const i = smp_items_order[k];
+      smp_update_bias(biases[i], smp_items_times[i]);
     }
   }
+  smp_update_costs();
   return cvm::get_error();
 #else
   return COLVARS_NOT_IMPLEMENTED;
@@ -548,6 +939,58 @@ int colvarproxy_smp::smp_biases_script_loop()
 }
 
 
+#if defined(_OPENMP)
+namespace {
+
+  /// Create one OpenMP task for each call of task(i, data), and wait for them
+  int spawn_smp_tasks(size_t num_tasks, int (*task)(size_t, void *),
+                      void *data)
+  {
+    int error_code = COLVARS_OK;
+    for (size_t i = 0; i < num_tasks; i++) {
+#pragma omp task shared(error_code) firstprivate(i)
+      {
+        int const task_error_code = (*task)(i, data);
+        if (task_error_code != COLVARS_OK) {
+#pragma omp atomic
+          error_code |= task_error_code;
+        }
+      }
+    }
+#pragma omp taskwait
+    return error_code;
+  }
+}
+#endif
+
+
+int colvarproxy_smp::smp_tasks(size_t num_tasks, int (*task)(size_t, void *),
+                               void *data)
+{
+  int error_code = COLVARS_OK;
+#if defined(_OPENMP)
+  if ((smp_enabled() == COLVARS_OK) && (num_tasks > 1)) {
+    if (omp_in_parallel()) {
+      // Threads waiting at the end of the enclosing loop will pick these up
+      return spawn_smp_tasks(num_tasks, task, data);
+    }
+#pragma omp parallel
+    {
+#pragma omp single
+      {
+        error_code = spawn_smp_tasks(num_tasks, task, data);
+      }
+    }
+    return error_code;
+  }
+#endif
+  for (size_t i = 0; i < num_tasks; i++) {
+    error_code |= (*task)(i, data);
+  }
+  return error_code;
+}
+
+
 
 
 int colvarproxy_smp::smp_thread_id()
@@ -673,6 +1116,10 @@ int colvarproxy::close_files()
     // Nothing to do on threads other than the main one
     return COLVARS_OK;
   }
+  if (colvars != NULL) {
+    // Write any trajectory frames still held in memory
+    colvars->flush_traj_buffer();
+  }
   std::list<std::string>::iterator    osni = output_stream_names.begin();
   std::list<std::ostream *>::iterator osi  = output_files.begin();
   for ( ; osi != output_files.end(); osi++, osni++) {
@@ -690,6 +1137,10 @@ int colvarproxy::reset()
   int error_code = COLVARS_OK;
   error_code |= colvarproxy_atoms::reset();
   error_code |= colvarproxy_atom_groups::reset();
+  // The objects whose costs were measured are being deleted (new objects
+  // may reuse their addresses)
+  smp_init_items(smp_colvars_items, 0);
+  smp_init_items(smp_biases_items, 0);
   return error_code;
 }
 
@@ -748,6 +1199,11 @@ int colvarproxy::post_run()
     error_code |= colvars->write_restart_file(cvm::output_prefix()+".colvars.state");
     error_code |= colvars->write_output_files();
   }
+  if (cvm::profiling()) {
+    cvm::log("Time spent by each Colvars object and operation "
+             "(percent of the total time of the Colvars module):\n"+
+             colvars->profile_report());
+  }
   error_code |= flush_output_streams();
   return error_code;
 }
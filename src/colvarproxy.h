@@ -110,6 +110,19 @@ public:
   virtual cvm::rvector position_distance(cvm::atom_pos const &pos1,
                                          cvm::atom_pos const &pos2) const;
 
+  /// \brief Get the PBC-aware distance vectors between pos1 and each of the
+  /// n positions in pos2 (same result as n calls to position_distance());
+  /// batched loops over the unit cell are used only when
+  /// batched_cell_distances is set, per-pair calls otherwise
+  /// \param pos1 Reference position
+  /// \param pos2 Array of n positions
+  /// \param n Number of positions
+  /// \param dist Output array of n distance vectors (pos2[i] - pos1)
+  virtual void position_distances(cvm::atom_pos const &pos1,
+                                  cvm::atom_pos const *pos2,
+                                  size_t n,
+                                  cvm::rvector *dist) const;
+
   /// Recompute PBC reciprocal lattice (assumes XYZ periodicity)
   void update_pbc_lattice();
 
@@ -192,6 +205,12 @@ protected:
 
   /// Reciprocal lattice vectors
   cvm::rvector reciprocal_cell_x, reciprocal_cell_y, reciprocal_cell_z;
+
+  /// \brief Whether position_distances() may compute minimum-image distances
+  /// from the unit cell above; set this only in proxies where
+  /// position_distance() gives the same result for each boundaries_type that
+  /// they set (unsupported boundaries always call position_distance())
+  bool batched_cell_distances;
 };
 
 
@@ -292,8 +311,19 @@ public:
   inline void apply_atom_force(int index, cvm::rvector const &new_force)
   {
     atoms_new_colvar_forces[index] += new_force;
+    flag_atom_applied_force(index, new_force);
   }
 
+  /// \brief Copy the current positions of the atoms with the given indices
+  /// into the array pos (batched version of get_atom_position())
+  virtual void get_atoms_positions(std::vector<int> const &indices,
+                                   cvm::atom_pos *pos) const;
+
+  /// \brief Add the given forces to the atoms with the given indices (batched
+  /// version of apply_atom_force())
+  virtual void apply_atoms_forces(std::vector<int> const &indices,
+                                  cvm::rvector const *new_forces);
+
   /// Read the current velocity of the given atom
   inline cvm::rvector get_atom_velocity(int /* index */)
   {
@@ -357,11 +387,22 @@ public:
     return &atoms_new_colvar_forces;
   }
 
-  inline std::vector<cvm::rvector> *modify_atom_applied_forces()
+  /// \brief Access the applied forces for writing; since the forces may be
+  /// changed arbitrarily, all atoms are considered to have received a force
+  std::vector<cvm::rvector> *modify_atom_applied_forces();
+
+  /// \brief Indices of the atoms that received a non-zero force since the
+  /// last call to reset_atoms_applied_forces(), in order of first application;
+  /// all other atoms have zero applied forces
+  inline std::vector<int> const *get_atoms_applied_force_indices() const
   {
-    return &atoms_new_colvar_forces;
+    return &atoms_applied_force_indices;
   }
 
+  /// \brief Set to zero the forces applied to the atoms; only the atoms that
+  /// received a force since the previous call are visited
+  void reset_atoms_applied_forces();
+
   /// Compute the root-mean-square of the applied forces
   void compute_rms_atoms_applied_force();
 
@@ -415,6 +456,19 @@ protected:
   std::vector<cvm::rvector> atoms_total_forces;
   /// \brief Forces applied from colvars, to be communicated to the MD integrator
   std::vector<cvm::rvector> atoms_new_colvar_forces;
+  /// \brief Whether each atom is listed in atoms_applied_force_indices
+  std::vector<int>          atoms_applied_force_flags;
+  /// \brief Indices of the atoms with non-zero entries in atoms_new_colvar_forces
+  std::vector<int>          atoms_applied_force_indices;
+
+  /// Record that a force was applied to this atom, unless the force is zero
+  inline void flag_atom_applied_force(int index, cvm::rvector const &new_force)
+  {
+    if (!atoms_applied_force_flags[index] && (new_force.norm2() > 0.0)) {
+      atoms_applied_force_flags[index] = 1;
+      atoms_applied_force_indices.push_back(index);
+    }
+  }
 
   /// Root-mean-square of the applied forces
   cvm::real atoms_rms_applied_force_;
@@ -453,6 +507,81 @@ public:
   /// \brief Whether this proxy implementation has capability for scalable groups
   virtual int scalable_group_coms();
 
+  /// \brief Whether this proxy can compute additive reductions other than the
+  /// center of mass over the atoms of scalable groups
+  virtual int scalable_group_reductions();
+
+  /// \brief Additive reductions over the atoms of a scalable group; the
+  /// positions are taken relative to a reference point c (parameters: c_x,
+  /// c_y, c_z), which should be kept close to the group to avoid loss of
+  /// precision.  Until the parameters are set, engines compute the reduction
+  /// around the center of mass of the group at the same step, and store it as
+  /// the parameters.  Only sums of the positions with unit or mass weights
+  /// are supported; other functions of the positions (e.g. switching
+  /// functions) are computed from the atoms of non-scalable groups
+  enum atom_group_reduction_type {
+    /// Sum of w_i (r_i-c) (3 values: x, y, z)
+    reduction_sum_positions,
+    /// Sum of w_i (r_i-c) (x) (r_i-c) (6 values: xx, xy, xz, yy, yz, zz)
+    reduction_sum_positions_outer
+  };
+
+  /// Per-atom weights of an additive reduction
+  enum atom_group_reduction_weight {
+    reduction_weight_unit,
+    reduction_weight_mass
+  };
+
+  /// Number of values computed by a reduction of the given type
+  static size_t atom_group_reduction_size(int type);
+
+  /// \brief Request that a reduction over the atoms of the given group be
+  /// computed where the atoms reside, at every step; returns the index of the
+  /// reduction (not shared with other requests, because each requester sets
+  /// its own parameters), or a negative error code
+  virtual int request_atom_group_reduction(int group_index, int type,
+                                           int weight);
+
+  /// \brief Set the parameters of a reduction (e.g. its center), used from
+  /// the next evaluation
+  int set_atom_group_reduction_params(int index,
+                                      std::vector<cvm::real> const &params);
+
+  /// Current values of the given reduction
+  inline cvm::real const *get_atom_group_reduction(int index) const
+  {
+    return &(atom_groups_reductions_values[atom_groups_reductions_offsets[index]]);
+  }
+
+  /// \brief Parameters used to compute the current values of the given
+  /// reduction (empty before the first computation, if not set)
+  inline std::vector<cvm::real> const &get_atom_group_reduction_params(int index) const
+  {
+    return atom_groups_reductions_params[index];
+  }
+
+  /// \brief Request that the forces \sum_k coeffs[k] * d(value_k)/d(r_i) be
+  /// applied to the atoms of the reduction's group
+  void apply_atom_group_reduction_force(int index, cvm::real const *coeffs);
+
+  /// \brief Add to values the reduction of the given type over n atoms (e.g.
+  /// those local to one process; partial results can be summed)
+  static void compute_atom_group_reduction(int type,
+                                           std::vector<cvm::real> const &params,
+                                           size_t n, cvm::atom_pos const *pos,
+                                           cvm::real const *weights,
+                                           cvm::real *values);
+
+  /// \brief Add to forces the atomic forces requested for a reduction by the
+  /// coefficients coeffs (see apply_atom_group_reduction_force())
+  static void compute_atom_group_reduction_forces(int type,
+                                                  std::vector<cvm::real> const &params,
+                                                  cvm::real const *coeffs,
+                                                  size_t n,
+                                                  cvm::atom_pos const *pos,
+                                                  cvm::real const *weights,
+                                                  cvm::rvector *forces);
+
   /// Prepare this group for collective variables calculation, selecting atoms by internal ids (0-based)
   virtual int init_atom_group(std::vector<int> const &atoms_ids);
 
@@ -577,6 +706,22 @@ protected:
   /// Maximum norm among all applied group forces
   cvm::real atom_groups_max_applied_force_;
 
+  /// Index of the group of each requested reduction
+  std::vector<int> atom_groups_reductions_groups;
+  /// Type of each requested reduction
+  std::vector<int> atom_groups_reductions_types;
+  /// Per-atom weights used by each requested reduction
+  std::vector<int> atom_groups_reductions_weights;
+  /// Parameters of each requested reduction
+  std::vector< std::vector<cvm::real> > atom_groups_reductions_params;
+  /// Offset of each reduction in the values and coefficients arrays
+  std::vector<size_t> atom_groups_reductions_offsets;
+  /// Values of all reductions, to be set by the MD engine
+  std::vector<cvm::real> atom_groups_reductions_values;
+  /// \brief Force coefficients of all reductions, to be applied by the MD
+  /// engine and then zeroed
+  std::vector<cvm::real> atom_groups_reductions_coeffs;
+
   /// Used by all init_atom_group() functions: create a slot for an atom group not requested yet
   int add_atom_group_slot(int atom_group_id);
 };
@@ -609,6 +754,12 @@ public:
   /// Distribute calculation of biases across threads 2nd through last, with all scripted biased on 1st thread
   virtual int smp_biases_script_loop();
 
+  /// \brief Run num_tasks independent calls of task(i, data), in parallel
+  /// if threads are available; when called from one of the loops above,
+  /// the tasks are nested and may be run by threads that are otherwise idle
+  virtual int smp_tasks(size_t num_tasks, int (*task)(size_t, void *),
+                        void *data);
+
   /// Index of this thread
   virtual int smp_thread_id();
 
@@ -628,6 +779,55 @@ protected:
 
   /// Lock state for OpenMP
   void *omp_lock_state;
+
+  /// \brief Items of one kind of parallel loop, in the order of the loop,
+  /// with the running average of the time taken by each; the costs are kept
+  /// across steps as long as the items do not change
+  struct smp_loop_items {
+    /// Object (variable or bias) of each item
+    std::vector<void const *> objects;
+    /// Index of each item within its object
+    std::vector<int> indices;
+    /// Cost of each item (negative if not measured yet)
+    std::vector<double> costs;
+  };
+
+  /// Items of the loop over the variables' components
+  smp_loop_items smp_colvars_items;
+
+  /// Items of the loops over the biases
+  smp_loop_items smp_biases_items;
+
+  /// Items of the current parallel loop
+  smp_loop_items *smp_items;
+
+  /// \brief Start setting the n items of a parallel loop; call
+  /// smp_set_item() for each of them, then smp_schedule_items()
+  void smp_init_items(smp_loop_items &loop, size_t n);
+
+  /// \brief Set item i of the current loop; its cost is forgotten if it
+  /// differs from the item at the same position in the last loop
+  inline void smp_set_item(size_t i, void const *object, int index)
+  {
+    if ((smp_items->objects[i] != object) || (smp_items->indices[i] != index)) {
+      smp_items->objects[i] = object;
+      smp_items->indices[i] = index;
+      smp_items->costs[i] = -1.0;
+    }
+  }
+
+  /// \brief Order the items of the current loop by decreasing cost, as
+  /// measured in previous steps
+  void smp_schedule_items();
+
+  /// Update the cost estimates with the times measured for the current items
+  void smp_update_costs();
+
+  /// Order in which the items of the current parallel loop are executed
+  std::vector<size_t> smp_items_order;
+
+  /// Time taken by each item of the current parallel loop
+  std::vector<double> smp_items_times;
 };
 
 
@@ -660,6 +860,185 @@ public:
   /// \brief Send data to other replica
   virtual int replica_comm_send(char* msg_data, int msg_len, int dest_rep);
 
+  /// \brief Whether the tagged, non-blocking functions below are implemented;
+  /// if not, they fall back to the blocking functions above, and messages
+  /// with different tags are not kept apart
+  virtual int replica_comm_async();
+
+  /// \brief New tag for the messages of one communication pattern (e.g. a
+  /// sparse_sum), so that they are not received by another; tags are given
+  /// in order, and must be requested in the same order on all replicas
+  int replica_comm_new_tag();
+
+  /// \brief Start sending data with the given tag to another replica,
+  /// without waiting for it to be received; msg_data must not be modified
+  /// until replica_comm_send_done() returns true.  Returns the index of the
+  /// request, or -1 on failure
+  virtual int replica_comm_isend(char *msg_data, int msg_len, int dest_rep,
+                                 int tag);
+
+  /// \brief Whether the given send request is complete (waiting for it if
+  /// wait is true); the index of a complete request may be reused
+  virtual bool replica_comm_send_done(int request, bool wait);
+
+  /// \brief Whether a message with the given tag from the given replica can
+  /// be received without blocking (true if the implementation cannot test it)
+  virtual bool replica_comm_ready(int src_rep, int tag);
+
+  /// \brief Receive data with the given tag from another replica, returning
+  /// its length
+  virtual int replica_comm_recv_tagged(char *msg_data, int buf_len,
+                                       int src_rep, int tag);
+
+  /// \brief Element-wise sum over all replicas of sparse arrays of records
+  /// (e.g. grid bins), in which only the records set by at least one replica
+  /// are communicated.  Partial sums travel along a binomial tree rooted at
+  /// replica 0 and the total is sent back along the same tree, so that each
+  /// replica exchanges O(log(num_replicas)) messages.  The summation can be
+  /// advanced without blocking, to overlap it with other work.  Each sum
+  /// sends its messages with its own tag, so that several can be in progress
+  /// at the same time.
+  class sparse_sum {
+
+  public:
+
+    sparse_sum();
+
+    /// \brief Set the communicator, the total number of records and the
+    /// number of values in each record; also gets the tag of the messages of
+    /// this sum from the communicator, so all replicas must initialize their
+    /// sums in the same order
+    int init(colvarproxy_replicas *comm, size_t num_records,
+             size_t record_size);
+
+    /// Whether init() was called
+    inline bool initialized() const
+    {
+      return (comm != NULL);
+    }
+
+    /// \brief Start a summation, given the records of this replica and their
+    /// values (record_size values for each record)
+    int start(std::vector<size_t> const &records,
+              std::vector<cvm::real> const &values);
+
+    /// \brief Perform the steps of the summation whose messages have arrived
+    /// (all remaining steps, if block is true); once the summation is
+    /// complete, release the messages sent by it when their sends complete
+    int progress(bool block);
+
+    /// Whether a summation was started and is not yet complete
+    inline bool active() const
+    {
+      return (state == state_reduce) || (state == state_broadcast);
+    }
+
+    /// Whether the last summation is complete
+    inline bool complete() const
+    {
+      return (state == state_complete);
+    }
+
+    /// Records of the sum in increasing order (valid once complete)
+    inline std::vector<size_t> const &records() const
+    {
+      return sum_records;
+    }
+
+    /// Values of the sum (valid once complete)
+    inline std::vector<cvm::real> const &values() const
+    {
+      return sum_values;
+    }
+
+    /// Number of messages sent by this replica so far
+    inline size_t num_messages_sent() const
+    {
+      return messages_sent;
+    }
+
+  protected:
+
+    /// Communicator
+    colvarproxy_replicas *comm;
+
+    /// Size of each record
+    size_t record_size;
+
+    /// Parent of this replica in the tree (-1 for replica 0)
+    int parent;
+
+    /// Children of this replica in the tree, in order of reception
+    std::vector<int> children;
+
+    /// Number of children whose partial sums were already received
+    size_t children_done;
+
+    enum {
+      state_idle,
+      state_reduce,
+      state_broadcast,
+      state_complete
+    } state;
+
+    /// Dense accumulation buffer of the partial sum
+    std::vector<cvm::real> acc_values;
+
+    /// Flags of the records set in acc_values
+    std::vector<unsigned char> acc_flags;
+
+    /// Records set in acc_values
+    std::vector<size_t> acc_records;
+
+    /// Records of the complete sum
+    std::vector<size_t> sum_records;
+
+    /// Values of the complete sum
+    std::vector<cvm::real> sum_values;
+
+    /// Tag of the messages of this sum
+    int tag;
+
+    /// Buffer of the messages received
+    std::vector<char> buffer;
+
+    /// Buffer of the messages being sent
+    std::vector<char> send_buffer;
+
+    /// Requests of the messages being sent from send_buffer
+    std::vector<int> send_requests;
+
+    /// Number of messages sent
+    size_t messages_sent;
+
+    /// Add a record to the accumulation buffer
+    void accumulate(size_t record, cvm::real const *values);
+
+    /// Clear the accumulation buffer (only the records that were set)
+    void clear_accumulator();
+
+    /// \brief Pack the accumulation buffer into send_buffer, returning the
+    /// message size
+    size_t pack_accumulator();
+
+    /// Add the records of a message to the accumulation buffer
+    int unpack_message(size_t msg_len);
+
+    /// Receive a message into buffer, returning its size (0 on failure)
+    size_t receive(int src_rep);
+
+    /// Send the first msg_len bytes of send_buffer to a replica
+    int send(size_t msg_len, int dest_rep);
+
+    /// \brief Release the requests of the sends that are complete (waiting
+    /// for all if block is true); returns true if send_buffer is free
+    bool complete_sends(bool block);
+  };
+
+protected:
+
+  /// Last tag given by replica_comm_new_tag()
+  int replica_comm_last_tag;
 };
 
 
@@ -7,11 +7,18 @@
 // If you wish to distribute your changes, please submit them to the
 // Colvars repository at GitHub.
 
+#include <algorithm>
+#include <cstring>
+
 #include "colvarmodule.h"
 #include "colvarproxy.h"
 
 
-colvarproxy_replicas::colvarproxy_replicas() {}
+colvarproxy_replicas::colvarproxy_replicas()
+{
+  // Tag 0 is left to the untagged messages
+  replica_comm_last_tag = 0;
+}
 
 
 colvarproxy_replicas::~colvarproxy_replicas() {}
@@ -54,3 +61,292 @@ int colvarproxy_replicas::replica_comm_send(char* /* msg_data */,
 }
 
 
+int colvarproxy_replicas::replica_comm_async()
+{
+  return COLVARS_NOT_IMPLEMENTED;
+}
+
+
+int colvarproxy_replicas::replica_comm_new_tag()
+{
+  return ++replica_comm_last_tag;
+}
+
+
+int colvarproxy_replicas::replica_comm_isend(char *msg_data, int msg_len,
+                                             int dest_rep, int /* tag */)
+{
+  // Blocking send: the request is complete when this returns
+  return (replica_comm_send(msg_data, msg_len, dest_rep) == msg_len) ? 0 : -1;
+}
+
+
+bool colvarproxy_replicas::replica_comm_send_done(int /* request */,
+                                                  bool /* wait */)
+{
+  return true;
+}
+
+
+bool colvarproxy_replicas::replica_comm_ready(int /* src_rep */,
+                                              int /* tag */)
+{
+  return true;
+}
+
+
+int colvarproxy_replicas::replica_comm_recv_tagged(char *msg_data,
+                                                   int buf_len, int src_rep,
+                                                   int /* tag */)
+{
+  return replica_comm_recv(msg_data, buf_len, src_rep);
+}
+
+
+colvarproxy_replicas::sparse_sum::sparse_sum()
+{
+  comm = NULL;
+  record_size = 0;
+  parent = -1;
+  children_done = 0;
+  state = state_idle;
+  messages_sent = 0;
+  tag = 0;
+}
+
+
+int colvarproxy_replicas::sparse_sum::init(colvarproxy_replicas *comm_in,
+                                           size_t num_records,
+                                           size_t record_size_in)
+{
+  comm = comm_in;
+  tag = comm->replica_comm_new_tag();
+  record_size = record_size_in;
+  acc_values.assign(num_records * record_size, 0.0);
+  acc_flags.assign(num_records, 0);
+  acc_records.clear();
+  state = state_idle;
+
+  // Binomial tree: the parent of a replica is obtained by clearing its
+  // lowest set bit, and its children by setting each lower bit in turn
+  int const me = comm->replica_index();
+  int const n = comm->num_replicas();
+  parent = (me > 0) ? (me & (me - 1)) : -1;
+  children.clear();
+  for (int k = 1; k < n; k <<= 1) {
+    if (me & k) break;
+    if (me + k < n) children.push_back(me + k);
+  }
+
+  // Largest possible message: all records set
+  buffer.resize(sizeof(size_t) +
+                num_records * (sizeof(size_t) + record_size * sizeof(cvm::real)));
+  send_buffer.resize(buffer.size());
+  return COLVARS_OK;
+}
+
+
+void colvarproxy_replicas::sparse_sum::accumulate(size_t record,
+                                                  cvm::real const *values)
+{
+  if (!acc_flags[record]) {
+    acc_flags[record] = 1;
+    acc_records.push_back(record);
+  }
+  cvm::real *acc = &(acc_values[record * record_size]);
+  for (size_t k = 0; k < record_size; k++) {
+    acc[k] += values[k];
+  }
+}
+
+
+void colvarproxy_replicas::sparse_sum::clear_accumulator()
+{
+  for (size_t i = 0; i < acc_records.size(); i++) {
+    size_t const record = acc_records[i];
+    acc_flags[record] = 0;
+    for (size_t k = 0; k < record_size; k++) {
+      acc_values[record * record_size + k] = 0.0;
+    }
+  }
+  acc_records.clear();
+}
+
+
+size_t colvarproxy_replicas::sparse_sum::pack_accumulator()
+{
+  // Layout: number of records, their indices, then their values
+  size_t const n = acc_records.size();
+  char *p = &(send_buffer[0]);
+  std::memcpy(p, &n, sizeof(size_t));
+  p += sizeof(size_t);
+  if (n > 0) {
+    std::memcpy(p, &(acc_records[0]), n * sizeof(size_t));
+    p += n * sizeof(size_t);
+  }
+  for (size_t i = 0; i < n; i++) {
+    std::memcpy(p, &(acc_values[acc_records[i] * record_size]),
+                record_size * sizeof(cvm::real));
+    p += record_size * sizeof(cvm::real);
+  }
+  return size_t(p - &(send_buffer[0]));
+}
+
+
+int colvarproxy_replicas::sparse_sum::unpack_message(size_t msg_len)
+{
+  size_t n = 0;
+  if (msg_len < sizeof(size_t)) {
+    return cvm::error("Error: incomplete message received from replica.\n",
+                      COLVARS_ERROR);
+  }
+  std::memcpy(&n, &(buffer[0]), sizeof(size_t));
+  if (msg_len != sizeof(size_t) +
+      n * (sizeof(size_t) + record_size * sizeof(cvm::real))) {
+    return cvm::error("Error: message of unexpected size received from "
+                      "replica.\n", COLVARS_ERROR);
+  }
+  char const *p_records = &(buffer[0]) + sizeof(size_t);
+  char const *p_values = p_records + n * sizeof(size_t);
+  std::vector<cvm::real> values(record_size);
+  for (size_t i = 0; i < n; i++) {
+    size_t record = 0;
+    std::memcpy(&record, p_records + i * sizeof(size_t), sizeof(size_t));
+    if (record >= acc_flags.size()) {
+      return cvm::error("Error: invalid record received from replica.\n",
+                        COLVARS_ERROR);
+    }
+    std::memcpy(&(values[0]), p_values + i * record_size * sizeof(cvm::real),
+                record_size * sizeof(cvm::real));
+    accumulate(record, &(values[0]));
+  }
+  return COLVARS_OK;
+}
+
+
+size_t colvarproxy_replicas::sparse_sum::receive(int src_rep)
+{
+  int const len = comm->replica_comm_recv_tagged(&(buffer[0]),
+                                                 int(buffer.size()), src_rep,
+                                                 tag);
+  return (len > 0) ? size_t(len) : 0;
+}
+
+
+int colvarproxy_replicas::sparse_sum::send(size_t msg_len, int dest_rep)
+{
+  int const request = comm->replica_comm_isend(&(send_buffer[0]),
+                                               int(msg_len), dest_rep, tag);
+  if (request < 0) {
+    return cvm::error("Error: could not send a message to replica "+
+                      cvm::to_str(dest_rep)+".\n", COLVARS_ERROR);
+  }
+  send_requests.push_back(request);
+  messages_sent++;
+  return COLVARS_OK;
+}
+
+
+bool colvarproxy_replicas::sparse_sum::complete_sends(bool block)
+{
+  size_t n = 0;
+  for (size_t i = 0; i < send_requests.size(); i++) {
+    if (!comm->replica_comm_send_done(send_requests[i], block)) {
+      send_requests[n++] = send_requests[i];
+    }
+  }
+  send_requests.resize(n);
+  return (n == 0);
+}
+
+
+int colvarproxy_replicas::sparse_sum::start(std::vector<size_t> const &records,
+                                            std::vector<cvm::real> const &values)
+{
+  if (comm == NULL) {
+    return cvm::error("Error: sparse sum over replicas used before "
+                      "initialization.\n", COLVARS_BUG_ERROR);
+  }
+  if (active()) {
+    return cvm::error("Error: starting a sum over replicas while the previous "
+                      "one is not complete.\n", COLVARS_BUG_ERROR);
+  }
+  clear_accumulator();
+  for (size_t i = 0; i < records.size(); i++) {
+    accumulate(records[i], &(values[i * record_size]));
+  }
+  children_done = 0;
+  state = state_reduce;
+  return COLVARS_OK;
+}
+
+
+int colvarproxy_replicas::sparse_sum::progress(bool block)
+{
+  int error_code = COLVARS_OK;
+
+  if (!active()) {
+    // Release the sends of the last summation
+    complete_sends(block);
+    return error_code;
+  }
+
+  if (state == state_reduce) {
+    // Collect the partial sums of the subtrees
+    while (children_done < children.size()) {
+      int const child = children[children_done];
+      if (!block && !comm->replica_comm_ready(child, tag)) {
+        return error_code;
+      }
+      error_code |= unpack_message(receive(child));
+      children_done++;
+    }
+    if (parent >= 0) {
+      // The buffer may still be in use by the sends of the last summation
+      if (!complete_sends(block)) {
+        return error_code;
+      }
+      error_code |= send(pack_accumulator(), parent);
+    }
+    state = state_broadcast;
+  }
+
+  if (state == state_broadcast) {
+    size_t msg_len = 0;
+    if (parent >= 0) {
+      // Replace the partial sum with the total
+      if (!block && !comm->replica_comm_ready(parent, tag)) {
+        return error_code;
+      }
+      if (!complete_sends(block)) {
+        return error_code;
+      }
+      msg_len = receive(parent);
+      clear_accumulator();
+      error_code |= unpack_message(msg_len);
+      // Forward the total as it was received
+      buffer.swap(send_buffer);
+    } else {
+      if (!complete_sends(block)) {
+        return error_code;
+      }
+      msg_len = pack_accumulator();
+    }
+    for (size_t i = children.size(); i > 0; i--) {
+      error_code |= send(msg_len, children[i-1]);
+    }
+
+    std::sort(acc_records.begin(), acc_records.end());
+    sum_records = acc_records;
+    sum_values.resize(acc_records.size() * record_size);
+    for (size_t i = 0; i < acc_records.size(); i++) {
+      for (size_t k = 0; k < record_size; k++) {
+        sum_values[i * record_size + k] =
+          acc_values[acc_records[i] * record_size + k];
+      }
+    }
+    state = state_complete;
+  }
+
+  return error_code;
+}
@@ -7,8 +7,12 @@
 // If you wish to distribute your changes, please submit them to the
 // Colvars repository at GitHub.
 
+#include <sstream>
+
 #include "colvarmodule.h"
+#include "colvarproxy.h"
 #include "colvarproxy_volmaps.h"
+#include "colvaratoms.h"
 #include "colvarmodule_utils.h"
 
 
@@ -18,7 +22,10 @@ colvarproxy_volmaps::colvarproxy_volmaps()
 }
 
 
-colvarproxy_volmaps::~colvarproxy_volmaps() {}
+colvarproxy_volmaps::~colvarproxy_volmaps()
+{
+  clear_internal_volmaps();
+}
 
 
 int colvarproxy_volmaps::volmaps_available()
@@ -36,10 +43,20 @@ int colvarproxy_volmaps::reset()
   volmaps_ncopies.clear();
   volmaps_values.clear();
   volmaps_new_colvar_forces.clear();
+  clear_internal_volmaps();
   return COLVARS_OK;
 }
 
 
+void colvarproxy_volmaps::clear_internal_volmaps()
+{
+  for (size_t i = 0; i < internal_volmaps.size(); i++) {
+    delete internal_volmaps[i];
+  }
+  internal_volmaps.clear();
+}
+
+
 int colvarproxy_volmaps::add_volmap_slot(int volmap_id)
 {
   volmaps_ids.push_back(volmap_id);
@@ -120,6 +137,254 @@ int colvarproxy_volmaps::compute_volmap(int /* flags */,
 }
 
 
+int colvarproxy_volmaps::load_internal_volmap(std::string const &filename,
+                                              bool periodic)
+{
+  for (size_t i = 0; i < internal_volmaps.size(); i++) {
+    if ((internal_volmaps[i]->file_name == filename) &&
+        (internal_volmaps[i]->periodic == periodic)) {
+      // Already loaded by another variable
+      return i;
+    }
+  }
+
+  internal_volmap *map = new internal_volmap();
+  map->periodic = periodic;
+  if (map->read_opendx(filename) != COLVARS_OK) {
+    delete map;
+    return -1;
+  }
+
+  cvm::log("Loaded volumetric map from file \""+filename+"\": "+
+           cvm::to_str(map->nx)+" x "+cvm::to_str(map->ny)+" x "+
+           cvm::to_str(map->nz)+" points, origin = "+
+           cvm::to_str(map->origin)+", spacing = "+
+           cvm::to_str(map->delta)+
+           (periodic ? ", periodic" : "")+".\n");
+
+  internal_volmaps.push_back(map);
+  return (internal_volmaps.size() - 1);
+}
+
+
+int colvarproxy_volmaps::compute_internal_volmap(int flags,
+                                                 int volmap_id,
+                                                 cvm::atom_iter atom_begin,
+                                                 cvm::atom_iter atom_end,
+                                                 cvm::real *value,
+                                                 cvm::real *atom_field)
+{
+  if ((volmap_id < 0) || (((size_t) volmap_id) >= internal_volmaps.size())) {
+    return cvm::error("Error: invalid numeric ID ("+cvm::to_str(volmap_id)+
+                      ") for an internally stored map.\n", COLVARS_BUG_ERROR);
+  }
+
+  internal_volmap const *map = internal_volmaps[volmap_id];
+
+  // Select at compile time the loop to run
+  if (flags & volmap_flag_gradients) {
+    if (flags & volmap_flag_use_atom_field) {
+      map->compute<volmap_flag_gradients | volmap_flag_use_atom_field>
+        (atom_begin, atom_end, value, atom_field);
+    } else {
+      map->compute<volmap_flag_gradients>(atom_begin, atom_end, value, NULL);
+    }
+  } else {
+    if (flags & volmap_flag_use_atom_field) {
+      map->compute<volmap_flag_use_atom_field>(atom_begin, atom_end,
+                                               value, atom_field);
+    } else {
+      map->compute<volmap_flag_null>(atom_begin, atom_end, value, NULL);
+    }
+  }
+
+  return COLVARS_OK;
+}
+
+
+colvarproxy_volmaps::internal_volmap::internal_volmap()
+{
+  periodic = false;
+  nx = ny = nz = 0;
+}
+
+
+int colvarproxy_volmaps::internal_volmap::read_opendx(std::string const &filename)
+{
+  colvarproxy *proxy = cvm::main()->proxy;
+  std::istream &is = proxy->input_stream(filename, "volumetric map file");
+  if (!is) {
+    return COLVARS_FILE_ERROR;
+  }
+
+  file_name = filename;
+
+  std::vector<cvm::rvector> deltas;
+  size_t num_items = 0;
+  bool data_follows = false;
+
+  std::string line;
+  while (!data_follows && cvm::getline(is, line)) {
+    if ((line.size() == 0) || (line[0] == '#')) continue;
+    std::istringstream ls(line);
+    std::string word;
+    ls >> word;
+    if (word == "origin") {
+      ls >> origin.x >> origin.y >> origin.z;
+    } else if (word == "delta") {
+      cvm::rvector d;
+      ls >> d.x >> d.y >> d.z;
+      deltas.push_back(d);
+    } else if (word == "object") {
+      if (line.find("gridpositions") != std::string::npos) {
+        std::string const counts("counts");
+        std::istringstream cs(line.substr(line.find(counts)+counts.size()));
+        cs >> nx >> ny >> nz;
+      } else if (line.find("data follows") != std::string::npos) {
+        std::string const items("items");
+        std::istringstream cs(line.substr(line.find(items)+items.size()));
+        cs >> num_items;
+        data_follows = true;
+      }
+    }
+  }
+
+  if (!data_follows || (nx < 2) || (ny < 2) || (nz < 2) ||
+      (deltas.size() != 3) ||
+      (num_items != ((size_t) nx) * ((size_t) ny) * ((size_t) nz))) {
+    proxy->close_input_stream(filename);
+    return cvm::error("Error: could not read the header of OpenDX file \""+
+                      filename+"\".\n", COLVARS_INPUT_ERROR);
+  }
+
+  if ((deltas[0].y != 0.0) || (deltas[0].z != 0.0) ||
+      (deltas[1].x != 0.0) || (deltas[1].z != 0.0) ||
+      (deltas[2].x != 0.0) || (deltas[2].y != 0.0)) {
+    proxy->close_input_stream(filename);
+    return cvm::error("Error: the grid of OpenDX file \""+filename+
+                      "\" is not aligned with the Cartesian axes; this is "
+                      "not supported.\n", COLVARS_INPUT_ERROR);
+  }
+
+  origin = cvm::rvector(proxy->angstrom_to_internal(origin.x),
+                        proxy->angstrom_to_internal(origin.y),
+                        proxy->angstrom_to_internal(origin.z));
+  delta = cvm::rvector(proxy->angstrom_to_internal(deltas[0].x),
+                       proxy->angstrom_to_internal(deltas[1].y),
+                       proxy->angstrom_to_internal(deltas[2].z));
+
+  if ((delta.x <= 0.0) || (delta.y <= 0.0) || (delta.z <= 0.0)) {
+    proxy->close_input_stream(filename);
+    return cvm::error("Error: OpenDX file \""+filename+"\" has non-positive "
+                      "grid spacings.\n", COLVARS_INPUT_ERROR);
+  }
+
+  data.resize(num_items);
+  for (size_t i = 0; i < num_items; i++) {
+    if (!(is >> data[i])) {
+      proxy->close_input_stream(filename);
+      return cvm::error("Error: OpenDX file \""+filename+"\" contains "+
+                        cvm::to_str(i)+" values instead of "+
+                        cvm::to_str(num_items)+".\n", COLVARS_INPUT_ERROR);
+    }
+  }
+
+  proxy->close_input_stream(filename);
+  return COLVARS_OK;
+}
+
+
+template <int flags>
+void colvarproxy_volmaps::internal_volmap::compute(cvm::atom_iter atom_begin,
+                                                   cvm::atom_iter atom_end,
+                                                   cvm::real *value,
+                                                   cvm::real const *atom_field) const
+{
+  cvm::real const inv_dx = 1.0/delta.x;
+  cvm::real const inv_dy = 1.0/delta.y;
+  cvm::real const inv_dz = 1.0/delta.z;
+  // Without periodicity, the map is interpolated between its first and last
+  // points along each axis; otherwise, the last point is followed by the first
+  cvm::real const ux = periodic ? cvm::real(nx) : cvm::real(nx-1);
+  cvm::real const uy = periodic ? cvm::real(ny) : cvm::real(ny-1);
+  cvm::real const uz = periodic ? cvm::real(nz) : cvm::real(nz-1);
+  cvm::real const *const v = &(data[0]);
+  size_t const stride_x = ny * nz;
+  size_t const stride_y = nz;
+
+  cvm::real sum = 0.0;
+  size_t i = 0;
+  for (cvm::atom_iter ai = atom_begin; ai != atom_end; ai++, i++) {
+
+    // Continuous grid coordinates of the atom
+    cvm::real gx = (ai->pos().x - origin.x) * inv_dx;
+    cvm::real gy = (ai->pos().y - origin.y) * inv_dy;
+    cvm::real gz = (ai->pos().z - origin.z) * inv_dz;
+
+    if (periodic) {
+      gx -= ux * cvm::floor(gx / ux);
+      gy -= uy * cvm::floor(gy / uy);
+      gz -= uz * cvm::floor(gz / uz);
+    } else if ((gx < 0.0) || (gx > ux) || (gy < 0.0) || (gy > uy) ||
+               (gz < 0.0) || (gz > uz)) {
+      // Out-of-bounds atoms have a value of zero
+      continue;
+    }
+
+    int ix = static_cast<int>(gx);
+    int iy = static_cast<int>(gy);
+    int iz = static_cast<int>(gz);
+    // Tiny negative coordinates are wrapped onto the period itself by rounding
+    if (ix >= nx) { ix -= nx; gx -= ux; }
+    if (iy >= ny) { iy -= ny; gy -= uy; }
+    if (iz >= nz) { iz -= nz; gz -= uz; }
+    // Atoms lying exactly on the last grid point use the last cell
+    if (ix >= nx-1 && !periodic) ix = nx-2;
+    if (iy >= ny-1 && !periodic) iy = ny-2;
+    if (iz >= nz-1 && !periodic) iz = nz-2;
+    cvm::real const fx = gx - cvm::real(ix);
+    cvm::real const fy = gy - cvm::real(iy);
+    cvm::real const fz = gz - cvm::real(iz);
+
+    size_t const x0 = ix * stride_x;
+    size_t const y0 = iy * stride_y;
+    size_t const z0 = iz;
+    size_t const x1 = ((ix+1 < nx) ? (ix+1) : 0) * stride_x;
+    size_t const y1 = ((iy+1 < ny) ? (iy+1) : 0) * stride_y;
+    size_t const z1 = ((iz+1 < nz) ? (iz+1) : 0);
+
+    cvm::real const v000 = v[x0+y0+z0], v001 = v[x0+y0+z1];
+    cvm::real const v010 = v[x0+y1+z0], v011 = v[x0+y1+z1];
+    cvm::real const v100 = v[x1+y0+z0], v101 = v[x1+y0+z1];
+    cvm::real const v110 = v[x1+y1+z0], v111 = v[x1+y1+z1];
+
+    // Interpolate along z, then y, then x
+    cvm::real const d00 = v001 - v000, d01 = v011 - v010;
+    cvm::real const d10 = v101 - v100, d11 = v111 - v110;
+    cvm::real const c00 = v000 + fz * d00, c01 = v010 + fz * d01;
+    cvm::real const c10 = v100 + fz * d10, c11 = v110 + fz * d11;
+    cvm::real const c0 = c00 + fy * (c01 - c00);
+    cvm::real const c1 = c10 + fy * (c11 - c10);
+    cvm::real const V = c0 + fx * (c1 - c0);
+
+    cvm::real const w = (flags & volmap_flag_use_atom_field) ?
+      atom_field[i] : 1.0;
+
+    sum += w * V;
+
+    if (flags & volmap_flag_gradients) {
+      cvm::real const dz0 = d00 + fy * (d01 - d00);
+      cvm::real const dz1 = d10 + fy * (d11 - d10);
+      ai->grad().x += w * inv_dx * (c1 - c0);
+      ai->grad().y += w * inv_dy * ((c01 - c00) + fx * ((c11 - c10) - (c01 - c00)));
+      ai->grad().z += w * inv_dz * (dz0 + fx * (dz1 - dz0));
+    }
+  }
+
+  *value += sum;
+}
+
+
 void colvarproxy_volmaps::compute_rms_volmaps_applied_force()
 {
   volmaps_rms_applied_force_ =
@@ -95,6 +95,29 @@ public:
     volmap_flag_use_atom_field = (1<<8)
   };
 
+  /// \brief Load a volumetric map from an OpenDX file and store it internally
+  /// (for engines that do not provide maps, or for maps private to Colvars)
+  /// \param filename Name of the OpenDX file (coordinates in Angstrom)
+  /// \param periodic Whether the map repeats itself along each of its axes
+  /// \returns Numeric ID of the map in the internal store, or -1 on error
+  int load_internal_volmap(std::string const &filename, bool periodic);
+
+  /// Number of maps loaded in the internal store
+  inline size_t num_internal_volmaps() const
+  {
+    return internal_volmaps.size();
+  }
+
+  /// \brief Same as compute_volmap(), but always using the maps stored
+  /// internally by Colvars (i.e. available in all back-ends)
+  /// \param volmap_id Numeric ID returned by load_internal_volmap()
+  int compute_internal_volmap(int flags,
+                              int volmap_id,
+                              cvm::atom_iter atom_begin,
+                              cvm::atom_iter atom_end,
+                              cvm::real *value,
+                              cvm::real *atom_field);
+
   /// Compute the root-mean-square of the applied forces
   void compute_rms_volmaps_applied_force();
 
@@ -122,6 +145,53 @@ protected:
 
   /// Maximum norm among all applied forces
   cvm::real volmaps_max_applied_force_;
+
+  class internal_volmap;
+
+  /// Volumetric maps loaded and interpolated by Colvars itself
+  std::vector<internal_volmap *> internal_volmaps;
+
+  /// Delete all internally stored maps
+  void clear_internal_volmaps();
+};
+
+
+/// \brief Volumetric map defined on a regular orthogonal grid, stored and
+/// interpolated by Colvars (trilinear interpolation of value and gradient)
+class colvarproxy_volmaps::internal_volmap {
+
+public:
+
+  internal_volmap();
+
+  /// Read from an OpenDX file; coordinates are converted to internal units
+  int read_opendx(std::string const &filename);
+
+  /// Sum the (optionally weighted) map values at the atomic positions; if
+  /// requested by flags, also increment the atomic gradients
+  template <int flags>
+  void compute(cvm::atom_iter atom_begin,
+               cvm::atom_iter atom_end,
+               cvm::real *value,
+               cvm::real const *atom_field) const;
+
+  /// Name of the file that the map was read from
+  std::string file_name;
+
+  /// Whether the map is repeated periodically along each axis
+  bool periodic;
+
+  /// Number of grid points along each axis
+  int nx, ny, nz;
+
+  /// Position of the first grid point
+  cvm::rvector origin;
+
+  /// Spacing between grid points along each axis
+  cvm::rvector delta;
+
+  /// Map values, with the z index varying fastest (as in OpenDX)
+  std::vector<cvm::real> data;
 };
 
 
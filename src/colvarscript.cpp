@@ -36,6 +36,8 @@ colvarscript::colvarscript(colvarproxy *p, colvarmodule *m)
    colvars(m)
 {
   cmd_names = NULL;
+  binary_result_mode_ = false;
+  clear_binary_result();
   init_commands();
 #ifdef COLVARS_TCL
   // must be called after constructing derived proxy class to allow for overloading
@@ -344,6 +346,7 @@ std::string colvarscript::get_command_cmdline_help(colvarscript::Object_type t,
 int colvarscript::run(int objc, unsigned char *const objv[])
 {
   clear_str_result();
+  clear_binary_result();
 
   if (cvm::debug()) {
     cvm::log("Called script run with " + cvm::to_str(objc) + " args:");
@@ -606,6 +609,16 @@ int colvarscript::clear_str_result()
 }
 
 
+int colvarscript::clear_binary_result()
+{
+  bin_result_data_ = NULL;
+  bin_result_type_ = COLVARSCRIPT_RESULT_NONE;
+  bin_result_ndim_ = 0;
+  bin_result_shape_[0] = bin_result_shape_[1] = 0;
+  return COLVARS_OK;
+}
+
+
 extern "C"
 int run_colvarscript_command(int objc, unsigned char *const objv[])
 {
@@ -633,6 +646,44 @@ const char * get_colvarscript_result()
 }
 
 
+extern "C"
+int run_colvarscript_command_binary(int objc, unsigned char *const objv[])
+{
+  colvarscript *script = colvarscript_obj();
+  if (!script) {
+    cvm::error("Called run_colvarscript_command_binary without a script "
+               "object.\n", COLVARS_BUG_ERROR);
+    return -1;
+  }
+  script->set_binary_result_mode(true);
+  int const retval = script->run(objc, objv);
+  script->set_binary_result_mode(false);
+  return retval;
+}
+
+
+extern "C"
+int get_colvarscript_result_binary(void const **data, int *type, int *ndim,
+                                   size_t *shape)
+{
+  colvarscript *script = colvarscript_obj();
+  if (!script) {
+    cvm::error("Called get_colvarscript_result_binary without a script "
+               "object.\n");
+    return -1;
+  }
+  if (data) *data = script->binary_result_data();
+  if (type) *type = script->binary_result_type();
+  if (ndim) *ndim = script->binary_result_ndim();
+  if (shape) {
+    shape[0] = script->binary_result_shape()[0];
+    shape[1] = script->binary_result_shape()[1];
+  }
+  return (script->binary_result_data() != NULL) ? COLVARSCRIPT_OK :
+    COLVARSCRIPT_ERROR;
+}
+
+
 #if defined(COLVARS_TCL)
 
 #if defined(VMDTCL)
@@ -864,54 +915,139 @@ int colvarscript::set_result_text(std::vector<colvarvalue> const &x,
 }
 
 
-// Member functions to set script results for each typexc
+// Binary results
+
+int colvarscript::set_result_binary_view(void const *data, int type,
+                                         size_t n0, size_t n1)
+{
+  bin_result_data_ = data;
+  bin_result_type_ = type;
+  bin_result_ndim_ = (n1 > 0) ? 2 : 1;
+  bin_result_shape_[0] = n0;
+  bin_result_shape_[1] = n1;
+  if (n0 == 0) {
+    // Empty vectors do not guarantee a valid data pointer
+    static cvm::real const dummy = 0.0;
+    bin_result_data_ = &dummy;
+  }
+  return COLVARS_OK;
+}
+
+
+int colvarscript::set_result_binary_real(cvm::real const *data,
+                                         size_t n0, size_t n1)
+{
+  size_t const n = (n1 > 0) ? n0 * n1 : n0;
+  bin_result_real_buffer_.assign(data, data + n);
+  return set_result_binary_view(n > 0 ? &(bin_result_real_buffer_[0]) : NULL,
+                                COLVARSCRIPT_RESULT_REAL, n0, n1);
+}
+
+
+// Member functions to set script results for each type
 
 int colvarscript::set_result_int(int const &x, unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    bin_result_int_buffer_.assign(1, x);
+    return set_result_binary_view(&(bin_result_int_buffer_[0]),
+                                  COLVARSCRIPT_RESULT_INT, 1);
+  }
   return set_result_text<int>(x, obj);
 }
 
 int colvarscript::set_result_int_vec(std::vector<int> const &x,
                                      unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    return set_result_binary_view(x.size() ? &(x[0]) : NULL,
+                                  COLVARSCRIPT_RESULT_INT, x.size());
+  }
   return set_result_text< std::vector<int> >(x, obj);
 }
 
 
 int colvarscript::set_result_long_int(long int const &x, unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    bin_result_long_int_buffer_.assign(1, x);
+    return set_result_binary_view(&(bin_result_long_int_buffer_[0]),
+                                  COLVARSCRIPT_RESULT_LONG_INT, 1);
+  }
   return set_result_text<long int>(x, obj);
 }
 
 int colvarscript::set_result_long_int_vec(std::vector<long int> const &x,
                                           unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    return set_result_binary_view(x.size() ? &(x[0]) : NULL,
+                                  COLVARSCRIPT_RESULT_LONG_INT, x.size());
+  }
   return set_result_text< std::vector<long int> >(x, obj);
 }
 
 
 int colvarscript::set_result_real(cvm::real const &x, unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    return set_result_binary_real(&x, 1);
+  }
   return set_result_text<cvm::real>(x, obj);
 }
 
 int colvarscript::set_result_real_vec(std::vector<cvm::real> const &x,
                                       unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    return set_result_binary_view(x.size() ? &(x[0]) : NULL,
+                                  COLVARSCRIPT_RESULT_REAL, x.size());
+  }
   return set_result_text< std::vector<cvm::real> >(x, obj);
 }
 
 
 int colvarscript::set_result_rvector(cvm::rvector const &x, unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    return set_result_binary_real(&(x.x), 3);
+  }
   return set_result_text<cvm::rvector>(x, obj);
 }
 
 int colvarscript::set_result_rvector_vec(std::vector<cvm::rvector> const &x,
                                          unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    // rvector objects are stored as three contiguous reals
+    return set_result_binary_view(x.size() ? &(x[0].x) : NULL,
+                                  COLVARSCRIPT_RESULT_REAL, x.size(), 3);
+  }
   return set_result_text< std::vector<cvm::rvector> >(x, obj);
 }
 
 
 int colvarscript::set_result_colvarvalue(colvarvalue const &x,
                                          unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    cvm::vector1d<cvm::real> v = x.as_vector();
+    return set_result_binary_real(v.c_array(), v.size());
+  }
   return set_result_text<colvarvalue>(x, obj);
 }
 
 int colvarscript::set_result_colvarvalue_vec(std::vector<colvarvalue> const &x,
                                              unsigned char *obj) {
+  if (binary_result_mode() && !obj) {
+    // Flatten all values into a (n, size) array
+    size_t const n = x.size();
+    size_t const m = (n > 0) ? x[0].size() : 0;
+    bin_result_real_buffer_.resize(n * m);
+    for (size_t i = 0; i < n; i++) {
+      if (x[i].size() != m) {
+        // Values of heterogeneous sizes are only returned as text
+        clear_binary_result();
+        return set_result_text< std::vector<colvarvalue> >(x, obj);
+      }
+      cvm::vector1d<cvm::real> const v = x[i].as_vector();
+      for (size_t j = 0; j < m; j++) {
+        bin_result_real_buffer_[i*m+j] = v[j];
+      }
+    }
+    return set_result_binary_view(n*m > 0 ? &(bin_result_real_buffer_[0]) :
+                                  NULL, COLVARSCRIPT_RESULT_REAL, n, m);
+  }
   return set_result_text< std::vector<colvarvalue> >(x, obj);
 }
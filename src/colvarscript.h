@@ -24,6 +24,12 @@
 #define COLVARSCRIPT_ERROR -1
 #define COLVARSCRIPT_OK 0
 
+// Data types of binary results (see colvarscript::binary_result_type())
+#define COLVARSCRIPT_RESULT_NONE 0
+#define COLVARSCRIPT_RESULT_INT 1
+#define COLVARSCRIPT_RESULT_LONG_INT 2
+#define COLVARSCRIPT_RESULT_REAL 3
+
 
 class colvarscript  {
 
@@ -66,6 +72,48 @@ public:
   /// Clear the string result
   int clear_str_result();
 
+  /// Whether array-valued results are returned in binary form, instead of
+  /// being formatted as text
+  inline bool binary_result_mode() const
+  {
+    return binary_result_mode_;
+  }
+
+  /// Enable or disable binary results for the following script calls
+  inline void set_binary_result_mode(bool flag)
+  {
+    binary_result_mode_ = flag;
+  }
+
+  /// \brief Pointer to the binary result of the current scripting call, or
+  /// NULL if the result is only available as text; the data are valid until
+  /// the next call, and may point directly to internal arrays (no copy)
+  inline void const *binary_result_data() const
+  {
+    return bin_result_data_;
+  }
+
+  /// Data type of the binary result (one of COLVARSCRIPT_RESULT_*)
+  inline int binary_result_type() const
+  {
+    return bin_result_type_;
+  }
+
+  /// Number of dimensions of the binary result (1 or 2, 0 if none)
+  inline int binary_result_ndim() const
+  {
+    return bin_result_ndim_;
+  }
+
+  /// Sizes of the binary result along each dimension (row-major order)
+  inline size_t const *binary_result_shape() const
+  {
+    return bin_result_shape_;
+  }
+
+  /// Clear the binary result
+  int clear_binary_result();
+
   /// Add the given string to the error message of the script interface
   void add_error_msg(std::string const &s);
 
@@ -206,6 +254,9 @@ public:
   // Output functions - convert internal objects to representations suitable
   // for use in the scripting language.  At the moment only conversion to C
   // strings is supported, and obj is assumed to be a char * pointer.
+  // In binary result mode and when obj is NULL, the vector versions store a
+  // view of x (no copy is made, and x must outlive the current result); the
+  // other versions copy x into an internal buffer.
 
   /// Copy x into obj if not NULL, or into the script object's result otherwise
   int set_result_int(int const &x, unsigned char *obj = NULL);
@@ -309,6 +360,37 @@ private: // TODO
   /// Code reused by all instances of set_result_text()
   int set_result_text_from_str(std::string const &x_str, unsigned char *obj);
 
+  /// Point the binary result to the given array with shape (n0) or (n0, n1)
+  int set_result_binary_view(void const *data, int type,
+                             size_t n0, size_t n1 = 0);
+
+  /// Copy a real-valued array into the binary result buffer
+  int set_result_binary_real(cvm::real const *data, size_t n0, size_t n1 = 0);
+
+  /// Whether the next result with a NULL output object should be binary
+  bool binary_result_mode_;
+
+  /// Pointer to the binary result (internal array or one of the buffers)
+  void const *bin_result_data_;
+
+  /// Data type of the binary result
+  int bin_result_type_;
+
+  /// Number of dimensions of the binary result
+  int bin_result_ndim_;
+
+  /// Shape of the binary result
+  size_t bin_result_shape_[2];
+
+  /// Buffer for binary long integer results that are not stored elsewhere
+  std::vector<long int> bin_result_long_int_buffer_;
+
+  /// Buffer for binary integer results that are not stored elsewhere
+  std::vector<int> bin_result_int_buffer_;
+
+  /// Buffer for binary real results that are not stored elsewhere
+  std::vector<cvm::real> bin_result_real_buffer_;
+
 
 };
 
@@ -441,6 +523,17 @@ extern "C" {
   /// Get the string result of a script call
   const char * get_colvarscript_result();
 
+  /// Same as run_colvarscript_command(), but array-valued results are stored
+  /// in binary form and retrieved with get_colvarscript_result_binary()
+  int run_colvarscript_command_binary(int objc, unsigned char *const objv[]);
+
+  /// \brief Get the binary result of the last script call: data points to
+  /// row-major array of the given type (COLVARSCRIPT_RESULT_*), with ndim
+  /// dimensions whose sizes are written into shape (at least 2 elements);
+  /// data is set to NULL if the result is only available as text
+  int get_colvarscript_result_binary(void const **data, int *type, int *ndim,
+                                     size_t *shape);
+
 }
 
 
@@ -238,11 +238,7 @@ CVSCRIPT(cv_resetatomappliedforces,
          "Reset forces applied by Colvars to atoms",
          0, 0,
          "",
-            size_t i;
-            std::vector<cvm::rvector> *f = script->proxy()->modify_atom_applied_forces();
-            for (i = 0; i < f->size(); i++) {
-              (*f)[i].reset();
-            }
+            script->proxy()->reset_atoms_applied_forces();
             return COLVARS_OK;
          )
 
@@ -477,6 +473,29 @@ CVSCRIPT(cv_printframelabels,
          return COLVARS_OK;
          )
 
+CVSCRIPT(cv_profile,
+         "Get the time spent by each colvar component, bias and output operation, or control the profiler\n"
+         "report : string - Timings of each object and operation, most costly first",
+         0, 1,
+         "action : string - \"on\" or \"off\" to enable or disable profiling, \"reset\" to clear the timings",
+         char const *argstr =
+           script->obj_to_str(script->get_module_cmd_arg(0, objc, objv));
+         if (argstr) {
+           std::string const action(argstr);
+           if (action == "on") {
+             return script->module()->set_profiling(true);
+           } else if (action == "off") {
+             return script->module()->set_profiling(false);
+           } else if (action == "reset") {
+             return script->module()->reset_profile();
+           }
+           script->add_error_msg("Unknown action \""+action+"\"");
+           return COLVARSCRIPT_ERROR;
+         }
+         script->set_result_str(script->module()->profile_report());
+         return COLVARS_OK;
+         )
+
 CVSCRIPT(cv_reset,
          "Delete all internal configuration",
          0, 0,
@@ -145,10 +145,20 @@ public:
     }
   }
 
+  /// Add a*v to this vector, without temporary copies
+  inline void add_scaled(vector1d<T> const &v, cvm::real a)
+  {
+    check_sizes(*this, v);
+    size_t i;
+    for (i = 0; i < this->size(); i++) {
+      (*this)[i] += a * v[i];
+    }
+  }
+
   inline friend vector1d<T> operator + (vector1d<T> const &v1,
                                         vector1d<T> const &v2)
   {
-    check_sizes(v1.size(), v2.size());
+    check_sizes(v1, v2);
     vector1d<T> result(v1.size());
     size_t i;
     for (i = 0; i < v1.size(); i++) {
@@ -160,7 +170,7 @@ public:
   inline friend vector1d<T> operator - (vector1d<T> const &v1,
                                         vector1d<T> const &v2)
   {
-    check_sizes(v1.size(), v2.size());
+    check_sizes(v1, v2);
     vector1d<T> result(v1.size());
     size_t i;
     for (i = 0; i < v1.size(); i++) {
@@ -197,7 +207,7 @@ public:
   /// Inner product
   inline friend T operator * (vector1d<T> const &v1, vector1d<T> const &v2)
   {
-    check_sizes(v1.size(), v2.size());
+    check_sizes(v1, v2);
     T prod(0.0);
     size_t i;
     for (i = 0; i < v1.size(); i++) {
@@ -222,6 +232,18 @@ public:
     return cvm::sqrt(this->norm2());
   }
 
+  /// Squared distance from v, without temporary copies
+  inline cvm::real dist2(vector1d<T> const &v) const
+  {
+    check_sizes(*this, v);
+    cvm::real result = 0.0;
+    size_t i;
+    for (i = 0; i < this->size(); i++) {
+      result += ((*this)[i] - v[i]) * ((*this)[i] - v[i]);
+    }
+    return result;
+  }
+
   inline cvm::real sum() const
   {
     cvm::real result = 0.0;
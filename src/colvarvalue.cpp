@@ -240,14 +240,22 @@ void colvarvalue::apply_constraints()
     break;
   case colvarvalue::type_vector:
     if (elem_types.size() > 0) {
-      // if we have information about non-scalar types, use it
+      // if we have information about non-scalar types, use it: only unit
+      // vectors and quaternions are constrained, normalize them in place
       size_t i;
       for (i = 0; i < elem_types.size(); i++) {
-        if (elem_sizes[i] == 1) continue; // TODO this can be optimized further
-        colvarvalue cvtmp(vector1d_value.slice(elem_indices[i],
-                                               elem_indices[i] + elem_sizes[i]), elem_types[i]);
-        cvtmp.apply_constraints();
-        set_elem(i, cvtmp);
+        if ((elem_types[i] != type_unit3vector) &&
+            (elem_types[i] != type_quaternion)) continue;
+        cvm::real *v = &(vector1d_value[elem_indices[i]]);
+        cvm::real norm2 = 0.0;
+        int j;
+        for (j = 0; j < elem_sizes[i]; j++) {
+          norm2 += v[j] * v[j];
+        }
+        cvm::real const norm = cvm::sqrt(norm2);
+        for (j = 0; j < elem_sizes[i]; j++) {
+          v[j] /= norm;
+        }
       }
     }
     break;
@@ -468,7 +476,11 @@ colvarvalue operator + (colvarvalue const &x1,
   case colvarvalue::type_quaternionderiv:
     return colvarvalue(x1.quaternion_value + x2.quaternion_value);
   case colvarvalue::type_vector:
-    return colvarvalue(x1.vector1d_value + x2.vector1d_value, colvarvalue::type_vector);
+    {
+      colvarvalue result(x1.vector1d_value, colvarvalue::type_vector);
+      result.vector1d_value += x2.vector1d_value;
+      return result;
+    }
   case colvarvalue::type_notset:
   default:
     x1.undef_op();
@@ -495,7 +507,11 @@ colvarvalue operator - (colvarvalue const &x1,
   case colvarvalue::type_quaternionderiv:
     return colvarvalue(x1.quaternion_value - x2.quaternion_value);
   case colvarvalue::type_vector:
-    return colvarvalue(x1.vector1d_value - x2.vector1d_value, colvarvalue::type_vector);
+    {
+      colvarvalue result(x1.vector1d_value, colvarvalue::type_vector);
+      result.vector1d_value -= x2.vector1d_value;
+      return result;
+    }
   case colvarvalue::type_notset:
   default:
     x1.undef_op();
@@ -522,7 +538,11 @@ colvarvalue operator * (cvm::real const &a,
   case colvarvalue::type_quaternionderiv:
     return colvarvalue(a * x.quaternion_value);
   case colvarvalue::type_vector:
-    return colvarvalue(x.vector1d_value * a, colvarvalue::type_vector);
+    {
+      colvarvalue result(x.vector1d_value, colvarvalue::type_vector);
+      result.vector1d_value *= a;
+      return result;
+    }
   case colvarvalue::type_notset:
   default:
     x.undef_op();
@@ -554,7 +574,11 @@ colvarvalue operator / (colvarvalue const &x,
   case colvarvalue::type_quaternionderiv:
     return colvarvalue(x.quaternion_value / a);
   case colvarvalue::type_vector:
-    return colvarvalue(x.vector1d_value / a, colvarvalue::type_vector);
+    {
+      colvarvalue result(x.vector1d_value, colvarvalue::type_vector);
+      result.vector1d_value /= a;
+      return result;
+    }
   case colvarvalue::type_notset:
   default:
     x.undef_op();
@@ -613,8 +637,11 @@ colvarvalue colvarvalue::dist2_grad(colvarvalue const &x2) const
   case colvarvalue::type_quaternionderiv:
     return this->quaternion_value.dist2_grad(x2.quaternion_value);
   case colvarvalue::type_vector:
-    return colvarvalue(2.0 * (this->vector1d_value - x2.vector1d_value), colvarvalue::type_vector);
-    break;
+    {
+      colvarvalue result(colvarvalue::type_vector);
+      dist2_grad(x2, result);
+      return result;
+    }
   case colvarvalue::type_notset:
   default:
     this->undef_op();
@@ -623,6 +650,22 @@ colvarvalue colvarvalue::dist2_grad(colvarvalue const &x2) const
 }
 
 
+void colvarvalue::dist2_grad(colvarvalue const &x2, colvarvalue &grad) const
+{
+  if (this->value_type == colvarvalue::type_vector) {
+    colvarvalue::check_types(*this, x2);
+    grad.type(*this);
+    size_t i;
+    for (i = 0; i < vector1d_value.size(); i++) {
+      grad.vector1d_value[i] = 2.0 * (vector1d_value[i] - x2.vector1d_value[i]);
+    }
+  } else {
+    // Other types have no dynamically allocated storage
+    grad = dist2_grad(x2);
+  }
+}
+
+
 /// Return the midpoint between x1 and x2, optionally weighted by lambda
 /// (which must be between 0.0 and 1.0)
 colvarvalue const colvarvalue::interpolate(colvarvalue const &x1,
@@ -187,6 +187,10 @@ public:
   /// Derivative with respect to this \link colvarvalue \endlink of the square distance
   colvarvalue dist2_grad(colvarvalue const &x2) const;
 
+  /// \brief Same as dist2_grad(x2), but stores the result in grad, whose
+  /// storage is reused for vector types
+  void dist2_grad(colvarvalue const &x2, colvarvalue &grad) const;
+
   /// Return the midpoint between x1 and x2, optionally weighted by lambda
   /// (which must be between 0.0 and 1.0)
   static colvarvalue const interpolate(colvarvalue const &x1,
@@ -201,6 +205,9 @@ public:
   void operator *= (cvm::real const &a);
   void operator /= (cvm::real const &a);
 
+  /// Add a*x to this value, without creating temporary copies
+  void add_scaled(colvarvalue const &x, cvm::real a);
+
   // Binary operators (return values)
   friend colvarvalue operator + (colvarvalue const &x1, colvarvalue const &x2);
   friend colvarvalue operator - (colvarvalue const &x1, colvarvalue const &x2);
@@ -624,6 +631,33 @@ inline void colvarvalue::operator /= (cvm::real const &a)
 }
 
 
+inline void colvarvalue::add_scaled(colvarvalue const &x, cvm::real a)
+{
+  colvarvalue::check_types(*this, x);
+
+  switch (value_type) {
+  case colvarvalue::type_scalar:
+    real_value += a * x.real_value;
+    break;
+  case colvarvalue::type_3vector:
+  case colvarvalue::type_unit3vector:
+  case colvarvalue::type_unit3vectorderiv:
+    rvector_value += a * x.rvector_value;
+    break;
+  case colvarvalue::type_quaternion:
+  case colvarvalue::type_quaternionderiv:
+    quaternion_value += a * x.quaternion_value;
+    break;
+  case colvarvalue::type_vector:
+    vector1d_value.add_scaled(x.vector1d_value, a);
+    break;
+  case colvarvalue::type_notset:
+  default:
+    undef_op();
+  }
+}
+
+
 inline cvm::vector1d<cvm::real> const colvarvalue::as_vector() const
 {
   switch (value_type) {
@@ -662,18 +696,9 @@ inline cvm::real colvarvalue::norm2() const
   case colvarvalue::type_quaternionderiv:
     return (this->quaternion_value).norm2();
   case colvarvalue::type_vector:
-    if (elem_types.size() > 0) {
-      // if we have information about non-scalar types, use it
-      cvm::real result = 0.0;
-      size_t i;
-      for (i = 0; i < elem_types.size(); i++) {
-        result += (this->get_elem(i)).norm2();
-      }
-      return result;
-    } else {
-      return vector1d_value.norm2();
-    }
-    break;
+    // The square norm of each element is the sum of the squares of its
+    // components, also when the elements are not scalars
+    return vector1d_value.norm2();
   case colvarvalue::type_notset:
   default:
     return 0.0;
@@ -723,7 +748,7 @@ inline cvm::real colvarvalue::dist2(colvarvalue const &x2) const
     // object has it implemented internally
     return this->quaternion_value.dist2(x2.quaternion_value);
   case colvarvalue::type_vector:
-    return (this->vector1d_value - x2.vector1d_value).norm2();
+    return (this->vector1d_value).dist2(x2.vector1d_value);
   case colvarvalue::type_notset:
   default:
     this->undef_op();
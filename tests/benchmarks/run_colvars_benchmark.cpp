@@ -0,0 +1,583 @@
+// -*- c++ -*-
+
+// This file is part of the Collective Variables module (Colvars).
+// The original version of Colvars and its updates are located at:
+// https://github.com/Colvars/colvars
+// Please update all Colvars source files before making any changes.
+// If you wish to distribute your changes, please submit them to the
+// Colvars repository at GitHub.
+
+// Micro-benchmarks of Colvars components and biases, driven by the stub
+// proxy over a synthetic periodic system of configurable size
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarscript.h"
+#include "colvarproxy.h"
+
+#include "colvarproxy_stub.h"
+
+
+namespace {
+
+/// Whether allocations are currently being counted
+std::atomic<bool> count_allocations(false);
+
+/// Number of allocations since the counter was last reset
+std::atomic<size_t> num_allocations(0);
+
+}
+
+
+void *operator new(std::size_t size)
+{
+  if (count_allocations) {
+    num_allocations++;
+  }
+  void *p = std::malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void *operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+
+/// Stub proxy that holds a synthetic system in a periodic orthogonal box
+class colvarproxy_benchmark : public colvarproxy_stub {
+
+public:
+
+  colvarproxy_benchmark(std::vector<cvm::atom_pos> const &coords,
+                        cvm::real box_length, bool verbose,
+                        bool per_pair_distances)
+    : system_coords(coords), verbose_log(verbose)
+  {
+    angstrom_value = kcal_mol_value = 1.0;
+    b_simulation_running = true;
+    // Without batched distances, each pair goes through position_distance()
+    // as in engines that compute minimum images themselves
+    batched_cell_distances = !per_pair_distances;
+    boundaries_type = boundaries_pbc_ortho;
+    unit_cell_x = cvm::rvector(box_length, 0.0, 0.0);
+    unit_cell_y = cvm::rvector(0.0, box_length, 0.0);
+    unit_cell_z = cvm::rvector(0.0, 0.0, box_length);
+    update_pbc_lattice();
+  }
+
+  ~colvarproxy_benchmark() override
+  {
+    // Delete the module here, so that its messages still go through log()
+    delete colvars;
+    colvars = NULL;
+  }
+
+  int init_atom(int atom_number) override
+  {
+    // Look up previously requested atoms in constant time, so that the setup
+    // of large groups does not dominate the run
+    int const aid = check_atom_id(atom_number);
+    if (aid < 0) {
+      return COLVARS_INPUT_ERROR;
+    }
+    if (atom_slots.size() != system_coords.size()) {
+      atom_slots.assign(system_coords.size(), -1);
+    }
+    if (atom_slots[aid] >= 0) {
+      atoms_ncopies[atom_slots[aid]] += 1;
+      return atom_slots[aid];
+    }
+    atom_slots[aid] = add_atom_slot(aid);
+    return atom_slots[aid];
+  }
+
+  int check_atom_id(int atom_number) override
+  {
+    if ((atom_number < 1) || (atom_number > int(system_coords.size()))) {
+      return cvm::error("Error: invalid atom number " +
+                        cvm::to_str(atom_number) + ".\n",
+                        COLVARS_INPUT_ERROR);
+    }
+    return atom_number-1;
+  }
+
+  void log(std::string const &message) override
+  {
+    if (verbose_log) {
+      colvarproxy_stub::log(message);
+    }
+  }
+
+  /// Copy the coordinates of the requested atoms into the proxy's arrays
+  void update_positions()
+  {
+    for (size_t i = 0; i < atoms_ids.size(); i++) {
+      atoms_positions[i] = system_coords[atoms_ids[i]];
+    }
+    reset_atoms_applied_forces();
+  }
+
+protected:
+
+  /// Coordinates of all atoms in the system
+  std::vector<cvm::atom_pos> const &system_coords;
+
+  /// Whether to print the log messages of the module
+  bool verbose_log;
+
+  /// Proxy index of each atom of the system (-1 if not requested)
+  std::vector<int> atom_slots;
+};
+
+
+/// Settings of the benchmark run, set from the command line
+struct benchmark_params {
+  size_t num_atoms = 1000;
+  long num_steps = 1000;
+  long num_warmup_steps = 10;
+  bool random_coords = false;
+  unsigned int seed = 1;
+  /// Number density in atoms per cubic Angstrom
+  cvm::real density = 0.05;
+  /// Magnitude of the random displacement applied at each step
+  cvm::real displacement = 0.05;
+  /// Compute minimum-image distances one pair at a time
+  bool per_pair_distances = false;
+  bool verbose = false;
+};
+
+
+/// Synthetic system: coordinates inside a cubic periodic box
+struct synthetic_system {
+
+  std::vector<cvm::atom_pos> coords;
+  cvm::real box_length;
+  std::mt19937 rng;
+
+  explicit synthetic_system(benchmark_params const &params)
+    : rng(params.seed)
+  {
+    box_length = std::cbrt(cvm::real(params.num_atoms) / params.density);
+    std::uniform_real_distribution<cvm::real> uniform(0.0, box_length);
+    size_t const n_side =
+      size_t(std::ceil(std::cbrt(cvm::real(params.num_atoms)) - 1.0e-9));
+    cvm::real const spacing = box_length / cvm::real(n_side);
+    coords.resize(params.num_atoms);
+    for (size_t i = 0; i < params.num_atoms; i++) {
+      if (params.random_coords) {
+        coords[i] = cvm::atom_pos(uniform(rng), uniform(rng), uniform(rng));
+      } else {
+        coords[i] = cvm::atom_pos(spacing * cvm::real(i % n_side),
+                                  spacing * cvm::real((i / n_side) % n_side),
+                                  spacing * cvm::real(i / (n_side * n_side)));
+      }
+    }
+  }
+
+  /// Random displacement of all atoms, wrapped back into the box
+  void move(cvm::real displacement)
+  {
+    std::uniform_real_distribution<cvm::real> uniform(-displacement,
+                                                      displacement);
+    for (size_t i = 0; i < coords.size(); i++) {
+      for (size_t d = 0; d < 3; d++) {
+        cvm::real &x = coords[i][d];
+        x += uniform(rng);
+        x -= box_length * std::floor(x / box_length);
+      }
+    }
+  }
+
+  /// Write the current coordinates, scaled about the box center, to an XYZ file
+  void write_xyz(std::string const &filename, cvm::real scale) const
+  {
+    std::ofstream os(filename.c_str());
+    os << coords.size() << "\n" << "Colvars benchmark\n";
+    os << std::setprecision(10);
+    cvm::atom_pos const center(0.5*box_length, 0.5*box_length, 0.5*box_length);
+    for (size_t i = 0; i < coords.size(); i++) {
+      cvm::atom_pos const x = center + scale * (coords[i] - center);
+      os << "X " << x.x << " " << x.y << " " << x.z << "\n";
+    }
+  }
+};
+
+
+/// Write the weights and biases of a dense layer with deterministic values
+void write_dense_layer(std::string const &prefix, size_t n_in, size_t n_out)
+{
+  std::ofstream wos((prefix + "_weights.txt").c_str());
+  std::ofstream bos((prefix + "_biases.txt").c_str());
+  for (size_t j = 0; j < n_out; j++) {
+    for (size_t i = 0; i < n_in; i++) {
+      wos << (i > 0 ? " " : "") << 0.1 * std::sin(cvm::real(1 + i + 7*j));
+    }
+    wos << "\n";
+    bos << 0.05 * std::cos(cvm::real(1 + j)) << "\n";
+  }
+}
+
+
+/// Range of atom numbers (1-based, inclusive) as a selection keyword
+std::string atom_range(size_t first, size_t last)
+{
+  return "atomNumbersRange " + cvm::to_str(first) + "-" + cvm::to_str(last);
+}
+
+
+/// Scalar colvar shared by the bias benchmarks: distance between the
+/// centers of the two halves of the system
+std::string distance_colvar(benchmark_params const &params, cvm::real box_length)
+{
+  size_t const half = params.num_atoms / 2;
+  return
+    "colvar {\n"
+    "  name d\n"
+    "  width 0.1\n"
+    "  lowerBoundary 0.0\n"
+    "  upperBoundary " + cvm::to_str(box_length) + "\n"
+    "  distance {\n"
+    "    group1 { " + atom_range(1, half) + " }\n"
+    "    group2 { " + atom_range(half+1, params.num_atoms) + " }\n"
+    "  }\n"
+    "}\n";
+}
+
+
+/// Names of the available benchmarks
+std::vector<std::string> const &benchmark_names()
+{
+  static std::vector<std::string> const names = {
+    "coordNum", "rmsd", "gspath", "neuralNetwork",
+    "metadynamics", "abf", "histogram"
+  };
+  return names;
+}
+
+
+/// Build the configuration of the named benchmark, writing any input files
+/// that it needs; returns an empty string if the name is unknown
+std::string benchmark_config(std::string const &name,
+                             benchmark_params const &params,
+                             synthetic_system const &system)
+{
+  size_t const n = params.num_atoms;
+  size_t const half = n / 2;
+
+  if (name == "coordNum") {
+    size_t const n1 = (n / 10 > 0) ? n / 10 : 1;
+    return
+      "colvar {\n"
+      "  name cn\n"
+      "  coordNum {\n"
+      "    cutoff 6.0\n"
+      "    group1 { " + atom_range(1, n1) + " }\n"
+      "    group2 { " + atom_range(n1+1, n) + " }\n"
+      "  }\n"
+      "}\n"
+      "harmonic {\n"
+      "  colvars cn\n"
+      "  centers 0.0\n"
+      "  forceConstant 0.001\n"
+      "}\n";
+  }
+
+  if (name == "rmsd") {
+    system.write_xyz("benchmark_ref.xyz", 1.0);
+    return
+      "colvar {\n"
+      "  name rmsd\n"
+      "  rmsd {\n"
+      "    atoms { " + atom_range(1, n) + " }\n"
+      "    refPositionsFile benchmark_ref.xyz\n"
+      "  }\n"
+      "}\n"
+      "harmonic {\n"
+      "  colvars rmsd\n"
+      "  centers 0.0\n"
+      "  forceConstant 1.0\n"
+      "}\n";
+  }
+
+  if (name == "gspath") {
+    size_t const num_frames = 4;
+    std::string frames;
+    for (size_t k = 0; k < num_frames; k++) {
+      std::string const file_name =
+        "benchmark_frame_" + cvm::to_str(k+1) + ".xyz";
+      system.write_xyz(file_name, 1.0 + 0.02 * cvm::real(k));
+      frames += "    refPositionsFile" + cvm::to_str(k+1) + " " + file_name + "\n";
+    }
+    return
+      "colvar {\n"
+      "  name s\n"
+      "  gspath {\n"
+      "    atoms { " + atom_range(1, n) + " }\n" + frames +
+      "  }\n"
+      "}\n"
+      "harmonic {\n"
+      "  colvars s\n"
+      "  centers 0.5\n"
+      "  forceConstant 1.0\n"
+      "}\n";
+  }
+
+  if (name == "neuralNetwork") {
+    size_t const hidden = 16;
+    write_dense_layer("benchmark_layer1", 2, hidden);
+    write_dense_layer("benchmark_layer2", hidden, 1);
+    size_t const quarter = (n / 4 > 0) ? n / 4 : 1;
+    return
+      "colvar {\n"
+      "  name nn\n"
+      "  neuralNetwork {\n"
+      "    output_component 0\n"
+      "    layer1_WeightsFile benchmark_layer1_weights.txt\n"
+      "    layer1_BiasesFile benchmark_layer1_biases.txt\n"
+      "    layer1_activation tanh\n"
+      "    layer2_WeightsFile benchmark_layer2_weights.txt\n"
+      "    layer2_BiasesFile benchmark_layer2_biases.txt\n"
+      "    layer2_activation linear\n"
+      "    distance {\n"
+      "      name 001\n"
+      "      group1 { " + atom_range(1, quarter) + " }\n"
+      "      group2 { " + atom_range(quarter+1, half) + " }\n"
+      "    }\n"
+      "    distance {\n"
+      "      name 002\n"
+      "      group1 { " + atom_range(half+1, half+quarter) + " }\n"
+      "      group2 { " + atom_range(half+quarter+1, n) + " }\n"
+      "    }\n"
+      "  }\n"
+      "}\n"
+      "harmonic {\n"
+      "  colvars nn\n"
+      "  centers 0.0\n"
+      "  forceConstant 1.0\n"
+      "}\n";
+  }
+
+  if (name == "metadynamics") {
+    return distance_colvar(params, system.box_length) +
+      "metadynamics {\n"
+      "  colvars d\n"
+      "  hillWeight 0.001\n"
+      "  hillWidth 1.0\n"
+      "  newHillFrequency 10\n"
+      "}\n";
+  }
+
+  if (name == "abf") {
+    return distance_colvar(params, system.box_length) +
+      "abf {\n"
+      "  colvars d\n"
+      "  fullSamples 10\n"
+      "}\n";
+  }
+
+  if (name == "histogram") {
+    return distance_colvar(params, system.box_length) +
+      "histogram {\n"
+      "  colvars d\n"
+      "}\n";
+  }
+
+  return "";
+}
+
+
+/// Result of one benchmark
+struct benchmark_result {
+  double ns_per_step;
+  double allocs_per_step;
+};
+
+
+int run_benchmark(std::string const &name, benchmark_params const &params,
+                  benchmark_result &result)
+{
+  synthetic_system system(params);
+  std::string const config = benchmark_config(name, params, system);
+  if (config.empty()) {
+    std::cerr << "Error: unknown benchmark \"" << name << "\".\n";
+    return COLVARS_INPUT_ERROR;
+  }
+
+  // The stub proxy prints its initialization messages to standard output:
+  // hide them unless requested
+  std::streambuf *cout_buf = std::cout.rdbuf();
+  std::ostringstream init_log;
+  if (!params.verbose) {
+    std::cout.rdbuf(init_log.rdbuf());
+  }
+  colvarproxy_benchmark *proxy =
+    new colvarproxy_benchmark(system.coords, system.box_length, params.verbose,
+                              params.per_pair_distances);
+  std::cout.rdbuf(cout_buf);
+
+  int error_code = proxy->colvars->read_config_string(config);
+
+  double total_ns = 0.0;
+  size_t total_allocations = 0;
+
+  for (long step = 0; (step < params.num_warmup_steps + params.num_steps) &&
+         (error_code == COLVARS_OK); step++) {
+
+    bool const timed = (step >= params.num_warmup_steps);
+    colvarmodule::it = step;
+    system.move(params.displacement);
+    proxy->update_positions();
+
+    num_allocations = 0;
+    count_allocations = timed;
+    auto const t_start = std::chrono::steady_clock::now();
+
+    error_code |= proxy->colvars->calc();
+
+    auto const t_end = std::chrono::steady_clock::now();
+    count_allocations = false;
+
+    if (timed) {
+      total_ns += std::chrono::duration<double, std::nano>(t_end - t_start).count();
+      total_allocations += num_allocations;
+    }
+  }
+
+  delete proxy;
+
+  if (error_code != COLVARS_OK) {
+    std::cerr << "Error: benchmark \"" << name << "\" failed.\n";
+    return error_code;
+  }
+
+  double const n_steps = double(params.num_steps > 0 ? params.num_steps : 1);
+  result.ns_per_step = total_ns / n_steps;
+  result.allocs_per_step = double(total_allocations) / n_steps;
+  return COLVARS_OK;
+}
+
+
+void print_usage(char const *program)
+{
+  std::cerr << "Usage: " << program << " [options] [benchmark ...]\n"
+            << "\n"
+            << "Options:\n"
+            << "  --atoms N      Number of atoms in the system (default: 1000)\n"
+            << "  --steps N      Number of timed steps (default: 1000)\n"
+            << "  --warmup N     Number of untimed steps before those (default: 10)\n"
+            << "  --random       Random initial coordinates (default: cubic lattice)\n"
+            << "  --seed N       Seed of the random number generator (default: 1)\n"
+            << "  --density X    Number density, atoms/A^3 (default: 0.05)\n"
+            << "  --per-pair-distances\n"
+            << "                 Compute minimum-image distances one pair at a\n"
+            << "                 time, as without batched distances\n"
+            << "  --verbose      Print the messages of the Colvars module\n"
+            << "  --list         List the available benchmarks\n"
+            << "\n"
+            << "Without arguments, all benchmarks are run.  Results are printed\n"
+            << "to standard output, one line per benchmark.\n";
+}
+
+
+extern "C" int main(int argc, char *argv[])
+{
+  benchmark_params params;
+  std::vector<std::string> names;
+
+  for (int i = 1; i < argc; i++) {
+    std::string const arg(argv[i]);
+    bool const has_value = (i+1 < argc);
+    if ((arg == "--atoms") && has_value) {
+      params.num_atoms = std::strtoul(argv[++i], NULL, 10);
+    } else if ((arg == "--steps") && has_value) {
+      params.num_steps = std::strtol(argv[++i], NULL, 10);
+    } else if ((arg == "--warmup") && has_value) {
+      params.num_warmup_steps = std::strtol(argv[++i], NULL, 10);
+    } else if ((arg == "--seed") && has_value) {
+      params.seed = std::strtoul(argv[++i], NULL, 10);
+    } else if ((arg == "--density") && has_value) {
+      params.density = std::strtod(argv[++i], NULL);
+    } else if (arg == "--per-pair-distances") {
+      params.per_pair_distances = true;
+    } else if (arg == "--random") {
+      params.random_coords = true;
+    } else if (arg == "--verbose") {
+      params.verbose = true;
+    } else if (arg == "--list") {
+      for (auto const &name : benchmark_names()) {
+        std::cout << name << "\n";
+      }
+      return 0;
+    } else if ((arg.size() > 0) && (arg[0] == '-')) {
+      print_usage(argv[0]);
+      return 1;
+    } else {
+      names.push_back(arg);
+    }
+  }
+
+  if ((params.num_atoms < 4) || (params.num_steps < 1) ||
+      (params.density <= 0.0)) {
+    std::cerr << "Error: at least 4 atoms, 1 step and a positive density "
+              << "are required.\n";
+    return 1;
+  }
+
+  if (names.empty()) {
+    names = benchmark_names();
+  }
+
+  int error_code = 0;
+
+  std::cout << "# benchmark natoms steps ns_per_step allocs_per_step\n";
+  for (auto const &name : names) {
+    benchmark_result result;
+    if (run_benchmark(name, params, result) != COLVARS_OK) {
+      error_code = 1;
+      continue;
+    }
+    std::cout << name << " " << params.num_atoms << " " << params.num_steps
+              << " " << std::fixed << std::setprecision(1)
+              << result.ns_per_step << " " << std::setprecision(2)
+              << result.allocs_per_step << "\n";
+    std::cout.unsetf(std::ios::floatfield);
+  }
+
+  return error_code;
+}
@@ -23,6 +23,8 @@ colvarproxy_stub::colvarproxy_stub()
   // both fields are taken from data structures already available
   updated_masses_ = updated_charges_ = true;
 
+  batched_cell_distances = true;
+
   colvars = new colvarmodule(this);
   cvm::log("Using minimal testing interface.\n");
 
@@ -75,14 +77,25 @@ int colvarproxy_stub::set_unit_system(std::string const &units_in,
 }
 
 
+void colvarproxy_stub::count_message()
+{
+  num_messages++;
+  if (std::this_thread::get_id() != main_thread_id) {
+    num_messages_other_threads++;
+  }
+}
+
+
 void colvarproxy_stub::log(std::string const &message)
 {
+  count_message();
   std::cout << "colvars: " << message;
 }
 
 
 void colvarproxy_stub::error(std::string const &message)
 {
+  count_message();
   add_error_msg(message);
   std::cerr << "colvars: " << message;
 }
@@ -119,3 +132,197 @@ int colvarproxy_stub::init_atom(int atom_number)
   return index;
 }
 
+
+void colvarproxy_stub::get_atoms_positions(std::vector<int> const &indices,
+                                           cvm::atom_pos *pos) const
+{
+  // Positions are stored in the proxy's own array: copy them in one pass
+  cvm::rvector const *positions = atoms_positions.data();
+  int const *idx = indices.data();
+  size_t const n = indices.size();
+  for (size_t i = 0; i < n; i++) {
+    pos[i] = positions[idx[i]];
+  }
+}
+
+
+void colvarproxy_stub::apply_atoms_forces(std::vector<int> const &indices,
+                                          cvm::rvector const *new_forces)
+{
+  cvm::rvector *forces = atoms_new_colvar_forces.data();
+  int const *idx = indices.data();
+  size_t const n = indices.size();
+  for (size_t i = 0; i < n; i++) {
+    forces[idx[i]] += new_forces[i];
+    flag_atom_applied_force(idx[i], new_forces[i]);
+  }
+}
+
+
+int colvarproxy_stub::scalable_group_coms()
+{
+  return b_scalable_groups ? COLVARS_OK : COLVARS_NOT_IMPLEMENTED;
+}
+
+
+int colvarproxy_stub::scalable_group_reductions()
+{
+  return b_scalable_groups ? COLVARS_OK : COLVARS_NOT_IMPLEMENTED;
+}
+
+
+void colvarproxy_stub::set_scalable_groups(bool yesno)
+{
+  b_scalable_groups = yesno;
+}
+
+
+int colvarproxy_stub::init_atom_group(std::vector<int> const &atoms_ids)
+{
+  if (!b_scalable_groups) {
+    return colvarproxy::init_atom_group(atoms_ids);
+  }
+
+  std::vector<int> slots;
+  slots.reserve(atoms_ids.size());
+  for (size_t i = 0; i < atoms_ids.size(); i++) {
+    int const slot = init_atom(atoms_ids[i] + 1);
+    if (slot < 0) {
+      return slot;
+    }
+    slots.push_back(slot);
+  }
+
+  int const index = add_atom_group_slot(atom_groups_ids.size());
+  atom_groups_slots.push_back(slots);
+  compute_atom_groups_properties();
+  return index;
+}
+
+
+int colvarproxy_stub::calc_step(bool async,
+                                std::vector<cvm::rvector> &total_forces)
+{
+  int error_code = COLVARS_OK;
+  reset_atoms_applied_forces();
+  if (async) {
+    error_code |= colvars->calc_async_start();
+  } else {
+    error_code |= colvars->calc();
+  }
+
+  // Only reads the positions, and can overlap with the Colvars calculation
+  total_forces.assign(atoms_positions.size(), cvm::rvector(0.0, 0.0, 0.0));
+  for (size_t i = 0; i + 1 < atoms_positions.size(); i++) {
+    cvm::rvector const f = atoms_positions[i+1] - atoms_positions[i];
+    total_forces[i] += f;
+    total_forces[i+1] -= f;
+  }
+
+  if (async) {
+    error_code |= colvars->calc_async_wait();
+  }
+  for (size_t i = 0; i < total_forces.size(); i++) {
+    total_forces[i] += atoms_new_colvar_forces[i];
+  }
+  return error_code;
+}
+
+
+void colvarproxy_stub::load_group_atoms(int group_index, int weight)
+{
+  std::vector<int> const &slots = atom_groups_slots[group_index];
+  group_positions.resize(slots.size());
+  group_weights.resize(slots.size());
+  for (size_t i = 0; i < slots.size(); i++) {
+    group_positions[i] = atoms_positions[slots[i]];
+    group_weights[i] =
+      (weight == reduction_weight_mass) ? atoms_masses[slots[i]] : 1.0;
+  }
+}
+
+
+void colvarproxy_stub::compute_atom_groups_properties()
+{
+  for (size_t ig = 0; ig < atom_groups_slots.size(); ig++) {
+    std::vector<int> const &slots = atom_groups_slots[ig];
+    cvm::real mass = 0.0, charge = 0.0;
+    cvm::rvector mr(0.0);
+    for (size_t i = 0; i < slots.size(); i++) {
+      mass += atoms_masses[slots[i]];
+      charge += atoms_charges[slots[i]];
+      mr += atoms_masses[slots[i]] * atoms_positions[slots[i]];
+    }
+    atom_groups_masses[ig] = mass;
+    atom_groups_charges[ig] = charge;
+    atom_groups_coms[ig] = (mass > 0.0) ? mr / mass : cvm::rvector(0.0);
+  }
+}
+
+
+int colvarproxy_stub::compute_atom_groups()
+{
+  compute_atom_groups_properties();
+
+  for (size_t k = 0; k < atom_groups_reductions_groups.size(); k++) {
+    int const type = atom_groups_reductions_types[k];
+    cvm::real *values =
+      &(atom_groups_reductions_values[atom_groups_reductions_offsets[k]]);
+    for (size_t j = 0; j < atom_group_reduction_size(type); j++) {
+      values[j] = 0.0;
+    }
+    int const ig = atom_groups_reductions_groups[k];
+    if (atom_groups_reductions_params[k].empty()) {
+      // First computation: center the reduction on the group
+      cvm::atom_pos const &com = atom_groups_coms[ig];
+      atom_groups_reductions_params[k].push_back(com.x);
+      atom_groups_reductions_params[k].push_back(com.y);
+      atom_groups_reductions_params[k].push_back(com.z);
+    }
+    load_group_atoms(ig, atom_groups_reductions_weights[k]);
+    compute_atom_group_reduction(type, atom_groups_reductions_params[k],
+                                 group_positions.size(),
+                                 group_positions.data(), group_weights.data(),
+                                 values);
+  }
+
+  return COLVARS_OK;
+}
+
+
+int colvarproxy_stub::apply_atom_groups_forces()
+{
+  for (size_t ig = 0; ig < atom_groups_slots.size(); ig++) {
+    std::vector<int> const &slots = atom_groups_slots[ig];
+    cvm::rvector const f = atom_groups_new_colvar_forces[ig];
+    if ((f.norm2() > 0.0) && (atom_groups_masses[ig] > 0.0)) {
+      for (size_t i = 0; i < slots.size(); i++) {
+        apply_atom_force(slots[i],
+                         (atoms_masses[slots[i]] / atom_groups_masses[ig]) * f);
+      }
+    }
+    atom_groups_new_colvar_forces[ig] = cvm::rvector(0.0);
+  }
+
+  for (size_t k = 0; k < atom_groups_reductions_groups.size(); k++) {
+    int const type = atom_groups_reductions_types[k];
+    cvm::real *coeffs =
+      &(atom_groups_reductions_coeffs[atom_groups_reductions_offsets[k]]);
+    int const ig = atom_groups_reductions_groups[k];
+    load_group_atoms(ig, atom_groups_reductions_weights[k]);
+    group_forces.assign(group_positions.size(), cvm::rvector(0.0));
+    compute_atom_group_reduction_forces(type, atom_groups_reductions_params[k],
+                                        coeffs, group_positions.size(),
+                                        group_positions.data(),
+                                        group_weights.data(),
+                                        group_forces.data());
+    for (size_t i = 0; i < group_forces.size(); i++) {
+      apply_atom_force(atom_groups_slots[ig][i], group_forces[i]);
+    }
+    for (size_t j = 0; j < atom_group_reduction_size(type); j++) {
+      coeffs[j] = 0.0;
+    }
+  }
+
+  return COLVARS_OK;
+}
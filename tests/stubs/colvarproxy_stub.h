@@ -12,6 +12,9 @@
 
 #define COLVARPROXY_VERSION COLVARS_VERSION
 
+#include <atomic>
+#include <thread>
+
 
 // Non-functional implementation that doesn't raise errors when critical
 // functions aren't implemented
@@ -41,6 +44,74 @@ public:
 
   int check_atom_id(int atom_number) override;
 
+  void get_atoms_positions(std::vector<int> const &indices,
+                           cvm::atom_pos *pos) const override;
+
+  void apply_atoms_forces(std::vector<int> const &indices,
+                          cvm::rvector const *new_forces) override;
+
+  int scalable_group_coms() override;
+
+  int scalable_group_reductions() override;
+
+  int init_atom_group(std::vector<int> const &atoms_ids) override;
+
+  /// \brief Enable scalable atom groups, computed by compute_atom_groups()
+  /// as a reference for MD engine implementations (call before reading the
+  /// configuration)
+  void set_scalable_groups(bool yesno);
+
+  /// \brief Compute the masses, charges, centers of mass and requested
+  /// reductions of the scalable groups from the atomic data
+  int compute_atom_groups();
+
+  /// \brief Distribute the forces applied to scalable groups (and to their
+  /// reductions) onto their atoms
+  int apply_atom_groups_forces();
+
+  /// \brief Compute the total forces of one step as an MD engine would: its
+  /// own forces (harmonic springs between consecutive atoms, as a stand-in
+  /// for a force field) plus the Colvars forces; if async is true, Colvars
+  /// runs in the background while the engine's own forces are computed
+  int calc_step(bool async, std::vector<cvm::rvector> &total_forces);
+
+  /// Number of messages received by log() and error()
+  std::atomic<size_t> num_messages{0};
+
+  /// \brief Number of messages received by log() and error() from a thread
+  /// other than the one that created the proxy
+  std::atomic<size_t> num_messages_other_threads{0};
+
+protected:
+
+  /// Thread that created the proxy
+  std::thread::id main_thread_id = std::this_thread::get_id();
+
+  /// Count a message received by log() or error()
+  void count_message();
+
+  /// Whether scalable atom groups are enabled
+  bool b_scalable_groups = false;
+
+  /// Atom slots of each scalable group
+  std::vector<std::vector<int>> atom_groups_slots;
+
+  /// Positions of the atoms of one group (work buffer)
+  std::vector<cvm::atom_pos> group_positions;
+
+  /// Weights of the atoms of one group (work buffer)
+  std::vector<cvm::real> group_weights;
+
+  /// Forces on the atoms of one group (work buffer)
+  std::vector<cvm::rvector> group_forces;
+
+  /// Fill the work buffers with the positions and weights of a group
+  void load_group_atoms(int group_index, int weight);
+
+  /// \brief Compute the masses, charges and centers of mass of the scalable
+  /// groups (but not their reductions, which are computed only at steps)
+  void compute_atom_groups_properties();
+
 };
 
 
@@ -0,0 +1,114 @@
+// -*- c++ -*-
+
+// This file is part of the Collective Variables module (Colvars).
+// The original version of Colvars and its updates are located at:
+// https://github.com/Colvars/colvars
+// Please update all Colvars source files before making any changes.
+// If you wish to distribute your changes, please submit them to the
+// Colvars repository at GitHub.
+
+#include <cmath>
+#include <iostream>
+#include <map>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+
+#include "colvarproxy_stub.h"
+#include "colvars_test_utils.h"
+
+
+colvarproxy_stub *colvars_test::new_proxy(std::string const &config,
+                                          int &error_code,
+                                          std::string const &output_prefix,
+                                          bool scalable_groups)
+{
+  colvarproxy_stub *proxy = new colvarproxy_stub();
+  proxy->angstrom_value = 1.0;
+  if (output_prefix.size()) {
+    proxy->output_prefix() = output_prefix;
+  }
+  proxy->set_scalable_groups(scalable_groups);
+  error_code |= proxy->colvars->read_config_string(config);
+  return proxy;
+}
+
+
+cvm::atom_pos colvars_test::test_position(int atom_id, int step)
+{
+  cvm::real const t = cvm::real(atom_id) * (1.0 + 0.02 * step);
+  return cvm::atom_pos(std::cos(1.3*t) + 0.2*t, std::sin(0.7*t),
+                       0.3*t*t - 1.0);
+}
+
+
+void colvars_test::set_test_positions(colvarproxy_stub *proxy, int step,
+                                      cvm::rvector const &offset)
+{
+  std::vector<int> const &ids = *(proxy->get_atom_ids());
+  for (size_t i = 0; i < ids.size(); i++) {
+    (*proxy->modify_atom_positions())[i] = test_position(ids[i], step) + offset;
+  }
+  proxy->reset_atoms_applied_forces();
+}
+
+
+void colvars_test::append_applied_forces(colvarproxy_stub *proxy,
+                                         std::vector<cvm::rvector> &forces)
+{
+  std::vector<int> const &ids = *(proxy->get_atom_ids());
+  std::map<int, cvm::rvector> forces_by_id;
+  for (size_t i = 0; i < ids.size(); i++) {
+    forces_by_id[ids[i]] += (*proxy->get_atom_applied_forces())[i];
+  }
+  for (std::map<int, cvm::rvector>::const_iterator it = forces_by_id.begin();
+       it != forces_by_id.end(); it++) {
+    forces.push_back(it->second);
+  }
+}
+
+
+int colvars_test::compare_results(run_results const &results,
+                                  run_results const &ref,
+                                  cvm::real tolerance)
+{
+  int error_code = COLVARS_OK;
+  if ((results.values.size() != ref.values.size()) ||
+      (results.forces.size() != ref.forces.size())) {
+    std::cerr << "Error: " << results.values.size() << " values and "
+              << results.forces.size() << " forces instead of "
+              << ref.values.size() << " and " << ref.forces.size() << ".\n";
+    return COLVARS_ERROR;
+  }
+  for (size_t i = 0; i < ref.values.size(); i++) {
+    std::cout << "Value " << i << " = " << results.values[i]
+              << " (expected " << ref.values[i] << ")\n";
+    if (std::fabs(results.values[i] - ref.values[i]) >
+        tolerance * (1.0 + std::fabs(ref.values[i]))) {
+      std::cerr << "Error: value " << i << " differs.\n";
+      error_code = COLVARS_ERROR;
+    }
+  }
+  for (size_t i = 0; i < ref.forces.size(); i++) {
+    if ((results.forces[i] - ref.forces[i]).norm() >
+        tolerance * (1.0 + ref.forces[i].norm())) {
+      std::cerr << "Error: force " << i << " = " << results.forces[i]
+                << " instead of " << ref.forces[i] << "\n";
+      error_code = COLVARS_ERROR;
+    }
+  }
+  std::cout << "Compared " << ref.values.size() << " values and "
+            << ref.forces.size() << " forces.\n";
+  return error_code;
+}
+
+
+int colvars_test::compare_runs(std::function<int(bool, run_results &)> const &run,
+                               cvm::real tolerance)
+{
+  run_results results, ref;
+  int error_code = run(false, ref);
+  error_code |= run(true, results);
+  error_code |= compare_results(results, ref, tolerance);
+  return error_code;
+}
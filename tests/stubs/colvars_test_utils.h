@@ -0,0 +1,64 @@
+// -*- c++ -*-
+
+// This file is part of the Collective Variables module (Colvars).
+// The original version of Colvars and its updates are located at:
+// https://github.com/Colvars/colvars
+// Please update all Colvars source files before making any changes.
+// If you wish to distribute your changes, please submit them to the
+// Colvars repository at GitHub.
+
+#ifndef COLVARS_TEST_UTILS_H
+#define COLVARS_TEST_UTILS_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvartypes.h"
+
+class colvarproxy_stub;
+
+
+/// Helper functions shared by the unit tests that use colvarproxy_stub
+namespace colvars_test {
+
+  /// \brief Create a stub proxy with lengths in Angstrom, and read the given
+  /// configuration (output_prefix and scalable_groups are set before that)
+  colvarproxy_stub *new_proxy(std::string const &config, int &error_code,
+                              std::string const &output_prefix = "",
+                              bool scalable_groups = false);
+
+  /// \brief Position of an atom at a step of the test trajectory (the atoms
+  /// are not collinear, so that all variables are well defined)
+  cvm::atom_pos test_position(int atom_id, int step = 0);
+
+  /// \brief Set the positions of all atoms requested by the proxy to
+  /// test_position() plus offset, and reset their applied forces
+  void set_test_positions(colvarproxy_stub *proxy, int step,
+                          cvm::rvector const &offset = cvm::rvector(0.0, 0.0,
+                                                                    0.0));
+
+  /// Append the forces applied to each atom, in order of atom number
+  void append_applied_forces(colvarproxy_stub *proxy,
+                             std::vector<cvm::rvector> &forces);
+
+  /// Values and forces computed by one run of a test
+  struct run_results {
+    std::vector<cvm::real> values;
+    std::vector<cvm::rvector> forces;
+  };
+
+  /// \brief Compare results with reference results, with a relative
+  /// tolerance (zero to require identical numbers); print the differences
+  /// and return an error code
+  int compare_results(run_results const &results, run_results const &ref,
+                      cvm::real tolerance);
+
+  /// \brief Call run(false, ...) for the reference results and run(true,
+  /// ...) for the results of the variant being tested, and compare them
+  int compare_runs(std::function<int(bool, run_results &)> const &run,
+                   cvm::real tolerance);
+}
+
+#endif
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvargrid.h"
+
+#include "colvarproxy_stub.h"
+
+
+std::string const colvar_config =
+  "colvar {\n"
+  "  name d\n"
+  "  width 0.5\n"
+  "  lowerBoundary 0.0\n"
+  "  upperBoundary 5.0\n"
+  "  distance {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 2 }\n"
+  "  }\n"
+  "}\n"
+  "colvar {\n"
+  "  name e\n"
+  "  width 0.5\n"
+  "  lowerBoundary 0.0\n"
+  "  upperBoundary 5.0\n"
+  "  distance {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 3 }\n"
+  "    group2 { atomNumbers 4 }\n"
+  "  }\n"
+  "}\n";
+
+std::string const abf_config =
+  "abf {\n"
+  "  colvars d\n"
+  "  fullSamples 100\n"
+  "  updateBias off\n"
+  "  gridInterpolation cubic\n"
+  "  inputPrefix test_abf_interpolation\n"
+  "}\n";
+
+std::string const abf_2d_config =
+  "abf {\n"
+  "  colvars d e\n"
+  "  fullSamples 100\n"
+  "  updateBias off\n"
+  "  gridInterpolation cubic\n"
+  "  inputPrefix test_abf_interpolation_2d\n"
+  "}\n";
+
+
+// Mean force at bin coordinate u; quadratic, so that the cubic spline
+// reproduces it
+cvm::real mean_force(cvm::real u)
+{
+  return 1.0 + 0.1 * u + 0.02 * u * u;
+}
+
+
+// Mean force along e of bin (i, j) of the 2D bias; the linear and cubic
+// interpolations along d differ
+cvm::real mean_force_2d(int i, int j)
+{
+  return 1.0 + 0.1 * j + 0.03 * i * i;
+}
+
+
+// Applied ABF force at distance x
+cvm::real abf_force(colvarproxy_stub *proxy, cvm::real x, int &error_code)
+{
+  (*proxy->modify_atom_positions())[0] = cvm::atom_pos(0.0, 0.0, 0.0);
+  (*proxy->modify_atom_positions())[1] = cvm::atom_pos(x, 0.0, 0.0);
+  error_code |= proxy->colvars->calc();
+  return cvm::colvar_by_name("d")->applied_force().real_value;
+}
+
+
+// Applied ABF force along e at distances x (d) and y (e)
+cvm::real abf_force_2d(colvarproxy_stub *proxy, cvm::real x, cvm::real y,
+                       int &error_code)
+{
+  (*proxy->modify_atom_positions())[2] = cvm::atom_pos(0.0, 1.0, 0.0);
+  (*proxy->modify_atom_positions())[3] = cvm::atom_pos(0.0, 1.0 + y, 0.0);
+  abf_force(proxy, x, error_code);
+  return cvm::colvar_by_name("e")->applied_force().real_value;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  colvarproxy_stub *proxy = new colvarproxy_stub();
+  proxy->angstrom_value = 1.0;
+  int error_code = proxy->colvars->read_config_string(colvar_config);
+  std::vector<colvar *> cvs(1, cvm::colvar_by_name("d"));
+  std::vector<colvar *> cvs_2d(cvs);
+  cvs_2d.push_back(cvm::colvar_by_name("e"));
+
+  // Bins 4 and 5 (centers 2.25 and 2.75) are below fullSamples, their
+  // neighbors are full
+  colvar_grid_count samples(cvs);
+  colvar_grid_gradient gradients(cvs);
+  std::vector<int> ix = samples.new_index();
+  for ( ; samples.index_ok(ix); samples.incr(ix)) {
+    samples.set_value(ix, ((ix[0] == 4) || (ix[0] == 5)) ? 52 : 200);
+    gradients.set_value(ix, mean_force(ix[0]));
+  }
+  {
+    std::ofstream os("test_abf_interpolation.count");
+    samples.write_multicol(os);
+    std::ofstream os_grad("test_abf_interpolation.grad");
+    gradients.write_multicol(os_grad);
+  }
+
+  // In 2D, the bins with j = 6 (center 3.25 along e) are below fullSamples
+  colvar_grid_count samples_2d(cvs_2d);
+  colvar_grid_gradient gradients_2d(cvs_2d);
+  ix = samples_2d.new_index();
+  for ( ; samples_2d.index_ok(ix); samples_2d.incr(ix)) {
+    samples_2d.set_value(ix, (ix[1] == 6) ? 52 : 200);
+    gradients_2d.set_value(ix, 0.0, 0);
+    gradients_2d.set_value(ix, mean_force_2d(ix[0], ix[1]), 1);
+  }
+  {
+    std::ofstream os("test_abf_interpolation_2d.count");
+    samples_2d.write_multicol(os);
+    std::ofstream os_grad("test_abf_interpolation_2d.grad");
+    gradients_2d.write_multicol(os_grad);
+  }
+
+  error_code |= proxy->colvars->read_config_string(abf_config);
+
+  // Between bins 1 and 2, all bins of the cubic stencil are full
+  cvm::real const x_full = 1.1;
+  cvm::real const f_full = abf_force(proxy, x_full, error_code);
+  cvm::real const f_full_ref = mean_force(x_full / 0.5 - 0.5);
+  std::cout << "Force at " << x_full << " = " << f_full << " (expected "
+            << f_full_ref << ")\n";
+  if (std::fabs(f_full - f_full_ref) > 1.0e-10) {
+    error_code = 1;
+  }
+
+  // Between bins 4 and 5, the cubic weights of the full bins 3 and 6 are
+  // negative: the ramp factor (0.04 in both bins) must be interpolated
+  // linearly, and not change sign
+  cvm::real const x_ramp = 2.5;
+  cvm::real const f_ramp = abf_force(proxy, x_ramp, error_code);
+  cvm::real const f_ramp_ref = 0.04 * mean_force(x_ramp / 0.5 - 0.5);
+  std::cout << "Force at " << x_ramp << " = " << f_ramp << " (expected "
+            << f_ramp_ref << ")\n";
+  if (std::fabs(f_ramp - f_ramp_ref) > 1.0e-10) {
+    error_code = 1;
+  }
+
+  // Across the center of bin j = 4 along e, the cubic stencil starts to
+  // include the bins with j = 6: the force must not jump
+  error_code |= proxy->colvars->read_config_string(abf_2d_config);
+  cvm::real const y_edge = 2.25, dy = 1.0e-7;
+  cvm::real const f_below = abf_force_2d(proxy, x_full, y_edge - dy, error_code);
+  cvm::real const f_above = abf_force_2d(proxy, x_full, y_edge + dy, error_code);
+  std::cout << "Force along e at " << y_edge << " -/+ " << dy << " = "
+            << f_below << ", " << f_above << "\n";
+  if (std::fabs(f_above - f_below) > 1.0e-5) {
+    error_code = 1;
+  }
+
+  proxy->remove_file("test_abf_interpolation.count");
+  proxy->remove_file("test_abf_interpolation.grad");
+  proxy->remove_file("test_abf_interpolation_2d.count");
+  proxy->remove_file("test_abf_interpolation_2d.grad");
+  delete proxy;
+  return error_code;
+}
@@ -0,0 +1,287 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvarbias.h"
+
+#include "colvarproxy_stub.h"
+
+
+std::string const config =
+  "smp off\n"
+  "colvar {\n"
+  "  name d1\n"
+  "  width 0.5\n"
+  "  lowerBoundary 0.0\n"
+  "  upperBoundary 5.0\n"
+  "  distance {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 2 }\n"
+  "  }\n"
+  "}\n"
+  "colvar {\n"
+  "  name d2\n"
+  "  width 0.25\n"
+  "  lowerBoundary 0.0\n"
+  "  upperBoundary 5.0\n"
+  "  distance {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 3 }\n"
+  "    group2 { atomNumbers 4 }\n"
+  "  }\n"
+  "}\n"
+  "abf {\n"
+  "  name abf1\n"
+  "  colvars d1\n"
+  "  shared on\n"
+  "  sharedFreq 5\n"
+  "  sharedAsync on\n"
+  "}\n"
+  "abf {\n"
+  "  name abf2\n"
+  "  colvars d2\n"
+  "  shared on\n"
+  "  sharedFreq 5\n"
+  "  sharedAsync on\n"
+  "}\n";
+
+char const *bias_names[] = { "abf1", "abf2" };
+
+int const num_steps = 48;
+
+
+// Two replicas in separate processes, connected by a stream socket; each
+// message is preceded by its tag and length, and queued by tag on arrival
+class socket_replicas_proxy : public colvarproxy_stub {
+public:
+
+  socket_replicas_proxy(int replica, int socket_fd)
+    : me(replica), fd(socket_fd) {}
+
+  int replica_enabled() override { return COLVARS_OK; }
+  int replica_index() override { return me; }
+  int num_replicas() override { return 2; }
+  void replica_comm_barrier() override {}
+
+  int replica_comm_async() override { return COLVARS_OK; }
+
+  int replica_comm_send(char *msg_data, int msg_len, int dest_rep) override
+  {
+    return (replica_comm_isend(msg_data, msg_len, dest_rep, 0) < 0) ? 0 :
+      msg_len;
+  }
+
+  int replica_comm_recv(char *msg_data, int buf_len, int src_rep) override
+  {
+    return replica_comm_recv_tagged(msg_data, buf_len, src_rep, 0);
+  }
+
+  int replica_comm_isend(char *msg_data, int msg_len, int /* dest_rep */,
+                         int tag) override
+  {
+    int const header[2] = { tag, msg_len };
+    if (!write_all(reinterpret_cast<char const *>(header), sizeof(header)) ||
+        !write_all(msg_data, msg_len)) {
+      return -1;
+    }
+    num_sent[tag]++;
+    return 0;
+  }
+
+  bool replica_comm_send_done(int /* request */, bool /* wait */) override
+  {
+    return true;
+  }
+
+  bool replica_comm_ready(int /* src_rep */, int tag) override
+  {
+    struct pollfd p = { fd, POLLIN, 0 };
+    while (queues[tag].empty() && (poll(&p, 1, 0) > 0)) {
+      if (!read_message()) break;
+    }
+    return !queues[tag].empty();
+  }
+
+  int replica_comm_recv_tagged(char *msg_data, int buf_len,
+                               int /* src_rep */, int tag) override
+  {
+    while (queues[tag].empty()) {
+      if (!read_message()) return 0;
+    }
+    std::vector<char> const msg = queues[tag].front();
+    queues[tag].pop_front();
+    if (int(msg.size()) > buf_len) return 0;
+    std::memcpy(msg_data, msg.data(), msg.size());
+    return int(msg.size());
+  }
+
+  /// Number of messages sent with each tag
+  std::map<int, size_t> num_sent;
+
+protected:
+
+  int me;
+  int fd;
+  std::map<int, std::deque< std::vector<char> > > queues;
+
+  bool write_all(char const *data, size_t len)
+  {
+    while (len > 0) {
+      ssize_t const n = write(fd, data, len);
+      if (n <= 0) return false;
+      data += n;
+      len -= size_t(n);
+    }
+    return true;
+  }
+
+  bool read_all(char *data, size_t len)
+  {
+    while (len > 0) {
+      ssize_t const n = read(fd, data, len);
+      if (n <= 0) return false;
+      data += n;
+      len -= size_t(n);
+    }
+    return true;
+  }
+
+  bool read_message()
+  {
+    int header[2];
+    if (!read_all(reinterpret_cast<char *>(header), sizeof(header))) {
+      return false;
+    }
+    std::vector<char> msg(header[1]);
+    if ((header[1] > 0) && !read_all(msg.data(), msg.size())) return false;
+    queues[header[0]].push_back(msg);
+    return true;
+  }
+};
+
+
+std::string counts_file(int replica)
+{
+  return "test_abf_shared_async." + std::to_string(replica) + ".counts";
+}
+
+
+// Sample a different range of each variable in each replica, then complete
+// the exchanges and write the counts of both biases
+int run_replica(int replica, int fd)
+{
+  socket_replicas_proxy *proxy = new socket_replicas_proxy(replica, fd);
+  proxy->angstrom_value = 1.0;
+  int error_code = proxy->colvars->read_config_string(config);
+
+  for (int step = 0; step < num_steps; step++) {
+    cvm::it = step;
+    cvm::real const d1 = 0.3 + 2.5 * replica + 0.1 * (step % 20);
+    cvm::real const d2 = 0.2 + 2.5 * replica + 0.11 * (step % 20);
+    std::vector<cvm::atom_pos> &pos = *(proxy->modify_atom_positions());
+    pos[0] = cvm::atom_pos(0.0, 0.0, 0.0);
+    pos[1] = cvm::atom_pos(d1, 0.0, 0.0);
+    pos[2] = cvm::atom_pos(0.0, 1.0, 0.0);
+    pos[3] = cvm::atom_pos(0.0, 1.0 + d2, 0.0);
+    (*proxy->modify_atom_total_forces())[1] = cvm::rvector(0.5 * replica, 0.0, 0.0);
+    error_code |= proxy->colvars->calc();
+  }
+
+  std::ofstream os(counts_file(replica).c_str());
+  for (size_t ib = 0; ib < sizeof(bias_names)/sizeof(bias_names[0]); ib++) {
+    colvarbias *bias = cvm::bias_by_name(bias_names[ib]);
+    error_code |= bias->replica_share();
+    for (int i = 0; i < bias->bin_num(); i++) {
+      os << bias->bin_count(i) << " ";
+    }
+    os << "\n";
+  }
+
+  if (proxy->num_sent.size() != 2) {
+    std::cerr << "Error: the two biases did not use separate tags.\n";
+    error_code = 1;
+  }
+
+  delete proxy;
+  return error_code;
+}
+
+
+std::vector< std::vector<int> > read_counts(int replica)
+{
+  std::vector< std::vector<int> > counts;
+  std::ifstream is(counts_file(replica).c_str());
+  std::string line;
+  while (std::getline(is, line)) {
+    std::istringstream ls(line);
+    counts.push_back(std::vector<int>());
+    int c;
+    while (ls >> c) counts.back().push_back(c);
+  }
+  return counts;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    std::cerr << "Error: cannot create a socket pair.\n";
+    return 1;
+  }
+
+  pid_t const pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    _exit(run_replica(1, fds[1]) ? 1 : 0);
+  }
+  close(fds[1]);
+  int error_code = run_replica(0, fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+    std::cerr << "Error: replica 1 failed.\n";
+    error_code = 1;
+  }
+
+  // After the last exchange both replicas have all samples: each replica
+  // sampled half of the range of each variable, at the same number of steps
+  std::vector< std::vector<int> > const counts0 = read_counts(0);
+  std::vector< std::vector<int> > const counts1 = read_counts(1);
+  if ((counts0.size() != 2) || (counts0 != counts1)) {
+    std::cerr << "Error: the replicas have different samples.\n";
+    error_code = 1;
+  }
+  for (size_t ib = 0; ib < counts0.size(); ib++) {
+    std::vector<int> const &c = counts0[ib];
+    int total = 0, low = 0;
+    for (size_t i = 0; i < c.size(); i++) {
+      total += c[i];
+      if (i < c.size() / 2) low += c[i];
+    }
+    std::cout << bias_names[ib] << ": " << total << " samples, " << low
+              << " in the range of replica 0\n";
+    if ((total == 0) || (2 * low != total)) {
+      std::cerr << "Error: wrong samples for bias " << bias_names[ib] << ".\n";
+      error_code = 1;
+    }
+  }
+
+  std::remove(counts_file(0).c_str());
+  std::remove(counts_file(1).c_str());
+  return error_code;
+}
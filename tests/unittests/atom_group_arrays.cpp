@@ -0,0 +1,181 @@
+#include <iostream>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvaratoms.h"
+
+
+// Minimal proxy that can allocate atom slots
+class atoms_test_proxy : public colvarproxy {
+public:
+  int init_atom(int atom_number)
+  {
+    return add_atom_slot(atom_number);
+  }
+};
+
+
+// Check that each atom refers to its element of the group's arrays
+int check_atom_views(cvm::atom_group const &group)
+{
+  std::vector<cvm::atom_pos> const &pos = group.positions_view();
+  if (pos.size() != group.size()) return 1;
+  for (size_t i = 0; i < group.size(); i++) {
+    if (&(group[i].pos()) != &(pos[i])) {
+      std::cerr << "Error: atom " << i << " does not refer to the array of "
+                << "positions\n";
+      return 1;
+    }
+    if (group[i].mass() != (*cvm::proxy->get_atom_masses())[group[i].proxy_index()]) {
+      std::cerr << "Error: wrong mass for atom " << i << "\n";
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  atoms_test_proxy *proxy = new atoms_test_proxy();
+  proxy->colvars = new colvarmodule(proxy);
+
+  int const n = 5;
+  std::vector<cvm::atom> atoms;
+  for (int i = 0; i < n; i++) {
+    atoms.push_back(cvm::atom(i+1));
+    (*proxy->modify_atom_masses())[i] = 1.0 + i;
+    (*proxy->modify_atom_positions())[i] = cvm::rvector(i, 0.5*i*i, -2.0*i);
+  }
+
+  cvm::atom_group *group = new cvm::atom_group(atoms);
+  group->setup();
+  group->read_positions();
+  group->calc_center_of_mass();
+  group->calc_center_of_geometry();
+
+  int error_code = check_atom_views(*group);
+
+  cvm::atom_pos com_ref(0.0), cog_ref(0.0);
+  cvm::real mass = 0.0;
+  for (int i = 0; i < n; i++) {
+    cvm::atom_pos const x = (*proxy->get_atom_positions())[i];
+    com_ref += (1.0 + i) * x;
+    cog_ref += x;
+    mass += 1.0 + i;
+  }
+  com_ref /= mass;
+  cog_ref /= cvm::real(n);
+  std::cout << "COM = " << group->center_of_mass() << " (expected "
+            << com_ref << ")\n";
+  std::cout << "COG = " << group->center_of_geometry() << " (expected "
+            << cog_ref << ")\n";
+  if ((group->center_of_mass() - com_ref).norm() > 1.0e-12) error_code = 1;
+  if ((group->center_of_geometry() - cog_ref).norm() > 1.0e-12) error_code = 1;
+
+  // Transformations of the group are seen by the atoms, and direct changes
+  // of the atoms by the centers
+  group->apply_translation(cvm::rvector(1.0, -1.0, 0.5));
+  if (((*group)[2].pos() - ((*proxy->get_atom_positions())[2] +
+                          cvm::rvector(1.0, -1.0, 0.5))).norm() > 1.0e-12) {
+    error_code = 1;
+  }
+  (*group)[0].pos().x += 5.0;
+  group->calc_center_of_geometry();
+  if ((group->center_of_geometry() - cog_ref -
+       cvm::rvector(1.0 + 5.0/n, -1.0, 0.5)).norm() > 1.0e-12) {
+    std::cerr << "Error: center of geometry does not follow the atoms\n";
+    error_code = 1;
+  }
+
+  // Forces are distributed by mass and accumulated in the proxy in one call
+  cvm::rvector const force(3.0, -6.0, 1.5);
+  group->apply_force(force);
+  group->apply_force(force);
+  for (int i = 0; i < n; i++) {
+    cvm::rvector const f_ref = 2.0 * ((1.0 + i) / mass) * force;
+    if (((*proxy->get_atom_applied_forces())[i] - f_ref).norm() > 1.0e-12) {
+      std::cerr << "Error: wrong force on atom " << i << ": "
+                << (*proxy->get_atom_applied_forces())[i] << "\n";
+      error_code = 1;
+    }
+  }
+
+  // Map of the group atoms onto a larger sorted list of IDs
+  std::vector<int> atom_ids;
+  for (int i = 0; i < n + 3; i++) {
+    atom_ids.push_back(i);
+  }
+  std::vector<int> const &collect_index = group->collect_index(atom_ids);
+  for (size_t i = 0; i < group->size(); i++) {
+    if ((collect_index.size() != group->size()) ||
+        (atom_ids[collect_index[i]] != (*group)[i].id)) {
+      std::cerr << "Error: wrong collect index for atom " << i << "\n";
+      error_code = 1;
+    }
+  }
+
+  // Adding an atom invalidates the map, which is then recomputed; the atoms
+  // follow the arrays when those are reallocated
+  group->add_atom(cvm::atom(n+2));
+  error_code |= check_atom_views(*group);
+  if (group->collect_index(atom_ids).size() != group->size() ||
+      atom_ids[group->collect_index(atom_ids)[n]] != (*group)[n].id) {
+    std::cerr << "Error: collect index not updated after adding an atom\n";
+    error_code = 1;
+  }
+
+  // Only the atoms that received a non-zero force are listed, and only
+  // those are reset
+  if (proxy->get_atoms_applied_force_indices()->size() != size_t(n)) {
+    std::cerr << "Error: wrong number of atoms with applied forces\n";
+    error_code = 1;
+  }
+  proxy->reset_atoms_applied_forces();
+  proxy->apply_atom_force(3, cvm::rvector(0.0));
+  proxy->apply_atom_force(1, force);
+  std::vector<int> const &indices = *(proxy->get_atoms_applied_force_indices());
+  if ((indices.size() != 1) || (indices[0] != 1)) {
+    std::cerr << "Error: wrong list of atoms with applied forces\n";
+    error_code = 1;
+  }
+  for (int i = 0; i < n; i++) {
+    cvm::rvector const f_ref = (i == 1) ? force : cvm::rvector(0.0);
+    if (((*proxy->get_atom_applied_forces())[i] - f_ref).norm() > 0.0) {
+      std::cerr << "Error: wrong force on atom " << i << " after reset: "
+                << (*proxy->get_atom_applied_forces())[i] << "\n";
+      error_code = 1;
+    }
+  }
+
+  // Replacing an atom without changing the size of the group is seen by the
+  // next exchange with the proxy
+  {
+    group->read_positions();
+    (*group)[1] = cvm::atom(n+4);
+    size_t const slot = (*group)[1].proxy_index();
+    (*proxy->modify_atom_positions())[slot] = cvm::rvector(-7.0, 8.0, 9.0);
+    group->read_positions();
+    if (((*group)[1].pos() - cvm::rvector(-7.0, 8.0, 9.0)).norm() > 0.0) {
+      std::cerr << "Error: position of a replaced atom not read\n";
+      error_code = 1;
+    }
+    error_code |= check_atom_views(*group);
+  }
+
+  // Removing an atom shifts the following ones and their data
+  {
+    group->read_positions();
+    cvm::atom_pos const pos3 = (*group)[3].pos();
+    group->remove_atom(group->begin() + 2);
+    error_code |= check_atom_views(*group);
+    group->read_positions();
+    if (((*group)[2].pos() - pos3).norm() > 0.0) {
+      std::cerr << "Error: wrong position after removing an atom\n";
+      error_code = 1;
+    }
+  }
+
+  delete group;
+  return error_code;
+}
@@ -0,0 +1,87 @@
+#include <iostream>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvarbias.h"
+
+#include "colvarproxy_stub.h"
+#include "colvars_test_utils.h"
+
+
+std::string const config =
+  "colvar {\n"
+  "  name d\n"
+  "  width 0.05\n"
+  "  lowerBoundary 0.0\n"
+  "  upperBoundary 10.0\n"
+  "  distance {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 2 }\n"
+  "    group2 { atomNumbers 3 4 }\n"
+  "  }\n"
+  "}\n"
+  "colvar {\n"
+  "  name v\n"
+  "  distancePairs {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 2 }\n"
+  "    group2 { atomNumbers 3 4 }\n"
+  "  }\n"
+  "}\n"
+  "metadynamics {\n"
+  "  name meta\n"
+  "  colvars d\n"
+  "  hillWeight 0.1\n"
+  "  hillWidth 3.0\n"
+  "  newHillFrequency 1\n"
+  "}\n"
+  "harmonic {\n"
+  "  name h\n"
+  "  colvars v\n"
+  "  centers (1.0, 2.0, 3.0, 4.0)\n"
+  "  forceConstant 2.0\n"
+  "  targetCenters (2.0, 2.0, 2.0, 2.0)\n"
+  "  targetNumSteps 2\n"
+  "  targetNumStages 4\n"
+  "}\n";
+
+
+/// Run a short trajectory, and append the total forces of each step; the
+/// moving restraint logs messages during the calculation, which must all be
+/// passed to the proxy from this thread
+int run(bool async, colvars_test::run_results &results)
+{
+  int error_code = COLVARS_OK;
+  colvarproxy_stub *proxy = colvars_test::new_proxy(config, error_code);
+  std::vector<cvm::rvector> step_forces;
+  size_t const num_messages_setup = proxy->num_messages;
+  for (int step = 0; step < 10; step++) {
+    cvm::it = step;
+    colvars_test::set_test_positions(proxy, step);
+    error_code |= proxy->calc_step(async, step_forces);
+    if (proxy->colvars->calc_async_pending()) {
+      std::cerr << "Error: calculation still pending after the step.\n";
+      error_code = 1;
+    }
+    results.forces.insert(results.forces.end(), step_forces.begin(),
+                          step_forces.end());
+  }
+  results.values.push_back(cvm::real(proxy->num_messages -
+                                     num_messages_setup));
+  if (proxy->num_messages_other_threads > 0) {
+    std::cerr << "Error: " << proxy->num_messages_other_threads
+              << " messages passed to the proxy from another thread.\n";
+    error_code = 1;
+  }
+  delete proxy;
+  return error_code;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  // Synchronous and asynchronous steps give identical forces and messages
+  return colvars_test::compare_runs(&run, 0.0);
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvarbias.h"
+
+#include "colvarproxy_stub.h"
+
+
+// Count the heap allocations made by the whole program
+size_t num_allocations = 0;
+
+void *operator new(std::size_t size)
+{
+  num_allocations++;
+  void *p = std::malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+
+std::string const config =
+  "colvar {\n"
+  "  name v\n"
+  "  distancePairs {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 2 }\n"
+  "    group2 { atomNumbers 3 4 }\n"
+  "  }\n"
+  "}\n"
+  "harmonic {\n"
+  "  name h\n"
+  "  colvars v\n"
+  "  centers (1.0, 2.0, 3.0, 4.0)\n"
+  "  forceConstant 2.0\n"
+  "}\n";
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  colvarproxy_stub *proxy = new colvarproxy_stub();
+  proxy->angstrom_value = 1.0;
+  int error_code = proxy->colvars->read_config_string(config);
+  colvar *cv = cvm::colvar_by_name("v");
+  colvarbias *bias = cvm::bias_by_name("h");
+
+  std::vector<int> const &ids = *(proxy->get_atom_ids());
+  for (size_t i = 0; i < ids.size(); i++) {
+    cvm::real const t = cvm::real(ids[i]);
+    (*proxy->modify_atom_positions())[i] = cvm::atom_pos(t, 0.5*t*t, 0.0);
+  }
+  error_code |= proxy->colvars->calc();
+
+  // Force computation of a vector variable: bias, colvar and components
+  size_t const num_steps = 10;
+  size_t const start = num_allocations;
+  for (size_t step = 0; step < num_steps; step++) {
+    cv->reset_bias_force();
+    error_code |= bias->update();
+    bias->communicate_forces();
+    cv->update_forces_energy();
+    cv->communicate_forces();
+  }
+  size_t const count = num_allocations - start;
+
+  std::cout << "Allocations in " << num_steps << " force updates: "
+            << count << "\n";
+  if (count > 0) error_code = 1;
+
+  // The force is still computed correctly
+  colvarvalue const centers(cv->value() + 0.5 * cv->applied_force());
+  for (size_t i = 0; i < centers.size(); i++) {
+    if (std::abs(centers[i] - cvm::real(i + 1)) > 1.0e-12) {
+      std::cerr << "Error: wrong force " << cv->applied_force()
+                << " for value " << cv->value() << "\n";
+      error_code = 1;
+      break;
+    }
+  }
+
+  delete proxy;
+  return error_code;
+}
@@ -0,0 +1,127 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvaratoms.h"
+#include "colvar.h"
+#include "colvarcomp.h"
+
+
+// Proxy that shares atom slots between components
+class pairlist_test_proxy : public colvarproxy {
+public:
+
+  pairlist_test_proxy()
+  {
+    angstrom_value = 1.0;
+    boundaries_type = boundaries_non_periodic;
+  }
+
+  int init_atom(int atom_number)
+  {
+    for (size_t i = 0; i < atoms_ids.size(); i++) {
+      if (atoms_ids[i] == atom_number) {
+        atoms_ncopies[i] += 1;
+        return i;
+      }
+    }
+    return add_atom_slot(atom_number);
+  }
+};
+
+
+// Exposes the number of pair list builds
+template<class T> class pairlist_probe : public T {
+public:
+  pairlist_probe(std::string const &conf) : T(conf), num_builds(0) {}
+  cvm::real eval()
+  {
+    this->read_data();
+    this->calc_value();
+    if (this->pairlist_num_evals == 1) num_builds++;
+    return this->x.real_value;
+  }
+  int num_builds;
+};
+
+
+cvm::real random_real()
+{
+  return cvm::real(std::rand()) / cvm::real(RAND_MAX);
+}
+
+
+template<class T>
+int compare(pairlist_test_proxy *proxy, std::string const &groups,
+            std::string const &name)
+{
+  int error_code = 0;
+  std::string const conf = groups + "cutoff 1.5\ntolerance 0.01\n";
+  pairlist_probe<T> ref(conf + "pairListFrequency 1\n");
+  pairlist_probe<T> skin(conf + "pairListSkin 0.8\n");
+  pairlist_probe<T> sparse(conf + "pairListFrequency 1000\n");
+
+  int const n_steps = 100;
+  for (int step = 0; step < n_steps; step++) {
+    for (size_t i = 0; i < proxy->get_atom_positions()->size(); i++) {
+      (*proxy->modify_atom_positions())[i] +=
+        0.1 * cvm::rvector(random_real() - 0.5, random_real() - 0.5,
+                            random_real() - 0.5);
+    }
+    cvm::real const x_ref = ref.eval();
+    cvm::real const x_skin = skin.eval();
+    cvm::real const x_sparse = sparse.eval();
+    if (std::fabs(x_skin - x_ref) > 1.0e-12) {
+      std::cerr << "Error: " << name << " with skin at step " << step << ": "
+                << x_skin << " instead of " << x_ref << "\n";
+      error_code = 1;
+    }
+    if ((step == 0) && (std::fabs(x_sparse - x_ref) > 1.0e-12)) {
+      std::cerr << "Error: " << name << " pair list not built at the first "
+                << "evaluation.\n";
+      error_code = 1;
+    }
+  }
+
+  std::cout << name << ": " << skin.num_builds << " builds with skin, "
+            << sparse.num_builds << " with pairListFrequency 1000\n";
+  if ((skin.num_builds < 1) || (skin.num_builds >= n_steps) ||
+      (sparse.num_builds != 1)) {
+    std::cerr << "Error: wrong number of pair list builds.\n";
+    error_code = 1;
+  }
+  return error_code;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  pairlist_test_proxy *proxy = new pairlist_test_proxy();
+  proxy->colvars = new colvarmodule(proxy);
+
+  std::string const groups =
+    "group1 { atomNumbers 1 2 3 4 5 6 7 8 }\n"
+    "group2 { atomNumbers 9 10 11 12 13 14 15 16 }\n";
+  std::string const group1 =
+    "group1 { atomNumbers 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 }\n";
+
+  // Allocate the atoms and place them randomly
+  colvar::coordnum *dummy = new colvar::coordnum(groups);
+  std::srand(1);
+  for (size_t i = 0; i < proxy->get_atom_positions()->size(); i++) {
+    (*proxy->modify_atom_positions())[i] =
+      3.0 * cvm::rvector(random_real(), random_real(), random_real());
+  }
+
+  int error_code = 0;
+  error_code |= compare<colvar::coordnum>(proxy, groups, "coordNum");
+  error_code |= compare<colvar::coordnum>(proxy, groups +
+                                          "group2CenterOnly on\n",
+                                          "coordNum (group2CenterOnly)");
+  error_code |= compare<colvar::selfcoordnum>(proxy, group1, "selfCoordNum");
+
+  delete dummy;
+  return error_code;
+}
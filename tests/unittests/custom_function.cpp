@@ -0,0 +1,146 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvarbias.h"
+
+#include "colvarproxy_stub.h"
+
+
+// Scalar and vector custom functions of a scalar (d) and a vector (v)
+// component; some derivatives are constant (f with respect to v3), zero (g
+// with respect to v1 for its first element) or variable
+std::string const config =
+  "colvar {\n"
+  "  name f\n"
+  "  customFunction d*v2 + sin(v1)^2 + 2*v3 - exp(-d)\n"
+  "  distance {\n"
+  "    name d\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 2 }\n"
+  "    group2 { atomNumbers 3 }\n"
+  "  }\n"
+  "  distanceVec {\n"
+  "    name v\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 3 }\n"
+  "    group2 { atomNumbers 4 }\n"
+  "  }\n"
+  "}\n"
+  "colvar {\n"
+  "  name g\n"
+  "  customFunction v3*v2 - 0.5*d^2\n"
+  "  customFunction sqrt(v1*v1 + v2*v2 + v3*v3) / d\n"
+  "  distance {\n"
+  "    name d\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 2 }\n"
+  "    group2 { atomNumbers 3 }\n"
+  "  }\n"
+  "  distanceVec {\n"
+  "    name v\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 3 }\n"
+  "    group2 { atomNumbers 4 }\n"
+  "  }\n"
+  "}\n"
+  "harmonic {\n"
+  "  name hf\n"
+  "  colvars f\n"
+  "  centers 1.0\n"
+  "  forceConstant 0.7\n"
+  "}\n"
+  "harmonic {\n"
+  "  name hg\n"
+  "  colvars g\n"
+  "  centers (1.0, 0.5)\n"
+  "  forceConstant 1.3\n"
+  "}\n";
+
+
+std::vector<cvm::atom_pos> positions;
+
+
+/// Compute the colvars and biases from the given positions, and return the
+/// total bias energy
+cvm::real calc_energy(colvarproxy_stub *proxy, int &error_code)
+{
+  std::vector<int> const &ids = *(proxy->get_atom_ids());
+  for (size_t i = 0; i < ids.size(); i++) {
+    (*proxy->modify_atom_positions())[i] = positions[ids[i]];
+  }
+  proxy->reset_atoms_applied_forces();
+  error_code |= proxy->colvars->calc();
+  cvm::real energy = 0.0;
+  for (size_t i = 0; i < proxy->colvars->biases.size(); i++) {
+    energy += proxy->colvars->biases[i]->get_energy();
+  }
+  return energy;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  colvarproxy_stub *proxy = new colvarproxy_stub();
+  proxy->angstrom_value = 1.0;
+  int error_code = proxy->colvars->read_config_string(config);
+
+  positions.push_back(cvm::atom_pos(0.1, 0.3, -0.2));
+  positions.push_back(cvm::atom_pos(0.5, -0.4, 0.3));
+  positions.push_back(cvm::atom_pos(1.7, 0.9, 0.6));
+  positions.push_back(cvm::atom_pos(2.2, 1.6, 1.5));
+
+  cvm::real const energy = calc_energy(proxy, error_code);
+  std::vector<cvm::rvector> const forces = *(proxy->get_atom_applied_forces());
+
+  // Values compared with the expressions evaluated directly
+  cvm::real const d = ((positions[2] -
+                        0.5 * (positions[0] + positions[1])).norm());
+  cvm::rvector const v = positions[3] - positions[2];
+  cvm::real const f_ref = d*v.y + std::sin(v.x)*std::sin(v.x) + 2.0*v.z -
+    std::exp(-d);
+  cvm::real const g1_ref = v.z*v.y - 0.5*d*d;
+  cvm::real const g2_ref = v.norm() / d;
+
+  colvarvalue const &f = proxy->colvars->colvar_by_name("f")->value();
+  colvarvalue const &g = proxy->colvars->colvar_by_name("g")->value();
+  std::cout << "f = " << f << " (expected " << f_ref << ")\n";
+  std::cout << "g = " << g << " (expected ( " << g1_ref << " , " << g2_ref
+            << " ))\n";
+  if ((std::fabs(f.real_value - f_ref) > 1.0e-12) ||
+      (std::fabs(g.vector1d_value[0] - g1_ref) > 1.0e-12) ||
+      (std::fabs(g.vector1d_value[1] - g2_ref) > 1.0e-12)) {
+    std::cerr << "Error: wrong values of the custom functions.\n";
+    error_code = 1;
+  }
+
+  // Forces (i.e. gradients of the functions times the bias forces)
+  // compared with finite differences of the energy
+  cvm::real const h = 1.0e-6;
+  std::vector<int> const ids = *(proxy->get_atom_ids());
+  for (size_t i = 0; i < ids.size(); i++) {
+    for (size_t id = 0; id < 3; id++) {
+      positions[ids[i]][id] += h;
+      cvm::real const e_plus = calc_energy(proxy, error_code);
+      positions[ids[i]][id] -= 2.0*h;
+      cvm::real const e_minus = calc_energy(proxy, error_code);
+      positions[ids[i]][id] += h;
+      cvm::real const f_num = -1.0 * (e_plus - e_minus) / (2.0*h);
+      if (std::fabs(forces[i][id] - f_num) > 1.0e-6 * (1.0 + std::fabs(f_num))) {
+        std::cerr << "Error: force on atom " << ids[i]+1 << ", component " << id
+                  << ": " << forces[i][id] << " instead of " << f_num << "\n";
+        error_code = 1;
+      }
+    }
+  }
+
+  std::cout << "Compared the forces on " << ids.size()
+            << " atoms with finite differences of the energy "
+            << energy << ".\n";
+
+  delete proxy;
+  return error_code;
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+
+#include "colvarproxy_stub.h"
+#include "colvars_test_utils.h"
+
+
+std::string const config_plugin =
+  "colvar {\n"
+  "  name d\n"
+  "  plugin {\n"
+  "    library " CVC_PLUGIN_PATH "\n"
+  "    atoms { atomNumbers 1 4 }\n"
+  "  }\n"
+  "}\n"
+  "colvar {\n"
+  "  name d2\n"
+  "  plugin {\n"
+  "    library " CVC_PLUGIN_PATH "\n"
+  "    atoms { atomNumbers 1 4 }\n"
+  "    parameters scale 2.0\n"
+  "  }\n"
+  "}\n";
+
+std::string const config_distance =
+  "colvar {\n"
+  "  name d\n"
+  "  distance {\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 4 }\n"
+  "    forceNoPBC yes\n"
+  "  }\n"
+  "}\n";
+
+std::string const config_bias =
+  "harmonic {\n"
+  "  colvars d\n"
+  "  centers 1.0\n"
+  "  forceConstant 2.0\n"
+  "}\n";
+
+
+// Compute the variables and the atomic forces, with the plugin or with the
+// built-in distance (scaled by hand for the second value)
+int run(bool plugin, colvars_test::run_results &results)
+{
+  int error_code = COLVARS_OK;
+  colvarproxy_stub *proxy =
+    colvars_test::new_proxy((plugin ? config_plugin : config_distance) +
+                            config_bias, error_code);
+  colvars_test::set_test_positions(proxy, 0);
+  error_code |= proxy->colvars->calc();
+
+  cvm::real const d = cvm::colvar_by_name("d")->value().real_value;
+  results.values.push_back(d);
+  results.values.push_back(plugin ?
+                           cvm::colvar_by_name("d2")->value().real_value :
+                           2.0 * d);
+  colvars_test::append_applied_forces(proxy, results.forces);
+
+  delete proxy;
+  return error_code;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  return colvars_test::compare_runs(&run, 1.0e-12);
+}
@@ -0,0 +1,71 @@
+// Example of a component plugin: distance between the first two atoms,
+// multiplied by an optional scaling factor given as parameter
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "colvarcomp_plugin_api.h"
+
+
+namespace {
+
+  struct distance_plugin {
+    double scale;
+    double dist;
+  };
+
+  void *create(char const *parameters, int num_atoms, char *error_msg,
+               int error_msg_len)
+  {
+    if (num_atoms != 2) {
+      std::strncpy(error_msg, "exactly two atoms are needed", error_msg_len);
+      return NULL;
+    }
+    distance_plugin *p = new distance_plugin;
+    p->scale = 1.0;
+    p->dist = 0.0;
+    std::sscanf(parameters, " scale %lf", &(p->scale));
+    return p;
+  }
+
+  void destroy(void *instance)
+  {
+    delete reinterpret_cast<distance_plugin *>(instance);
+  }
+
+  int calc_value(void *instance, int, double const *pos, double *value)
+  {
+    distance_plugin *p = reinterpret_cast<distance_plugin *>(instance);
+    double const dx = pos[3] - pos[0], dy = pos[4] - pos[1], dz = pos[5] - pos[2];
+    p->dist = std::sqrt(dx*dx + dy*dy + dz*dz);
+    *value = p->scale * p->dist;
+    return 0;
+  }
+
+  int calc_gradients(void *instance, int, double const *pos, double *grad)
+  {
+    distance_plugin *p = reinterpret_cast<distance_plugin *>(instance);
+    if (p->dist == 0.0) return 1;
+    for (int d = 0; d < 3; d++) {
+      grad[3+d] = p->scale * (pos[3+d] - pos[d]) / p->dist;
+      grad[d] = -grad[3+d];
+    }
+    return 0;
+  }
+
+  colvars_cvc_plugin const functions = {
+    COLVARS_CVC_PLUGIN_API_VERSION,
+    "distance",
+    &create,
+    &destroy,
+    &calc_value,
+    &calc_gradients
+  };
+}
+
+
+extern "C" colvars_cvc_plugin const *colvars_cvc_plugin_entry()
+{
+  return &functions;
+}
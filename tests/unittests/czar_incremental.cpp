@@ -0,0 +1,112 @@
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvargrid.h"
+
+#include "colvarproxy_stub.h"
+
+
+std::string const config =
+  "colvar {\n"
+  "  name d\n"
+  "  width 0.5\n"
+  "  lowerBoundary 0.0\n"
+  "  upperBoundary 5.0\n"
+  "  distance {\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 2 }\n"
+  "  }\n"
+  "}\n"
+  "colvar {\n"
+  "  name phi\n"
+  "  width 30.0\n"
+  "  dihedral {\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 2 }\n"
+  "    group3 { atomNumbers 3 }\n"
+  "    group4 { atomNumbers 4 }\n"
+  "  }\n"
+  "}\n";
+
+
+int compare_grids(colvar_grid<cvm::real> const &a, colvar_grid<cvm::real> const &b,
+                  std::string const &what)
+{
+  for (size_t i = 0; i < a.raw_data_num(); i++) {
+    if (a.value(i) != b.value(i)) {
+      std::cerr << "Error: " << what << " differs at index " << i << ": "
+                << a.value(i) << " instead of " << b.value(i) << "\n";
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  colvarproxy_stub *proxy = new colvarproxy_stub();
+  int error_code = proxy->colvars->read_config_string(config);
+  std::vector<colvar *> cvs;
+  cvs.push_back(cvm::colvar_by_name("d"));
+  cvs.push_back(cvm::colvar_by_name("phi"));
+
+  colvar_grid_count z_samples(cvs);
+  colvar_grid_gradient z_gradients(cvs);
+  z_gradients.samples = &z_samples;
+  colvar_grid_gradient czar(cvs), czar_ref(cvs);
+  integrate_potential pmf(cvs, &czar), pmf_ref(cvs, &czar_ref);
+
+  cvm::real const kT = 0.6;
+  czar.set_czar(z_gradients, z_samples, kT);
+  pmf.set_div();
+
+  std::srand(1);
+  std::vector< std::vector<int> > updated;
+  size_t num_updated = 0;
+  int const num_rounds = 20;
+  for (int round = 0; round < num_rounds; round++) {
+
+    // Sample a few bins, including the edges of the non-periodic variable
+    for (int k = 0; k < 5; k++) {
+      std::vector<int> ix(2);
+      ix[0] = std::rand() % int(z_samples.number_of_points(0));
+      ix[1] = std::rand() % int(z_samples.number_of_points(1));
+      cvm::real force[2];
+      force[0] = cvm::real(std::rand() % 100) / 10.0 - 5.0;
+      force[1] = cvm::real(std::rand() % 100) / 10.0 - 5.0;
+      z_gradients.acc_force(ix, force);
+      czar.flag_czar_bin(ix);
+    }
+
+    czar.update_czar(z_gradients, z_samples, kT, updated);
+    for (size_t i = 0; i < updated.size(); i++) {
+      pmf.update_div_neighbors(updated[i]);
+    }
+    num_updated += updated.size();
+
+    czar_ref.set_czar(z_gradients, z_samples, kT);
+    pmf_ref.set_div();
+
+    error_code |= compare_grids(czar, czar_ref, "CZAR gradient");
+
+    // Identical divergences give identical solutions from the same guess
+    pmf.reset();
+    pmf_ref.reset();
+    cvm::real err;
+    pmf.integrate(200, 1.0e-12, err);
+    pmf_ref.integrate(200, 1.0e-12, err);
+    error_code |= compare_grids(pmf, pmf_ref, "CZAR PMF");
+  }
+
+  std::cout << "Updated " << num_updated << " points in " << num_rounds
+            << " rounds, out of " << czar.number_of_points() << "\n";
+  if (num_updated >= num_rounds * czar.number_of_points()) error_code = 1;
+
+  delete proxy;
+  return error_code;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <string>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+
+
+// Proxy with two atoms on the x axis
+class deferred_gradients_proxy : public colvarproxy {
+public:
+  deferred_gradients_proxy()
+  {
+    angstrom_value = 1.0;
+    boundaries_type = boundaries_non_periodic;
+  }
+  int init_atom(int atom_number)
+  {
+    return add_atom_slot(atom_number);
+  }
+  void set_distance(cvm::real d)
+  {
+    atoms_positions[0] = cvm::atom_pos(0.0, 0.0, 0.0);
+    atoms_positions[1] = cvm::atom_pos(d, 0.0, 0.0);
+    reset_atoms_applied_forces();
+  }
+  cvm::rvector force(size_t i) const
+  {
+    return atoms_new_colvar_forces[i];
+  }
+};
+
+
+// Number of calls to calc_gradients recorded by the profiler
+size_t count_gradient_calls(std::string const &report)
+{
+  std::string const key("calc_gradients");
+  size_t const pos = report.find(key);
+  if (pos == std::string::npos) return 0;
+  size_t const line_start = report.rfind('\n', pos) + 1;
+  return std::stoul(report.substr(line_start, pos - line_start));
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  deferred_gradients_proxy *proxy = new deferred_gradients_proxy();
+  proxy->colvars = new colvarmodule(proxy);
+
+  int error_code = proxy->colvars->read_config_string(
+    "colvar {\n"
+    "  name d\n"
+    "  distance {\n"
+    "    group1 { atomNumbers 1 }\n"
+    "    group2 { atomNumbers 2 }\n"
+    "  }\n"
+    "}\n"
+    "harmonicWalls {\n"
+    "  colvars d\n"
+    "  lowerWalls 1.0\n"
+    "  upperWalls 3.0\n"
+    "  forceConstant 2.0\n"
+    "}\n");
+  error_code |= proxy->colvars->set_profiling(true);
+
+  // Inside the walls, the bias force is zero: no gradients, no atomic forces
+  proxy->set_distance(2.0);
+  error_code |= proxy->colvars->calc();
+  size_t n_calls = count_gradient_calls(proxy->colvars->profile_report());
+  if (n_calls != 0) {
+    std::cerr << "Error: gradients computed " << n_calls
+              << " times with zero force.\n";
+    error_code = 1;
+  }
+  if (proxy->force(0).norm2() + proxy->force(1).norm2() != 0.0) {
+    std::cerr << "Error: non-zero atomic forces inside the walls.\n";
+    error_code = 1;
+  }
+
+  // Beyond the upper wall, gradients are computed and forces applied
+  proxy->set_distance(3.5);
+  error_code |= proxy->colvars->calc();
+  n_calls = count_gradient_calls(proxy->colvars->profile_report());
+  if (n_calls != 1) {
+    std::cerr << "Error: gradients computed " << n_calls
+              << " times instead of 1.\n";
+    error_code = 1;
+  }
+  // Force constant is scaled by the square of the width (1.0)
+  cvm::rvector const f_ref(-2.0 * 0.5, 0.0, 0.0);
+  if (((proxy->force(1) - f_ref).norm() > 1.0e-12) ||
+      ((proxy->force(0) + f_ref).norm() > 1.0e-12)) {
+    std::cerr << "Error: wrong atomic forces " << proxy->force(0) << ", "
+              << proxy->force(1) << " (expected " << -1.0 * f_ref << ", "
+              << f_ref << ").\n";
+    error_code = 1;
+  }
+
+  return error_code;
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvargrid.h"
+
+#include "colvarproxy_stub.h"
+
+
+std::string const config =
+  "colvar {\n"
+  "  name d\n"
+  "  width 0.5\n"
+  "  lowerBoundary 0.0\n"
+  "  upperBoundary 5.0\n"
+  "  distance {\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 2 }\n"
+  "  }\n"
+  "}\n";
+
+
+// Reconstruct all frames from the binary history file; also count the
+// keyframes
+int read_history(std::string const &filename, std::vector<cvm::step_number> &steps,
+                 std::vector< std::vector<cvm::real> > &frames,
+                 size_t &num_keyframes)
+{
+  std::ifstream is(filename.c_str(), std::ios::binary);
+  char signature[8];
+  is.read(signature, 8);
+  if (std::strncmp(signature, "CVGRIDH2", 8) != 0) return 1;
+  cvm::real nd_mult[2];
+  is.read(reinterpret_cast<char *>(nd_mult), sizeof(nd_mult));
+  std::vector<cvm::real> header(4 * size_t(nd_mult[0]));
+  is.read(reinterpret_cast<char *>(&(header[0])),
+          header.size() * sizeof(cvm::real));
+
+  std::vector<cvm::real> data;
+  cvm::real frame_header[3];
+  num_keyframes = 0;
+  while (is.read(reinterpret_cast<char *>(frame_header), sizeof(frame_header))) {
+    steps.push_back(cvm::step_number(frame_header[0]));
+    size_t const n = size_t(frame_header[2]);
+    if (frame_header[1] == 0.0) {
+      data.resize(n);
+      is.read(reinterpret_cast<char *>(&(data[0])), n * sizeof(cvm::real));
+      num_keyframes++;
+    } else {
+      std::vector<int> indices(n);
+      std::vector<cvm::real> values(n);
+      if (n > 0) {
+        is.read(reinterpret_cast<char *>(&(indices[0])), n * sizeof(int));
+        is.read(reinterpret_cast<char *>(&(values[0])), n * sizeof(cvm::real));
+      }
+      for (size_t j = 0; j < n; j++) {
+        data[indices[j]] = values[j];
+      }
+    }
+    if (!is) return 1;
+    frames.push_back(data);
+  }
+  return 0;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  colvarproxy_stub *proxy = new colvarproxy_stub();
+  int error_code = proxy->colvars->read_config_string(config);
+  std::vector<colvar *> cvs(1, cvm::colvar_by_name("d"));
+  colvar_grid_scalar grid(cvs);
+
+  std::string const filename("test_grid_history.bin");
+  colvar_grid_history history;
+  history.init(filename, 4);
+
+  // Change a few bins at each frame, except at frame 6 where all bins
+  // change, and keep a copy of each frame
+  std::vector< std::vector<cvm::real> > frames_ref;
+  int const num_frames = 10;
+  for (int t = 0; t < num_frames; t++) {
+    if (t == 6) grid.add_constant(0.125);
+    std::vector<int> ix(1, (3 * t) % int(grid.number_of_points()));
+    grid.set_value(ix, grid.value(ix) + 1.5);
+    ix[0] = (ix[0] + 1) % int(grid.number_of_points());
+    grid.set_value(ix, -0.25 * t);
+    std::vector<cvm::real> data(grid.number_of_points());
+    for (size_t i = 0; i < data.size(); i++) data[i] = grid.value(i);
+    frames_ref.push_back(data);
+    error_code |= history.write_frame(grid, 100 * t);
+  }
+  proxy->close_output_stream(filename);
+
+  std::vector<cvm::step_number> steps;
+  std::vector< std::vector<cvm::real> > frames;
+  size_t num_keyframes = 0;
+  error_code |= read_history(filename, steps, frames, num_keyframes);
+  if (frames.size() != size_t(num_frames)) {
+    std::cerr << "Error: " << frames.size() << " frames read instead of "
+              << num_frames << "\n";
+    error_code = 1;
+  }
+  for (size_t t = 0; t < frames.size(); t++) {
+    if ((steps[t] != cvm::step_number(100 * t)) || (frames[t] != frames_ref[t])) {
+      std::cerr << "Error: frame " << t << " reconstructed incorrectly\n";
+      error_code = 1;
+    }
+  }
+
+  // Frames 0, 4 and 8 are keyframes by frequency, frame 6 because most of
+  // its values changed
+  if (num_keyframes != 4) {
+    std::cerr << "Error: " << num_keyframes << " keyframes instead of 4\n";
+    error_code = 1;
+  }
+
+  // Four keyframes plus two or three changed values per frame
+  std::ifstream is(filename.c_str(), std::ios::binary | std::ios::ate);
+  size_t const file_size = size_t(is.tellg());
+  size_t const full_size = 8 + sizeof(cvm::real) *
+    (6 + num_frames * (3 + grid.number_of_points()));
+  std::cout << "History file size: " << file_size << " bytes ("
+            << full_size << " with keyframes only)\n";
+  if (file_size >= full_size) error_code = 1;
+
+  proxy->remove_file(filename);
+  delete proxy;
+  return error_code;
+}
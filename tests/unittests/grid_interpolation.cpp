@@ -0,0 +1,136 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvargrid.h"
+
+#include "colvarproxy_stub.h"
+
+
+std::string const config =
+  "colvar {\n"
+  "  name d\n"
+  "  width 0.5\n"
+  "  lowerBoundary 0.0\n"
+  "  upperBoundary 5.0\n"
+  "  distance {\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 2 }\n"
+  "  }\n"
+  "}\n"
+  "colvar {\n"
+  "  name phi\n"
+  "  width 30.0\n"
+  "  dihedral {\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 2 }\n"
+  "    group3 { atomNumbers 3 }\n"
+  "    group4 { atomNumbers 4 }\n"
+  "  }\n"
+  "}\n";
+
+
+// Smooth test function, periodic in the second variable (degrees)
+cvm::real test_function(cvm::real d, cvm::real phi)
+{
+  return std::cos(0.8*d) * (1.0 + 0.5*std::sin(phi*PI/180.0));
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  colvarproxy_stub *proxy = new colvarproxy_stub();
+  int error_code = proxy->colvars->read_config_string(config);
+  std::vector<colvar *> cvs;
+  cvs.push_back(cvm::colvar_by_name("d"));
+  cvs.push_back(cvm::colvar_by_name("phi"));
+
+  colvar_grid_scalar grid(cvs);
+  std::vector<int> ix = grid.new_index();
+  for ( ; grid.index_ok(ix); grid.incr(ix)) {
+    grid.set_value(ix, test_function(grid.bin_to_value_scalar(ix[0], 0).real_value,
+                                     grid.bin_to_value_scalar(ix[1], 1).real_value));
+  }
+
+  // Both interpolations are exact at the centers of the bins
+  std::vector<colvarvalue> values(2, colvarvalue(colvarvalue::type_scalar));
+  for (ix = grid.new_index(); grid.index_ok(ix); grid.incr(ix)) {
+    values[0] = grid.bin_to_value_scalar(ix[0], 0);
+    values[1] = grid.bin_to_value_scalar(ix[1], 1);
+    for (int order = 1; order <= 3; order += 2) {
+      if (std::fabs(grid.value_interpolated(&values, order) - grid.value(ix)) >
+          1.0e-12) {
+        std::cerr << "Error: interpolation of order " << order
+                  << " is not exact at " << ix[0] << " " << ix[1] << "\n";
+        error_code = 1;
+      }
+    }
+  }
+
+  // Compare the errors of each method at random points away from the
+  // non-periodic edges, including across the periodic boundary
+  cvm::real max_err[3] = { 0.0, 0.0, 0.0 };
+  std::srand(1);
+  for (int k = 0; k < 1000; k++) {
+    cvm::real const d = 1.0 + 3.0 * cvm::real(std::rand()) / RAND_MAX;
+    cvm::real const phi = -180.0 + 360.0 * cvm::real(std::rand()) / RAND_MAX;
+    values[0] = d;
+    values[1] = phi;
+    cvm::real const f = test_function(d, phi);
+    cvm::real const err[3] = {
+      std::fabs(grid.value(grid.get_colvars_index(values)) - f),
+      std::fabs(grid.value_interpolated(&values, 1) - f),
+      std::fabs(grid.value_interpolated(&values, 3) - f) };
+    for (int m = 0; m < 3; m++) {
+      if (err[m] > max_err[m]) max_err[m] = err[m];
+    }
+
+    // Gradients are consistent with the interpolated values
+    cvm::real const h = 1.0e-6;
+    for (int order = 1; order <= 3; order += 2) {
+      cvm::real grad[2];
+      cvm::real const v = grid.value_interpolated(&values, order, grad);
+      for (int i = 0; i < 2; i++) {
+        std::vector<colvarvalue> values_h(values);
+        values_h[i].real_value += h;
+        cvm::real const dv = (grid.value_interpolated(&values_h, order) - v) / h;
+        if (std::fabs(dv - grad[i]) > 1.0e-4 * (1.0 + std::fabs(dv))) {
+          std::cerr << "Error: gradient " << grad[i] << " instead of " << dv
+                    << " for order " << order << "\n";
+          error_code = 1;
+        }
+      }
+    }
+  }
+
+  std::cout << "Maximum errors: nearest bin = " << max_err[0]
+            << ", linear = " << max_err[1] << ", cubic = " << max_err[2]
+            << "\n";
+  if (!(max_err[2] < 0.5 * max_err[1] && max_err[1] < 0.5 * max_err[0])) {
+    error_code = 1;
+  }
+
+  // Linear bin indices address the same data as index vectors
+  colvar_grid_count samples(cvs);
+  colvar_grid_gradient gradients(cvs);
+  gradients.samples = &samples;
+  ix = gradients.new_index();
+  ix[0] = 3; ix[1] = 5;
+  cvm::real const force[2] = { 1.5, -2.0 };
+  gradients.acc_force(ix, force);
+  gradients.acc_force(ix, force);
+  std::vector<cvm::real> v1(2), v2(2);
+  gradients.vector_value(ix, v1);
+  gradients.vector_value(size_t(3 * samples.number_of_points(1) + 5), v2);
+  if (v1 != v2 || v1[0] != -1.5) {
+    std::cerr << "Error: vector_value() by linear index is inconsistent.\n";
+    error_code = 1;
+  }
+
+  delete proxy;
+  return error_code;
+}
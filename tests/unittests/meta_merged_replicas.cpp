@@ -0,0 +1,161 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvarbias.h"
+
+#include "colvarproxy_stub.h"
+#include "colvars_test_utils.h"
+
+
+std::string const registry("test_meta_replicas.registry.txt");
+
+
+std::string config(std::string const &replica, bool merge)
+{
+  return
+    "colvar {\n"
+    "  name d\n"
+    "  width 0.1\n"
+    "  lowerBoundary 0.0\n"
+    "  upperBoundary 5.0\n"
+    "  distance {\n"
+    "    forceNoPBC yes\n"
+    "    group1 { atomNumbers 1 }\n"
+    "    group2 { atomNumbers 2 }\n"
+    "  }\n"
+    "}\n"
+    "metadynamics {\n"
+    "  name meta\n"
+    "  colvars d\n"
+    "  hillWeight 0.5\n"
+    "  hillWidth 2.0\n"
+    "  newHillFrequency 1\n"
+    "  multipleReplicas on\n"
+    "  replicaID " + replica + "\n"
+    "  replicasRegistry " + registry + "\n"
+    "  replicaUpdateFrequency 1000\n"
+    "  mergeReplicaGrids " + std::string(merge ? "on" : "off") + "\n"
+    "}\n";
+}
+
+
+void set_distance(colvarproxy_stub *proxy, cvm::real d)
+{
+  (*proxy->modify_atom_positions())[0] = cvm::atom_pos(0.0, 0.0, 0.0);
+  (*proxy->modify_atom_positions())[1] = cvm::atom_pos(d, 0.0, 0.0);
+  proxy->reset_atoms_applied_forces();
+}
+
+
+// Run a replica that shares a state file and a non-empty buffer of hills
+int run_replica(std::string const &replica, cvm::real d0)
+{
+  int error_code = COLVARS_OK;
+  colvarproxy_stub *proxy =
+    colvars_test::new_proxy(config(replica, false), error_code,
+                            "test_meta_" + replica);
+  error_code |= proxy->colvars->setup_output();
+  for (int step = 0; step < 10; step++) {
+    cvm::it = step;
+    set_distance(proxy, d0 + 0.1 * step);
+    error_code |= proxy->colvars->calc();
+    if (step == 5) {
+      error_code |= cvm::bias_by_name("meta")->write_state_to_replicas();
+    }
+  }
+  error_code |= proxy->flush_output_streams();
+  delete proxy;
+  return error_code;
+}
+
+
+// Write the registry with the given replicas only
+void write_registry(std::vector<std::string> const &lines, size_t n)
+{
+  std::ofstream os(registry.c_str());
+  for (size_t i = 0; i < n; i++) {
+    os << lines[i] << "\n";
+  }
+}
+
+
+// Lines of the registry written by replicas B and C
+std::vector<std::string> registry_lines;
+
+
+// Compute the bias of the first replica, which reads replica B at step 0
+// and replica C at step 1000; the state file of B is hidden meanwhile, so
+// that reading it again (i.e. rebuilding the merged grids) would drop it
+int run_main_replica(bool merge, colvars_test::run_results &results)
+{
+  std::string const state_B("test_meta_B.colvars.meta.B.state");
+  write_registry(registry_lines, 1);
+  int error_code = COLVARS_OK;
+  colvarproxy_stub *proxy = colvars_test::new_proxy(config("A", merge),
+                                                    error_code, "test_meta_A");
+  error_code |= proxy->colvars->setup_output();
+  cvm::it = 0;
+  set_distance(proxy, 1.5);
+  error_code |= proxy->colvars->calc();
+  error_code |= proxy->rename_file(state_B, state_B + ".hidden");
+  write_registry(registry_lines, 2);
+  cvm::it = 1000;
+  set_distance(proxy, 1.5);
+  error_code |= proxy->colvars->calc();
+  error_code |= proxy->rename_file(state_B + ".hidden", state_B);
+  cvm::real const energy = cvm::bias_by_name("meta")->get_energy();
+  // Two local hills, plus 10 from each of the other replicas
+  if (!merge && (energy <= 0.5)) {
+    std::cerr << "Error: the hills of the other replicas are missing.\n";
+    error_code = 1;
+  }
+  results.values.push_back(energy);
+  colvars_test::append_applied_forces(proxy, results.forces);
+  error_code |= proxy->flush_output_streams();
+  delete proxy;
+  return error_code;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  colvarproxy_stub *proxy = new colvarproxy_stub();
+  proxy->remove_file(registry);
+  delete proxy;
+
+  int error_code = run_replica("B", 1.0);
+  error_code |= run_replica("C", 1.8);
+
+  {
+    std::ifstream is(registry.c_str());
+    std::string line;
+    while (std::getline(is, line)) {
+      registry_lines.push_back(line);
+    }
+  }
+  if (registry_lines.size() != 2) {
+    std::cerr << "Error: the registry should contain replicas B and C.\n";
+    return 1;
+  }
+
+  // Merged grids give the same bias as separate ones
+  error_code |= colvars_test::compare_runs(&run_main_replica, 1.0e-12);
+
+  proxy = new colvarproxy_stub();
+  proxy->remove_file(registry);
+  char const *replicas[] = { "A", "B", "C" };
+  for (size_t i = 0; i < 3; i++) {
+    std::string const r(replicas[i]);
+    proxy->remove_file("meta." + r + ".files.txt");
+    proxy->remove_file("meta." + r + ".files.txt.BAK");
+    proxy->remove_file("test_meta_" + r + ".colvars.meta." + r + ".hills");
+    proxy->remove_file("test_meta_" + r + ".colvars.meta." + r + ".state");
+  }
+  delete proxy;
+
+  return error_code;
+}
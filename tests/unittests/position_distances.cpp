@@ -0,0 +1,189 @@
+#include <iostream>
+#include <cmath>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvaratoms.h"
+#include "colvar.h"
+#include "colvarcomp.h"
+
+
+// Proxy that can set the unit cell
+class pbc_test_proxy : public colvarproxy {
+public:
+  void set_cell(int type, cvm::rvector const &a, cvm::rvector const &b,
+                cvm::rvector const &c)
+  {
+    batched_cell_distances = true;
+    boundaries_type = static_cast<Boundaries_type>(type);
+    unit_cell_x = a;
+    unit_cell_y = b;
+    unit_cell_z = c;
+    if (boundaries_type != boundaries_non_periodic) {
+      update_pbc_lattice();
+    }
+  }
+  int test_batch(std::vector<cvm::atom_pos> const &pos)
+  {
+    size_t const n = pos.size();
+    std::vector<cvm::rvector> dist(n);
+    int error_code = 0;
+    for (size_t i = 0; i < n; i++) {
+      position_distances(pos[i], &(pos[0]), n, &(dist[0]));
+      for (size_t j = 0; j < n; j++) {
+        cvm::rvector const ref = position_distance(pos[i], pos[j]);
+        if ((dist[j] - ref).norm() > 1.0e-12) {
+          std::cerr << "Mismatch for pair " << i << " " << j << ": "
+                    << dist[j] << " vs. " << ref << "\n";
+          error_code = 1;
+        }
+      }
+    }
+    return error_code;
+  }
+};
+
+
+// Proxy with its own minimum-image convention, like NAMD or LAMMPS: the cell
+// that it passes to Colvars has a wrong element, which must not be used
+class engine_test_proxy : public colvarproxy {
+public:
+  engine_test_proxy(cvm::rvector const &a, cvm::rvector const &b,
+                    cvm::rvector const &c)
+    : box_a(a), box_b(b), box_c(c)
+  {
+    angstrom_value = 1.0;
+    boundaries_type = boundaries_pbc_triclinic;
+    unit_cell_x = a;
+    unit_cell_y = cvm::rvector(b.x, b.y, c.z);
+    unit_cell_z = c;
+    update_pbc_lattice();
+    cvm::rvector const va = cvm::rvector::outer(b, c);
+    cvm::rvector const vb = cvm::rvector::outer(c, a);
+    cvm::rvector const vc = cvm::rvector::outer(a, b);
+    recip_a = va/(va*a);
+    recip_b = vb/(vb*b);
+    recip_c = vc/(vc*c);
+  }
+  cvm::rvector position_distance(cvm::atom_pos const &pos1,
+                                 cvm::atom_pos const &pos2) const override
+  {
+    cvm::rvector const diff = pos2 - pos1;
+    return diff - std::floor(recip_a*diff + 0.5) * box_a
+      - std::floor(recip_b*diff + 0.5) * box_b
+      - std::floor(recip_c*diff + 0.5) * box_c;
+  }
+  int init_atom(int atom_number) override
+  {
+    for (size_t i = 0; i < atoms_ids.size(); i++) {
+      if (atoms_ids[i] == atom_number) {
+        atoms_ncopies[i] += 1;
+        return i;
+      }
+    }
+    return add_atom_slot(atom_number);
+  }
+  cvm::rvector box_a, box_b, box_c, recip_a, recip_b, recip_c;
+};
+
+
+// Check that the batched distances and the components using them follow the
+// engine's implementation
+int test_engine_override(std::vector<cvm::atom_pos> const &pos)
+{
+  int error_code = 0;
+  engine_test_proxy *proxy =
+    new engine_test_proxy(cvm::rvector(31.0, 0.0, 0.0),
+                          cvm::rvector(5.0, 27.0, 2.0),
+                          cvm::rvector(-4.0, 6.0, 43.0));
+  proxy->colvars = new colvarmodule(proxy);
+
+  size_t const n = pos.size();
+  std::vector<cvm::rvector> dist(n);
+  cvm::position_distances(pos[0], &(pos[0]), n, &(dist[0]));
+  for (size_t j = 0; j < n; j++) {
+    if ((dist[j] - proxy->position_distance(pos[0], pos[j])).norm() > 1.0e-12) {
+      std::cerr << "Error: batched distance " << dist[j]
+                << " differs from the engine's.\n";
+      error_code = 1;
+    }
+  }
+
+  // Two groups of 10 atoms each
+  std::string const groups =
+    "group1 { atomNumbersRange 1-10 }\n"
+    "group2 { atomNumbersRange 11-20 }\n";
+  colvar::distance_pairs *pairs = new colvar::distance_pairs(groups);
+  colvar::coordnum *coord = new colvar::coordnum(groups + "cutoff 8.0\n");
+  for (size_t i = 0; i < 20; i++) {
+    (*proxy->modify_atom_positions())[i] = pos[i];
+  }
+  pairs->read_data();
+  pairs->calc_value();
+  coord->read_data();
+  coord->calc_value();
+
+  cvm::real coord_ref = 0.0;
+  for (size_t i1 = 0; i1 < 10; i1++) {
+    for (size_t i2 = 0; i2 < 10; i2++) {
+      cvm::real const d = proxy->position_distance(pos[i1], pos[10+i2]).norm();
+      if (std::fabs(pairs->value()[i1*10+i2] - d) > 1.0e-12) {
+        std::cerr << "Error: distancePairs element " << i1*10+i2 << " = "
+                  << pairs->value()[i1*10+i2] << " instead of " << d << "\n";
+        error_code = 1;
+      }
+      cvm::real const l2 = (d/8.0)*(d/8.0);
+      cvm::real const l6 = l2*l2*l2;
+      coord_ref += (1.0 - l6) / (1.0 - l6*l6);
+    }
+  }
+  std::cout << "coordNum = " << coord->value().real_value << " (expected "
+            << coord_ref << ")\n";
+  if (std::fabs(coord->value().real_value - coord_ref) > 1.0e-10) {
+    error_code = 1;
+  }
+
+  delete pairs;
+  delete coord;
+  delete proxy;
+  return error_code;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  pbc_test_proxy *proxy = new pbc_test_proxy();
+  proxy->colvars = new colvarmodule(proxy);
+
+  std::vector<cvm::atom_pos> pos;
+  for (int i = 0; i < 50; i++) {
+    // Deterministic spread of positions over several cell lengths
+    pos.push_back(cvm::atom_pos(13.7*((i*37)%23) - 150.0,
+                                9.1*((i*11)%29) - 120.0,
+                                7.3*((i*5)%31) - 100.0));
+  }
+
+  int error_code = 0;
+
+  proxy->set_cell(0, cvm::rvector(0.0, 0.0, 0.0), cvm::rvector(0.0, 0.0, 0.0),
+                  cvm::rvector(0.0, 0.0, 0.0));
+  std::cout << "Non-periodic\n";
+  error_code |= proxy->test_batch(pos);
+
+  proxy->set_cell(1, cvm::rvector(31.0, 0.0, 0.0), cvm::rvector(0.0, 27.0, 0.0),
+                  cvm::rvector(0.0, 0.0, 43.0));
+  std::cout << "Orthorhombic\n";
+  error_code |= proxy->test_batch(pos);
+
+  proxy->set_cell(2, cvm::rvector(31.0, 0.0, 0.0), cvm::rvector(5.0, 27.0, 0.0),
+                  cvm::rvector(-4.0, 6.0, 43.0));
+  std::cout << "Triclinic\n";
+  error_code |= proxy->test_batch(pos);
+
+  delete proxy;
+
+  std::cout << "Engine implementation\n";
+  error_code |= test_engine_override(pos);
+
+  return error_code;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <string>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvarscript.h"
+
+
+// Minimal proxy that can allocate atom slots
+class profiler_test_proxy : public colvarproxy {
+public:
+  profiler_test_proxy()
+  {
+    boundaries_type = boundaries_non_periodic;
+  }
+  int init_atom(int atom_number)
+  {
+    return add_atom_slot(atom_number);
+  }
+  void log(std::string const &message)
+  {
+    log_text += message;
+    colvarproxy::log(message);
+  }
+  std::string log_text;
+};
+
+
+std::string run_command(std::string const &cmd, std::string const &arg = "")
+{
+  unsigned char *objv[3];
+  objv[0] = (unsigned char *) "cv";
+  objv[1] = (unsigned char *) cmd.c_str();
+  objv[2] = (unsigned char *) arg.c_str();
+  if (run_colvarscript_command(arg.size() ? 3 : 2, objv) != COLVARSCRIPT_OK) {
+    return "ERROR";
+  }
+  return std::string(get_colvarscript_result());
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  profiler_test_proxy *proxy = new profiler_test_proxy();
+  proxy->colvars = new colvarmodule(proxy);
+
+  int error_code = proxy->colvars->read_config_string(
+    "profiling on\n"
+    "colvar {\n"
+    "  name d\n"
+    "  distance {\n"
+    "    group1 { atomNumbers 1 2 }\n"
+    "    group2 { atomNumbers 3 }\n"
+    "  }\n"
+    "}\n"
+    "harmonic {\n"
+    "  name h\n"
+    "  colvars d\n"
+    "  centers 1.0\n"
+    "  forceConstant 1.0\n"
+    "}\n");
+
+  for (size_t i = 0; i < proxy->get_atom_positions()->size(); i++) {
+    (*proxy->modify_atom_positions())[i] = cvm::rvector(i, 0.5*i, 0.0);
+  }
+
+  for (int step = 0; step < 5; step++) {
+    error_code |= proxy->colvars->calc();
+  }
+
+  std::string const report = run_command("profile");
+  std::cout << report;
+
+  char const *items[] = { "colvarmodule: calc",
+                          "distance", "calc_value", "calc_gradients",
+                          "apply_force", "bias h: update" };
+  for (size_t i = 0; i < sizeof(items)/sizeof(items[0]); i++) {
+    if (report.find(items[i]) == std::string::npos) {
+      std::cerr << "Error: \"" << items[i] << "\" missing from the report.\n";
+      error_code = 1;
+    }
+  }
+
+  // Every operation ran once per step
+  if (report.find("         5 ") == std::string::npos) {
+    std::cerr << "Error: wrong number of calls.\n";
+    error_code = 1;
+  }
+
+  // Slots are identified by the contents of the names, which are copied
+  int slots[2];
+  for (int i = 0; i < 2; i++) {
+    slots[i] = proxy->colvars->profile_slot(std::string("temporary ") + "name",
+                                            "op");
+    cvm::profile_timer const timer(slots[i]);
+  }
+  if ((slots[0] != slots[1]) ||
+      (run_command("profile").find("         2 ") == std::string::npos)) {
+    std::cerr << "Error: timers with equal names not merged.\n";
+    error_code = 1;
+  }
+
+  // The report is logged at the end of the run, not with every output
+  proxy->log_text.clear();
+  error_code |= proxy->colvars->write_output_files();
+  if (proxy->log_text.find("Time spent") != std::string::npos) {
+    std::cerr << "Error: report logged when writing output files.\n";
+    error_code = 1;
+  }
+  error_code |= proxy->post_run();
+  if (proxy->log_text.find("temporary name: op") == std::string::npos) {
+    std::cerr << "Error: report not logged at the end of the run.\n";
+    error_code = 1;
+  }
+
+  // Timings are cleared, and no longer collected when profiling is off
+  if ((run_command("profile", "reset") == "ERROR") ||
+      (run_command("profile", "off") == "ERROR")) {
+    error_code = 1;
+  }
+  error_code |= proxy->colvars->calc();
+  if (run_command("profile").find("calc_value") != std::string::npos) {
+    std::cerr << "Error: timings collected after disabling the profiler.\n";
+    error_code = 1;
+  }
+
+  if (run_command("profile", "sideways") != "ERROR") {
+    std::cerr << "Error: invalid action accepted.\n";
+    error_code = 1;
+  }
+
+  return error_code;
+}
@@ -0,0 +1,199 @@
+#include <iostream>
+#include <sstream>
+#include <cmath>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvaratoms.h"
+#include "colvar.h"
+#include "colvarcomp.h"
+
+
+// Proxy that numbers the backbone atoms N, CA, C, O of each residue
+class protein_test_proxy : public colvarproxy {
+public:
+
+  protein_test_proxy()
+  {
+    angstrom_value = 1.0;
+    boundaries_type = boundaries_non_periodic;
+  }
+
+  /// If true, the O atom of each residue is the N atom of the next one,
+  /// so that atoms are shared between hydrogen bonds
+  static bool merge_o_n;
+
+  static int atom_number(int residue, std::string const &atom_name)
+  {
+    if (merge_o_n && (atom_name == "O")) return atom_number(residue+1, "N");
+    int k = 0;
+    if (atom_name == "CA") k = 1;
+    if (atom_name == "C") k = 2;
+    if (atom_name == "O") k = 3;
+    return 4*(residue-1) + k + 1;
+  }
+
+  int init_atom(int atom_number)
+  {
+    for (size_t i = 0; i < atoms_ids.size(); i++) {
+      if (atoms_ids[i] == atom_number) {
+        atoms_ncopies[i] += 1;
+        return i;
+      }
+    }
+    int const index = add_atom_slot(atom_number);
+    atoms_positions[index] = backbone_position(atom_number);
+    return index;
+  }
+
+  int init_atom(cvm::residue_id const &residue,
+                std::string const &atom_name,
+                std::string const & /* segment_id */)
+  {
+    return init_atom(atom_number(residue, atom_name));
+  }
+
+  /// Helix-like coordinates with some irregularity
+  static cvm::atom_pos backbone_position(int atom_number)
+  {
+    cvm::real const s = 0.95 * cvm::real(atom_number) +
+      0.1 * std::sin(3.0 * cvm::real(atom_number));
+    return cvm::atom_pos(2.3 * std::cos(s), 2.3 * std::sin(s), 0.38 * s);
+  }
+};
+
+bool protein_test_proxy::merge_o_n = false;
+
+
+// Value of the component from its current atomic positions
+cvm::real eval(colvar::cvc *cvc)
+{
+  cvc->read_data();
+  cvc->calc_value();
+  return cvc->value().real_value;
+}
+
+
+// Compare the atomic gradients with finite differences, scaling those of
+// the atoms not named unscaled_name by the given factor
+int check_gradients(colvar::cvc *cvc, protein_test_proxy *proxy,
+                    std::string const &unscaled_name, cvm::real scale)
+{
+  int error_code = 0;
+  cvm::real const x0 = eval(cvc);
+  cvc->calc_gradients();
+  cvm::atom_group &group = *(cvc->atom_groups[0]);
+  std::vector<cvm::rvector> grads;
+  for (size_t ia = 0; ia < group.size(); ia++) {
+    grads.push_back(group[ia].grad());
+  }
+
+  cvm::real const h = 1.0e-6;
+  for (size_t ia = 0; ia < group.size(); ia++) {
+    int const index = group[ia].proxy_index();
+    int const number = (*proxy->get_atom_ids())[index];
+    bool const scaled =
+      ((number - 1) % 4 != (protein_test_proxy::atom_number(1, unscaled_name) - 1));
+    for (size_t id = 0; id < 3; id++) {
+      (*proxy->modify_atom_positions())[index][id] += h;
+      cvm::real const x1 = eval(cvc);
+      (*proxy->modify_atom_positions())[index][id] -= h;
+      cvm::real const dx = (x1 - x0) / h * (scaled ? scale : 1.0);
+      if (std::fabs(dx - grads[ia][id]) > 1.0e-4 * (1.0 + std::fabs(dx))) {
+        std::cerr << "Error: gradient of atom " << number << ", component "
+                  << id << ": " << grads[ia][id] << " instead of " << dx
+                  << "\n";
+        error_code = 1;
+      }
+    }
+  }
+  eval(cvc);
+  return error_code;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  protein_test_proxy *proxy = new protein_test_proxy();
+  proxy->colvars = new colvarmodule(proxy);
+
+  int error_code = 0;
+  int const n_res = 8;
+
+  // alpha_angles compared with the individual angle and hBond components
+  colvar::cvc *alpha = new colvar::alpha_angles("residueRange 1-8\n");
+  cvm::real const x_alpha = eval(alpha);
+
+  cvm::real x_ref = 0.0;
+  for (int r = 1; r <= n_res-2; r++) {
+    colvar::angle theta(cvm::atom(r, "CA", "MAIN"), cvm::atom(r+1, "CA", "MAIN"),
+                        cvm::atom(r+2, "CA", "MAIN"));
+    cvm::real const t = (eval(&theta) - 88.0) / 15.0;
+    x_ref += 0.5 / cvm::real(n_res-2) * (1.0 - t*t) / (1.0 - t*t*t*t);
+  }
+  for (int r = 1; r <= n_res-4; r++) {
+    colvar::h_bond hb(cvm::atom(r, "O", "MAIN"), cvm::atom(r+4, "N", "MAIN"),
+                      3.3, 6, 8);
+    x_ref += 0.5 / cvm::real(n_res-4) * eval(&hb);
+  }
+
+  std::cout << "alpha = " << x_alpha << " (expected " << x_ref << ")\n";
+  if (std::fabs(x_alpha - x_ref) > 1.0e-12) error_code = 1;
+
+  // Hydrogen bond terms carry a factor 0.5 in the gradients
+  error_code |= check_gradients(alpha, proxy, "CA", 0.5);
+
+  // Atoms shared between hydrogen bonds collect the gradients of each bond
+  protein_test_proxy::merge_o_n = true;
+  colvar::cvc *alpha_shared = new colvar::alpha_angles("residueRange 1-8\n");
+  error_code |= check_gradients(alpha_shared, proxy, "CA", 0.5);
+  protein_test_proxy::merge_o_n = false;
+
+  // dihedPC compared with the individual dihedral components
+  std::ostringstream conf;
+  conf << "residueRange 1-" << n_res << "\nvector {";
+  std::vector<cvm::real> coeffs;
+  for (int i = 0; i < 4*(n_res-1); i++) {
+    coeffs.push_back(0.25 * cvm::real((i % 7) - 3));
+    conf << " " << coeffs.back();
+  }
+  conf << " }\n";
+  colvar::cvc *dpc = new colvar::dihedPC(conf.str());
+  cvm::real const x_dpc = eval(dpc);
+
+  x_ref = 0.0;
+  for (int r = 1; r <= n_res-1; r++) {
+    colvar::dihedral psi(cvm::atom(r, "N", "MAIN"), cvm::atom(r, "CA", "MAIN"),
+                         cvm::atom(r, "C", "MAIN"), cvm::atom(r+1, "N", "MAIN"));
+    colvar::dihedral phi(cvm::atom(r, "C", "MAIN"), cvm::atom(r+1, "N", "MAIN"),
+                         cvm::atom(r+1, "CA", "MAIN"), cvm::atom(r+1, "C", "MAIN"));
+    cvm::real const t_psi = (PI / 180.) * eval(&psi);
+    cvm::real const t_phi = (PI / 180.) * eval(&phi);
+    size_t const i = 2*(r-1);
+    x_ref += coeffs[2*i  ] * std::cos(t_psi) + coeffs[2*i+1] * std::sin(t_psi);
+    x_ref += coeffs[2*i+2] * std::cos(t_phi) + coeffs[2*i+3] * std::sin(t_phi);
+  }
+
+  std::cout << "dihedPC = " << x_dpc << " (expected " << x_ref << ")\n";
+  if (std::fabs(x_dpc - x_ref) > 1.0e-12) error_code = 1;
+
+  error_code |= check_gradients(dpc, proxy, "CA", 1.0);
+
+  // Forces are applied to each distinct atom once
+  dpc->calc_gradients();
+  dpc->apply_force(colvarvalue(2.0));
+  cvm::atom_group &group = *(dpc->atom_groups[0]);
+  for (size_t ia = 0; ia < group.size(); ia++) {
+    cvm::rvector const f =
+      (*proxy->get_atom_applied_forces())[group[ia].proxy_index()];
+    if ((f - 2.0 * group[ia].grad()).norm() > 1.0e-12) {
+      std::cerr << "Error: wrong force on atom " << ia << ": " << f << "\n";
+      error_code = 1;
+    }
+  }
+
+  delete alpha;
+  delete alpha_shared;
+  delete dpc;
+  return error_code;
+}
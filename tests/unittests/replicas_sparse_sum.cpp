@@ -0,0 +1,263 @@
+#include <array>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+
+
+// Messages between replicas running as threads of the same process, kept
+// apart by tag
+class loopback_network {
+public:
+
+  loopback_network(int n) : num(n) {}
+
+  void send(int src, int dest, int tag, char const *data, int len)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queues[key(src, dest, tag)].push_back(std::vector<char>(data, data+len));
+    cond.notify_all();
+  }
+
+  int recv(int src, int dest, int tag, char *data, int buf_len)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    std::deque< std::vector<char> > &q = queues[key(src, dest, tag)];
+    cond.wait(lock, [&q] { return !q.empty(); });
+    std::vector<char> const msg = q.front();
+    q.pop_front();
+    if (int(msg.size()) > buf_len) return 0;
+    std::memcpy(data, msg.data(), msg.size());
+    return int(msg.size());
+  }
+
+  bool ready(int src, int dest, int tag)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !queues[key(src, dest, tag)].empty();
+  }
+
+  int const num;
+
+protected:
+
+  static std::array<int, 3> key(int src, int dest, int tag)
+  {
+    std::array<int, 3> const k = {{ src, dest, tag }};
+    return k;
+  }
+
+  std::map< std::array<int, 3>, std::deque< std::vector<char> > > queues;
+  std::mutex mutex;
+  std::condition_variable cond;
+};
+
+
+class loopback_replicas : public colvarproxy_replicas {
+public:
+
+  loopback_replicas(loopback_network *n, int i) : net(n), index(i) {}
+
+  int replica_enabled() { return COLVARS_OK; }
+  int replica_index() { return index; }
+  int num_replicas() { return net->num; }
+
+  int replica_comm_async() { return COLVARS_OK; }
+
+  int replica_comm_isend(char *msg_data, int msg_len, int dest_rep, int tag)
+  {
+    net->send(index, dest_rep, tag, msg_data, msg_len);
+    requests.push_back(0);
+    return int(requests.size()) - 1;
+  }
+
+  bool replica_comm_send_done(int request, bool wait)
+  {
+    // Sends complete only when tested a second time, unless waited for
+    return wait || (++requests[request] > 1);
+  }
+
+  bool replica_comm_ready(int src_rep, int tag)
+  {
+    return net->ready(src_rep, index, tag);
+  }
+
+  int replica_comm_recv_tagged(char *msg_data, int buf_len, int src_rep,
+                               int tag)
+  {
+    return net->recv(src_rep, index, tag, msg_data, buf_len);
+  }
+
+protected:
+
+  loopback_network *net;
+  int index;
+
+  /// Number of times each send request was tested
+  std::vector<int> requests;
+};
+
+
+size_t const num_records = 1000;
+size_t const record_size = 3;
+int const num_rounds = 4;
+
+
+// Sparse records set by each replica in each round
+void make_records(int replica, int round, std::vector<size_t> &records,
+                  std::vector<cvm::real> &values)
+{
+  // Linear congruential generator, because std::rand() is not thread-safe
+  unsigned long seed = 1 + 97*replica + 13*round;
+  records.clear();
+  values.clear();
+  for (size_t i = 0; i < num_records; i++) {
+    seed = (1103515245UL * seed + 12345UL) % 2147483648UL;
+    if ((seed >> 16) % 20 != 0) continue;
+    records.push_back(i);
+    for (size_t k = 0; k < record_size; k++) {
+      seed = (1103515245UL * seed + 12345UL) % 2147483648UL;
+      values.push_back(cvm::real((seed >> 16) % 1000) * 0.25);
+    }
+  }
+}
+
+
+// Two sums are run at the same time, so their messages must not be mixed
+int const num_sums = 2;
+
+
+struct replica_result {
+  std::vector< std::map<size_t, std::vector<cvm::real> > > sums[num_sums];
+  size_t messages_sent;
+};
+
+
+void run_replica(loopback_network *net, int replica, bool block,
+                 replica_result *result)
+{
+  loopback_replicas comm(net, replica);
+  colvarproxy_replicas::sparse_sum sums[num_sums];
+  int s;
+  for (s = 0; s < num_sums; s++) {
+    sums[s].init(&comm, num_records, record_size);
+  }
+  std::vector<size_t> records;
+  std::vector<cvm::real> values;
+  for (int round = 0; round < num_rounds; round++) {
+    for (s = 0; s < num_sums; s++) {
+      make_records(replica, num_rounds * s + round, records, values);
+      sums[s].start(records, values);
+    }
+    if (block) {
+      // Complete the sums in the reverse order of their messages
+      for (s = num_sums; s > 0; s--) {
+        sums[s-1].progress(true);
+      }
+    } else {
+      // Odd replicas send the messages of the sums in the reverse order
+      bool done = false;
+      while (!done) {
+        done = true;
+        for (s = 0; s < num_sums; s++) {
+          colvarproxy_replicas::sparse_sum &sum =
+            sums[(replica % 2) ? (num_sums - 1 - s) : s];
+          sum.progress(false);
+          done = done && sum.complete();
+        }
+        std::this_thread::yield();
+      }
+    }
+    for (s = 0; s < num_sums; s++) {
+      std::map<size_t, std::vector<cvm::real> > total;
+      for (size_t i = 0; i < sums[s].records().size(); i++) {
+        total[sums[s].records()[i]] =
+          std::vector<cvm::real>(sums[s].values().begin() + i*record_size,
+                                 sums[s].values().begin() + (i+1)*record_size);
+      }
+      result->sums[s].push_back(total);
+    }
+  }
+  result->messages_sent = 0;
+  for (s = 0; s < num_sums; s++) {
+    result->messages_sent += sums[s].num_messages_sent();
+  }
+}
+
+
+int test_sum(int num_replicas, bool block)
+{
+  loopback_network net(num_replicas);
+  std::vector<replica_result> results(num_replicas);
+  std::vector<std::thread> threads;
+  for (int r = 0; r < num_replicas; r++) {
+    threads.push_back(std::thread(run_replica, &net, r, block, &(results[r])));
+  }
+  for (int r = 0; r < num_replicas; r++) {
+    threads[r].join();
+  }
+
+  int error_code = 0;
+  std::vector<size_t> records;
+  std::vector<cvm::real> values;
+  for (int round = 0; round < num_sums * num_rounds; round++) {
+    int const s = round / num_rounds;
+    std::map<size_t, std::vector<cvm::real> > ref;
+    for (int r = 0; r < num_replicas; r++) {
+      make_records(r, round, records, values);
+      for (size_t i = 0; i < records.size(); i++) {
+        std::vector<cvm::real> &x = ref[records[i]];
+        x.resize(record_size, 0.0);
+        for (size_t k = 0; k < record_size; k++) {
+          x[k] += values[i*record_size+k];
+        }
+      }
+    }
+    for (int r = 0; r < num_replicas; r++) {
+      if (results[r].sums[s][round % num_rounds] != ref) {
+        std::cerr << "Error: wrong sum " << s << " on replica " << r
+                  << " in round " << round % num_rounds << " with "
+                  << num_replicas << " replicas.\n";
+        error_code = 1;
+      }
+    }
+  }
+
+  // Each replica sends one message to its parent and one to each child
+  size_t max_messages = 0;
+  for (int r = 0; r < num_replicas; r++) {
+    if (results[r].messages_sent > max_messages) {
+      max_messages = results[r].messages_sent;
+    }
+  }
+  size_t log_num = 0;
+  while ((1 << log_num) < num_replicas) log_num++;
+  std::cout << num_replicas << " replicas ("
+            << (block ? "blocking" : "non-blocking") << "): at most "
+            << max_messages / (num_sums * num_rounds)
+            << " messages per replica, sum and round\n";
+  if (max_messages > size_t(num_sums * num_rounds) * (log_num + 1)) {
+    std::cerr << "Error: too many messages.\n";
+    error_code = 1;
+  }
+  return error_code;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+  int error_code = 0;
+  int const num_replicas[] = { 1, 2, 3, 5, 8 };
+  for (size_t i = 0; i < sizeof(num_replicas)/sizeof(int); i++) {
+    error_code |= test_sum(num_replicas[i], true);
+    error_code |= test_sum(num_replicas[i], false);
+  }
+  return error_code;
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+
+#include "colvarproxy_stub.h"
+#include "colvars_test_utils.h"
+
+
+std::string const config =
+  "colvar {\n"
+  "  name rg\n"
+  "  gyration { atoms { atomNumbersRange 1-7 } }\n"
+  "}\n"
+  "colvar {\n"
+  "  name in\n"
+  "  inertia { atoms { atomNumbersRange 1-7 } }\n"
+  "}\n"
+  "colvar {\n"
+  "  name iz\n"
+  "  inertiaZ { atoms { atomNumbersRange 1-7 }\n"
+  "             axis (1.0, 2.0, 0.5) }\n"
+  "}\n"
+  "harmonic {\n"
+  "  colvars rg in iz\n"
+  "  centers 1.0 10.0 3.0\n"
+  "  forceConstant 2.0\n"
+  "}\n";
+
+char const *names[] = { "rg", "in", "iz" };
+
+
+// Compute the variables and the atomic forces, with or without scalable
+// groups, with the atoms translated by offset, at two steps: the reductions
+// are centered by the engine at the first step, and by the variables after
+int run(bool scalable, cvm::rvector const &offset,
+        colvars_test::run_results &results)
+{
+  int error_code = COLVARS_OK;
+  colvarproxy_stub *proxy = colvars_test::new_proxy(config, error_code, "",
+                                                    scalable);
+
+  if (scalable && (proxy->get_atom_group_ids()->size() != 3)) {
+    std::cerr << "Error: the groups were not made scalable.\n";
+    error_code = 1;
+  }
+
+  std::vector<int> const &ids = *(proxy->get_atom_ids());
+  for (int step = 0; step < 2; step++) {
+    for (size_t i = 0; i < ids.size(); i++) {
+      (*proxy->modify_atom_masses())[i] = 1.0 + 0.5 * ids[i];
+    }
+    colvars_test::set_test_positions(proxy, 0, offset +
+                                     cvm::rvector(0.1 * step, -0.2 * step,
+                                                  0.05 * step));
+    if (scalable) proxy->compute_atom_groups();
+    error_code |= proxy->colvars->calc();
+    if (scalable) proxy->apply_atom_groups_forces();
+
+    for (size_t i = 0; i < sizeof(names)/sizeof(names[0]); i++) {
+      results.values.push_back(cvm::colvar_by_name(names[i])->value().real_value);
+    }
+    colvars_test::append_applied_forces(proxy, results.forces);
+  }
+
+  delete proxy;
+  return error_code;
+}
+
+
+// Compare values and forces of the scalable and non-scalable paths
+int test_offset(cvm::rvector const &offset, cvm::real tol)
+{
+  return colvars_test::compare_runs(
+    [&offset](bool scalable, colvars_test::run_results &results) {
+      return run(scalable, offset, results);
+    }, tol);
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  int error_code = test_offset(cvm::rvector(0.0), 1.0e-10);
+
+  // Far from the origin, sums of the squared positions would lose all
+  // significant digits of the scatter matrix
+  error_code |= test_offset(cvm::rvector(3.0e6, -2.0e6, 1.0e6), 1.0e-8);
+
+  return error_code;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvarscript.h"
+
+
+// Minimal proxy that can allocate atom slots
+class binary_test_proxy : public colvarproxy {
+public:
+  int init_atom(int atom_number)
+  {
+    return add_atom_slot(atom_number);
+  }
+};
+
+
+int run_binary(std::string const &cmd, void const **data, int *type,
+               int *ndim, size_t *shape)
+{
+  unsigned char *objv[2];
+  objv[0] = (unsigned char *) "cv";
+  objv[1] = (unsigned char *) cmd.c_str();
+  if (run_colvarscript_command_binary(2, objv) != COLVARSCRIPT_OK) {
+    return 1;
+  }
+  return get_colvarscript_result_binary(data, type, ndim, shape);
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  binary_test_proxy *proxy = new binary_test_proxy();
+  proxy->colvars = new colvarmodule(proxy);
+
+  int const n = 4;
+  for (int i = 0; i < n; i++) {
+    proxy->init_atom(10+i);
+    (*proxy->modify_atom_positions())[i] = cvm::rvector(i, 2.0*i, -1.0*i);
+  }
+
+  int error_code = 0;
+  void const *data = NULL;
+  int type = -1, ndim = -1;
+  size_t shape[2];
+
+  // Positions are returned as a view of the proxy's array, with shape (n, 3)
+  if (run_binary("getatompositions", &data, &type, &ndim, shape) != 0) {
+    std::cerr << "Error: getatompositions has no binary result.\n";
+    return 1;
+  }
+  std::cout << "positions: type = " << type << ", ndim = " << ndim
+            << ", shape = (" << shape[0] << ", " << shape[1] << ")\n";
+  if ((type != COLVARSCRIPT_RESULT_REAL) || (ndim != 2) ||
+      (shape[0] != size_t(n)) || (shape[1] != 3)) error_code = 1;
+  if (data != &((*proxy->get_atom_positions())[0].x)) {
+    std::cerr << "Error: positions were copied.\n";
+    error_code = 1;
+  }
+  cvm::real const *pos = reinterpret_cast<cvm::real const *>(data);
+  for (int i = 0; i < n; i++) {
+    if ((pos[3*i] != i) || (pos[3*i+1] != 2.0*i) || (pos[3*i+2] != -1.0*i)) {
+      error_code = 1;
+    }
+  }
+
+  // Integer array
+  if (run_binary("getatomids", &data, &type, &ndim, shape) != 0) {
+    std::cerr << "Error: getatomids has no binary result.\n";
+    return 1;
+  }
+  int const *ids = reinterpret_cast<int const *>(data);
+  if ((type != COLVARSCRIPT_RESULT_INT) || (ndim != 1) ||
+      (shape[0] != size_t(n)) || (ids[n-1] != 10+n-1)) error_code = 1;
+
+  // Scalars are copied into a buffer
+  if (run_binary("getatomappliedforcesmax", &data, &type, &ndim, shape) != 0) {
+    std::cerr << "Error: getatomappliedforcesmax has no binary result.\n";
+    return 1;
+  }
+  if ((type != COLVARSCRIPT_RESULT_REAL) || (ndim != 1) || (shape[0] != 1) ||
+      (*reinterpret_cast<cvm::real const *>(data) != 0.0)) error_code = 1;
+
+  // String results are not available in binary form
+  if (run_binary("version", &data, &type, &ndim, shape) == 0) error_code = 1;
+  if ((data != NULL) || (type != COLVARSCRIPT_RESULT_NONE)) error_code = 1;
+
+  // The text interface is unchanged
+  unsigned char *objv[2];
+  objv[0] = (unsigned char *) "cv";
+  objv[1] = (unsigned char *) "getatomids";
+  run_colvarscript_command(2, objv);
+  std::cout << "text result: " << get_colvarscript_result() << "\n";
+  if (std::string(get_colvarscript_result()) != "10 11 12 13") error_code = 1;
+
+  delete proxy;
+  return error_code;
+}
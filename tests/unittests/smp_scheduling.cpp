@@ -0,0 +1,117 @@
+#include <iostream>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvarbias.h"
+
+#include "colvarproxy_stub.h"
+#include "colvars_test_utils.h"
+
+
+std::string config(bool smp)
+{
+  return
+    "smp " + std::string(smp ? "on" : "off") + "\n"
+    "colvar {\n"
+    "  name d1\n"
+    "  width 0.05\n"
+    "  lowerBoundary 0.0\n"
+    "  upperBoundary 6.0\n"
+    "  distance {\n"
+    "    forceNoPBC yes\n"
+    "    group1 { atomNumbers 1 }\n"
+    "    group2 { atomNumbers 2 }\n"
+    "  }\n"
+    "}\n"
+    "colvar {\n"
+    "  name d2\n"
+    "  width 0.05\n"
+    "  lowerBoundary 0.0\n"
+    "  upperBoundary 6.0\n"
+    "  distance {\n"
+    "    forceNoPBC yes\n"
+    "    group1 { atomNumbers 3 }\n"
+    "    group2 { atomNumbers 4 }\n"
+    "  }\n"
+    "}\n"
+    "metadynamics {\n"
+    "  name meta\n"
+    "  colvars d1 d2\n"
+    "  hillWeight 0.1\n"
+    "  hillWidth 3.0\n"
+    "  newHillFrequency 1\n"
+    "}\n"
+    "harmonic {\n"
+    "  name h\n"
+    "  colvars d1\n"
+    "  centers 2.0\n"
+    "  forceConstant 1.0\n"
+    "}\n"
+    "harmonicWalls {\n"
+    "  name w\n"
+    "  colvars d2\n"
+    "  upperWalls 2.5\n"
+    "  forceConstant 1.0\n"
+    "}\n";
+}
+
+
+/// Run a short trajectory, and return the bias energies and atomic forces
+int run(bool smp, colvars_test::run_results &results)
+{
+  int error_code = COLVARS_OK;
+  colvarproxy_stub *proxy = colvars_test::new_proxy(config(smp), error_code);
+  for (int step = 0; step < 20; step++) {
+    cvm::it = step;
+    colvars_test::set_test_positions(proxy, step);
+    error_code |= proxy->colvars->calc();
+  }
+  char const *biases[] = { "meta", "h", "w" };
+  for (size_t i = 0; i < 3; i++) {
+    results.values.push_back(cvm::bias_by_name(biases[i])->get_energy());
+  }
+  if (!smp && (results.values[0] <= 0.0)) {
+    std::cerr << "Error: no metadynamics energy.\n";
+    error_code = 1;
+  }
+  colvars_test::append_applied_forces(proxy, results.forces);
+  delete proxy;
+  return error_code;
+}
+
+
+/// Task used to test colvarproxy_smp::smp_tasks()
+int fill_task(size_t i, void *data)
+{
+  (*reinterpret_cast<std::vector<int> *>(data))[i] = static_cast<int>(i);
+  return COLVARS_OK;
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  int error_code = 0;
+
+  // All tasks are run exactly once
+  {
+    colvarproxy_stub *proxy = new colvarproxy_stub();
+    std::vector<int> filled(100, -1);
+    error_code |= proxy->smp_tasks(filled.size(), &fill_task,
+                                   reinterpret_cast<void *>(&filled));
+    for (size_t i = 0; i < filled.size(); i++) {
+      if (filled[i] != static_cast<int>(i)) {
+        std::cerr << "Error: task " << i << " was not run.\n";
+        error_code = 1;
+      }
+    }
+    delete proxy;
+  }
+
+  // Threads, and the order in which biases are computed, do not change
+  // the results
+  error_code |= colvars_test::compare_runs(&run, 0.0);
+
+  return error_code;
+}
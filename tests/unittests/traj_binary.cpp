@@ -0,0 +1,218 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvar.h"
+#include "colvarbias.h"
+
+#include "colvarproxy_stub.h"
+#include "colvars_test_utils.h"
+
+
+// Output prefix; if given on the command line, the trajectory is kept and
+// the values of its last frame are written to a text file, <prefix>.ref
+std::string prefix("test_traj_binary");
+
+std::string const config =
+  "colvarsTrajFrequency 1\n"
+  "colvarsTrajFormat binary\n"
+  "colvarsTrajFlushFrequency 4\n"
+  "colvar {\n"
+  "  name d\n"
+  "  outputAppliedForce on\n"
+  "  distance {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 }\n"
+  "    group2 { atomNumbers 2 }\n"
+  "  }\n"
+  "}\n"
+  "colvar {\n"
+  "  name v\n"
+  "  distancePairs {\n"
+  "    forceNoPBC yes\n"
+  "    group1 { atomNumbers 1 2 }\n"
+  "    group2 { atomNumbers 3 4 }\n"
+  "  }\n"
+  "}\n"
+  "harmonic {\n"
+  "  name h\n"
+  "  colvars d\n"
+  "  centers 1.0\n"
+  "  forceConstant 2.0\n"
+  "  outputEnergy on\n"
+  "  outputCenters on\n"
+  "}\n";
+
+
+/// Check that two values are identical to the last bit
+bool same_value(colvarvalue const &x1, colvarvalue const &x2)
+{
+  if (x1.size() != x2.size()) return false;
+  for (size_t i = 0; i < x1.size(); i++) {
+    if (x1[i] != x2[i]) return false;
+  }
+  return true;
+}
+
+
+/// Read the tag and length of the next record
+bool read_record(std::istream &is, std::string &tag, int &length)
+{
+  tag.assign(8, ' ');
+  return is.read(&(tag[0]), tag.size()) &&
+    is.read(reinterpret_cast<char *>(&length), sizeof(int));
+}
+
+
+/// Size of the file written so far
+long file_size(std::string const &file_name)
+{
+  std::ifstream is(file_name.c_str(), std::ios::binary | std::ios::ate);
+  return is ? static_cast<long>(is.tellg()) : -1L;
+}
+
+
+/// Write the components of x to os, with enough digits to read them back
+void write_ref(std::ostream &os, std::string const &label,
+               colvarvalue const &x)
+{
+  os << label;
+  for (size_t i = 0; i < x.size(); i++) {
+    os << " " << std::setprecision(17) << x[i];
+  }
+  os << "\n";
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  bool const keep_files = (argc > 1);
+  if (keep_files) {
+    prefix = argv[1];
+  }
+  std::string const traj_file(prefix+".colvars.traj");
+
+  int error_code = 0;
+  int const num_steps = 10;
+
+  // Write the trajectory, and record the values of the last step
+  colvarproxy_stub *proxy = colvars_test::new_proxy(config, error_code,
+                                                    prefix);
+  error_code |= proxy->colvars->setup_output();
+
+  long size_first_frame = -1;
+  for (int step = 0; step < num_steps; step++) {
+    cvm::it = step;
+    colvars_test::set_test_positions(proxy, step);
+    error_code |= proxy->colvars->calc();
+    if (step == 3) {
+      // Only the frame of step 0 was written so far, the others are buffered
+      size_first_frame = file_size(traj_file);
+    }
+  }
+  colvarvalue const d_ref(cvm::colvar_by_name("d")->value());
+  colvarvalue const fa_d_ref(cvm::colvar_by_name("d")->applied_force());
+  colvarvalue const v_ref(cvm::colvar_by_name("v")->value());
+  cvm::real const energy_ref = cvm::bias_by_name("h")->get_energy();
+  error_code |= proxy->post_run();
+  delete proxy;
+
+  // Parse the header record and check the size of the file
+  std::ifstream is(traj_file.c_str(), std::ios::binary);
+  std::string tag;
+  int length = 0;
+  if (!read_record(is, tag, length) || (tag != "CVTRAJB2")) {
+    std::cerr << "Error: wrong signature \"" << tag << "\".\n";
+    error_code = 1;
+  }
+  std::string header(length, ' ');
+  is.read(&(header[0]), length);
+  std::istringstream header_is(header);
+  std::string line;
+  std::vector<std::string> labels;
+  size_t num_values = 0;
+  while (std::getline(header_is, line)) {
+    std::istringstream line_is(line);
+    std::string label, type;
+    size_t n = 0;
+    line_is >> label >> type >> n;
+    labels.push_back(label);
+    num_values += n;
+  }
+  long const header_size = static_cast<long>(is.tellg());
+
+  std::cout << "Binary trajectory with " << labels.size() << " columns and "
+            << num_values << " values per frame.\n";
+  // step (1), d (1), fa_d (1), v (4), E_h (1), x0_d (1)
+  if ((labels.size() != 6) || (num_values != 9) || (labels[4] != "E_h") ||
+      (labels[5] != "x0_d")) {
+    std::cerr << "Error: wrong columns in binary trajectory.\n";
+    error_code = 1;
+  }
+  long const frame_size = 8 + sizeof(int) + num_values * sizeof(cvm::real);
+  if (size_first_frame != header_size + frame_size) {
+    std::cerr << "Error: " << size_first_frame
+              << " bytes written before the first flush.\n";
+    error_code = 1;
+  }
+  if (file_size(traj_file) != header_size + num_steps * frame_size) {
+    std::cerr << "Error: wrong size of binary trajectory, "
+              << file_size(traj_file) << " bytes.\n";
+    error_code = 1;
+  }
+
+  // The bias columns are written without formatting as well
+  std::vector<cvm::real> frame(num_values);
+  for (int step = 0; step < num_steps; step++) {
+    if (!read_record(is, tag, length) || (tag != "CVTRAJFR") ||
+        (length != static_cast<int>(num_values)) ||
+        !is.read(reinterpret_cast<char *>(&(frame[0])),
+                 num_values * sizeof(cvm::real))) {
+      std::cerr << "Error: invalid frame record at step " << step << ".\n";
+      error_code = 1;
+      break;
+    }
+  }
+  if ((frame[7] != energy_ref) || (frame[8] != 1.0)) {
+    std::cerr << "Error: bias columns of the last frame are " << frame[7]
+              << " " << frame[8] << ", instead of " << energy_ref
+              << " 1.0.\n";
+    error_code = 1;
+  }
+  is.close();
+
+  // Read it back, and compare the last frame with the values computed
+  proxy = colvars_test::new_proxy(config, error_code);
+  error_code |= proxy->colvars->read_traj(traj_file.c_str(), 0, 0);
+  if (cvm::it != num_steps - 1) {
+    std::cerr << "Error: last step read is " << cvm::it << ".\n";
+    error_code = 1;
+  }
+  if (!same_value(cvm::colvar_by_name("d")->value(), d_ref) ||
+      !same_value(cvm::colvar_by_name("d")->applied_force(), fa_d_ref) ||
+      !same_value(cvm::colvar_by_name("v")->value(), v_ref)) {
+    std::cerr << "Error: values read from the binary trajectory differ "
+              << "from the ones computed.\n";
+    error_code = 1;
+  }
+
+  if (keep_files) {
+    std::ofstream ref_os((prefix+".ref").c_str());
+    write_ref(ref_os, "d", d_ref);
+    write_ref(ref_os, "fa_d", fa_d_ref);
+    write_ref(ref_os, "v", v_ref);
+    write_ref(ref_os, "E_h", colvarvalue(energy_ref));
+    write_ref(ref_os, "x0_d", colvarvalue(1.0));
+  } else {
+    proxy->remove_file(traj_file);
+  }
+  proxy->remove_file(traj_file+".BAK");
+  proxy->remove_file(prefix+".colvars.state");
+  delete proxy;
+
+  return error_code;
+}
@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+
+# Read with plot_colvars_traj.py the binary trajectory written by the
+# traj_binary test (whose executable is the first argument), and compare its
+# last frame with the values computed by Colvars
+
+import os
+import subprocess
+import sys
+
+try:
+    import numpy as np
+except ImportError:
+    print("numpy is not available: skipping this test.")
+    sys.exit(77)
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', '..', 'colvartools'))
+from plot_colvars_traj import Colvars_traj
+
+prefix = 'test_traj_binary_py'
+subprocess.check_call([sys.argv[1], prefix])
+
+ref = {}
+for line in open(prefix+'.ref'):
+    words = line.split()
+    ref[words[0]] = np.array([float(w) for w in words[1:]])
+
+traj = Colvars_traj(prefix+'.colvars.traj')
+error = False
+
+if sorted(traj.variables) != sorted(ref.keys()):
+    print("Error: variables", sorted(traj.variables), "instead of",
+          sorted(ref.keys()))
+    error = True
+
+for key in ref:
+    if key not in traj:
+        continue
+    cv = traj[key]
+    values = np.atleast_1d(cv.values[-1])
+    print(key, ": ", cv.num_frames, " frames, last value ", values, sep='')
+    if (cv.num_frames != 10) or (cv.steps[-1] != 9):
+        print("Error: wrong frames for", key)
+        error = True
+    if not np.array_equal(values, ref[key]):
+        print("Error: last value of", key, "should be", ref[key])
+        error = True
+
+for f in [prefix+'.colvars.traj', prefix+'.ref']:
+    os.remove(f)
+
+sys.exit(1 if error else 0)
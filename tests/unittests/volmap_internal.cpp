@@ -0,0 +1,113 @@
+#include <iostream>
+#include <fstream>
+
+#include "colvarmodule.h"
+#include "colvarproxy.h"
+#include "colvaratoms.h"
+
+
+// Linear function, which trilinear interpolation should reproduce exactly
+cvm::real linear_map(cvm::real x, cvm::real y, cvm::real z)
+{
+  return 1.0 + 0.5*x - 0.25*y + 2.0*z;
+}
+
+
+/// Write a cubic map of the linear function, starting at the given origin
+void write_map(char const *filename, int n, cvm::real h, cvm::real origin)
+{
+  std::ofstream dx(filename);
+  dx << "# Test map\n"
+     << "object 1 class gridpositions counts " << n << " " << n << " " << n << "\n"
+     << "origin " << origin << " " << origin << " " << origin << "\n"
+     << "delta " << h << " 0 0\n"
+     << "delta 0 " << h << " 0\n"
+     << "delta 0 0 " << h << "\n"
+     << "object 2 class gridconnections counts " << n << " " << n << " " << n << "\n"
+     << "object 3 class array type double rank 0 items " << n*n*n << " data follows\n";
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      for (int k = 0; k < n; k++) {
+        dx << linear_map(origin+i*h, origin+j*h, origin+k*h) << "\n";
+      }
+    }
+  }
+}
+
+
+extern "C" int main(int argc, char *argv[]) {
+
+  colvarproxy *proxy = new colvarproxy();
+  proxy->colvars = new colvarmodule(proxy);
+  proxy->angstrom_value = 1.0;
+
+  int const n = 5;
+  cvm::real const h = 0.5;
+  write_map("volmap_internal.dx", n, h, -1.0);
+  write_map("volmap_internal_0.dx", n, h, 0.0);
+
+  int const volmap_id = proxy->load_internal_volmap("volmap_internal.dx", false);
+  int const periodic_id = proxy->load_internal_volmap("volmap_internal.dx", true);
+  int const periodic0_id = proxy->load_internal_volmap("volmap_internal_0.dx", true);
+  proxy->remove_file("volmap_internal.dx");
+  proxy->remove_file("volmap_internal_0.dx");
+  if ((volmap_id < 0) || (periodic_id < 0) || (periodic0_id < 0)) {
+    std::cerr << "Error: could not load map.\n";
+    return 1;
+  }
+
+  std::vector<cvm::atom> atoms(3);
+  atoms[0].pos() = cvm::atom_pos(0.1, -0.3, 0.7);
+  atoms[1].pos() = cvm::atom_pos(1.0, 1.0, 1.0);   // Last grid point
+  atoms[2].pos() = cvm::atom_pos(5.0, 0.0, 0.0);   // Outside the map
+
+  std::vector<cvm::real> weights(3, 2.0);
+
+  cvm::real value = 0.0;
+  proxy->compute_internal_volmap(colvarproxy::volmap_flag_gradients |
+                                 colvarproxy::volmap_flag_use_atom_field,
+                                 volmap_id, atoms.begin(), atoms.end(),
+                                 &value, &(weights[0]));
+
+  cvm::real const ref_value = 2.0 * (linear_map(0.1, -0.3, 0.7) +
+                                     linear_map(1.0, 1.0, 1.0));
+  cvm::rvector const ref_grad(1.0, -0.5, 4.0);
+
+  int error_code = 0;
+  std::cout << "value = " << value << " (expected " << ref_value << ")\n";
+  if (cvm::fabs(value - ref_value) > 1.0e-10) error_code = 1;
+  for (size_t i = 0; i < 2; i++) {
+    std::cout << "grad[" << i << "] = " << atoms[i].grad() << "\n";
+    if ((atoms[i].grad() - ref_grad).norm() > 1.0e-10) error_code = 1;
+  }
+  if (atoms[2].grad().norm() != 0.0) error_code = 1;
+
+  // Periodic map: a shift by one period gives the same value
+  std::vector<cvm::atom> images(2);
+  images[0].pos() = cvm::atom_pos(0.1, -0.3, 0.7);
+  images[1].pos() = images[0].pos() + cvm::atom_pos(n*h, -2.0*n*h, n*h);
+  cvm::real value0 = 0.0, value1 = 0.0;
+  proxy->compute_internal_volmap(colvarproxy::volmap_flag_null, periodic_id,
+                                 images.begin(), images.begin()+1,
+                                 &value0, NULL);
+  proxy->compute_internal_volmap(colvarproxy::volmap_flag_null, periodic_id,
+                                 images.begin()+1, images.end(),
+                                 &value1, NULL);
+  std::cout << "periodic images: " << value0 << " " << value1 << "\n";
+  if (cvm::fabs(value1 - value0) > 1.0e-10) error_code = 1;
+
+  // Periodic map: an atom just below the origin wraps onto the first point
+  std::vector<cvm::atom> below(1);
+  below[0].pos() = cvm::atom_pos(-1.0e-17, -1.0e-17, -1.0e-17);
+  cvm::real value_below = 0.0;
+  proxy->compute_internal_volmap(colvarproxy::volmap_flag_null, periodic0_id,
+                                 below.begin(), below.end(),
+                                 &value_below, NULL);
+  std::cout << "value below the origin = " << value_below << " (expected "
+            << linear_map(0.0, 0.0, 0.0) << ")\n";
+  if (cvm::fabs(value_below - linear_map(0.0, 0.0, 0.0)) > 1.0e-10) {
+    error_code = 1;
+  }
+
+  return error_code;
+}
@@ -32,6 +32,7 @@ $colvars_defines = " -DVMDCOLVARS";
                     'colvarcomp_gpath.C',
                     'colvarcomp_protein.C',
                     'colvarcomp_rotations.C',
+                    'colvarcomp_plugin.C',
                     'colvarcomp_volmaps.C',
                     'colvardeps.C',
                     'colvargrid.C',